@@ -1,20 +1,26 @@
 #include <napi.h>
 #include "camera.h"
+#include "frame_sink.h"
+#ifdef _WIN32
 #include <mfapi.h>
 
 static void MfCleanup() {
   // Best-effort shutdown of Media Foundation at process exit.
   MFShutdown();
 }
+#endif
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
+#ifdef _WIN32
   HRESULT hr = MFStartup(MF_VERSION);
   if (SUCCEEDED(hr)) {
     // Register atexit cleanup to call MFShutdown when the process exits.
     atexit(MfCleanup);
   }
+#endif
 
   Napi::Object camExports = Camera::Init(env, exports);
+  FrameSink::Init(env, camExports);
 
   // Register bench exports if available
   // bench.BenchInit is declared in bench.cc
@@ -1,12 +1,178 @@
 const addon = require("bindings")("addon.node");
 const EventEmitter = require("events");
+const { createFrameRing, FrameRingReader } = require("./frame_ring");
+
+// Slot order of the native frame info array (FrameInfoSlot in frame_target.h)
+const INFO_SEQUENCE = 0;
+const INFO_DEVICE_TIME = 1;
+const INFO_TIMESTAMP = 2;
+const INFO_ARRIVAL = 3;
+const INFO_FORMAT = 4;
+const INFO_WIDTH = 5;
+const INFO_HEIGHT = 6;
+const INFO_STRIDE = 7;
+const INFO_FLAGS = 8;
+const INFO_SIZE = 9;
+const FLAG_DISCONTINUITY = 1;
+
+// Messages of the FrameSink handshake over a MessagePort or Worker
+const SINK_REQUEST = "camera:frame-sink-request";
+const SINK_REPLY = "camera:frame-sink";
+const SINK_REQUEST_TIMEOUT_MS = 5000;
+let nextSinkRequestId = 1;
+
+// Ids matching readInto timeouts to their native requests
+let nextReadIntoId = 1;
+
+// Metadata of the frame being delivered. One instance per camera reads a
+// Float64Array the native side rewrites before every 'frame' event, so
+// delivery allocates nothing beyond the Buffer. Values are only valid during
+// the event; use toJSON() to keep a snapshot.
+class FrameInfo {
+  constructor(slots) {
+    this._slots = slots;
+  }
+  // Frames delivered by the backend this capture session, from 0. Gaps mean
+  // frames were dropped between the backend and JS (delivery queue).
+  get sequence() {
+    return this._slots[INFO_SEQUENCE];
+  }
+  // Presentation time on the device/driver clock, microseconds
+  get deviceTimestamp() {
+    return this._slots[INFO_DEVICE_TIME];
+  }
+  // deviceTimestamp rebased to the first frame of the session, microseconds
+  get timestamp() {
+    return this._slots[INFO_TIMESTAMP];
+  }
+  // Monotonic clock (QPC / CLOCK_MONOTONIC) when the backend received the
+  // frame, microseconds
+  get arrivalTime() {
+    return this._slots[INFO_ARRIVAL];
+  }
+  // Format of the delivered bytes ('NV12', 'RGB32', 'MJPEG', ...); '' for
+  // backend-native formats without a short name
+  get subtype() {
+    return addon.pixelFormatNames[this._slots[INFO_FORMAT]] || "";
+  }
+  get width() {
+    return this._slots[INFO_WIDTH];
+  }
+  get height() {
+    return this._slots[INFO_HEIGHT];
+  }
+  // Bytes per row of the first plane; 0 for compressed formats
+  get stride() {
+    return this._slots[INFO_STRIDE];
+  }
+  // Frames were lost before delivery (device gap, exhausted frame pool)
+  get discontinuity() {
+    return (this._slots[INFO_FLAGS] & FLAG_DISCONTINUITY) !== 0;
+  }
+  get size() {
+    return this._slots[INFO_SIZE];
+  }
+  toJSON() {
+    return {
+      sequence: this.sequence,
+      deviceTimestamp: this.deviceTimestamp,
+      timestamp: this.timestamp,
+      arrivalTime: this.arrivalTime,
+      subtype: this.subtype,
+      width: this.width,
+      height: this.height,
+      stride: this.stride,
+      discontinuity: this.discontinuity,
+      size: this.size,
+    };
+  }
+}
+
+// Receives the frames of a camera started with { target } on the thread that
+// created the sink, typically a worker: frames are delivered by the native
+// side straight into this thread's event loop, never through the camera's.
+// Emits 'frame' (buffer, info) like Camera. With { port } the sink answers
+// Camera#startCapture({ target: worker or port }) handshakes on that port.
+// close() stops delivery and lets the thread exit.
+class FrameSink extends EventEmitter {
+  // options: see index.d.ts FrameSinkOptions
+  constructor(options = {}) {
+    super();
+    options = options || {};
+    this._native = new addon.FrameSink((frameData) => {
+      this.emit("frame", frameData, this._frameInfo);
+    }, options);
+    this._frameInfo = new FrameInfo(this._native.getFrameInfoArray());
+    // Pass to startCapture({ target }) in any thread of this process
+    this.id = this._native.getId();
+
+    this._port = options.port || null;
+    if (this._port) {
+      this._onPortMessage = (message) => {
+        if (message && message.type === SINK_REQUEST) {
+          this._port.postMessage({ type: SINK_REPLY, requestId: message.requestId, sinkId: this.id });
+        }
+      };
+      this._port.on("message", this._onPortMessage);
+    }
+  }
+
+  // Delivery queue counters (same shape as Camera#getStats().delivery)
+  getStats() {
+    return this._native.getStats();
+  }
+
+  close() {
+    if (this._port) {
+      this._port.off("message", this._onPortMessage);
+      this._port = null;
+    }
+    this._native.close();
+  }
+}
+
+// Ask the FrameSink listening on the other end of `port` (a MessagePort or
+// Worker) for its id.
+function requestFrameSink(port) {
+  return new Promise((resolve, reject) => {
+    const requestId = nextSinkRequestId++;
+    const done = (error, sinkId) => {
+      clearTimeout(timer);
+      port.off("message", onMessage);
+      if (error) reject(error);
+      else resolve(sinkId);
+    };
+    const onMessage = (message) => {
+      if (message && message.type === SINK_REPLY && message.requestId === requestId) {
+        done(null, message.sinkId);
+      }
+    };
+    const timer = setTimeout(() => {
+      done(new Error("No FrameSink answered on the target port (create one with { port })"));
+    }, SINK_REQUEST_TIMEOUT_MS);
+    port.on("message", onMessage);
+    port.postMessage({ type: SINK_REQUEST, requestId });
+  });
+}
+
+// startCapture's `target` as a native FrameSink id
+async function resolveFrameTarget(target) {
+  if (typeof target === "number") return target;
+  if (target instanceof FrameSink) return target.id;
+  if (target && typeof target.frameSinkId === "number") return target.frameSinkId;
+  if (target && typeof target.postMessage === "function" && typeof target.on === "function") {
+    return requestFrameSink(target);
+  }
+  throw new TypeError("target must be a FrameSink, its id, or a Worker/MessagePort with a FrameSink listening");
+}
 
 class Camera extends EventEmitter {
-  constructor() {
+  // options: see index.d.ts CameraOptions
+  constructor(options = {}) {
     super(); // Call EventEmitter constructor
 
-    // Create native camera instance
-    this._nativeCamera = new addon.Camera();
+    // Create native camera instance on the selected capture backend
+    this._nativeCamera = new addon.Camera(options || {});
 
     // Bind async methods from native camera
     this.enumerateDevices = this._nativeCamera.enumerateDevicesAsync.bind(
@@ -15,9 +181,6 @@ class Camera extends EventEmitter {
     this.claimDevice = this._nativeCamera.claimDeviceAsync.bind(
       this._nativeCamera,
     );
-    this.releaseDevice = this._nativeCamera.releaseDeviceAsync.bind(
-      this._nativeCamera,
-    );
 
     // Bind other native methods
     this.getSupportedFormats = this._nativeCamera.getSupportedFormatsAsync.bind(
@@ -71,28 +234,50 @@ class Camera extends EventEmitter {
     this.getDimensions = this._nativeCamera.getDimensions.bind(
       this._nativeCamera,
     );
+    // Frame delivery counters (frame pool hits/misses/high-water mark)
+    this.getStats = this._nativeCamera.getStats.bind(this._nativeCamera);
+    // Name of the capture backend in use ('mediafoundation', 'v4l2', 'synthetic', 'replay')
+    this.backend = this._nativeCamera.getBackend();
 
     this._isCapturing = false;
 
+    // Reused for every frame (see FrameInfo)
+    this._frameInfo = new FrameInfo(this._nativeCamera.getFrameInfoArray());
+
     // Frame event emitter used by native code
     this._frameEventEmitter = (frameData) => {
       // Keep reference alive until event handlers run
-      this.emit("frame", frameData);
+      this.emit("frame", frameData, this._frameInfo);
     };
   }
 
   // Modern async startCapture method with events
-  async startCapture() {
+  // options: see index.d.ts StartCaptureOptions
+  async startCapture(options = {}) {
     if (this._isCapturing) {
       throw new Error("Capture is already in progress");
     }
 
+    options = options || {};
+    if (options.ring !== undefined && options.ring !== null) {
+      if (!(options.ring instanceof SharedArrayBuffer)) {
+        throw new TypeError("ring must be a SharedArrayBuffer created by createFrameRing()");
+      }
+      // The native side writes through an Int32Array view, which also gives
+      // it the word Atomics.notify wakes consumers on
+      options = Object.assign({}, options, { ring: new Int32Array(options.ring) });
+    }
+
     this._isCapturing = true;
 
     try {
+      if (options.target !== undefined && options.target !== null) {
+        options = Object.assign({}, options, { target: await resolveFrameTarget(options.target) });
+      }
       // Pass the frame event emitter to the native method
       const result = await this._nativeCamera.startCaptureAsync(
         this._frameEventEmitter,
+        options,
       );
       return result;
     } catch (error) {
@@ -112,10 +297,95 @@ class Camera extends EventEmitter {
     }
   }
 
+  // Pull-based delivery: starts capture and yields frames as the loop asks for
+  // them, stopping capture when the loop ends. Frames are only converted and
+  // copied for a pending request (latestOnly) or while fewer than queueSize
+  // are waiting, so a slow or idle loop costs next to nothing.
+  // options: see index.d.ts FramesOptions
+  async *frames(options = {}) {
+    options = options || {};
+    const { latestOnly, ...captureOptions } = options;
+    await this.startCapture(Object.assign(captureOptions, { pull: { latestOnly: !!latestOnly } }));
+    try {
+      for (;;) {
+        const frame = await this._nativeCamera.pullFrameAsync();
+        // null: capture was stopped
+        if (!frame) return;
+        yield frame;
+      }
+    } finally {
+      if (this._isCapturing) await this.stopCapture();
+    }
+  }
+
+  // Write the next frame into `buffer` (an ArrayBuffer, a SharedArrayBuffer
+  // or a view such as a Buffer) and resolve with its metadata; `size` is the
+  // number of bytes written from the start of the buffer. Shared memory is
+  // written directly; other buffers get a copy once the frame is ready and
+  // reject with a TypeError if they were detached meanwhile. Starts a
+  // latest-only pull session when capture is not running yet, so frames are
+  // only produced for pending reads; stopCapture() ends it. Resolves with
+  // null once capture stops, rejects with a RangeError when the frame does
+  // not fit and with an ETIMEDOUT error when no frame arrives in timeoutMs.
+  // options: see index.d.ts ReadIntoOptions
+  async readInto(buffer, options = {}) {
+    options = options || {};
+    if (!this._isCapturing) {
+      await this.startCapture({ pull: { latestOnly: true } });
+    }
+    // N-API only sees a SharedArrayBuffer's memory through a view
+    if (typeof SharedArrayBuffer !== "undefined" && buffer instanceof SharedArrayBuffer) {
+      buffer = new Uint8Array(buffer);
+    }
+    const requestId = nextReadIntoId++;
+    const timeoutMs = options.timeoutMs;
+    let timedOut = false;
+    let timer = null;
+    if (typeof timeoutMs === "number" && timeoutMs >= 0) {
+      timer = setTimeout(() => {
+        timedOut = true;
+        // A frame already being written into the buffer still resolves
+        this._nativeCamera.cancelReadInto(requestId);
+      }, timeoutMs);
+    }
+    try {
+      const result = await this._nativeCamera.readIntoAsync(buffer, requestId);
+      if (!result && timedOut) {
+        const error = new Error(`No frame within ${timeoutMs} ms`);
+        error.code = "ETIMEDOUT";
+        throw error;
+      }
+      return result;
+    } finally {
+      clearTimeout(timer);
+    }
+  }
+
+  // Releasing the device also ends a capture session: pending frames() and
+  // readInto() calls resolve with null
+  async releaseDevice() {
+    this._isCapturing = false;
+    return this._nativeCamera.releaseDeviceAsync();
+  }
+
   // Helper method to check if capturing
   isCapturing() {
     return this._isCapturing;
   }
 }
 
+// Process-wide conversion kernel selection (see README: Conversion kernels)
+Camera.setConversionIsa = addon.setConversionIsa;
+Camera.getConversionKernels = addon.getConversionKernels;
+
+Camera.FrameInfo = FrameInfo;
+
+// Frame delivery into another thread's event loop (startCapture({ target }))
+Camera.FrameSink = FrameSink;
+
+// Shared-memory frame delivery (startCapture({ ring })); also available
+// without the addon from frame_ring.js for worker_threads
+Camera.createFrameRing = createFrameRing;
+Camera.FrameRingReader = FrameRingReader;
+
 module.exports = Camera;
@@ -0,0 +1,250 @@
+#include "backend_mf.h"
+
+#include <windows.h>
+#include <objbase.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <cstring>
+
+namespace {
+
+// COM must be initialized on every thread that touches the source reader;
+// backend calls arrive on short-lived worker threads.
+class ComScope {
+ public:
+  ComScope() : m_initialized(SUCCEEDED(CoInitializeEx(NULL, COINIT_MULTITHREADED))) {
+  }
+  ~ComScope() {
+    if (m_initialized) CoUninitialize();
+  }
+
+ private:
+  bool m_initialized;
+};
+
+std::string WideToUtf8(const WCHAR* w) {
+  std::string out;
+  if (!w) return out;
+  int len = WideCharToMultiByte(CP_UTF8, 0, w, -1, NULL, 0, NULL, NULL);
+  if (len > 0) {
+    out.assign(len, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, w, -1, &out[0], len, NULL, NULL);
+    if (!out.empty() && out.back() == '\0') out.pop_back();
+  }
+  return out;
+}
+
+std::wstring Utf8ToWide(const std::string& s) {
+  std::wstring out;
+  int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, NULL, 0);
+  if (len > 0) {
+    out.assign(len, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &out[0], len);
+    if (!out.empty() && out.back() == L'\0') out.pop_back();
+  }
+  return out;
+}
+
+// "{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}"
+std::string GuidToString(const GUID& g) {
+  OLECHAR wsz[64];
+  StringFromGUID2(g, wsz, ARRAYSIZE(wsz));
+  return WideToUtf8(wsz);
+}
+
+CaptureFormat MakeFormat(const GUID& subtype, UINT32 width, UINT32 height, double frameRate) {
+  CaptureFormat f;
+  f.format = PixelFormatFromSubtype(subtype);
+  f.guid = GuidToString(subtype);
+  // Short friendly name when known, the GUID string otherwise
+  f.subtype = f.format != PixelFormat::Unknown ? PixelFormatName(f.format) : f.guid;
+  f.width = width;
+  f.height = height;
+  f.frameRate = frameRate;
+  return f;
+}
+
+bool ParseGuid(const std::string& s, GUID& out) {
+  std::wstring w = Utf8ToWide(s);
+  CLSID clsid;
+  if (w.empty() || FAILED(CLSIDFromString(w.c_str(), &clsid))) return false;
+  out = clsid;
+  return true;
+}
+
+}  // namespace
+
+MediaFoundationBackend::MediaFoundationBackend() {
+}
+
+MediaFoundationBackend::~MediaFoundationBackend() {
+  ReleaseDevice();
+}
+
+HRESULT MediaFoundationBackend::EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) {
+  outDevices.clear();
+  ComScope com;
+  DeviceList list;
+  std::vector<std::pair<std::wstring, std::wstring>> devices;
+  HRESULT hr = list.GetAllDevices(devices);
+  if (FAILED(hr)) return hr;
+  for (const auto& d : devices) {
+    outDevices.push_back({WideToUtf8(d.first.c_str()), WideToUtf8(d.second.c_str())});
+  }
+  return S_OK;
+}
+
+HRESULT MediaFoundationBackend::ClaimDevice(const std::string& identifier) {
+  ComScope com;
+  ReleaseDevice();
+
+  IMFActivate* pActivate = nullptr;
+  DeviceList list;
+  std::wstring id = Utf8ToWide(identifier);
+  HRESULT hr = list.GetDevice(id.c_str(), &pActivate);
+  if (FAILED(hr)) return hr;
+
+  // Create a CCapture instance and initialize its reader from the claimed
+  // activation so GetSupportedFormats can enumerate types.
+  CCapture* cap = nullptr;
+  hr = CCapture::CreateInstance(NULL, &cap);
+  if (SUCCEEDED(hr)) hr = cap->InitFromActivate(pActivate);
+  if (FAILED(hr)) {
+    if (cap) cap->Release();
+    pActivate->Release();
+    return hr;
+  }
+
+  // GetDevice returns an AddRef'd IMFActivate so we can store it directly.
+  m_activate = pActivate;
+  m_device = cap;
+  return S_OK;
+}
+
+HRESULT MediaFoundationBackend::ReleaseDevice() {
+  HRESULT hr = S_OK;
+  if (m_device) {
+    hr = m_device->ReleaseDevice();
+    m_device->Release();
+    m_device = nullptr;
+  }
+  if (m_activate) {
+    m_activate->Release();
+    m_activate = nullptr;
+  }
+  return hr;
+}
+
+HRESULT MediaFoundationBackend::GetClaimedDevice(CaptureDeviceInfo& outDevice) {
+  if (!m_activate) return CAPTURE_E_NOT_READY;
+  WCHAR* pFriendly = nullptr;
+  WCHAR* pSymbolic = nullptr;
+  if (SUCCEEDED(m_activate->GetAllocatedString(MF_DEVSOURCE_ATTRIBUTE_FRIENDLY_NAME, &pFriendly, nullptr))) {
+    outDevice.friendlyName = WideToUtf8(pFriendly);
+  }
+  if (SUCCEEDED(m_activate->GetAllocatedString(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_SYMBOLIC_LINK, &pSymbolic, nullptr))) {
+    outDevice.symbolicLink = WideToUtf8(pSymbolic);
+  }
+  if (pFriendly) CoTaskMemFree(pFriendly);
+  if (pSymbolic) CoTaskMemFree(pSymbolic);
+  return S_OK;
+}
+
+HRESULT MediaFoundationBackend::GetSupportedFormats(std::vector<CaptureFormat>& outFormats) {
+  outFormats.clear();
+  if (!m_device) return CAPTURE_E_NOT_READY;
+  std::vector<std::tuple<GUID, UINT32, UINT32, double>> types;
+  HRESULT hr = m_device->GetSupportedFormats(types);
+  if (FAILED(hr)) return hr;
+  for (const auto& t : types) {
+    outFormats.push_back(MakeFormat(std::get<0>(t), std::get<1>(t), std::get<2>(t), std::get<3>(t)));
+  }
+  return S_OK;
+}
+
+HRESULT MediaFoundationBackend::SetFormat(const CaptureFormat& format) {
+  if (!m_device) return CAPTURE_E_NOT_READY;
+  GUID subtype = GUID_NULL;
+  if (!format.guid.empty()) {
+    if (!ParseGuid(format.guid, subtype)) {
+      PixelFormat named = PixelFormat::Unknown;
+      if (!ParsePixelFormat(format.guid, named)) return E_INVALIDARG;
+      subtype = SubtypeFromPixelFormat(named);
+    }
+  } else {
+    subtype = SubtypeFromPixelFormat(format.format);
+  }
+  if (IsEqualGUID(subtype, GUID_NULL)) return E_INVALIDARG;
+  return m_device->SetFormat(subtype, format.width, format.height, format.frameRate);
+}
+
+HRESULT MediaFoundationBackend::GetCurrentFormat(CaptureFormat& outFormat) {
+  if (!m_device) return CAPTURE_E_NOT_READY;
+  UINT32 w = 0, h = 0;
+  double fr = 0.0;
+  GUID subtype = GUID_NULL;
+  HRESULT hr = m_device->GetCurrentDimensions(&w, &h, &fr, &subtype);
+  if (FAILED(hr)) return hr;
+  outFormat = MakeFormat(subtype, w, h, fr);
+  return S_OK;
+}
+
+bool MediaFoundationBackend::ParseNativeFormat(const std::string& id, CaptureFormat& outFormat) const {
+  GUID subtype;
+  if (!ParseGuid(id, subtype)) return false;
+  outFormat = MakeFormat(subtype, outFormat.width, outFormat.height, outFormat.frameRate);
+  return true;
+}
+
+HRESULT MediaFoundationBackend::SetOutputFormat(PixelFormat format) {
+  if (!m_device) return CAPTURE_E_NOT_READY;
+  return m_device->SetOutputFormat(format);
+}
+
+HRESULT MediaFoundationBackend::StartCapture() {
+  if (!m_device || !m_activate) return CAPTURE_E_NOT_READY;
+  ComScope com;
+  EncodingParameters params = {0, 0};
+  return m_device->StartCapture(m_activate, params);
+}
+
+HRESULT MediaFoundationBackend::StopCapture() {
+  if (!m_device) return S_OK;
+  return m_device->EndCaptureSession();
+}
+
+void MediaFoundationBackend::SetFrameCallback(std::function<void(FramePtr)> cb) {
+  if (m_device) m_device->SetFrameCallback(std::move(cb));
+}
+
+void MediaFoundationBackend::SetFrameGate(FrameGate gate) {
+  if (m_device) m_device->SetFrameGate(std::move(gate));
+}
+
+void MediaFoundationBackend::SetFrameTap(FrameTap tap) {
+  if (m_device) m_device->SetFrameTap(std::move(tap));
+}
+
+void MediaFoundationBackend::SetFrameDestination(std::shared_ptr<FrameDestination> destination) {
+  if (m_device) m_device->SetFrameDestination(std::move(destination));
+}
+
+void MediaFoundationBackend::SetMaxInFlightFrames(size_t maxInFlight) {
+  if (m_device) m_device->SetMaxInFlightFrames(maxInFlight);
+}
+
+void MediaFoundationBackend::SetConversionThreads(size_t threads, size_t bandHeight) {
+  if (m_device) m_device->SetConversionThreads(threads, bandHeight);
+}
+
+void MediaFoundationBackend::SetJpegOptions(const JpegOptions& options) {
+  if (m_device) m_device->SetJpegOptions(options);
+}
+
+FramePoolStats MediaFoundationBackend::GetFramePoolStats() const {
+  return m_device ? m_device->GetFramePoolStats() : FramePoolStats();
+}
+
+ProcessingStageStats MediaFoundationBackend::GetProcessingStats() const {
+  return m_device ? m_device->GetProcessingStats() : ProcessingStageStats();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "capture.h"
+#include "capture_backend.h"
+
+// Windows backend on top of CCapture (Media Foundation source reader). Native
+// formats carry their subtype GUID in CaptureFormat::guid, so subtypes
+// without a PixelFormat can still be selected.
+class MediaFoundationBackend : public CaptureBackend {
+ public:
+  MediaFoundationBackend();
+  ~MediaFoundationBackend() override;
+
+  const char* Name() const override { return "mediafoundation"; }
+
+  HRESULT EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) override;
+  HRESULT ClaimDevice(const std::string& identifier) override;
+  HRESULT ReleaseDevice() override;
+  HRESULT GetClaimedDevice(CaptureDeviceInfo& outDevice) override;
+
+  HRESULT GetSupportedFormats(std::vector<CaptureFormat>& outFormats) override;
+  HRESULT SetFormat(const CaptureFormat& format) override;
+  HRESULT GetCurrentFormat(CaptureFormat& outFormat) override;
+  bool ParseNativeFormat(const std::string& id, CaptureFormat& outFormat) const override;
+  HRESULT SetOutputFormat(PixelFormat format) override;
+
+  HRESULT StartCapture() override;
+  HRESULT StopCapture() override;
+
+  void SetFrameCallback(std::function<void(FramePtr)> cb) override;
+  void SetFrameGate(FrameGate gate) override;
+  void SetFrameTap(FrameTap tap) override;
+  void SetFrameDestination(std::shared_ptr<FrameDestination> destination) override;
+  void SetMaxInFlightFrames(size_t maxInFlight) override;
+  void SetConversionThreads(size_t threads, size_t bandHeight) override;
+  void SetJpegOptions(const JpegOptions& options) override;
+  FramePoolStats GetFramePoolStats() const override;
+  ProcessingStageStats GetProcessingStats() const override;
+
+ private:
+  CCapture* m_device = nullptr;
+  // Activation object of the claimed device (AddRef'd)
+  IMFActivate* m_activate = nullptr;
+};
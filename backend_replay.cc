@@ -0,0 +1,274 @@
+#include "backend_replay.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const double kMaxFrameRate = 1000.0;
+
+bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+  }
+  return true;
+}
+
+std::string BaseName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+}  // namespace
+
+ReplayCaptureBackend::ReplayCaptureBackend() : m_pool(FramePool::Create()), m_converter(m_pool) {
+}
+
+ReplayCaptureBackend::~ReplayCaptureBackend() {
+  StopCapture();
+}
+
+HRESULT ReplayCaptureBackend::EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) {
+  outDevices.clear();
+  const char* path = std::getenv(kPathVariable);
+  if (path && *path) outDevices.push_back({"Replay: " + BaseName(path), path});
+  return S_OK;
+}
+
+HRESULT ReplayCaptureBackend::ClaimDevice(const std::string& identifier) {
+  ReleaseDevice();
+  std::lock_guard<std::mutex> lock(m_lock);
+  HRESULT hr = m_recording.Open(identifier);
+  if (FAILED(hr)) return hr;
+  if (m_recording.Frames().empty()) {
+    m_recording.Close();
+    return E_INVALIDARG;
+  }
+  m_device = {"Replay: " + BaseName(identifier), identifier};
+  m_rate = m_recording.Format().frameRate;
+  return S_OK;
+}
+
+HRESULT ReplayCaptureBackend::ReleaseDevice() {
+  StopCapture();
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_recording.Close();
+  m_device = CaptureDeviceInfo();
+  m_rate = 0.0;
+  m_callback.reset();
+  m_tap = nullptr;
+  m_converter.SetOutputFormat(PixelFormat::Unknown);
+  m_converter.Reset();
+  m_pool->Trim();
+  return S_OK;
+}
+
+HRESULT ReplayCaptureBackend::GetClaimedDevice(CaptureDeviceInfo& outDevice) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_recording.IsOpen()) return CAPTURE_E_NOT_READY;
+  outDevice = m_device;
+  return S_OK;
+}
+
+HRESULT ReplayCaptureBackend::GetSupportedFormats(std::vector<CaptureFormat>& outFormats) {
+  outFormats.clear();
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_recording.IsOpen()) return CAPTURE_E_NOT_READY;
+  CaptureFormat unpaced = m_recording.Format();
+  unpaced.frameRate = 0.0;
+  outFormats.push_back(unpaced);
+  if (m_recording.Format().frameRate > 0.0) outFormats.push_back(m_recording.Format());
+  return S_OK;
+}
+
+HRESULT ReplayCaptureBackend::SetFormat(const CaptureFormat& format) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_recording.IsOpen()) return CAPTURE_E_NOT_READY;
+  const CaptureFormat& recorded = m_recording.Format();
+  // Only the rate is selectable; the frames are what they are.
+  bool sameFormat = format.guid.empty() ? format.format == recorded.format : EqualsIgnoreCase(format.guid, recorded.guid) || (recorded.format != PixelFormat::Unknown && EqualsIgnoreCase(format.guid, recorded.subtype));
+  if (!sameFormat || format.width != recorded.width || format.height != recorded.height) return E_INVALIDARG;
+  if (!(format.frameRate >= 0.0 && format.frameRate <= kMaxFrameRate)) return E_INVALIDARG;
+  // Takes effect with the next frame, also while capturing.
+  m_rate = format.frameRate;
+  m_wake.notify_all();
+  return S_OK;
+}
+
+HRESULT ReplayCaptureBackend::GetCurrentFormat(CaptureFormat& outFormat) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_recording.IsOpen()) return CAPTURE_E_NOT_READY;
+  outFormat = m_recording.Format();
+  outFormat.frameRate = m_rate;
+  return S_OK;
+}
+
+bool ReplayCaptureBackend::ParseNativeFormat(const std::string& id, CaptureFormat& outFormat) const {
+  // The recording's native id (an MF GUID, a V4L2 FourCC, ...)
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_recording.IsOpen() || !EqualsIgnoreCase(id, m_recording.Format().guid)) return false;
+  const CaptureFormat& recorded = m_recording.Format();
+  outFormat.format = recorded.format;
+  outFormat.subtype = recorded.subtype;
+  outFormat.guid = recorded.guid;
+  return true;
+}
+
+HRESULT ReplayCaptureBackend::SetOutputFormat(PixelFormat format) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_converter.SetOutputFormat(format);
+  return S_OK;
+}
+
+void ReplayCaptureBackend::SetConversionThreads(size_t threads, size_t bandHeight) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_converter.SetThreads(threads, bandHeight);
+}
+
+void ReplayCaptureBackend::SetJpegOptions(const JpegOptions& options) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_converter.SetJpegOptions(options);
+}
+
+void ReplayCaptureBackend::SetFrameCallback(std::function<void(FramePtr)> cb) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (cb) {
+    m_callback = std::make_shared<const FrameCallback>(std::move(cb));
+  } else {
+    m_callback.reset();
+  }
+}
+
+void ReplayCaptureBackend::SetFrameGate(FrameGate gate) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_gate = std::move(gate);
+}
+
+void ReplayCaptureBackend::SetFrameTap(FrameTap tap) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_tap = std::move(tap);
+}
+
+HRESULT ReplayCaptureBackend::StartCapture() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_recording.IsOpen()) return CAPTURE_E_NOT_READY;
+  if (m_running) return S_OK;
+  if (m_thread.joinable()) m_thread.join();
+  m_running = true;
+  m_thread = std::thread(&ReplayCaptureBackend::ReplayLoop, this);
+  return S_OK;
+}
+
+HRESULT ReplayCaptureBackend::StopCapture() {
+  m_running = false;
+  {
+    // Taking the lock orders the store before a paced wait re-checks it.
+    std::lock_guard<std::mutex> lock(m_lock);
+  }
+  m_wake.notify_all();
+  // Joining guarantees no frame callback runs once this returns.
+  if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id()) m_thread.join();
+  return S_OK;
+}
+
+void ReplayCaptureBackend::ReplayLoop() {
+  std::unique_lock<std::mutex> lock(m_lock);
+  const std::vector<FrameRecording::Entry>& frames = m_recording.Frames();
+  const size_t count = frames.size();
+  const double recordedRate = m_recording.Format().frameRate;
+  // One pass of the recording, plus one average frame interval so the loop
+  // seam keeps the recorded cadence.
+  const double spanUs = static_cast<double>(frames.back().timestampUs - frames.front().timestampUs);
+  const double loopUs = count > 1 ? spanUs * count / (count - 1) : (recordedRate > 0.0 ? 1e6 / recordedRate : 0.0);
+
+  m_stamper.Reset();
+  Clock::time_point epoch = Clock::now();  // time of position `base`
+  double baseUs = 0.0;                     // recording time at `epoch`
+  double positionUs = 0.0;                 // recording time of frame `index`
+  double rate = -1.0;
+  size_t index = 0;
+
+  while (m_running) {
+    if (m_rate != rate) {
+      // (Re)start pacing from the current frame after a rate change
+      rate = m_rate;
+      epoch = Clock::now();
+      baseUs = positionUs;
+    }
+    if (rate > 0.0) {
+      // Recorded timing, scaled by rate / recorded rate
+      const double speed = recordedRate > 0.0 ? rate / recordedRate : 1.0;
+      auto due = epoch + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>((positionUs - baseUs) / speed));
+      if (m_wake.wait_until(lock, due, [this, rate] { return !m_running || m_rate != rate; })) continue;
+    }
+
+    const int64_t arrivalUs = MonotonicMicros();
+    if (m_tap) {
+      const CaptureFormat& f = m_recording.Format();
+      FrameInfo raw;
+      raw.deviceTimeUs = static_cast<int64_t>(positionUs);
+      raw.arrivalUs = arrivalUs;
+      raw.format = f.format;
+      raw.width = f.width;
+      raw.height = f.height;
+      try { m_tap(frames[index].data, frames[index].size, raw); } catch (...) {}
+    }
+    FramePtr frame;
+    // Frames the gate refuses are passed over without loading them
+    const bool wanted = !m_gate || m_gate(static_cast<int64_t>(positionUs));
+    HRESULT hr = wanted ? LoadFrame(index, frame) : S_FALSE;
+    if (hr == S_OK && frame) {
+      // Recorded timestamps continue across loops
+      const CaptureFormat& f = m_recording.Format();
+      FrameInfo& info = frame->info;
+      info.format = m_converter.NeedsConversion(f.format) ? m_converter.OutputFormat() : f.format;
+      info.width = f.width;
+      info.height = f.height;
+      info.stride = PixelFormatStride(info.format, info.width);
+      m_stamper.Stamp(info, static_cast<int64_t>(positionUs), arrivalUs);
+    } else if (wanted) {
+      m_stamper.MarkDiscontinuity();
+    }
+    std::shared_ptr<const FrameCallback> callback = m_callback;
+
+    lock.unlock();
+    if (SUCCEEDED(hr) && frame && frame->size > 0 && callback) {
+      try { (*callback)(std::move(frame)); } catch (...) {}
+    }
+    frame.reset();
+    callback.reset();
+    // Unpaced: let setters waiting on m_lock in between frames.
+    if (rate <= 0.0 && wanted) std::this_thread::yield();
+    lock.lock();
+    if (rate <= 0.0 && !wanted) {
+      // Unpaced and refused (a pull with no request waiting): ask the gate
+      // again in a millisecond rather than spinning on it
+      m_wake.wait_for(lock, std::chrono::milliseconds(1), [this, rate] { return !m_running || m_rate != rate; });
+    }
+
+    // Every recorded frame is delivered; a late frame goes out immediately
+    // rather than being skipped, so runs stay comparable.
+    size_t next = index + 1 == count ? 0 : index + 1;
+    positionUs += next == 0 ? loopUs - spanUs : static_cast<double>(frames[next].timestampUs - frames[index].timestampUs);
+    index = next;
+  }
+}
+
+HRESULT ReplayCaptureBackend::LoadFrame(size_t index, FramePtr& outFrame) {
+  const FrameRecording::Entry& entry = m_recording.Frames()[index];
+  const CaptureFormat& f = m_recording.Format();
+  if (m_converter.NeedsConversion(f.format)) {
+    return m_converter.Convert(f.format, entry.data, entry.size, f.width, f.height, outFrame);
+  }
+  outFrame = m_pool->Acquire(entry.size);
+  if (!outFrame) return S_FALSE;  // in-flight cap reached: drop
+  memcpy(outFrame->data(), entry.data, entry.size);
+  return S_OK;
+}
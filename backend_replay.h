@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "capture_backend.h"
+#include "frame_converter.h"
+#include "frame_recording.h"
+
+// Backend that plays a frame recording (see frame_recording.h) back through
+// the normal delivery path, so a captured production stream (MJPEG size
+// bursts, timestamp jitter) becomes a reproducible benchmark on any machine.
+//
+// Devices are recording files: claimDevice takes a path, and enumerate lists
+// the file named by CAMERA_REPLAY_FILE, if set. The recording offers one
+// format at its recorded rate and the same format at rate 0:
+//   - the recorded rate replays with the original inter-frame timing;
+//   - any other positive rate scales that timing (2x the rate = 2x speed);
+//   - 0 delivers frames back to back, as fast as the consumer takes them.
+// Playback loops at the end of the recording until StopCapture.
+class ReplayCaptureBackend : public CaptureBackend {
+ public:
+  static constexpr const char* kPathVariable = "CAMERA_REPLAY_FILE";
+
+  ReplayCaptureBackend();
+  ~ReplayCaptureBackend() override;
+
+  const char* Name() const override { return "replay"; }
+
+  HRESULT EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) override;
+  HRESULT ClaimDevice(const std::string& identifier) override;
+  HRESULT ReleaseDevice() override;
+  HRESULT GetClaimedDevice(CaptureDeviceInfo& outDevice) override;
+
+  HRESULT GetSupportedFormats(std::vector<CaptureFormat>& outFormats) override;
+  HRESULT SetFormat(const CaptureFormat& format) override;
+  HRESULT GetCurrentFormat(CaptureFormat& outFormat) override;
+  bool ParseNativeFormat(const std::string& id, CaptureFormat& outFormat) const override;
+  HRESULT SetOutputFormat(PixelFormat format) override;
+
+  HRESULT StartCapture() override;
+  HRESULT StopCapture() override;
+
+  void SetFrameCallback(std::function<void(FramePtr)> cb) override;
+  void SetFrameGate(FrameGate gate) override;
+  void SetFrameTap(FrameTap tap) override;
+  void SetFrameDestination(std::shared_ptr<FrameDestination> destination) override { m_pool->SetDestination(std::move(destination)); }
+  void SetMaxInFlightFrames(size_t maxInFlight) override { m_pool->SetMaxInFlight(maxInFlight); }
+  void SetConversionThreads(size_t threads, size_t bandHeight) override;
+  void SetJpegOptions(const JpegOptions& options) override;
+  FramePoolStats GetFramePoolStats() const override { return m_pool->GetStats(); }
+
+ private:
+  using FrameCallback = std::function<void(FramePtr)>;
+
+  void ReplayLoop();
+  // Copy (or convert) recorded frame `index` into a pooled frame. Called with
+  // m_lock held. S_FALSE = pool exhausted.
+  HRESULT LoadFrame(size_t index, FramePtr& outFrame);
+
+  mutable std::mutex m_lock;  // guards everything below except m_pool
+  std::condition_variable m_wake;
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+  FrameRecording m_recording;
+  CaptureDeviceInfo m_device;
+  // Playback rate; the recorded rate means original timing, 0 = unpaced
+  double m_rate = 0.0;
+  std::shared_ptr<const FrameCallback> m_callback;
+  // Asked before a recorded frame is loaded (SetFrameGate)
+  FrameGate m_gate;
+  // Shown every recorded frame as it comes up, before the gate (SetFrameTap)
+  FrameTap m_tap;
+  std::shared_ptr<FramePool> m_pool;
+  FrameConverter m_converter;
+  FrameStamper m_stamper;
+};
@@ -0,0 +1,593 @@
+#include "backend_synthetic.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const uint32_t kMaxDimension = 16384;
+const double kMaxFrameRate = 1000.0;
+
+// Colour bars, B,G,R
+const uint8_t kBars[8][3] = {
+    {235, 235, 235},  // white
+    {16, 235, 235},   // yellow
+    {235, 235, 16},   // cyan
+    {16, 235, 16},    // green
+    {235, 16, 235},   // magenta
+    {16, 16, 235},    // red
+    {235, 16, 16},    // blue
+    {16, 16, 16},     // black
+};
+
+uint32_t CellWidth(uint32_t width) {
+  uint32_t cell = (width / 32) & ~7u;
+  return cell < 8 ? 8 : cell;
+}
+
+// One BGR row: the top `value` strip (if `strip`) followed by scrolled bars.
+void RenderRow(uint8_t* row, uint32_t width, uint32_t scroll, bool strip, uint32_t value) {
+  const uint32_t cell = CellWidth(width);
+  for (uint32_t x = 0; x < width; ++x) {
+    const uint8_t* c;
+    static const uint8_t kOne[3] = {255, 255, 255};
+    static const uint8_t kZero[3] = {0, 0, 0};
+    if (strip && x / cell < 32) {
+      c = ((value >> (31 - x / cell)) & 1u) ? kOne : kZero;
+    } else {
+      c = kBars[(static_cast<uint64_t>(x + scroll) % width) * 8 / width];
+    }
+    row[x * 3 + 0] = c[0];
+    row[x * 3 + 1] = c[1];
+    row[x * 3 + 2] = c[2];
+  }
+}
+
+// BT.601 limited range, the matrix the conversion kernels assume
+inline uint8_t RgbToY(int r, int g, int b) {
+  return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+inline uint8_t RgbToU(int r, int g, int b) {
+  return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+inline uint8_t RgbToV(int r, int g, int b) {
+  return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Convert one BGR template row into `format`. For NV12 `out` is the luma row
+// and `chroma` the interleaved UV row (written when non-null).
+void EmitRow(PixelFormat format, const uint8_t* bgr, uint32_t width, uint8_t* out, uint8_t* chroma) {
+  switch (format) {
+    case PixelFormat::RGB32:
+      for (uint32_t x = 0; x < width; ++x) {
+        out[x * 4 + 0] = bgr[x * 3 + 0];
+        out[x * 4 + 1] = bgr[x * 3 + 1];
+        out[x * 4 + 2] = bgr[x * 3 + 2];
+        out[x * 4 + 3] = 255;
+      }
+      break;
+    case PixelFormat::RGB24:
+      memcpy(out, bgr, static_cast<size_t>(width) * 3);
+      break;
+    case PixelFormat::YUY2:
+    case PixelFormat::UYVY:
+    case PixelFormat::NV12:
+      for (uint32_t x = 0; x < width; x += 2) {
+        const uint8_t* p0 = bgr + x * 3;
+        const uint8_t* p1 = bgr + (x + 1) * 3;
+        uint8_t y0 = RgbToY(p0[2], p0[1], p0[0]);
+        uint8_t y1 = RgbToY(p1[2], p1[1], p1[0]);
+        int r = (p0[2] + p1[2] + 1) / 2, g = (p0[1] + p1[1] + 1) / 2, b = (p0[0] + p1[0] + 1) / 2;
+        uint8_t u = RgbToU(r, g, b), v = RgbToV(r, g, b);
+        if (format == PixelFormat::NV12) {
+          out[x] = y0;
+          out[x + 1] = y1;
+          if (chroma) {
+            chroma[x] = u;
+            chroma[x + 1] = v;
+          }
+        } else if (format == PixelFormat::YUY2) {
+          uint8_t* d = out + x * 2;
+          d[0] = y0, d[1] = u, d[2] = y1, d[3] = v;
+        } else {
+          uint8_t* d = out + x * 2;
+          d[0] = u, d[1] = y0, d[2] = v, d[3] = y1;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// Minimal baseline JPEG writer for the synthetic MJPEG stream. The pattern is
+// flat within every 8x8 block, so each block is coded as its DC term alone
+// (4:4:4, one quantizer, the standard DC table and an EOB-only AC table).
+class DcJpegWriter {
+ public:
+  // Upper bound of the encoded size, for leasing the output frame up front.
+  static size_t MaxSize(uint32_t width, uint32_t height) {
+    size_t mcus = static_cast<size_t>((width + 7) / 8) * ((height + 7) / 8);
+    return mcus * 12 + 1024;  // <= 45 bits per MCU, doubled by byte stuffing
+  }
+
+  // `sample(bx, by, ycc)` returns the Y, Cb, Cr value of block (bx, by).
+  template <class Sample>
+  static size_t Encode(uint8_t* out, uint32_t width, uint32_t height, Sample sample) {
+    DcJpegWriter w(out);
+    w.Headers(width, height);
+    int prev[3] = {0, 0, 0};
+    for (uint32_t by = 0; by < (height + 7) / 8; ++by) {
+      for (uint32_t bx = 0; bx < (width + 7) / 8; ++bx) {
+        uint8_t ycc[3];
+        sample(bx, by, ycc);
+        for (int c = 0; c < 3; ++c) {
+          // DCT DC = 8 * (mean - 128); with quantizer 8 that is mean - 128.
+          int dc = ycc[c] - 128;
+          w.PutDc(dc - prev[c]);
+          prev[c] = dc;
+          w.PutBits(0, 1);  // EOB
+        }
+      }
+    }
+    w.Flush();
+    w.Marker(0xD9);
+    return static_cast<size_t>(w.m_out - out);
+  }
+
+ private:
+  explicit DcJpegWriter(uint8_t* out) : m_out(out) {
+  }
+
+  void Byte(uint8_t b) { *m_out++ = b; }
+  void Word(uint16_t v) {
+    Byte(static_cast<uint8_t>(v >> 8));
+    Byte(static_cast<uint8_t>(v));
+  }
+  void Marker(uint8_t m) {
+    Byte(0xFF);
+    Byte(m);
+  }
+
+  void Headers(uint32_t width, uint32_t height) {
+    static const uint8_t kJfif[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    // Standard luminance DC code lengths (ITU T.81 K.3), categories 0..11
+    static const uint8_t kDcBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+    Marker(0xD8);
+    Marker(0xE0);
+    Word(2 + sizeof(kJfif));
+    for (uint8_t b : kJfif) Byte(b);
+    // DQT: table 0, all 8
+    Marker(0xDB);
+    Word(67);
+    Byte(0);
+    for (int i = 0; i < 64; ++i) Byte(8);
+    // SOF0: 8-bit, 3 components, no subsampling, quantizer 0
+    Marker(0xC0);
+    Word(17);
+    Byte(8);
+    Word(static_cast<uint16_t>(height));
+    Word(static_cast<uint16_t>(width));
+    Byte(3);
+    for (uint8_t id = 1; id <= 3; ++id) {
+      Byte(id);
+      Byte(0x11);
+      Byte(0);
+    }
+    // DHT: DC table 0 and an AC table 0 holding only EOB (code '0')
+    Marker(0xC4);
+    Word(2 + 17 + 12 + 17 + 1);
+    Byte(0x00);
+    for (uint8_t b : kDcBits) Byte(b);
+    for (uint8_t v = 0; v < 12; ++v) Byte(v);
+    Byte(0x10);
+    Byte(1);
+    for (int i = 1; i < 16; ++i) Byte(0);
+    Byte(0x00);
+    // SOS: all three components, tables 0/0
+    Marker(0xDA);
+    Word(12);
+    Byte(3);
+    for (uint8_t id = 1; id <= 3; ++id) {
+      Byte(id);
+      Byte(0x00);
+    }
+    Byte(0);
+    Byte(63);
+    Byte(0);
+  }
+
+  void PutBits(uint32_t bits, int count) {
+    m_acc = (m_acc << count) | (bits & ((1u << count) - 1));
+    m_count += count;
+    while (m_count >= 8) {
+      uint8_t b = static_cast<uint8_t>(m_acc >> (m_count - 8));
+      Byte(b);
+      if (b == 0xFF) Byte(0);  // byte stuffing
+      m_count -= 8;
+    }
+  }
+
+  void PutDc(int diff) {
+    // Canonical codes for kDcBits: category 0 is '00', 1..5 are 3 bits, then
+    // one more bit per category.
+    static const uint16_t kCode[12] = {0x0, 0x2, 0x3, 0x4, 0x5, 0x6, 0xE, 0x1E, 0x3E, 0x7E, 0xFE, 0x1FE};
+    static const uint8_t kLen[12] = {2, 3, 3, 3, 3, 3, 4, 5, 6, 7, 8, 9};
+    int magnitude = diff < 0 ? -diff : diff;
+    int category = 0;
+    while (magnitude >> category) ++category;
+    PutBits(kCode[category], kLen[category]);
+    if (category) PutBits(static_cast<uint32_t>(diff < 0 ? diff - 1 : diff), category);
+  }
+
+  void Flush() {
+    if (m_count > 0) PutBits(0x7F, 8 - m_count);  // pad with 1s
+  }
+
+  uint8_t* m_out;
+  uint32_t m_acc = 0;
+  int m_count = 0;
+};
+
+bool IsRenderable(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::NV12:
+    case PixelFormat::YUY2:
+    case PixelFormat::UYVY:
+    case PixelFormat::RGB24:
+    case PixelFormat::RGB32:
+    case PixelFormat::MJPEG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+CaptureFormat MakeFormat(PixelFormat format, uint32_t width, uint32_t height, double frameRate) {
+  CaptureFormat f;
+  f.format = format;
+  f.subtype = PixelFormatName(format);
+  f.guid = f.subtype;
+  f.width = width;
+  f.height = height;
+  f.frameRate = frameRate;
+  return f;
+}
+
+bool EqualsIgnoreCase(const std::string& a, const char* b) {
+  size_t n = strlen(b);
+  if (a.size() != n) return false;
+  for (size_t i = 0; i < n; ++i) {
+    if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+SyntheticCaptureBackend::SyntheticCaptureBackend()
+    : m_format(MakeFormat(PixelFormat::NV12, 640, 480, 30.0)),
+      m_pool(FramePool::Create()),
+      m_staging(FramePool::Create(kProcessingDepth + 2)),
+      m_converter(m_pool),
+      m_stage(kProcessingDepth, [this](RenderedFrame& rendered) { ProcessFrame(rendered); }) {
+}
+
+SyntheticCaptureBackend::~SyntheticCaptureBackend() {
+  StopCapture();
+}
+
+HRESULT SyntheticCaptureBackend::EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) {
+  outDevices.clear();
+  outDevices.push_back({kFriendlyName, kSymbolicLink});
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::ClaimDevice(const std::string& identifier) {
+  if (!EqualsIgnoreCase(identifier, kFriendlyName) && !EqualsIgnoreCase(identifier, kSymbolicLink)) {
+    return CAPTURE_E_NOT_FOUND;
+  }
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_claimed = true;
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::ReleaseDevice() {
+  StopCapture();
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_claimed = false;
+  m_callback.reset();
+  m_tap.reset();
+  m_format = MakeFormat(PixelFormat::NV12, 640, 480, 30.0);
+  m_outputFormat = PixelFormat::Unknown;
+  m_rows.clear();
+  m_pool->Trim();
+  m_staging->Trim();
+  std::lock_guard<std::mutex> processLock(m_processLock);
+  m_converter.SetOutputFormat(PixelFormat::Unknown);
+  m_converter.Reset();
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::GetClaimedDevice(CaptureDeviceInfo& outDevice) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_claimed) return CAPTURE_E_NOT_READY;
+  outDevice = {kFriendlyName, kSymbolicLink};
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::GetSupportedFormats(std::vector<CaptureFormat>& outFormats) {
+  outFormats.clear();
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_claimed) return CAPTURE_E_NOT_READY;
+  }
+  static const uint32_t kSizes[][2] = {{320, 240}, {640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+  static const double kRates[] = {30.0, 60.0};
+  static const PixelFormat kFormats[] = {PixelFormat::MJPEG, PixelFormat::NV12, PixelFormat::YUY2, PixelFormat::RGB32};
+  // Sorted by size, then rate (the order getSupportedFormats reports)
+  for (const auto& size : kSizes) {
+    for (double rate : kRates) {
+      for (PixelFormat format : kFormats) outFormats.push_back(MakeFormat(format, size[0], size[1], rate));
+    }
+  }
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::SetFormat(const CaptureFormat& format) {
+  PixelFormat pixelFormat = format.format;
+  if (!format.guid.empty() && !ParsePixelFormat(format.guid, pixelFormat)) return E_INVALIDARG;
+  if (!IsRenderable(pixelFormat)) return E_INVALIDARG;
+  if (format.width == 0 || format.height == 0 || format.width > kMaxDimension || format.height > kMaxDimension) return E_INVALIDARG;
+  if (!(format.frameRate >= 0.0 && format.frameRate <= kMaxFrameRate)) return E_INVALIDARG;
+  const bool yuv = pixelFormat == PixelFormat::NV12 || pixelFormat == PixelFormat::YUY2 || pixelFormat == PixelFormat::UYVY;
+  if (yuv && (format.width % 2 != 0 || (pixelFormat == PixelFormat::NV12 && format.height % 2 != 0))) return E_INVALIDARG;
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_claimed) return CAPTURE_E_NOT_READY;
+  // Takes effect with the next rendered frame, also while capturing.
+  m_format = MakeFormat(pixelFormat, format.width, format.height, format.frameRate);
+  m_wake.notify_all();
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::GetCurrentFormat(CaptureFormat& outFormat) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_claimed) return CAPTURE_E_NOT_READY;
+  outFormat = m_format;
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::SetOutputFormat(PixelFormat format) {
+  // Travels with each rendered frame; applies from the next one
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_outputFormat = format;
+  return S_OK;
+}
+
+void SyntheticCaptureBackend::SetConversionThreads(size_t threads, size_t bandHeight) {
+  std::lock_guard<std::mutex> lock(m_processLock);
+  m_converter.SetThreads(threads, bandHeight);
+}
+
+void SyntheticCaptureBackend::SetJpegOptions(const JpegOptions& options) {
+  std::lock_guard<std::mutex> lock(m_processLock);
+  m_converter.SetJpegOptions(options);
+}
+
+void SyntheticCaptureBackend::SetFrameCallback(std::function<void(FramePtr)> cb) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (cb) {
+    m_callback = std::make_shared<const FrameCallback>(std::move(cb));
+  } else {
+    m_callback.reset();
+  }
+}
+
+void SyntheticCaptureBackend::SetFrameGate(FrameGate gate) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_gate = std::move(gate);
+}
+
+void SyntheticCaptureBackend::SetFrameTap(FrameTap tap) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (tap) {
+    m_tap = std::make_shared<const FrameTap>(std::move(tap));
+  } else {
+    m_tap.reset();
+  }
+}
+
+HRESULT SyntheticCaptureBackend::StartCapture() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_claimed) return CAPTURE_E_NOT_READY;
+  if (m_running) return S_OK;
+  if (m_thread.joinable()) m_thread.join();  // a loop that exited on its own
+  m_stamper.Reset();  // the stage is stopped
+  m_stage.Start();
+  m_running = true;
+  m_thread = std::thread(&SyntheticCaptureBackend::CaptureLoop, this);
+  return S_OK;
+}
+
+HRESULT SyntheticCaptureBackend::StopCapture() {
+  m_running = false;
+  {
+    // Taking the lock orders the store before a paced wait re-checks it.
+    std::lock_guard<std::mutex> lock(m_lock);
+  }
+  m_wake.notify_all();
+  if (m_thread.get_id() == std::this_thread::get_id()) return S_OK;
+  if (m_thread.joinable()) m_thread.join();
+  // With the renderer gone nothing pushes; stopping the stage guarantees no
+  // frame callback runs once this returns.
+  m_stage.Stop();
+  return S_OK;
+}
+
+void SyntheticCaptureBackend::CaptureLoop() {
+  const Clock::time_point start = Clock::now();
+  Clock::time_point epoch = start;  // time of frame `base`
+  uint32_t base = 0;
+  double rate = -1.0;
+  uint32_t index = 0;
+  uint32_t next = 0;  // index that follows the last rendered frame
+
+  std::unique_lock<std::mutex> lock(m_lock);
+  bool gap = false;  // a frame was dropped since the last hand-over
+  while (m_running) {
+    if (m_format.frameRate != rate) {
+      // (Re)start pacing from the current frame after a rate change
+      rate = m_format.frameRate;
+      epoch = Clock::now();
+      base = index;
+    }
+    if (rate > 0.0) {
+      auto due = epoch + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((index - base) / rate));
+      if (m_wake.wait_until(lock, due, [this, rate] { return !m_running || m_format.frameRate != rate; })) continue;
+    }
+
+    const int64_t arrivalUs = MonotonicMicros();
+    const int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    RenderedFrame rendered;
+    std::shared_ptr<const FrameTap> tap = m_tap;
+    // A frame nobody wants (not even the tap) is not rendered; it is not a
+    // gap either
+    const bool wanted = !m_gate || m_gate(elapsedUs);
+    HRESULT hr = wanted || tap ? RenderFrame(index, static_cast<uint32_t>(elapsedUs / 1000), rendered.frame) : S_FALSE;
+    if (hr == S_OK && rendered.frame) {
+      FrameInfo& info = rendered.frame->info;
+      info.format = m_format.format;
+      info.width = m_format.width;
+      info.height = m_format.height;
+      info.stride = PixelFormatStride(info.format, info.width);
+      rendered.outputFormat = m_outputFormat;
+      // Render time is the "device" clock; skipped frame numbers are a gap
+      rendered.deviceTimeUs = elapsedUs;
+      rendered.arrivalUs = arrivalUs;
+      rendered.discontinuity = gap || index != next;
+      rendered.callback = m_callback;
+    }
+    next = index + 1;
+
+    lock.unlock();
+    if (tap && rendered.frame) {
+      FrameInfo raw = rendered.frame->info;
+      raw.deviceTimeUs = elapsedUs;
+      raw.arrivalUs = arrivalUs;
+      try { (*tap)(rendered.frame->data(), rendered.frame->size, raw); } catch (...) {}
+    }
+    if (!wanted) rendered.frame.reset();
+    if (rendered.frame) {
+      // Paced, a full stage drops the frame as a camera would; unpaced, the
+      // renderer waits for room instead.
+      while (rate <= 0.0 && m_running && m_stage.Full()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+      gap = !m_stage.Push(std::move(rendered));
+    } else if (wanted) {
+      gap = true;
+    }
+    rendered = RenderedFrame();
+    // Unpaced: let setters waiting on m_lock in between frames.
+    if (rate <= 0.0 && wanted) std::this_thread::yield();
+    lock.lock();
+    if (rate <= 0.0 && !wanted) {
+      // Unpaced and refused (a pull with no request waiting): ask the gate
+      // again in a millisecond rather than spinning on it
+      m_wake.wait_for(lock, std::chrono::milliseconds(1), [this, rate] { return !m_running || m_format.frameRate != rate; });
+    }
+
+    ++index;
+    if (rate > 0.0) {
+      // Behind schedule by more than a frame: skip the missed frame numbers.
+      double elapsed = std::chrono::duration<double>(Clock::now() - epoch).count();
+      uint32_t onTime = base + static_cast<uint32_t>(elapsed * rate);
+      if (onTime > index) index = onTime;
+    }
+  }
+}
+
+void SyntheticCaptureBackend::ProcessFrame(RenderedFrame& rendered) {
+  FramePtr frame = std::move(rendered.frame);
+  const FrameInfo native = frame->info;
+  std::unique_lock<std::mutex> lock(m_processLock);
+  m_converter.SetOutputFormat(rendered.outputFormat);
+  if (m_converter.NeedsConversion(native.format)) {
+    FramePtr converted;
+    HRESULT hr = m_converter.Convert(native.format, frame->data(), frame->size, native.width, native.height, converted);
+    frame.reset();  // back to the staging pool
+    if (hr == S_OK && converted && converted->size > 0) {
+      frame = std::move(converted);
+      frame->info = native;
+      frame->info.format = rendered.outputFormat;
+      frame->info.stride = PixelFormatStride(rendered.outputFormat, native.width);
+    }
+  }
+  if (!frame) {
+    m_stamper.MarkDiscontinuity();
+    return;
+  }
+  m_stamper.Stamp(frame->info, rendered.deviceTimeUs, rendered.arrivalUs, rendered.discontinuity);
+  lock.unlock();
+  if (frame->size > 0 && rendered.callback) (*rendered.callback)(std::move(frame));
+}
+
+HRESULT SyntheticCaptureBackend::RenderFrame(uint32_t index, uint32_t millis, FramePtr& outFrame) {
+  const PixelFormat format = m_format.format;
+  const uint32_t width = m_format.width, height = m_format.height;
+  const size_t rowBytes = static_cast<size_t>(width) * 3;
+  const uint32_t scroll = static_cast<uint32_t>((static_cast<uint64_t>(index) * 4) % width);
+
+  // Three distinct rows per frame: frame number strip, time strip, bars.
+  m_rows.resize(rowBytes * 3);
+  uint8_t* rowIndex = m_rows.data();
+  uint8_t* rowTime = rowIndex + rowBytes;
+  uint8_t* rowBars = rowTime + rowBytes;
+  RenderRow(rowIndex, width, scroll, true, index);
+  RenderRow(rowTime, width, scroll, true, millis);
+  RenderRow(rowBars, width, scroll, false, 0);
+  auto templateFor = [&](uint32_t y) -> const uint8_t* { return y < 8 ? rowIndex : (y < 16 ? rowTime : rowBars); };
+
+  const bool convert = m_outputFormat != PixelFormat::Unknown && format != m_outputFormat;
+  size_t size = format == PixelFormat::MJPEG ? DcJpegWriter::MaxSize(width, height) : PixelFormatFrameSize(format, width, height);
+  // Rendered straight into pooled storage; a null lease means the in-flight
+  // cap (or the stage's staging depth) is reached: drop the frame.
+  outFrame = (convert ? m_staging : m_pool)->Acquire(size);
+  if (!outFrame) return S_FALSE;
+  uint8_t* out = outFrame->data();
+
+  if (format == PixelFormat::MJPEG) {
+    size = DcJpegWriter::Encode(out, width, height, [&](uint32_t bx, uint32_t by, uint8_t ycc[3]) {
+      const uint8_t* p = templateFor(std::min(by * 8 + 4, height - 1)) + std::min(bx * 8 + 4, width - 1) * 3;
+      int b = p[0], g = p[1], r = p[2];
+      // JFIF full-range YCbCr
+      ycc[0] = static_cast<uint8_t>((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+      ycc[1] = static_cast<uint8_t>(std::max(0, std::min(255, ((-11059 * r - 21709 * g + 32768 * b + 32768) >> 16) + 128)));
+      ycc[2] = static_cast<uint8_t>(std::max(0, std::min(255, ((32768 * r - 27439 * g - 5329 * b + 32768) >> 16) + 128)));
+    });
+  } else {
+    const size_t stride = format == PixelFormat::RGB32 ? width * 4u : (format == PixelFormat::RGB24 ? width * 3u : (format == PixelFormat::NV12 ? width : width * 2u));
+    uint8_t* chroma = out + static_cast<size_t>(width) * height;  // NV12 UV plane
+    // Render each template once, then replicate it down its rows.
+    uint32_t y = 0;
+    while (y < height) {
+      uint32_t end = y < 8 ? 8 : (y < 16 ? 16 : height);
+      if (end > height) end = height;
+      uint8_t* first = out + y * stride;
+      EmitRow(format, templateFor(y), width, first, format == PixelFormat::NV12 ? chroma + (y / 2) * static_cast<size_t>(width) : nullptr);
+      for (uint32_t r = y + 1; r < end; ++r) {
+        memcpy(out + r * stride, first, stride);
+        if (format == PixelFormat::NV12 && r % 2 == 0) memcpy(chroma + (r / 2) * static_cast<size_t>(width), chroma + (y / 2) * static_cast<size_t>(width), width);
+      }
+      y = end;
+    }
+  }
+
+  outFrame->size = size;
+  return S_OK;
+}
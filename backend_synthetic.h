@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "capture_backend.h"
+#include "frame_converter.h"
+#include "processing_stage.h"
+
+// Built-in backend that renders test patterns instead of reading a camera, so
+// the whole delivery path (frame pool, conversion, queue, N-API) can run and
+// be load-tested on machines without one, including headless CI.
+//
+// Every frame carries its own number and timestamp. The two strips sit on
+// 8-pixel boundaries, so they survive the blockwise MJPEG encoding intact:
+//   rows  0..7   frame number, 32 cells MSB first, white = 1
+//   rows  8..15  milliseconds since StartCapture, same encoding
+//   rows 16..    eight colour bars (white, yellow, cyan, green, magenta, red,
+//                blue, black) scrolling left by 4 pixels per frame
+// A cell is width / 32 pixels rounded down to a multiple of 8 (at least 8).
+//
+// SetFormat accepts any size (even for YUV formats) and any rate; rate 0
+// renders frames back to back. When the renderer falls behind the requested
+// rate it skips frame numbers, as a camera would.
+//
+// Like the Media Foundation backend, rendering (the "device") and conversion
+// plus delivery run on separate threads joined by a ProcessingStage, so its
+// hand-off latency and throughput can be measured without a camera.
+class SyntheticCaptureBackend : public CaptureBackend {
+ public:
+  static constexpr const char* kFriendlyName = "Synthetic Camera";
+  static constexpr const char* kSymbolicLink = "synthetic://camera0";
+
+  SyntheticCaptureBackend();
+  ~SyntheticCaptureBackend() override;
+
+  const char* Name() const override { return "synthetic"; }
+
+  HRESULT EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) override;
+  HRESULT ClaimDevice(const std::string& identifier) override;
+  HRESULT ReleaseDevice() override;
+  HRESULT GetClaimedDevice(CaptureDeviceInfo& outDevice) override;
+
+  HRESULT GetSupportedFormats(std::vector<CaptureFormat>& outFormats) override;
+  HRESULT SetFormat(const CaptureFormat& format) override;
+  HRESULT GetCurrentFormat(CaptureFormat& outFormat) override;
+  HRESULT SetOutputFormat(PixelFormat format) override;
+
+  HRESULT StartCapture() override;
+  HRESULT StopCapture() override;
+
+  void SetFrameCallback(std::function<void(FramePtr)> cb) override;
+  void SetFrameGate(FrameGate gate) override;
+  void SetFrameTap(FrameTap tap) override;
+  void SetFrameDestination(std::shared_ptr<FrameDestination> destination) override { m_pool->SetDestination(std::move(destination)); }
+  void SetMaxInFlightFrames(size_t maxInFlight) override { m_pool->SetMaxInFlight(maxInFlight); }
+  void SetConversionThreads(size_t threads, size_t bandHeight) override;
+  void SetJpegOptions(const JpegOptions& options) override;
+  FramePoolStats GetFramePoolStats() const override { return m_pool->GetStats(); }
+  ProcessingStageStats GetProcessingStats() const override { return m_stage.GetStats(); }
+
+ private:
+  using FrameCallback = std::function<void(FramePtr)>;
+
+  // Frames rendered ahead of the processing stage
+  static const size_t kProcessingDepth = 4;
+
+  // A rendered native frame on its way to the processing stage
+  struct RenderedFrame {
+    FramePtr frame;
+    PixelFormat outputFormat = PixelFormat::Unknown;  // Unknown = as rendered
+    int64_t deviceTimeUs = 0;
+    int64_t arrivalUs = 0;
+    bool discontinuity = false;
+    std::shared_ptr<const FrameCallback> callback;
+  };
+
+  void CaptureLoop();
+  // Render frame `index` in the current format. Frames that will be
+  // converted go to the staging pool, the rest straight to m_pool. Called
+  // with m_lock held. S_FALSE = pool exhausted.
+  HRESULT RenderFrame(uint32_t index, uint32_t millis, FramePtr& outFrame);
+  // Processing stage handler: convert, stamp and deliver.
+  void ProcessFrame(RenderedFrame& rendered);
+
+  mutable std::mutex m_lock;  // guards the members up to m_rows, except the pools
+  std::condition_variable m_wake;
+  std::thread m_thread;
+  bool m_claimed = false;
+  // Atomic so StopCapture takes effect even while an unpaced loop keeps
+  // re-taking m_lock.
+  std::atomic<bool> m_running{false};
+  CaptureFormat m_format;
+  PixelFormat m_outputFormat = PixelFormat::Unknown;
+  // Held through a shared_ptr so the stage can call it unlocked.
+  std::shared_ptr<const FrameCallback> m_callback;
+  // Asked before a frame is rendered, with m_lock held (SetFrameGate)
+  FrameGate m_gate;
+  // Shown every rendered frame, called unlocked (SetFrameTap)
+  std::shared_ptr<const FrameTap> m_tap;
+  std::shared_ptr<FramePool> m_pool;
+  // Native frames awaiting conversion; sized to the stage so they never
+  // count against the caller's in-flight cap
+  std::shared_ptr<FramePool> m_staging;
+  // BGR row templates (frame number, time, bars)
+  std::vector<uint8_t> m_rows;
+
+  std::mutex m_processLock;  // guards the converter and the stamper
+  FrameConverter m_converter;
+  FrameStamper m_stamper;
+  // Last member: stopped before the state its handler uses is destroyed.
+  ProcessingStage<RenderedFrame> m_stage;
+};
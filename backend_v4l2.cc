@@ -0,0 +1,702 @@
+#include "backend_v4l2.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+int SysOpen(const char* path, int flags) {
+  return ::open(path, flags);
+}
+int SysIoctl(int fd, unsigned long request, void* arg) {
+  return ::ioctl(fd, request, arg);
+}
+
+struct FourccEntry {
+  uint32_t fourcc;
+  PixelFormat format;
+};
+
+// Known FourCCs, preferred first for each PixelFormat. Formats without a
+// PixelFormat are listed so their ids round-trip through ParseNativeFormat.
+const FourccEntry kFourccs[] = {
+    {V4L2_PIX_FMT_NV12, PixelFormat::NV12},
+    {V4L2_PIX_FMT_YUYV, PixelFormat::YUY2},
+    {V4L2_PIX_FMT_UYVY, PixelFormat::UYVY},
+    {V4L2_PIX_FMT_BGR24, PixelFormat::RGB24},   // B,G,R
+    {V4L2_PIX_FMT_XBGR32, PixelFormat::RGB32},  // B,G,R,X
+    {V4L2_PIX_FMT_ABGR32, PixelFormat::RGB32},  // B,G,R,A
+    {V4L2_PIX_FMT_BGR32, PixelFormat::RGB32},   // deprecated alias of the above
+    {V4L2_PIX_FMT_RGBA32, PixelFormat::RGBA},   // R,G,B,A
+    {V4L2_PIX_FMT_MJPEG, PixelFormat::MJPEG},
+    {V4L2_PIX_FMT_JPEG, PixelFormat::MJPEG},
+    {V4L2_PIX_FMT_YUV420, PixelFormat::IYUV},
+    {V4L2_PIX_FMT_H264, PixelFormat::Unknown},
+};
+
+bool LookupFourcc(uint32_t fourcc, PixelFormat& out) {
+  for (const auto& e : kFourccs) {
+    if (e.fourcc == fourcc) {
+      out = e.format;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string FourccToString(uint32_t fourcc) {
+  std::string s(4, ' ');
+  for (int i = 0; i < 4; ++i) {
+    char c = static_cast<char>((fourcc >> (8 * i)) & 0xFF);
+    s[i] = isprint(static_cast<unsigned char>(c)) ? c : '?';
+  }
+  // Trailing spaces are padding ("Y10 " -> "Y10")
+  while (!s.empty() && s.back() == ' ') s.pop_back();
+  return s;
+}
+
+bool StringToFourcc(const std::string& s, uint32_t& out) {
+  if (s.empty() || s.size() > 4) return false;
+  char c[4] = {' ', ' ', ' ', ' '};
+  for (size_t i = 0; i < s.size(); ++i) c[i] = static_cast<char>(toupper(static_cast<unsigned char>(s[i])));
+  out = v4l2_fourcc(c[0], c[1], c[2], c[3]);
+  return true;
+}
+
+CaptureFormat MakeFormat(uint32_t fourcc, uint32_t width, uint32_t height, double frameRate) {
+  CaptureFormat f;
+  PixelFormat format = PixelFormat::Unknown;
+  LookupFourcc(fourcc, format);
+  f.format = format;
+  f.guid = FourccToString(fourcc);
+  // Short friendly name when known, the FourCC otherwise
+  f.subtype = format != PixelFormat::Unknown ? PixelFormatName(format) : f.guid;
+  f.width = width;
+  f.height = height;
+  f.frameRate = frameRate;
+  return f;
+}
+
+HRESULT HResultFromErrno(int err) {
+  switch (err) {
+    case ENOENT:
+    case ENXIO:
+      return CAPTURE_E_NOT_FOUND;
+    case EBUSY:
+      return CAPTURE_E_BUSY;
+    case EACCES:
+    case EPERM:
+      return E_ACCESSDENIED;
+    case ENOMEM:
+      return E_OUTOFMEMORY;
+    case EINVAL:
+    case ERANGE:
+      return E_INVALIDARG;
+    case ENODEV:
+      return CAPTURE_E_NOT_READY;
+    case ENOTTY:
+      return E_NOTIMPL;
+    default:
+      return E_FAIL;
+  }
+}
+
+bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+  }
+  return true;
+}
+
+// Sizes offered for stepwise/continuous frame-size ranges
+const uint32_t kStepwiseSizes[][2] = {{160, 120}, {320, 240}, {640, 480}, {800, 600}, {1024, 768}, {1280, 720}, {1920, 1080}, {2560, 1440}, {3840, 2160}};
+
+}  // namespace
+
+const V4l2Io& DefaultV4l2Io() {
+  static const V4l2Io io = {SysOpen, ::close, SysIoctl, ::mmap, ::munmap, "/dev"};
+  return io;
+}
+
+V4l2CaptureBackend::V4l2CaptureBackend(const V4l2Io& io)
+    : m_io(io), m_pool(FramePool::Create()), m_converter(m_pool) {
+}
+
+V4l2CaptureBackend::~V4l2CaptureBackend() {
+  ReleaseDevice();
+}
+
+int V4l2CaptureBackend::Ioctl(unsigned long request, void* arg) const {
+  int r;
+  do {
+    r = m_io.ioctl(m_fd, request, arg);
+  } while (r == -1 && errno == EINTR);
+  return r;
+}
+
+HRESULT V4l2CaptureBackend::EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) {
+  outDevices.clear();
+  DIR* dir = opendir(m_io.deviceDir);
+  if (!dir) return S_OK;  // no video nodes at all
+  std::vector<std::string> paths;
+  while (struct dirent* entry = readdir(dir)) {
+    if (strncmp(entry->d_name, "video", 5) == 0) paths.push_back(std::string(m_io.deviceDir) + "/" + entry->d_name);
+  }
+  closedir(dir);
+  // /dev/video2 before /dev/video10
+  std::sort(paths.begin(), paths.end(), [](const std::string& a, const std::string& b) {
+    return a.size() != b.size() ? a.size() < b.size() : a < b;
+  });
+
+  for (const auto& path : paths) {
+    int fd = m_io.open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) continue;
+    struct v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    int r;
+    do {
+      r = m_io.ioctl(fd, VIDIOC_QUERYCAP, &cap);
+    } while (r == -1 && errno == EINTR);
+    m_io.close(fd);
+    if (r < 0) continue;
+    // Metadata and output nodes share the video* namespace; keep capture nodes
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) continue;
+    outDevices.push_back({reinterpret_cast<const char*>(cap.card), path});
+  }
+  return S_OK;
+}
+
+HRESULT V4l2CaptureBackend::ClaimDevice(const std::string& identifier) {
+  ReleaseDevice();
+
+  std::vector<CaptureDeviceInfo> devices;
+  EnumerateDevices(devices);
+  const CaptureDeviceInfo* match = nullptr;
+  for (const auto& d : devices) {
+    if (EqualsIgnoreCase(d.friendlyName, identifier) || d.symbolicLink == identifier) {
+      match = &d;
+      break;
+    }
+  }
+  if (!match) return CAPTURE_E_NOT_FOUND;
+
+  int fd = m_io.open(match->symbolicLink.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) return HResultFromErrno(errno);
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_fd = fd;
+  m_device = *match;
+  return S_OK;
+}
+
+HRESULT V4l2CaptureBackend::ReleaseDevice() {
+  StopCapture();
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_fd >= 0) {
+    m_io.close(m_fd);
+    m_fd = -1;
+  }
+  m_device = CaptureDeviceInfo();
+  m_active = ActiveFormat();
+  m_callback.reset();
+  m_tap = nullptr;
+  m_converter.SetOutputFormat(PixelFormat::Unknown);
+  m_converter.Reset();
+  m_pool->Trim();
+  return S_OK;
+}
+
+HRESULT V4l2CaptureBackend::GetClaimedDevice(CaptureDeviceInfo& outDevice) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_fd < 0) return CAPTURE_E_NOT_READY;
+  outDevice = m_device;
+  return S_OK;
+}
+
+HRESULT V4l2CaptureBackend::GetSupportedFormats(std::vector<CaptureFormat>& outFormats) {
+  outFormats.clear();
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_fd < 0) return CAPTURE_E_NOT_READY;
+
+  auto addIntervals = [&](uint32_t fourcc, uint32_t width, uint32_t height) {
+    struct v4l2_frmivalenum ival;
+    memset(&ival, 0, sizeof(ival));
+    ival.pixel_format = fourcc;
+    ival.width = width;
+    ival.height = height;
+    bool any = false;
+    for (ival.index = 0; Ioctl(VIDIOC_ENUM_FRAMEINTERVALS, &ival) == 0; ++ival.index) {
+      if (ival.type == V4L2_FRMIVAL_TYPE_DISCRETE) {
+        if (ival.discrete.numerator != 0) {
+          outFormats.push_back(MakeFormat(fourcc, width, height, static_cast<double>(ival.discrete.denominator) / ival.discrete.numerator));
+          any = true;
+        }
+      } else {
+        // Continuous/stepwise: report the fastest and slowest rates
+        if (ival.stepwise.min.numerator != 0) {
+          outFormats.push_back(MakeFormat(fourcc, width, height, static_cast<double>(ival.stepwise.min.denominator) / ival.stepwise.min.numerator));
+          any = true;
+        }
+        if (ival.stepwise.max.numerator != 0) {
+          outFormats.push_back(MakeFormat(fourcc, width, height, static_cast<double>(ival.stepwise.max.denominator) / ival.stepwise.max.numerator));
+          any = true;
+        }
+        break;
+      }
+    }
+    // Drivers without interval enumeration still capture at some rate
+    if (!any) outFormats.push_back(MakeFormat(fourcc, width, height, 0.0));
+  };
+
+  struct v4l2_fmtdesc desc;
+  memset(&desc, 0, sizeof(desc));
+  desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  for (desc.index = 0; Ioctl(VIDIOC_ENUM_FMT, &desc) == 0; ++desc.index) {
+    struct v4l2_frmsizeenum size;
+    memset(&size, 0, sizeof(size));
+    size.pixel_format = desc.pixelformat;
+    for (size.index = 0; Ioctl(VIDIOC_ENUM_FRAMESIZES, &size) == 0; ++size.index) {
+      if (size.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
+        addIntervals(desc.pixelformat, size.discrete.width, size.discrete.height);
+        continue;
+      }
+      // Stepwise/continuous: common sizes inside the range, plus its bounds
+      const auto& sw = size.stepwise;
+      auto fits = [&sw](uint32_t w, uint32_t h) {
+        if (w < sw.min_width || w > sw.max_width || h < sw.min_height || h > sw.max_height) return false;
+        return (sw.step_width == 0 || (w - sw.min_width) % sw.step_width == 0) && (sw.step_height == 0 || (h - sw.min_height) % sw.step_height == 0);
+      };
+      addIntervals(desc.pixelformat, sw.min_width, sw.min_height);
+      for (const auto& s : kStepwiseSizes) {
+        if (fits(s[0], s[1]) && !(s[0] == sw.min_width && s[1] == sw.min_height) && !(s[0] == sw.max_width && s[1] == sw.max_height)) {
+          addIntervals(desc.pixelformat, s[0], s[1]);
+        }
+      }
+      if (sw.max_width != sw.min_width || sw.max_height != sw.min_height) addIntervals(desc.pixelformat, sw.max_width, sw.max_height);
+      break;
+    }
+  }
+
+  // Same order as the other backends: size, rate, then id
+  std::sort(outFormats.begin(), outFormats.end(), [](const CaptureFormat& a, const CaptureFormat& b) {
+    if (a.width != b.width) return a.width < b.width;
+    if (a.height != b.height) return a.height < b.height;
+    if (a.frameRate != b.frameRate) return a.frameRate < b.frameRate;
+    return a.guid < b.guid;
+  });
+  auto last = std::unique(outFormats.begin(), outFormats.end(), [](const CaptureFormat& a, const CaptureFormat& b) {
+    return a.width == b.width && a.height == b.height && std::fabs(a.frameRate - b.frameRate) < 1e-6 && a.guid == b.guid;
+  });
+  outFormats.erase(last, outFormats.end());
+  return S_OK;
+}
+
+bool V4l2CaptureBackend::ParseNativeFormat(const std::string& id, CaptureFormat& outFormat) const {
+  // Only known FourCCs: short names like "YUY2" or "RGB32" are not V4L2
+  // FourCCs and resolve through ParsePixelFormat instead.
+  uint32_t fourcc = 0;
+  PixelFormat format = PixelFormat::Unknown;
+  if (!StringToFourcc(id, fourcc) || !LookupFourcc(fourcc, format)) return false;
+  outFormat = MakeFormat(fourcc, outFormat.width, outFormat.height, outFormat.frameRate);
+  return true;
+}
+
+uint32_t V4l2CaptureBackend::FourccForFormat(PixelFormat format) const {
+  struct v4l2_fmtdesc desc;
+  memset(&desc, 0, sizeof(desc));
+  desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  for (desc.index = 0; Ioctl(VIDIOC_ENUM_FMT, &desc) == 0; ++desc.index) {
+    PixelFormat f = PixelFormat::Unknown;
+    if (LookupFourcc(desc.pixelformat, f) && f == format) return desc.pixelformat;
+  }
+  // Not offered by the device; let S_FMT reject the preferred FourCC
+  for (const auto& e : kFourccs) {
+    if (e.format == format) return e.fourcc;
+  }
+  return 0;
+}
+
+HRESULT V4l2CaptureBackend::SetFormat(const CaptureFormat& format) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_fd < 0) return CAPTURE_E_NOT_READY;
+  // Buffers are sized for the current format while streaming
+  if (m_running) return CAPTURE_E_BUSY;
+
+  uint32_t fourcc = 0;
+  PixelFormat named = PixelFormat::Unknown;
+  if (!format.guid.empty()) {
+    PixelFormat known;
+    if (!(StringToFourcc(format.guid, fourcc) && LookupFourcc(fourcc, known))) {
+      if (!ParsePixelFormat(format.guid, named)) {
+        // An arbitrary FourCC reported by GetSupportedFormats
+        if (!StringToFourcc(format.guid, fourcc)) return E_INVALIDARG;
+      } else {
+        fourcc = FourccForFormat(named);
+      }
+    }
+  } else {
+    fourcc = FourccForFormat(format.format);
+  }
+  if (fourcc == 0 || format.width == 0 || format.height == 0) return E_INVALIDARG;
+
+  struct v4l2_format fmt;
+  memset(&fmt, 0, sizeof(fmt));
+  fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  fmt.fmt.pix.width = format.width;
+  fmt.fmt.pix.height = format.height;
+  fmt.fmt.pix.pixelformat = fourcc;
+  fmt.fmt.pix.field = V4L2_FIELD_NONE;
+  if (Ioctl(VIDIOC_S_FMT, &fmt) < 0) return HResultFromErrno(errno);
+  // Drivers adjust unsupported requests instead of failing; require an exact
+  // match like the other backends.
+  if (fmt.fmt.pix.pixelformat != fourcc || fmt.fmt.pix.width != format.width || fmt.fmt.pix.height != format.height) return E_INVALIDARG;
+
+  if (format.frameRate > 0.0) {
+    struct v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (Ioctl(VIDIOC_G_PARM, &parm) == 0 && (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+      // 29.97 -> 1000/29970
+      double rounded = std::round(format.frameRate);
+      bool integral = std::fabs(format.frameRate - rounded) < 1e-3;
+      parm.parm.capture.timeperframe.numerator = integral ? 1 : 1000;
+      parm.parm.capture.timeperframe.denominator = static_cast<uint32_t>(integral ? rounded : std::round(format.frameRate * 1000.0));
+      if (Ioctl(VIDIOC_S_PARM, &parm) < 0) return HResultFromErrno(errno);
+    }
+  }
+  return QueryActiveFormat(m_active);
+}
+
+HRESULT V4l2CaptureBackend::QueryActiveFormat(ActiveFormat& out) const {
+  struct v4l2_format fmt;
+  memset(&fmt, 0, sizeof(fmt));
+  fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (Ioctl(VIDIOC_G_FMT, &fmt) < 0) return HResultFromErrno(errno);
+  out.fourcc = fmt.fmt.pix.pixelformat;
+  out.format = PixelFormat::Unknown;
+  LookupFourcc(out.fourcc, out.format);
+  out.width = fmt.fmt.pix.width;
+  out.height = fmt.fmt.pix.height;
+  out.bytesPerLine = fmt.fmt.pix.bytesperline;
+  // Some drivers leave bytesperline 0 for packed formats
+  if (out.bytesPerLine == 0) out.bytesPerLine = PixelFormatStride(out.format, out.width);
+  return S_OK;
+}
+
+HRESULT V4l2CaptureBackend::GetCurrentFormat(CaptureFormat& outFormat) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_fd < 0) return CAPTURE_E_NOT_READY;
+  ActiveFormat active;
+  HRESULT hr = QueryActiveFormat(active);
+  if (FAILED(hr)) return hr;
+  double frameRate = 0.0;
+  struct v4l2_streamparm parm;
+  memset(&parm, 0, sizeof(parm));
+  parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (Ioctl(VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator != 0) {
+    frameRate = static_cast<double>(parm.parm.capture.timeperframe.denominator) / parm.parm.capture.timeperframe.numerator;
+  }
+  outFormat = MakeFormat(active.fourcc, active.width, active.height, frameRate);
+  return S_OK;
+}
+
+HRESULT V4l2CaptureBackend::SetOutputFormat(PixelFormat format) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_converter.SetOutputFormat(format);
+  return S_OK;
+}
+
+void V4l2CaptureBackend::SetConversionThreads(size_t threads, size_t bandHeight) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_converter.SetThreads(threads, bandHeight);
+}
+
+void V4l2CaptureBackend::SetJpegOptions(const JpegOptions& options) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_converter.SetJpegOptions(options);
+}
+
+void V4l2CaptureBackend::SetDeviceBufferCount(size_t count) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_bufferCount = count == 0 ? kDefaultBufferCount : std::min(std::max<size_t>(count, 2), kMaxBufferCount);
+}
+
+void V4l2CaptureBackend::SetFrameCallback(std::function<void(FramePtr)> cb) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (cb) {
+    m_callback = std::make_shared<const FrameCallback>(std::move(cb));
+  } else {
+    m_callback.reset();
+  }
+}
+
+void V4l2CaptureBackend::SetFrameGate(FrameGate gate) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_gate = std::move(gate);
+}
+
+void V4l2CaptureBackend::SetFrameTap(FrameTap tap) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_tap = std::move(tap);
+}
+
+HRESULT V4l2CaptureBackend::MapBuffers(size_t count) {
+  struct v4l2_requestbuffers req;
+  memset(&req, 0, sizeof(req));
+  req.count = static_cast<uint32_t>(count);
+  req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  req.memory = V4L2_MEMORY_MMAP;
+  if (Ioctl(VIDIOC_REQBUFS, &req) < 0) return HResultFromErrno(errno);
+  // The driver may grant fewer (or more) buffers than requested
+  if (req.count < 2) return E_OUTOFMEMORY;
+
+  m_buffers.resize(req.count);
+  for (uint32_t i = 0; i < req.count; ++i) {
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = i;
+    if (Ioctl(VIDIOC_QUERYBUF, &buf) < 0) return HResultFromErrno(errno);
+    void* p = m_io.mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, buf.m.offset);
+    if (p == MAP_FAILED) return HResultFromErrno(errno);
+    m_buffers[i].data = p;
+    m_buffers[i].length = buf.length;
+    if (Ioctl(VIDIOC_QBUF, &buf) < 0) return HResultFromErrno(errno);
+  }
+  return S_OK;
+}
+
+void V4l2CaptureBackend::UnmapBuffers() {
+  for (auto& b : m_buffers) {
+    if (b.data) m_io.munmap(b.data, b.length);
+  }
+  m_buffers.clear();
+  if (m_fd >= 0) {
+    // Free the kernel buffers so the format can change
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    Ioctl(VIDIOC_REQBUFS, &req);
+  }
+}
+
+HRESULT V4l2CaptureBackend::StartCapture() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_fd < 0) return CAPTURE_E_NOT_READY;
+  if (m_running) return S_OK;
+  if (m_thread.joinable()) {
+    // A reader that stopped on device loss or from its own callback
+    m_thread.join();
+    StopStreaming();
+  }
+
+  HRESULT hr = QueryActiveFormat(m_active);
+  if (SUCCEEDED(hr)) hr = MapBuffers(m_bufferCount);
+  if (SUCCEEDED(hr)) {
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeFd < 0) hr = HResultFromErrno(errno);
+  }
+  if (SUCCEEDED(hr)) {
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (Ioctl(VIDIOC_STREAMON, &type) < 0) hr = HResultFromErrno(errno);
+  }
+  if (FAILED(hr)) {
+    UnmapBuffers();
+    if (m_wakeFd >= 0) {
+      ::close(m_wakeFd);
+      m_wakeFd = -1;
+    }
+    return hr;
+  }
+
+  m_stamper.Reset();
+  m_haveSequence = false;
+  m_running = true;
+  m_thread = std::thread(&V4l2CaptureBackend::ReaderLoop, this);
+  return S_OK;
+}
+
+HRESULT V4l2CaptureBackend::StopCapture() {
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_running = false;
+    if (m_wakeFd >= 0) {
+      uint64_t one = 1;
+      ssize_t n = ::write(m_wakeFd, &one, sizeof(one));
+      (void)n;
+    }
+  }
+  // From a frame callback: the reader exits once the callback returns and
+  // still owns the ring; the next StartCapture or ReleaseDevice joins it.
+  if (m_thread.get_id() == std::this_thread::get_id()) return S_OK;
+  if (!m_thread.joinable()) return S_OK;
+  // Joining guarantees no frame callback runs once this returns.
+  m_thread.join();
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  StopStreaming();
+  return S_OK;
+}
+
+void V4l2CaptureBackend::StopStreaming() {
+  if (m_fd >= 0 && !m_buffers.empty()) {
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    Ioctl(VIDIOC_STREAMOFF, &type);
+  }
+  UnmapBuffers();
+  if (m_wakeFd >= 0) {
+    ::close(m_wakeFd);
+    m_wakeFd = -1;
+  }
+}
+
+void V4l2CaptureBackend::ReaderLoop() {
+  int epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (epfd < 0) {
+    m_running = false;
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, m_fd, &ev);
+    ev.data.fd = m_wakeFd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+  }
+
+  while (m_running) {
+    struct epoll_event events[2];
+    int n = epoll_wait(epfd, events, 2, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    bool ready = false;
+    for (int i = 0; i < n; ++i) {
+      if (events[i].data.fd == m_wakeFd) continue;  // StopCapture
+      if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+        // Unplugged (ENODEV from now on): stop; a new claim is required
+        m_running = false;
+      } else if (events[i].events & EPOLLIN) {
+        ready = true;
+      }
+    }
+    if (!ready || !m_running) continue;
+
+    FramePtr frame;
+    std::shared_ptr<const FrameCallback> callback;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      struct v4l2_buffer buf;
+      memset(&buf, 0, sizeof(buf));
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = V4L2_MEMORY_MMAP;
+      if (Ioctl(VIDIOC_DQBUF, &buf) < 0) {
+        if (errno == ENODEV) m_running = false;
+        continue;  // EAGAIN: spurious wakeup
+      }
+      const int64_t arrivalUs = MonotonicMicros();
+      // Driver timestamp (CLOCK_MONOTONIC on current kernels)
+      const int64_t deviceUs = static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000 + buf.timestamp.tv_usec;
+      // The driver numbers every frame it captures; a jump means it dropped some
+      const bool gap = m_haveSequence && buf.sequence != m_nextSequence;
+      m_nextSequence = buf.sequence + 1;
+      m_haveSequence = true;
+      if (gap) m_stamper.MarkDiscontinuity();
+
+      if (buf.index >= m_buffers.size() || (buf.flags & V4L2_BUF_FLAG_ERROR)) {
+        m_stamper.MarkDiscontinuity();
+      } else {
+        const MappedBuffer& mapped = m_buffers[buf.index];
+        const size_t used = std::min<size_t>(buf.bytesused, mapped.length);
+        if (m_tap) {
+          FrameInfo raw;
+          raw.deviceTimeUs = deviceUs;
+          raw.arrivalUs = arrivalUs;
+          raw.format = m_active.format;
+          raw.width = m_active.width;
+          raw.height = m_active.height;
+          raw.stride = PixelFormatStride(raw.format, raw.width) != 0 ? m_active.bytesPerLine : 0;
+          try { m_tap(static_cast<const uint8_t*>(mapped.data), used, raw); } catch (...) {}
+        }
+        if (m_callback && (!m_gate || m_gate(deviceUs))) {
+          HRESULT hr = ProcessBuffer(static_cast<const uint8_t*>(mapped.data), used, frame);
+          if (hr == S_OK && frame) {
+            FrameInfo& info = frame->info;
+            info.format = m_converter.NeedsConversion(m_active.format) ? m_converter.OutputFormat() : m_active.format;
+            info.width = m_active.width;
+            info.height = m_active.height;
+            info.stride = PixelFormatStride(info.format, info.width);  // repacked if padded
+            m_stamper.Stamp(info, deviceUs, arrivalUs);
+            callback = m_callback;
+          } else {
+            m_stamper.MarkDiscontinuity();
+          }
+        }
+      }
+      // Hand the buffer straight back; the frame no longer references it.
+      Ioctl(VIDIOC_QBUF, &buf);
+    }
+
+    if (frame && frame->size > 0 && callback) {
+      try { (*callback)(std::move(frame)); } catch (...) {}
+    }
+  }
+  ::close(epfd);
+}
+
+HRESULT V4l2CaptureBackend::ProcessBuffer(const uint8_t* data, size_t bytesUsed, FramePtr& outFrame) {
+  const ActiveFormat& f = m_active;
+  const size_t packedSize = PixelFormatFrameSize(f.format, f.width, f.height);
+
+  if (packedSize == 0) {
+    // Compressed (MJPEG, H264, ...): the payload is bytesused long
+    if (bytesUsed == 0) return E_UNEXPECTED;
+    if (m_converter.NeedsConversion(f.format)) {
+      return m_converter.Convert(f.format, data, bytesUsed, f.width, f.height, outFrame);
+    }
+    outFrame = m_pool->Acquire(bytesUsed);
+    if (!outFrame) return S_FALSE;  // in-flight cap reached: drop
+    memcpy(outFrame->data(), data, bytesUsed);
+    return S_OK;
+  }
+
+  // Raw formats: rows may be padded to bytesperline
+  const bool tight = f.bytesPerLine == PixelFormatStride(f.format, f.width);
+  if (bytesUsed < PixelFormatStridedFrameSize(f.format, f.bytesPerLine, f.height)) return E_UNEXPECTED;
+
+  if (m_converter.NeedsConversion(f.format)) {
+    // Padded rows are read in place by the converter
+    return m_converter.Convert(f.format, data, bytesUsed, f.width, f.height, outFrame, tight ? 0 : f.bytesPerLine);
+  }
+
+  outFrame = m_pool->Acquire(packedSize);
+  if (!outFrame) return S_FALSE;  // in-flight cap reached: drop
+  if (tight) {
+    memcpy(outFrame->data(), data, packedSize);
+  } else {
+    PackPixelRows(f.format, data, f.bytesPerLine, f.width, f.height, outFrame->data());
+  }
+  return S_OK;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "capture_backend.h"
+#include "frame_converter.h"
+
+// System calls made on the device. The defaults are the libc functions; a
+// replacement table lets the backend run against a fake device (CI without a
+// camera or the vivid driver). The device fd must be pollable (epoll) and
+// report EPOLLIN when VIDIOC_DQBUF has a buffer ready.
+struct V4l2Io {
+  int (*open)(const char* path, int flags);
+  int (*close)(int fd);
+  int (*ioctl)(int fd, unsigned long request, void* arg);
+  void* (*mmap)(void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+  int (*munmap)(void* addr, size_t length);
+  // Directory scanned for video* nodes by EnumerateDevices
+  const char* deviceDir;
+};
+
+const V4l2Io& DefaultV4l2Io();
+
+// Linux backend on Video4Linux2 (single-planar capture). Streams through a
+// ring of mmap'd kernel buffers read by an epoll-driven thread; each frame is
+// copied (or converted) once from the kernel buffer into pooled frame storage
+// and the buffer is queued back immediately, so a slow consumer never holds
+// the driver's ring.
+//
+// Native formats are identified by FourCC ("YUYV", "MJPG", ...) in
+// CaptureFormat::guid; devices are identified by their node path.
+class V4l2CaptureBackend : public CaptureBackend {
+ public:
+  static constexpr size_t kDefaultBufferCount = 4;
+  static constexpr size_t kMaxBufferCount = 32;
+
+  explicit V4l2CaptureBackend(const V4l2Io& io = DefaultV4l2Io());
+  ~V4l2CaptureBackend() override;
+
+  const char* Name() const override { return "v4l2"; }
+
+  HRESULT EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) override;
+  HRESULT ClaimDevice(const std::string& identifier) override;
+  HRESULT ReleaseDevice() override;
+  HRESULT GetClaimedDevice(CaptureDeviceInfo& outDevice) override;
+
+  HRESULT GetSupportedFormats(std::vector<CaptureFormat>& outFormats) override;
+  HRESULT SetFormat(const CaptureFormat& format) override;
+  HRESULT GetCurrentFormat(CaptureFormat& outFormat) override;
+  bool ParseNativeFormat(const std::string& id, CaptureFormat& outFormat) const override;
+  HRESULT SetOutputFormat(PixelFormat format) override;
+
+  HRESULT StartCapture() override;
+  HRESULT StopCapture() override;
+
+  void SetFrameCallback(std::function<void(FramePtr)> cb) override;
+  void SetFrameGate(FrameGate gate) override;
+  void SetFrameTap(FrameTap tap) override;
+  void SetFrameDestination(std::shared_ptr<FrameDestination> destination) override { m_pool->SetDestination(std::move(destination)); }
+  void SetMaxInFlightFrames(size_t maxInFlight) override { m_pool->SetMaxInFlight(maxInFlight); }
+  void SetConversionThreads(size_t threads, size_t bandHeight) override;
+  void SetJpegOptions(const JpegOptions& options) override;
+  void SetDeviceBufferCount(size_t count) override;
+  FramePoolStats GetFramePoolStats() const override { return m_pool->GetStats(); }
+
+ private:
+  using FrameCallback = std::function<void(FramePtr)>;
+
+  struct MappedBuffer {
+    void* data = nullptr;
+    size_t length = 0;
+  };
+
+  // Negotiated capture format (from VIDIOC_G_FMT)
+  struct ActiveFormat {
+    uint32_t fourcc = 0;
+    PixelFormat format = PixelFormat::Unknown;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bytesPerLine = 0;
+  };
+
+  int Ioctl(unsigned long request, void* arg) const;
+  HRESULT QueryActiveFormat(ActiveFormat& out) const;
+  // FourCC the device offers for `format` (first match of VIDIOC_ENUM_FMT)
+  uint32_t FourccForFormat(PixelFormat format) const;
+  HRESULT MapBuffers(size_t count);
+  void UnmapBuffers();
+  void ReaderLoop();
+  // Turn one dequeued buffer into a delivered frame. Called with m_lock held.
+  HRESULT ProcessBuffer(const uint8_t* data, size_t bytesUsed, FramePtr& outFrame);
+  void StopStreaming();
+
+  const V4l2Io m_io;
+  mutable std::mutex m_lock;  // guards everything below except m_pool
+  int m_fd = -1;
+  int m_wakeFd = -1;  // eventfd that interrupts the reader's epoll_wait
+  CaptureDeviceInfo m_device;
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+  size_t m_bufferCount = kDefaultBufferCount;
+  std::vector<MappedBuffer> m_buffers;
+  ActiveFormat m_active;
+  std::shared_ptr<const FrameCallback> m_callback;
+  // Asked before a dequeued buffer is copied or converted (SetFrameGate)
+  FrameGate m_gate;
+  // Shown every dequeued buffer before the gate (SetFrameTap)
+  FrameTap m_tap;
+  std::shared_ptr<FramePool> m_pool;
+  FrameConverter m_converter;
+  FrameStamper m_stamper;
+  // Driver sequence number expected next (gap detection)
+  uint32_t m_nextSequence = 0;
+  bool m_haveSequence = false;
+};
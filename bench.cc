@@ -2,7 +2,11 @@
 #include <vector>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
 #include "convert.h"
+#include "convert_engine.h"
 
 using namespace Napi;
 
@@ -97,6 +101,146 @@ Value RunRgb32Bench(const CallbackInfo& info) {
     if (msSimd24 < best24Simd) best24Simd = msSimd24;
   }
 
+  // Bit-exact check of every RGB24 variant against the baseline, on a pixel
+  // count that leaves a tail for each kernel's block size.
+  std::vector<uint8_t> ref24(bytes);
+  baseline_rgb24_to_rgba(src24.data(), ref24.data(), pixels);
+  auto exact24 = [&](void (*fn)(const uint8_t*, uint8_t*, size_t)) {
+    const size_t n = pixels > 16 ? pixels - 1 : pixels;
+    fn(src24.data(), dst24.data(), n);
+    return std::memcmp(dst24.data(), ref24.data(), n * 4) == 0;
+  };
+  bool rgb24Exact = exact24(optimized_rgb24_to_rgba);
+  if (cpu_has_ssse3()) rgb24Exact = rgb24Exact && exact24(ssse3_rgb24_to_rgba);
+  if (cpu_has_avx2()) rgb24Exact = rgb24Exact && exact24(avx2_rgb24_to_rgba);
+
+  // NV12 -> RGBA benchmarks: baseline, each SIMD variant the CPU supports, and
+  // the startup-selected kernel. Every variant is also checked for bit-exact
+  // output against the baseline across all matrix/range combinations.
+  size_t bytesNv12 = pixels + 2 * ((width + 1) / 2) * ((height + 1) / 2);
+  std::vector<uint8_t> srcNv12(bytesNv12);
+  std::vector<uint8_t> dstNv12(bytes);
+  std::vector<uint8_t> refNv12(bytes);
+  for (size_t i = 0; i < bytesNv12; ++i) srcNv12[i] = static_cast<uint8_t>((i * 7919u) >> 3);
+  const uint8_t* nv12Y = srcNv12.data();
+  const uint8_t* nv12UV = srcNv12.data() + pixels;
+  const size_t uvStride = (width + 1) & ~static_cast<size_t>(1);
+
+  typedef void (*Nv12Fn)(const uint8_t*, size_t, const uint8_t*, size_t, uint8_t*, size_t, size_t, size_t, Rgb32Order, YuvMatrix, YuvRange);
+  auto timeNv12 = [&](Nv12Fn fn) {
+    double best = 1e99;
+    fn(nv12Y, width, nv12UV, uvStride, dstNv12.data(), width * 4, width, height, Rgb32Order::RGBA, YuvMatrix::BT601, YuvRange::Limited);
+    for (int r = 0; r < repeat; ++r) {
+      auto t0 = std::chrono::high_resolution_clock::now();
+      for (int it = 0; it < iterations; ++it) fn(nv12Y, width, nv12UV, uvStride, dstNv12.data(), width * 4, width, height, Rgb32Order::RGBA, YuvMatrix::BT601, YuvRange::Limited);
+      auto t1 = std::chrono::high_resolution_clock::now();
+      double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+      if (ms < best) best = ms;
+    }
+    return best;
+  };
+  auto exactNv12 = [&](Nv12Fn fn) {
+    for (int m = 0; m < 2; ++m) {
+      for (int rg = 0; rg < 2; ++rg) {
+        for (int o = 0; o < 2; ++o) {
+          YuvMatrix matrix = m ? YuvMatrix::BT709 : YuvMatrix::BT601;
+          YuvRange range = rg ? YuvRange::Full : YuvRange::Limited;
+          Rgb32Order order = o ? Rgb32Order::BGRA : Rgb32Order::RGBA;
+          baseline_nv12_to_rgb32(nv12Y, width, nv12UV, uvStride, refNv12.data(), width * 4, width, height, order, matrix, range);
+          fn(nv12Y, width, nv12UV, uvStride, dstNv12.data(), width * 4, width, height, order, matrix, range);
+          if (refNv12 != dstNv12) return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  bool nv12Exact = true;
+  double bestNv12Base = timeNv12(baseline_nv12_to_rgb32);
+  double bestNv12Sse2 = -1, bestNv12Avx2 = -1, bestNv12Avx512 = -1;
+  if (cpu_has_sse2()) {
+    bestNv12Sse2 = timeNv12(sse2_nv12_to_rgb32);
+    nv12Exact = nv12Exact && exactNv12(sse2_nv12_to_rgb32);
+  }
+  if (cpu_has_avx2()) {
+    bestNv12Avx2 = timeNv12(avx2_nv12_to_rgb32);
+    nv12Exact = nv12Exact && exactNv12(avx2_nv12_to_rgb32);
+  }
+  if (cpu_has_avx512bw()) {
+    bestNv12Avx512 = timeNv12(avx512_nv12_to_rgb32);
+    nv12Exact = nv12Exact && exactNv12(avx512_nv12_to_rgb32);
+  }
+
+  double bestNv12Simd = 1e99;
+  simd_nv12_to_rgba(srcNv12.data(), dstNv12.data(), width, height);
+  for (int r = 0; r < repeat; ++r) {
+    auto t0n = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it) simd_nv12_to_rgba(srcNv12.data(), dstNv12.data(), width, height);
+    auto t1n = std::chrono::high_resolution_clock::now();
+    double msNv12 = std::chrono::duration<double, std::milli>(t1n - t0n).count();
+    if (msNv12 < bestNv12Simd) bestNv12Simd = msNv12;
+  }
+
+  // YUY2 -> BGR24 benchmarks (the MJPEG capture path), plus a bit-exact check
+  // of every 4:2:2 variant over both layouts and all output formats.
+  const size_t yuy2Stride = ((width + 1) & ~static_cast<size_t>(1)) * 2;
+  std::vector<uint8_t> srcYuy2(yuy2Stride * height);
+  std::vector<uint8_t> dstYuy2(bytes);
+  std::vector<uint8_t> refYuy2(bytes);
+  for (size_t i = 0; i < srcYuy2.size(); ++i) srcYuy2[i] = static_cast<uint8_t>((i * 7919u) >> 3);
+
+  typedef void (*Yuv422Fn)(const uint8_t*, size_t, uint8_t*, size_t, size_t, size_t, Yuv422Layout, RgbFormat, YuvMatrix, YuvRange);
+  auto timeYuy2 = [&](Yuv422Fn fn) {
+    double best = 1e99;
+    fn(srcYuy2.data(), yuy2Stride, dstYuy2.data(), width * 3, width, height, Yuv422Layout::YUY2, RgbFormat::BGR24, YuvMatrix::BT601, YuvRange::Limited);
+    for (int r = 0; r < repeat; ++r) {
+      auto t0 = std::chrono::high_resolution_clock::now();
+      for (int it = 0; it < iterations; ++it) fn(srcYuy2.data(), yuy2Stride, dstYuy2.data(), width * 3, width, height, Yuv422Layout::YUY2, RgbFormat::BGR24, YuvMatrix::BT601, YuvRange::Limited);
+      auto t1 = std::chrono::high_resolution_clock::now();
+      double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+      if (ms < best) best = ms;
+    }
+    return best;
+  };
+  auto exactYuy2 = [&](Yuv422Fn fn) {
+    for (int l = 0; l < 2; ++l) {
+      for (int f = 0; f < 3; ++f) {
+        for (int m = 0; m < 2; ++m) {
+          Yuv422Layout layout = l ? Yuv422Layout::UYVY : Yuv422Layout::YUY2;
+          RgbFormat format = f == 0 ? RgbFormat::RGBA : (f == 1 ? RgbFormat::BGRA : RgbFormat::BGR24);
+          YuvMatrix matrix = m ? YuvMatrix::BT709 : YuvMatrix::BT601;
+          size_t dstStride = width * (format == RgbFormat::BGR24 ? 3 : 4);
+          baseline_yuv422_to_rgb(srcYuy2.data(), yuy2Stride, refYuy2.data(), dstStride, width, height, layout, format, matrix, YuvRange::Limited);
+          fn(srcYuy2.data(), yuy2Stride, dstYuy2.data(), dstStride, width, height, layout, format, matrix, YuvRange::Limited);
+          if (refYuy2 != dstYuy2) return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  bool yuy2Exact = true;
+  double bestYuy2Base = timeYuy2(baseline_yuv422_to_rgb);
+  double bestYuy2Ssse3 = -1, bestYuy2Avx2 = -1;
+  if (cpu_has_ssse3()) {
+    bestYuy2Ssse3 = timeYuy2(ssse3_yuv422_to_rgb);
+    yuy2Exact = yuy2Exact && exactYuy2(ssse3_yuv422_to_rgb);
+  }
+  if (cpu_has_avx2()) {
+    bestYuy2Avx2 = timeYuy2(avx2_yuv422_to_rgb);
+    yuy2Exact = yuy2Exact && exactYuy2(avx2_yuv422_to_rgb);
+  }
+
+  double bestYuy2Simd = 1e99;
+  simd_yuv422_to_rgb(srcYuy2.data(), dstYuy2.data(), width, height, Yuv422Layout::YUY2, RgbFormat::BGR24);
+  for (int r = 0; r < repeat; ++r) {
+    auto t0y = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it) simd_yuv422_to_rgb(srcYuy2.data(), dstYuy2.data(), width, height, Yuv422Layout::YUY2, RgbFormat::BGR24);
+    auto t1y = std::chrono::high_resolution_clock::now();
+    double msYuy2 = std::chrono::duration<double, std::milli>(t1y - t0y).count();
+    if (msYuy2 < bestYuy2Simd) bestYuy2Simd = msYuy2;
+  }
+
   // Build cpu object first so it appears first when serialized in JS
   Object cpu = Object::New(env);
   cpu.Set("avx2", Boolean::New(env, cpu_has_avx2()));
@@ -106,6 +250,7 @@ Value RunRgb32Bench(const CallbackInfo& info) {
   cpu.Set("sse4_1", Boolean::New(env, cpu_has_sse41()));
   cpu.Set("avx", Boolean::New(env, cpu_has_avx()));
   cpu.Set("bmi2", Boolean::New(env, cpu_has_bmi2()));
+  cpu.Set("avx512bw", Boolean::New(env, cpu_has_avx512bw()));
 
   Object result = Object::New(env);
   result.Set("cpu", cpu);
@@ -119,6 +264,115 @@ Value RunRgb32Bench(const CallbackInfo& info) {
   result.Set("rgb24_baseline_ms", Number::New(env, best24Base));
   result.Set("rgb24_optimized_ms", Number::New(env, best24Opt));
   result.Set("rgb24_simd_ms", Number::New(env, best24Simd));
+  result.Set("rgb24_kernel", String::New(env, convert_kernels().rgb24ToRgbaName));
+  result.Set("rgb24_exact", Boolean::New(env, rgb24Exact));
+  // NV12 timings (-1 = variant not supported by this CPU)
+  result.Set("nv12_baseline_ms", Number::New(env, bestNv12Base));
+  result.Set("nv12_sse2_ms", Number::New(env, bestNv12Sse2));
+  result.Set("nv12_avx2_ms", Number::New(env, bestNv12Avx2));
+  result.Set("nv12_avx512_ms", Number::New(env, bestNv12Avx512));
+  result.Set("nv12_simd_ms", Number::New(env, bestNv12Simd));
+  result.Set("nv12_kernel", String::New(env, nv12_kernel_name()));
+  result.Set("nv12_exact", Boolean::New(env, nv12Exact));
+  // YUY2 -> BGR24 timings (-1 = variant not supported by this CPU)
+  result.Set("yuy2_baseline_ms", Number::New(env, bestYuy2Base));
+  result.Set("yuy2_ssse3_ms", Number::New(env, bestYuy2Ssse3));
+  result.Set("yuy2_avx2_ms", Number::New(env, bestYuy2Avx2));
+  result.Set("yuy2_simd_ms", Number::New(env, bestYuy2Simd));
+  result.Set("yuy2_kernel", String::New(env, yuv422_kernel_name()));
+  result.Set("yuy2_exact", Boolean::New(env, yuy2Exact));
+  return result;
+}
+
+// N-API wrapper timing the banded conversion engine from 1 to maxThreads
+// threads. Returns [{ threads, nv12_ms, yuy2_ms }] (best of `repeat` runs).
+Value RunConvertScalingBench(const CallbackInfo& info) {
+  Env env = info.Env();
+  if (info.Length() < 4) {
+    TypeError::New(env, "expected width,height,iterations,repeat[,maxThreads[,bandHeight]]").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  size_t width = info[0].As<Number>().Uint32Value();
+  size_t height = info[1].As<Number>().Uint32Value();
+  int iterations = info[2].As<Number>().Int32Value();
+  int repeat = info[3].As<Number>().Int32Value();
+  size_t maxThreads = std::thread::hardware_concurrency();
+  if (info.Length() > 4 && info[4].IsNumber()) maxThreads = info[4].As<Number>().Uint32Value();
+  size_t bandHeight = 0;
+  if (info.Length() > 5 && info[5].IsNumber()) bandHeight = info[5].As<Number>().Uint32Value();
+  if (maxThreads == 0) maxThreads = 1;
+
+  size_t pixels = width * height;
+  std::vector<uint8_t> srcNv12(pixels + ((width + 1) & ~static_cast<size_t>(1)) * ((height + 1) / 2));
+  std::vector<uint8_t> srcYuy2(((width + 1) & ~static_cast<size_t>(1)) * 2 * height);
+  std::vector<uint8_t> dst(pixels * 4);
+  for (size_t i = 0; i < srcNv12.size(); ++i) srcNv12[i] = static_cast<uint8_t>((i * 7919u) >> 3);
+  for (size_t i = 0; i < srcYuy2.size(); ++i) srcYuy2[i] = static_cast<uint8_t>((i * 7919u) >> 3);
+
+  ConvertEngine engine(1, bandHeight);
+  auto timeIt = [&](const std::function<void()>& fn) {
+    double best = 1e99;
+    fn();
+    for (int r = 0; r < repeat; ++r) {
+      auto t0 = std::chrono::high_resolution_clock::now();
+      for (int it = 0; it < iterations; ++it) fn();
+      auto t1 = std::chrono::high_resolution_clock::now();
+      double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+      if (ms < best) best = ms;
+    }
+    return best;
+  };
+
+  Array results = Array::New(env);
+  uint32_t index = 0;
+  for (size_t threads = 1; threads <= maxThreads; ++threads) {
+    engine.SetThreadCount(threads);
+    double nv12Ms = timeIt([&] { engine.Nv12ToRgb32(srcNv12.data(), dst.data(), width, height, Rgb32Order::RGBA); });
+    double yuy2Ms = timeIt([&] { engine.Yuv422ToRgb(srcYuy2.data(), dst.data(), width, height, Yuv422Layout::YUY2, RgbFormat::BGR24); });
+    Object row = Object::New(env);
+    row.Set("threads", Number::New(env, static_cast<double>(engine.ThreadCount())));
+    row.Set("nv12_ms", Number::New(env, nv12Ms));
+    row.Set("yuy2_ms", Number::New(env, yuy2Ms));
+    results.Set(index++, row);
+  }
+  return results;
+}
+
+// Conversion kernel selection: setConversionIsa('auto' | 'scalar' | 'sse2' |
+// 'ssse3' | 'avx2' | 'avx512') pins every format pair to the best variant at or
+// below that tier. Returns false when the CPU lacks the tier.
+Value SetConversionIsa(const CallbackInfo& info) {
+  Env env = info.Env();
+  ConvertIsa isa;
+  if (info.Length() < 1 || !info[0].IsString() || !parse_convert_isa(info[0].As<String>().Utf8Value().c_str(), isa)) {
+    TypeError::New(env, "Unknown ISA. Use 'auto', 'scalar', 'sse2', 'ssse3', 'avx2' or 'avx512'.").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Boolean::New(env, set_convert_isa(isa));
+}
+
+// Active kernel per format pair: { isa, detected, rgb32ToRgba, rgb24ToRgba, nv12ToRgb32, yuv422ToRgb, ..., jpegFdct, jpegIdct }
+Value GetConversionKernels(const CallbackInfo& info) {
+  Env env = info.Env();
+  const ConvertKernels& k = convert_kernels();
+  Object result = Object::New(env);
+  result.Set("isa", String::New(env, convert_isa_name(k.isa)));
+  result.Set("detected", String::New(env, convert_isa_name(detected_convert_isa())));
+  result.Set("rgb32ToRgba", String::New(env, k.rgb32ToRgbaName));
+  result.Set("rgb24ToRgba", String::New(env, k.rgb24ToRgbaName));
+  result.Set("nv12ToRgb32", String::New(env, k.nv12ToRgb32Name));
+  result.Set("yuv422ToRgb", String::New(env, k.yuv422ToRgbName));
+  result.Set("yuv420ToRgb", String::New(env, k.yuv420ToRgbName));
+  result.Set("rgbToYuv420", String::New(env, k.rgbToYuv420Name));
+  result.Set("rgbToYuv422", String::New(env, k.rgbToYuv422Name));
+  result.Set("rgbRepack", String::New(env, k.rgbRepackName));
+  result.Set("yuv420ToYuv422", String::New(env, k.yuv420ToYuv422Name));
+  result.Set("yuv422ToYuv420", String::New(env, k.yuv422ToYuv420Name));
+  result.Set("uvInterleave", String::New(env, k.uvInterleaveName));
+  result.Set("uvDeinterleave", String::New(env, k.uvDeinterleaveName));
+  result.Set("yuv422Swap", String::New(env, k.yuv422SwapName));
+  result.Set("jpegFdct", String::New(env, k.jpegFdctName));
+  result.Set("jpegIdct", String::New(env, k.jpegIdctName));
   return result;
 }
 
@@ -126,5 +380,8 @@ Value RunRgb32Bench(const CallbackInfo& info) {
 
 Object BenchInit(Env env, Object exports) {
   exports.Set("runRgb32Bench", Function::New(env, RunRgb32Bench));
+  exports.Set("runConvertScalingBench", Function::New(env, RunConvertScalingBench));
+  exports.Set("setConversionIsa", Function::New(env, SetConversionIsa));
+  exports.Set("getConversionKernels", Function::New(env, GetConversionKernels));
   return exports;
 }
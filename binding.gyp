@@ -1,31 +1,158 @@
 {
   "targets": [
+    {
+      "target_name": "camera_convert",
+      "type": "static_library",
+      "cflags!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc": [
+        "-std=c++17",
+        "-pthread"
+      ],
+      "sources": [
+  "convert.cc",
+  "convert_engine.cc",
+  "convert_plan.cc",
+  "cpu_features.cc",
+  "jpeg_decoder.cc",
+  "jpeg_encoder.cc",
+  "jpeg_tables.cc"
+      ],
+      "direct_dependent_settings": {
+        "include_dirs": [
+          "."
+        ]
+      },
+      "msvs_settings": {
+        "VCCLCompilerTool": {
+          "ExceptionHandling": 1
+        }
+      }
+    },
+    {
+      "target_name": "convert_bench",
+      "type": "executable",
+      "dependencies": [
+        "camera_convert"
+      ],
+      "cflags!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc": [
+        "-std=c++17",
+        "-pthread"
+      ],
+      "ldflags": [
+        "-pthread"
+      ],
+      "sources": [
+  "convert_bench.cc"
+      ],
+      "msvs_settings": {
+        "VCCLCompilerTool": {
+          "ExceptionHandling": 1
+        }
+      }
+    },
+    {
+      "target_name": "frame_pool_test",
+      "type": "executable",
+      "cflags!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc": [
+        "-std=c++17",
+        "-pthread"
+      ],
+      "ldflags": [
+        "-pthread"
+      ],
+      "sources": [
+  "test/frame_pool_test.cc",
+  "frame.cc"
+      ],
+      "include_dirs": [
+        "."
+      ],
+      "msvs_settings": {
+        "VCCLCompilerTool": {
+          "ExceptionHandling": 1
+        }
+      }
+    },
+    {
+      "target_name": "frame_decimator_test",
+      "type": "executable",
+      "cflags!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc!": [
+        "-fno-exceptions"
+      ],
+      "cflags_cc": [
+        "-std=c++17",
+        "-pthread"
+      ],
+      "ldflags": [
+        "-pthread"
+      ],
+      "sources": [
+  "test/frame_decimator_test.cc",
+  "frame_decimator.cc"
+      ],
+      "include_dirs": [
+        "."
+      ],
+      "msvs_settings": {
+        "VCCLCompilerTool": {
+          "ExceptionHandling": 1
+        }
+      }
+    },
     {
       "target_name": "addon",
+      "dependencies": [
+        "camera_convert"
+      ],
       "cflags!": [
         "-fno-exceptions"
       ],
       "cflags_cc!": [
         "-fno-exceptions"
       ],
+      "cflags_cc": [
+        "-std=c++17",
+        "-pthread"
+      ],
+      "ldflags": [
+        "-pthread"
+      ],
       "sources": [
   "addon.cc",
   "camera.cc",
-  "capture.cc",
   "bench.cc",
-  "convert.cc"
-      ],
-      "libraries": [
-        "-lmf",
-        "-lmfplat",
-        "-lMfreadwrite",
-        "-lMfuuid",
-        "-lwmcodecdspuuid",
-        "-lole32",
-        "-luuid",
-        "-lstrmiids",
-        "-lshlwapi",
-        "-lwindowscodecs"
+  "frame.cc",
+  "frame_queue.cc",
+  "frame_ring.cc",
+  "frame_target.cc",
+  "frame_sink.cc",
+  "frame_pull.cc",
+  "frame_decimator.cc",
+  "frame_converter.cc",
+  "capture_backend.cc",
+  "backend_synthetic.cc",
+  "frame_recording.cc",
+  "backend_replay.cc"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
@@ -37,7 +164,78 @@
         "VCCLCompilerTool": {
           "ExceptionHandling": 1
         }
-      }
+      },
+      "conditions": [
+        [
+          "OS=='win'",
+          {
+            "sources": [
+  "capture.cc",
+  "backend_mf.cc",
+  "wic_jpeg_encoder.cc"
+            ],
+            "libraries": [
+              "-lmf",
+              "-lmfplat",
+              "-lMfreadwrite",
+              "-lMfuuid",
+              "-lwmcodecdspuuid",
+              "-lole32",
+              "-luuid",
+              "-lstrmiids",
+              "-lshlwapi",
+              "-lwindowscodecs"
+            ]
+          }
+        ],
+        [
+          "OS=='linux'",
+          {
+            "sources": [
+  "backend_v4l2.cc"
+            ]
+          }
+        ]
+      ]
     }
+  ],
+  "conditions": [
+    [
+      "OS=='linux'",
+      {
+        "targets": [
+          {
+            "target_name": "v4l2_backend_test",
+            "type": "executable",
+            "dependencies": [
+              "camera_convert"
+            ],
+            "cflags!": [
+              "-fno-exceptions"
+            ],
+            "cflags_cc!": [
+              "-fno-exceptions"
+            ],
+            "cflags_cc": [
+              "-std=c++17",
+              "-pthread"
+            ],
+            "ldflags": [
+              "-pthread"
+            ],
+            "sources": [
+  "test/v4l2_backend_test.cc",
+  "backend_v4l2.cc",
+  "backend_synthetic.cc",
+  "backend_replay.cc",
+  "frame_recording.cc",
+  "capture_backend.cc",
+  "frame_converter.cc",
+  "frame.cc"
+            ]
+          }
+        ]
+      }
+    ]
   ]
 }
@@ -1,66 +1,48 @@
 #include "camera.h"
-#include <comdef.h>
-#include <windows.h>
 #include <thread>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
-#include <mfapi.h>
-#include <mfidl.h>
-#include <mfreadwrite.h>
+#include <string>
 #include <vector>
-#include <tuple>
-#include <objbase.h>
-
-// Helper: map common media subtype GUIDs to friendly encoder names
-static std::string SubtypeGuidToName(const GUID& g) {
-  // MEDIASUBTYPE_MJPG / MFVideoFormat_MJPG GUID value (bytes: 'MJPG')
-  static const GUID MJPG_GUID = {0x47504A4D, 0x0000, 0x0010, {0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71}};
-
-  if (g == MFVideoFormat_RGB32) return "RGB32";
-  if (g == MFVideoFormat_RGB24) return "RGB24";
-  if (g == MFVideoFormat_NV12) return "NV12";
-  if (g == MFVideoFormat_YUY2) return "YUY2";
-  if (g == MFVideoFormat_UYVY) return "UYVY";
-  if (g == MFVideoFormat_IYUV) return "IYUV";
-  if (memcmp(&g, &MJPG_GUID, sizeof(GUID)) == 0) return "MJPEG";
-  // MJPEG is usually defined as MEDIASUBTYPE_MJPG / MFVideoFormat_MJPG
-#ifdef MFVideoFormat_MJPG
-  if (g == MFVideoFormat_MJPG) return "MJPEG";
-#endif
-  // Fallback: convert GUID to string
-  OLECHAR wsz[64];
-  StringFromGUID2(g, wsz, ARRAYSIZE(wsz));
-  int len = WideCharToMultiByte(CP_UTF8, 0, wsz, -1, NULL, 0, NULL, NULL);
-  std::string guidStr;
-  if (len > 0) {
-    guidStr.assign(len, '\0');
-    WideCharToMultiByte(CP_UTF8, 0, wsz, -1, &guidStr[0], len, NULL, NULL);
-    if (!guidStr.empty() && guidStr.back() == '\0') guidStr.pop_back();
-  }
-  return guidStr;
+
+// Resolve a format name or backend-native id (e.g. an MF subtype GUID string).
+static bool ResolveFormat(const CaptureBackend& backend, const std::string& id, CaptureFormat& out) {
+  if (backend.ParseNativeFormat(id, out)) return true;
+  PixelFormat format = PixelFormat::Unknown;
+  if (!ParsePixelFormat(id, format)) return false;
+  out.format = format;
+  out.subtype = PixelFormatName(format);
+  out.guid.clear();
+  return true;
 }
 
-// Helper: convert a GUID to a UTF-8 string like "{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}"
-static std::string GuidToString(const GUID& g) {
-  OLECHAR wsz[64];
-  StringFromGUID2(g, wsz, ARRAYSIZE(wsz));
-  int len = WideCharToMultiByte(CP_UTF8, 0, wsz, -1, NULL, 0, NULL, NULL);
-  std::string guidStr;
-  if (len > 0) {
-    guidStr.assign(len, '\0');
-    WideCharToMultiByte(CP_UTF8, 0, wsz, -1, &guidStr[0], len, NULL, NULL);
-    if (!guidStr.empty() && guidStr.back() == '\0') guidStr.pop_back();
-  }
-  return guidStr;
+static Napi::Object FormatToObject(Napi::Env env, const CaptureFormat& f) {
+  Napi::Object entry = Napi::Object::New(env);
+  entry.Set("subtype", Napi::String::New(env, f.subtype));
+  entry.Set("guid", Napi::String::New(env, f.guid));
+  entry.Set("width", Napi::Number::New(env, f.width));
+  entry.Set("height", Napi::Number::New(env, f.height));
+  // use only `frameRate` for frame rate information
+  entry.Set("frameRate", Napi::Number::New(env, f.frameRate));
+  return entry;
 }
 
 Napi::Object Camera::Init(Napi::Env env, Napi::Object exports) {
-  Napi::Function func = DefineClass(env, "Camera", {InstanceMethod("claimDeviceAsync", &Camera::ClaimDeviceAsync), InstanceMethod("enumerateDevicesAsync", &Camera::EnumerateDevicesAsync), InstanceMethod("getDimensions", &Camera::GetDimensions), InstanceMethod("getSupportedFormatsAsync", &Camera::GetSupportedFormatsAsync), InstanceMethod("getCameraInfoAsync", &Camera::GetCameraInfoAsync), InstanceMethod("releaseDeviceAsync", &Camera::ReleaseDeviceAsync), InstanceMethod("setFormatAsync", &Camera::SetFormatAsync), InstanceMethod("setOutputFormatAsync", &Camera::SetOutputFormatAsync), InstanceMethod("startCaptureAsync", &Camera::StartCaptureAsync), InstanceMethod("stopCaptureAsync", &Camera::StopCaptureAsync)});
+  Napi::Function func = DefineClass(env, "Camera", {InstanceMethod("claimDeviceAsync", &Camera::ClaimDeviceAsync), InstanceMethod("enumerateDevicesAsync", &Camera::EnumerateDevicesAsync), InstanceMethod("getDimensions", &Camera::GetDimensions), InstanceMethod("getSupportedFormatsAsync", &Camera::GetSupportedFormatsAsync), InstanceMethod("getCameraInfoAsync", &Camera::GetCameraInfoAsync), InstanceMethod("releaseDeviceAsync", &Camera::ReleaseDeviceAsync), InstanceMethod("setFormatAsync", &Camera::SetFormatAsync), InstanceMethod("setOutputFormatAsync", &Camera::SetOutputFormatAsync), InstanceMethod("startCaptureAsync", &Camera::StartCaptureAsync), InstanceMethod("stopCaptureAsync", &Camera::StopCaptureAsync), InstanceMethod("getStats", &Camera::GetStats), InstanceMethod("getBackend", &Camera::GetBackend), InstanceMethod("getFrameInfoArray", &Camera::GetFrameInfoArray), InstanceMethod("pullFrameAsync", &Camera::PullFrameAsync), InstanceMethod("readIntoAsync", &Camera::ReadIntoAsync), InstanceMethod("cancelReadInto", &Camera::CancelReadInto)});
 
   Napi::FunctionReference* constructor = new Napi::FunctionReference();
   *constructor = Napi::Persistent(func);
   env.SetInstanceData(constructor);
 
   exports.Set("Camera", func);
+
+  // Names of FrameInfo format codes (PixelFormat values); "" = backend-native
+  Napi::Array formatNames = Napi::Array::New(env);
+  for (uint32_t i = 0; i <= static_cast<uint32_t>(PixelFormat::RGBA); ++i) {
+    formatNames.Set(i, Napi::String::New(env, PixelFormatName(static_cast<PixelFormat>(i))));
+  }
+  exports.Set("pixelFormatNames", formatNames);
   return exports;
 }
 
@@ -72,7 +54,8 @@ Napi::Value Camera::GetCameraInfoAsync(const Napi::CallbackInfo& info) {
 
   std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise)]() mutable {
     try {
-      if (!this->claimedActivate) {
+      CaptureDeviceInfo device;
+      if (!this->claimed || FAILED(this->backend->GetClaimedDevice(device))) {
         auto cb = [deferred = std::move(deferred)](Napi::Env env, Napi::Function) mutable {
           deferred.Reject(Napi::Error::New(env, "No claimed device. Call claimDeviceAsync first.").Value());
         };
@@ -81,95 +64,43 @@ Napi::Value Camera::GetCameraInfoAsync(const Napi::CallbackInfo& info) {
         return;
       }
 
-      // Extract device-level attributes from claimedActivate
-      WCHAR* pFriendly = nullptr;
-      WCHAR* pSymbolic = nullptr;
-      std::string friendlyUtf8, symbolicUtf8;
-
-      HRESULT hr1 = this->claimedActivate->GetAllocatedString(MF_DEVSOURCE_ATTRIBUTE_FRIENDLY_NAME, &pFriendly, nullptr);
-      HRESULT hr2 = this->claimedActivate->GetAllocatedString(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_SYMBOLIC_LINK, &pSymbolic, nullptr);
-
-      if (SUCCEEDED(hr1) && pFriendly) {
-        int len = WideCharToMultiByte(CP_UTF8, 0, pFriendly, -1, NULL, 0, NULL, NULL);
-        if (len > 0) {
-          std::string tmp(len, '\0');
-          WideCharToMultiByte(CP_UTF8, 0, pFriendly, -1, &tmp[0], len, NULL, NULL);
-          if (!tmp.empty() && tmp.back() == '\0') tmp.pop_back();
-          friendlyUtf8 = std::move(tmp);
-        }
-      }
-      if (SUCCEEDED(hr2) && pSymbolic) {
-        int len = WideCharToMultiByte(CP_UTF8, 0, pSymbolic, -1, NULL, 0, NULL, NULL);
-        if (len > 0) {
-          std::string tmp(len, '\0');
-          WideCharToMultiByte(CP_UTF8, 0, pSymbolic, -1, &tmp[0], len, NULL, NULL);
-          if (!tmp.empty() && tmp.back() == '\0') tmp.pop_back();
-          symbolicUtf8 = std::move(tmp);
-        }
-      }
-
-      if (pFriendly) CoTaskMemFree(pFriendly);
-      if (pSymbolic) CoTaskMemFree(pSymbolic);
+      // Ask the backend for supported native types (includes the native id)
+      std::vector<CaptureFormat> types;
+      HRESULT hrTypes = this->backend->GetSupportedFormats(types);
 
-      // Ask CCapture for supported native types (includes subtype GUID)
-      std::vector<std::tuple<GUID, UINT32, UINT32, double>> types;
-      HRESULT hrTypes = S_OK;
-      if (this->device) {
-        hrTypes = this->device->GetSupportedFormats(types);
-      }
-
-      auto cb = [deferred = std::move(deferred), friendlyUtf8 = std::move(friendlyUtf8), symbolicUtf8 = std::move(symbolicUtf8), types = std::move(types), hrTypes](Napi::Env env, Napi::Function) mutable {
+      auto cb = [deferred = std::move(deferred), device = std::move(device), types = std::move(types), hrTypes](Napi::Env env, Napi::Function) mutable {
         if (FAILED(hrTypes)) {
           deferred.Reject(Napi::Error::New(env, "Failed to enumerate native types").Value());
           return;
         }
 
         Napi::Object out = Napi::Object::New(env);
-        out.Set("friendlyName", Napi::String::New(env, friendlyUtf8));
-        out.Set("symbolicLink", Napi::String::New(env, symbolicUtf8));
+        out.Set("friendlyName", Napi::String::New(env, device.friendlyName));
+        out.Set("symbolicLink", Napi::String::New(env, device.symbolicLink));
 
-        // Map of encoders/formats supported (collect unique subtype GUIDs)
+        // Map of encoders/formats supported (collect unique native ids)
         Napi::Array enc = Napi::Array::New(env);
-        std::vector<GUID> seenGuids;
-        for (size_t i = 0; i < types.size(); ++i) {
-          const GUID& g = std::get<0>(types[i]);
+        std::vector<std::string> seen;
+        for (const auto& t : types) {
           bool found = false;
-          for (const auto& sg : seenGuids) {
-            if (memcmp(&sg, &g, sizeof(GUID)) == 0) {
+          for (const auto& id : seen) {
+            if (id == t.guid) {
               found = true;
               break;
             }
           }
           if (!found) {
-            std::string name = SubtypeGuidToName(g);
-            enc.Set(enc.Length(), Napi::String::New(env, name));
-            seenGuids.push_back(g);
+            enc.Set(enc.Length(), Napi::String::New(env, t.subtype));
+            seen.push_back(t.guid);
           }
         }
 
         out.Set("encoders", enc);
 
-        // Return a flat array of CameraFormat objects: { subtype, width, height, frameRate }
+        // Return a flat array of CameraFormat objects: { subtype, guid, width, height, frameRate }
         Napi::Array formatsArr = Napi::Array::New(env, static_cast<uint32_t>(types.size()));
         for (uint32_t i = 0; i < types.size(); ++i) {
-          GUID g = std::get<0>(types[i]);
-          UINT32 w = std::get<1>(types[i]);
-          UINT32 h = std::get<2>(types[i]);
-          double fr = std::get<3>(types[i]);
-
-          // Use friendly short name for subtype if available and include GUID string
-          std::string subtypeName = SubtypeGuidToName(g);
-          std::string guidStr = GuidToString(g);
-
-          Napi::Object entry = Napi::Object::New(env);
-          entry.Set("subtype", Napi::String::New(env, subtypeName));
-          entry.Set("guid", Napi::String::New(env, guidStr));
-          entry.Set("width", Napi::Number::New(env, w));
-          entry.Set("height", Napi::Number::New(env, h));
-          // use only `frameRate` for frame rate information
-          entry.Set("frameRate", Napi::Number::New(env, fr));
-
-          formatsArr.Set(i, entry);
+          formatsArr.Set(i, FormatToObject(env, types[i]));
         }
 
         out.Set("formats", formatsArr);
@@ -191,22 +122,43 @@ Napi::Value Camera::GetCameraInfoAsync(const Napi::CallbackInfo& info) {
 }
 
 Camera::Camera(const Napi::CallbackInfo& info)
-    : Napi::ObjectWrap<Camera>(info), device(nullptr) {
+    : Napi::ObjectWrap<Camera>(info) {
   Napi::Env env = info.Env();
-}
 
-Camera::~Camera() {
-  if (claimedActivate) {
-    claimedActivate->Release();
-    claimedActivate = nullptr;
+  // Optional options object: { backend?: string }
+  std::string backendName;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Object opts = info[0].As<Napi::Object>();
+    if (opts.Has("backend") && opts.Get("backend").IsString()) {
+      backendName = opts.Get("backend").As<Napi::String>().Utf8Value();
+    }
   }
-  if (device) {
-    device->EndCaptureSession();
-    device->Release();
-    device = nullptr;
+  Napi::Float64Array slots = Napi::Float64Array::New(env, kFrameInfoSlots);
+  this->frameInfoSlots = slots.Data();
+  this->frameInfo = Napi::Persistent(slots);
+
+  this->backend = CreateCaptureBackend(backendName);
+  if (!this->backend) {
+    // An empty name only fails when CAMERA_BACKEND names an unknown backend
+    const char* envName = std::getenv("CAMERA_BACKEND");
+    if (backendName.empty() && envName) backendName = envName;
+    Napi::TypeError::New(env, "Unknown capture backend '" + backendName + "'. Available: auto, " + CaptureBackendNames()).ThrowAsJavaScriptException();
   }
 }
 
+Camera::~Camera() {
+  ReleaseFrameTarget();
+  // Finalizers cannot call into JS: blocked ring consumers see the stopped
+  // state on their next wake-up or timeout.
+  if (frameRing) frameRing->Detach();
+  // Backends stop capture and close the device on destruction
+  backend.reset();
+  // Pending pulls stay unanswered; the pull source's TSFN must not keep the
+  // event loop alive
+  if (framePull) framePull->Detach();
+  if (recorder) recorder->Close();
+}
+
 Napi::Value Camera::EnumerateDevicesAsync(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
@@ -224,25 +176,16 @@ Napi::Value Camera::EnumerateDevicesAsync(const Napi::CallbackInfo& info) {
   // Start async operation
   std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise)]() mutable {
     try {
-      // Get all devices using the capture DeviceList API (GetAllDevices now enumerates)
-      DeviceList list;
-      std::vector<std::pair<std::wstring, std::wstring>> devicesVec;
-      HRESULT hr = list.GetAllDevices(devicesVec);
+      std::vector<CaptureDeviceInfo> devicesVec;
+      HRESULT hr = this->backend->EnumerateDevices(devicesVec);
       if (SUCCEEDED(hr)) {
         auto callback = [deferred = std::move(deferred), devicesVec = std::move(devicesVec)](Napi::Env env, Napi::Function) mutable {
           Napi::Array devices = Napi::Array::New(env, static_cast<uint32_t>(devicesVec.size()));
 
           for (uint32_t i = 0; i < devicesVec.size(); ++i) {
             Napi::Object deviceInfo = Napi::Object::New(env);
-            const auto& pair = devicesVec[i];
-
-            // Convert std::wstring to std::u16string for N-API
-            std::u16string friendlyU16(pair.first.begin(), pair.first.end());
-            std::u16string symbolicU16(pair.second.begin(), pair.second.end());
-
-            deviceInfo.Set("friendlyName", Napi::String::New(env, friendlyU16));
-            deviceInfo.Set("symbolicLink", Napi::String::New(env, symbolicU16));
-
+            deviceInfo.Set("friendlyName", Napi::String::New(env, devicesVec[i].friendlyName));
+            deviceInfo.Set("symbolicLink", Napi::String::New(env, devicesVec[i].symbolicLink));
             devices.Set(i, deviceInfo);
           }
 
@@ -252,10 +195,7 @@ Napi::Value Camera::EnumerateDevicesAsync(const Napi::CallbackInfo& info) {
         tsfnPromise.BlockingCall(callback);
       } else {
         auto callback = [deferred = std::move(deferred), hr](Napi::Env env, Napi::Function) mutable {
-          _com_error err(hr);
-          LPCTSTR errMsg = err.ErrorMessage();
-          std::string message = errMsg;
-          deferred.Reject(Napi::Error::New(env, message).Value());
+          deferred.Reject(Napi::Error::New(env, HResultToString(hr)).Value());
         };
 
         tsfnPromise.BlockingCall(callback);
@@ -282,8 +222,7 @@ Napi::Value Camera::ClaimDeviceAsync(const Napi::CallbackInfo& info) {
     return env.Null();
   }
 
-  std::u16string idU16 = info[0].As<Napi::String>().Utf16Value();
-  std::wstring identifier(idU16.begin(), idU16.end());
+  std::string identifier = info[0].As<Napi::String>().Utf8Value();
 
   auto deferred = Napi::Promise::Deferred::New(env);
 
@@ -295,52 +234,8 @@ Napi::Value Camera::ClaimDeviceAsync(const Napi::CallbackInfo& info) {
       1);
 
   std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise), identifier]() mutable {
-    HRESULT hr = S_OK;
-    // Initialize COM on this worker thread for Media Foundation/API calls.
-    HRESULT hrCo = CoInitializeEx(NULL, COINIT_MULTITHREADED);
-    bool coInitialized = SUCCEEDED(hrCo);
-    IMFActivate* pActivate = nullptr;
-
-    DeviceList list;
-    hr = list.GetDevice(identifier.c_str(), &pActivate);
-
-    if (SUCCEEDED(hr) && pActivate) {
-      // GetDevice returns an AddRef'd IMFActivate so we can store it directly.
-      this->claimedActivate = pActivate;
-
-      // Create a CCapture instance and initialize its reader from the
-      // claimed activation so GetSupportedFormats can enumerate types.
-      CCapture* cap = nullptr;
-      HRESULT hrCreate = CCapture::CreateInstance(NULL, &cap);
-      if (SUCCEEDED(hrCreate) && cap) {
-        HRESULT hrInit = cap->InitFromActivate(pActivate);
-        if (SUCCEEDED(hrInit)) {
-          // Store device instance for subsequent operations
-          this->device = cap;
-        } else {
-          // Init failed: cleanup
-          cap->Release();
-          // release claimed activate as initialization failed
-          if (this->claimedActivate) {
-            this->claimedActivate->Release();
-            this->claimedActivate = nullptr;
-          }
-          hr = hrInit;
-        }
-      } else {
-        // Could not create CCapture instance
-        if (cap) cap->Release();
-        if (this->claimedActivate) {
-          this->claimedActivate->Release();
-          this->claimedActivate = nullptr;
-        }
-        hr = hrCreate;
-      }
-    }
-
-    if (coInitialized) {
-      CoUninitialize();
-    }
+    HRESULT hr = this->backend->ClaimDevice(identifier);
+    this->claimed = SUCCEEDED(hr);
 
     if (SUCCEEDED(hr)) {
       // Return claim result including the symbolic link (caller provided identifier may be friendly name or symbolic link).
@@ -348,44 +243,13 @@ Napi::Value Camera::ClaimDeviceAsync(const Napi::CallbackInfo& info) {
         Napi::Object result = Napi::Object::New(env);
         result.Set("success", Napi::Boolean::New(env, true));
         result.Set("message", Napi::String::New(env, "Device claimed successfully"));
-        // Convert the stored wide string identifier to UTF-8 for JS return
-        std::string symUtf8;
-        if (!identifier.empty()) {
-          int len = WideCharToMultiByte(CP_UTF8, 0, identifier.c_str(), -1, NULL, 0, NULL, NULL);
-          if (len > 0) {
-            std::string tmp(len, '\0');
-            WideCharToMultiByte(CP_UTF8, 0, identifier.c_str(), -1, &tmp[0], len, NULL, NULL);
-            if (!tmp.empty() && tmp.back() == '\0') tmp.pop_back();
-            symUtf8 = std::move(tmp);
-          }
-        }
-        result.Set("symbolicLink", Napi::String::New(env, symUtf8));
+        result.Set("symbolicLink", Napi::String::New(env, identifier));
         deferred.Resolve(result);
       };
       tsfnPromise.BlockingCall(callback);
     } else {
       auto callback = [deferred = std::move(deferred), hr](Napi::Env env, Napi::Function) mutable {
-        _com_error err(hr);
-        LPCTSTR errMsg = err.ErrorMessage();
-        std::string messageBody;
-#ifdef UNICODE
-        if (errMsg) {
-          int len = WideCharToMultiByte(CP_UTF8, 0, errMsg, -1, NULL, 0, NULL, NULL);
-          if (len > 0) {
-            std::string tmp(len, '\0');
-            WideCharToMultiByte(CP_UTF8, 0, errMsg, -1, &tmp[0], len, NULL, NULL);
-            // remove trailing null
-            if (!tmp.empty() && tmp.back() == '\0') tmp.pop_back();
-            messageBody = tmp;
-          }
-        }
-#else
-        if (errMsg) messageBody = errMsg;
-#endif
-        char header[64];
-        sprintf_s(header, sizeof(header), "HRESULT=0x%08X: ", (unsigned)hr);
-        std::string message = std::string(header) + messageBody;
-        deferred.Reject(Napi::Error::New(env, message).Value());
+        deferred.Reject(Napi::Error::New(env, HResultToString(hr)).Value());
       };
       tsfnPromise.BlockingCall(callback);
     }
@@ -396,29 +260,6 @@ Napi::Value Camera::ClaimDeviceAsync(const Napi::CallbackInfo& info) {
   return deferred.Promise();
 }
 
-// Helper: convert HRESULT to string
-static std::string HResultToString(HRESULT hr) {
-  _com_error err(hr);
-  LPCTSTR errMsg = err.ErrorMessage();
-  std::string messageBody;
-#ifdef UNICODE
-  if (errMsg) {
-    int len = WideCharToMultiByte(CP_UTF8, 0, errMsg, -1, NULL, 0, NULL, NULL);
-    if (len > 0) {
-      std::string tmp(len, '\0');
-      WideCharToMultiByte(CP_UTF8, 0, errMsg, -1, &tmp[0], len, NULL, NULL);
-      if (!tmp.empty() && tmp.back() == '\0') tmp.pop_back();
-      messageBody = tmp;
-    }
-  }
-#else
-  if (errMsg) messageBody = errMsg;
-#endif
-  char header[64];
-  sprintf_s(header, sizeof(header), "HRESULT=0x%08X: ", (unsigned)hr);
-  return std::string(header) + messageBody;
-}
-
 Napi::Value Camera::GetSupportedFormatsAsync(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
@@ -433,11 +274,11 @@ Napi::Value Camera::GetSupportedFormatsAsync(const Napi::CallbackInfo& info) {
 
   std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise)]() mutable {
     try {
-      std::vector<std::tuple<GUID, UINT32, UINT32, double>> types;
+      std::vector<CaptureFormat> types;
       HRESULT hr = S_OK;
 
-      if (this->device != nullptr) {
-        hr = this->device->GetSupportedFormats(types);
+      if (this->claimed) {
+        hr = this->backend->GetSupportedFormats(types);
       } else {
         auto callback = [deferred = std::move(deferred)](Napi::Env env, Napi::Function) mutable {
           deferred.Reject(Napi::Error::New(env, "No initialized device. Call claimDeviceAsync first to initialize the device before enumerating formats.").Value());
@@ -460,24 +301,7 @@ Napi::Value Camera::GetSupportedFormatsAsync(const Napi::CallbackInfo& info) {
       auto callback = [deferred = std::move(deferred), types = std::move(types)](Napi::Env env, Napi::Function) mutable {
         Napi::Array arr = Napi::Array::New(env, static_cast<uint32_t>(types.size()));
         for (uint32_t i = 0; i < types.size(); ++i) {
-          Napi::Object obj = Napi::Object::New(env);
-          GUID g = std::get<0>(types[i]);
-          // Use short friendly name when possible (e.g., "MJPEG", "NV12")
-          std::string subtypeName = SubtypeGuidToName(g);
-          std::string guidStr = GuidToString(g);
-          UINT32 w = std::get<1>(types[i]);
-          UINT32 h = std::get<2>(types[i]);
-          double fr = std::get<3>(types[i]);
-
-          obj.Set("subtype", Napi::String::New(env, subtypeName));
-          obj.Set("guid", Napi::String::New(env, guidStr));
-          obj.Set("width", Napi::Number::New(env, w));
-          obj.Set("height", Napi::Number::New(env, h));
-          obj.Set("frameRate", Napi::Number::New(env, fr));
-          // also set legacy frameRate for compatibility
-          obj.Set("frameRate", Napi::Number::New(env, fr));
-
-          arr.Set(i, obj);
+          arr.Set(i, FormatToObject(env, types[i]));
         }
         deferred.Resolve(arr);
       };
@@ -495,59 +319,17 @@ Napi::Value Camera::GetSupportedFormatsAsync(const Napi::CallbackInfo& info) {
   return deferred.Promise();
 }
 
-// Helper: map common subtype strings to GUIDs
-static bool ParseSubtypeString(const std::string& s, GUID& out) {
-  // Accept several common names (case-insensitive)
-  std::string u = s;
-  for (auto& c : u) c = (char)tolower(c);
-  if (u == "nv12") {
-    out = MFVideoFormat_NV12;
-    return true;
-  }
-  if (u == "rgb24" || u == "bgr24") {
-    out = MFVideoFormat_RGB24;
-    return true;
-  }
-  if (u == "rgb32" || u == "bgra" || u == "rgba") {
-    out = MFVideoFormat_RGB32;
-    return true;
-  }
-  if (u == "yuy2" || u == "yuyv" || u == "yuv2" || u == "yuv") {
-    out = MFVideoFormat_YUY2;
-    return true;
-  }
-  if (u == "mjpg" || u == "mjpeg" || u == "mjepg" || u == "mjpg") {
-    out = MFVideoFormat_MJPG;
-    return true;
-  }
-  // Attempt to parse a GUID string of the form {xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}
-  // Note: Simple parser; if parsing fails return false.
-  if (u.size() >= 36) {
-    // Use CLSIDFromString which accepts wide string
-    wchar_t wbuf[64];
-    size_t needed = 0;
-    mbstowcs_s(&needed, wbuf, s.c_str(), _TRUNCATE);
-    CLSID clsid;
-    HRESULT hr = CLSIDFromString(wbuf, &clsid);
-    if (SUCCEEDED(hr)) {
-      out = clsid;
-      return true;
-    }
-  }
-  return false;
-}
-
 Napi::Value Camera::SetFormatAsync(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  if (!this->device) {
+  if (!this->claimed) {
     Napi::TypeError::New(env, "Device not initialized").ThrowAsJavaScriptException();
     return env.Null();
   }
 
   // Accept only a single object: { subtype: string, width: number, height: number, frameRate: number }
   std::string subtypeStr;
-  UINT32 width = 0, height = 0;
+  uint32_t width = 0, height = 0;
   double frameRate = 0.0;
 
   if (!(info.Length() == 1 && info[0].IsObject())) {
@@ -587,31 +369,29 @@ Napi::Value Camera::SetFormatAsync(const Napi::CallbackInfo& info) {
     frameRate = obj.Get("frameRate").As<Napi::Number>().DoubleValue();
   }
 
-  GUID subtypeGuid = {0};
+  CaptureFormat format;
   // If a GUID string was provided, try parsing it first
   if (info[0].As<Napi::Object>().Has("guid") && info[0].As<Napi::Object>().Get("guid").IsString()) {
     std::string guidInput = info[0].As<Napi::Object>().Get("guid").As<Napi::String>().Utf8Value();
-    wchar_t wbuf[64];
-    size_t needed = 0;
-    mbstowcs_s(&needed, wbuf, guidInput.c_str(), _TRUNCATE);
-    CLSID clsid;
-    if (SUCCEEDED(CLSIDFromString(wbuf, &clsid))) {
-      subtypeGuid = clsid;
-    } else if (!subtypeStr.empty()) {
-      if (!ParseSubtypeString(subtypeStr, subtypeGuid)) {
+    if (!ResolveFormat(*this->backend, guidInput, format)) {
+      if (subtypeStr.empty()) {
+        Napi::TypeError::New(env, "Invalid 'guid' string and no 'subtype' provided").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+      if (!ResolveFormat(*this->backend, subtypeStr, format)) {
         Napi::TypeError::New(env, "Unknown subtype string or invalid GUID").ThrowAsJavaScriptException();
         return env.Null();
       }
-    } else {
-      Napi::TypeError::New(env, "Invalid 'guid' string and no 'subtype' provided").ThrowAsJavaScriptException();
-      return env.Null();
     }
   } else {
-    if (!ParseSubtypeString(subtypeStr, subtypeGuid)) {
+    if (!ResolveFormat(*this->backend, subtypeStr, format)) {
       Napi::TypeError::New(env, "Unknown subtype string or invalid GUID").ThrowAsJavaScriptException();
       return env.Null();
     }
   }
+  format.width = width;
+  format.height = height;
+  format.frameRate = frameRate;
 
   auto deferred = Napi::Promise::Deferred::New(env);
 
@@ -622,12 +402,11 @@ Napi::Value Camera::SetFormatAsync(const Napi::CallbackInfo& info) {
       0,
       1);
 
-  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise), subtypeGuid, width, height, frameRate]() mutable {
+  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise), format, width, height]() mutable {
     try {
-      // No validation against GetLastSupportedFormats here; forward request to
-      // CCapture::SetFormat which will return an HRESULT indicating success or failure.
-
-      HRESULT hr = this->device->SetFormat(subtypeGuid, width, height, frameRate);
+      // No validation against the supported formats here; the backend returns
+      // an HRESULT indicating success or failure.
+      HRESULT hr = this->backend->SetFormat(format);
       if (FAILED(hr)) {
         auto callback = [deferred = std::move(deferred), hr](Napi::Env env, Napi::Function) mutable {
           std::string msg = HResultToString(hr);
@@ -663,7 +442,7 @@ Napi::Value Camera::SetFormatAsync(const Napi::CallbackInfo& info) {
 Napi::Value Camera::SetOutputFormatAsync(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  if (!this->device) {
+  if (!this->claimed) {
     Napi::TypeError::New(env, "Device not initialized").ThrowAsJavaScriptException();
     return env.Null();
   }
@@ -671,15 +450,17 @@ Napi::Value Camera::SetOutputFormatAsync(const Napi::CallbackInfo& info) {
   auto deferred = Napi::Promise::Deferred::New(env);
 
   // Accept null/undefined to clear output format, or a string like "RGB32", "NV12", etc.
-  GUID outputGuid = GUID_NULL;
+  PixelFormat outputFormat = PixelFormat::Unknown;
   bool clearFormat = false;
 
   if (info.Length() == 0 || info[0].IsNull() || info[0].IsUndefined()) {
     clearFormat = true;
   } else if (info[0].IsString()) {
     std::string formatStr = info[0].As<Napi::String>().Utf8Value();
-    if (!ParseSubtypeString(formatStr, outputGuid)) {
-      Napi::TypeError::New(env, "Unknown output format. Use 'RGB32', 'RGB24', 'NV12', 'YUY2', or a GUID string.").ThrowAsJavaScriptException();
+    CaptureFormat resolved;
+    if (ResolveFormat(*this->backend, formatStr, resolved)) outputFormat = resolved.format;
+    if (outputFormat == PixelFormat::Unknown) {
+      Napi::TypeError::New(env, "Unknown output format. Use 'RGB32', 'RGB24', 'RGBA', 'NV12', 'IYUV', 'YUY2', 'UYVY', 'MJPEG', or a GUID string.").ThrowAsJavaScriptException();
       return env.Null();
     }
   } else {
@@ -689,15 +470,10 @@ Napi::Value Camera::SetOutputFormatAsync(const Napi::CallbackInfo& info) {
 
   auto tsfnPromise = Napi::ThreadSafeFunction::New(env, Napi::Function(), "SetOutputFormatAsync", 0, 1);
 
-  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise), outputGuid, clearFormat]() mutable {
+  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise), outputFormat, clearFormat]() mutable {
     try {
-      HRESULT hr = S_OK;
-
-      if (clearFormat) {
-        this->device->ClearOutputFormat();
-      } else {
-        hr = this->device->SetOutputFormat(outputGuid);
-      }
+      // PixelFormat::Unknown clears the output format
+      HRESULT hr = this->backend->SetOutputFormat(outputFormat);
 
       if (FAILED(hr)) {
         auto callback = [deferred = std::move(deferred), hr](Napi::Env env, Napi::Function) mutable {
@@ -732,16 +508,15 @@ Napi::Value Camera::GetDimensions(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   Napi::Object result = Napi::Object::New(env);
 
-  if (!this->device) {
+  if (!this->claimed) {
     result.Set("width", env.Null());
     result.Set("height", env.Null());
     result.Set("frameRate", env.Null());
     return result;
   }
 
-  UINT32 w = 0, h = 0;
-  double fr = 0.0;
-  HRESULT hr = this->device->GetCurrentDimensions(&w, &h, &fr);
+  CaptureFormat current;
+  HRESULT hr = this->backend->GetCurrentFormat(current);
   if (FAILED(hr)) {
     result.Set("width", env.Null());
     result.Set("height", env.Null());
@@ -749,8 +524,8 @@ Napi::Value Camera::GetDimensions(const Napi::CallbackInfo& info) {
     return result;
   }
 
-  result.Set("width", Napi::Number::New(env, w));
-  result.Set("height", Napi::Number::New(env, h));
+  result.Set("width", Napi::Number::New(env, current.width));
+  result.Set("height", Napi::Number::New(env, current.height));
   return result;
 }
 
@@ -768,13 +543,32 @@ Napi::Value Camera::ReleaseDeviceAsync(const Napi::CallbackInfo& info) {
       0,
       1);
 
+  // Releasing stops capture and resets the output format. Delivery ends as
+  // in StopCaptureAsync; pending pulls and readInto requests resolve with
+  // null once the backend has stopped writing into their buffers.
+  ReleaseFrameTarget();
+  this->backend->SetFrameCallback(nullptr);
+  this->backend->SetFrameGate(nullptr);
+  this->backend->SetFrameTap(nullptr);
+  this->backend->SetFrameDestination(nullptr);
+  CloseFrameRing(env);
+  std::shared_ptr<FrameRecorder> recorder = std::move(this->recorder);
+
   // Start async operation
-  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise)]() mutable {
+  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise), recorder]() mutable {
     try {
-      HRESULT hr = device->ReleaseDevice();
+      HRESULT hr = this->backend->ReleaseDevice();
+      this->claimed = false;
+      if (recorder) recorder->Close();
+      if (this->frameTsfn) {
+        this->frameTsfn.Release();
+        this->frameTsfn = Napi::ThreadSafeFunction();
+      }
 
       if (SUCCEEDED(hr)) {
-        auto callback = [deferred = std::move(deferred)](Napi::Env env, Napi::Function) mutable {
+        auto callback = [deferred = std::move(deferred), this](Napi::Env env, Napi::Function) mutable {
+          this->isCapturing = false;
+          if (this->framePull) this->framePull->Close(env);
           Napi::Object result = Napi::Object::New(env);
           result.Set("success", Napi::Boolean::New(env, true));
           result.Set("message", Napi::String::New(env, "Device released successfully"));
@@ -783,17 +577,18 @@ Napi::Value Camera::ReleaseDeviceAsync(const Napi::CallbackInfo& info) {
 
         tsfnPromise.BlockingCall(callback);
       } else {
-        auto callback = [deferred = std::move(deferred), hr](Napi::Env env, Napi::Function) mutable {
-          _com_error err(hr);
-          LPCTSTR errMsg = err.ErrorMessage();
-          std::string message = errMsg;
-          deferred.Reject(Napi::Error::New(env, message).Value());
+        auto callback = [deferred = std::move(deferred), hr, this](Napi::Env env, Napi::Function) mutable {
+          this->isCapturing = false;
+          if (this->framePull) this->framePull->Close(env);
+          deferred.Reject(Napi::Error::New(env, HResultToString(hr)).Value());
         };
 
         tsfnPromise.BlockingCall(callback);
       }
     } catch (const std::exception& e) {
-      auto callback = [deferred = std::move(deferred), message = std::string(e.what())](Napi::Env env, Napi::Function) mutable {
+      auto callback = [deferred = std::move(deferred), message = std::string(e.what()), this](Napi::Env env, Napi::Function) mutable {
+        this->isCapturing = false;
+        if (this->framePull) this->framePull->Close(env);
         deferred.Reject(Napi::Error::New(env, message).Value());
       };
 
@@ -806,65 +601,320 @@ Napi::Value Camera::ReleaseDeviceAsync(const Napi::CallbackInfo& info) {
   return deferred.Promise();
 }
 
+// Atomics.notify(control, kRingSignal): wakes ring consumers blocked in
+// FrameRingReader.wait / waitAsync.
+static void NotifyFrameRing(Napi::Env env, Napi::Int32Array control) {
+  Napi::Object atomics = env.Global().Get("Atomics").As<Napi::Object>();
+  Napi::Function notify = atomics.Get("notify").As<Napi::Function>();
+  notify.Call(atomics, {control, Napi::Number::New(env, kRingSignal)});
+}
+
+// Ask the JS thread to notify blocked ring consumers. FrameRing::Publish
+// coalesces requests, so at most one is pending however fast frames arrive.
+// V8 offers no way to wake Atomics.wait from a native thread; while this
+// thread is busy, consumers rely on the bounded waits in frame_ring.js.
+static void ScheduleRingWake(Napi::ThreadSafeFunction tsfn, std::shared_ptr<FrameRing> ring, Camera* camera) {
+  auto wake = [ring, camera](Napi::Env env, Napi::Function) {
+    ring->WakeDone();
+    // The camera detaches the ring before dropping the control array or
+    // being destroyed, so an attached ring means `camera` is alive.
+    if (static_cast<napi_env>(env) == nullptr || !ring->Attached()) return;
+    NotifyFrameRing(env, camera->frameRingControl.Value());
+  };
+  if (tsfn.NonBlockingCall(wake) != napi_ok) ring->WakeDone();
+}
+
+void Camera::ReleaseFrameTarget() {
+  if (this->deliveryCancel) this->deliveryCancel->store(true);
+  if (!this->frameTarget) return;
+  // A FrameSink outlives the session and may be started into again; only
+  // release a capture thread blocked on it.
+  if (this->ownsFrameTarget) {
+    this->frameTarget->Close();
+  } else {
+    this->frameTarget->CancelProducers();
+  }
+}
+
+void Camera::CloseFrameRing(Napi::Env env) {
+  if (!this->frameRing) return;
+  this->frameRing->Detach();
+  if (!this->frameRingControl.IsEmpty()) {
+    NotifyFrameRing(env, this->frameRingControl.Value());
+    this->frameRingControl.Reset();
+  }
+}
+
 Napi::Value Camera::StartCaptureAsync(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  if (!this->device) {
+  if (!this->claimed) {
     Napi::TypeError::New(env, "Device not initialized").ThrowAsJavaScriptException();
     return env.Null();
   }
   auto deferred = Napi::Promise::Deferred::New(env);
 
+  // Optional second argument:
+  //   { zeroCopy?: boolean, maxInFlightFrames?: number, queueSize?: number, dropPolicy?: string,
+  //     conversionThreads?: number, conversionBandHeight?: number, deviceBufferCount?: number,
+  //     record?: string, jpegQuality?: number, jpegSubsampling?: string, ring?: Int32Array,
+  //     target?: number, pull?: { latestOnly?: boolean }, decimate?: number,
+  //     targetFrameRate?: number }
+  // Zero-copy (default) hands the native frame storage to JS as an external
+  // Buffer; the frame is returned to the device's frame pool from the Buffer's
+  // finalizer. maxInFlightFrames bounds how many pooled frames may be out at once.
+  // queueSize/dropPolicy configure the bounded queue in front of the frame TSFN.
+  // conversionThreads/conversionBandHeight size the banded conversion pool.
+  // deviceBufferCount sizes the kernel buffer ring (V4L2; ignored elsewhere).
+  // record writes every captured frame, in the device format and with its
+  // device timestamp, to a recording file for the replay backend.
+  // jpegQuality (0..1) and jpegSubsampling ('420', '422', '444', '440' or
+  // 'default') tune PixelFormat JPEG output.
+  // ring (an Int32Array over a SharedArrayBuffer laid out by createFrameRing)
+  // delivers frames through shared memory instead of 'frame' events; the
+  // queue options do not apply then.
+  // target (a FrameSink id, possibly of a sink created in a worker) delivers
+  // frames to that sink's callback on the sink's thread instead; the sink's
+  // own queue options apply then.
+  // pull switches to on-demand delivery through pullFrameAsync: frames are
+  // only converted and copied for pending requests (latestOnly) or while
+  // fewer than queueSize are waiting to be pulled.
+  // decimate (keep one frame in N) and targetFrameRate (frames per second,
+  // picked by timestamp) drop frames in the backend before they are locked,
+  // converted or copied, whatever the delivery mode.
+  bool zeroCopy = true;
+  size_t maxInFlight = FramePool::kDefaultMaxInFlight;
+  size_t queueSize = 4;
+  DropPolicy dropPolicy = DropPolicy::DropOldest;
+  size_t conversionThreads = 0;
+  size_t conversionBandHeight = 0;
+  size_t deviceBufferCount = 0;
+  std::string recordPath;
+  JpegOptions jpegOptions;
+  Napi::Int32Array ringControl;
+  std::shared_ptr<FrameTarget> sinkTarget;
+  bool pull = false;
+  bool pullLatestOnly = false;
+  std::shared_ptr<FrameDecimator> decimator;
+  if (info.Length() > 1 && info[1].IsObject()) {
+    Napi::Object opts = info[1].As<Napi::Object>();
+    if (opts.Has("zeroCopy") && opts.Get("zeroCopy").IsBoolean()) {
+      zeroCopy = opts.Get("zeroCopy").As<Napi::Boolean>().Value();
+    }
+    if (opts.Has("maxInFlightFrames") && opts.Get("maxInFlightFrames").IsNumber()) {
+      maxInFlight = opts.Get("maxInFlightFrames").As<Napi::Number>().Uint32Value();
+    }
+    if (opts.Has("queueSize") && opts.Get("queueSize").IsNumber()) {
+      queueSize = opts.Get("queueSize").As<Napi::Number>().Uint32Value();
+    }
+    if (opts.Has("dropPolicy") && opts.Get("dropPolicy").IsString()) {
+      std::string policyStr = opts.Get("dropPolicy").As<Napi::String>().Utf8Value();
+      if (!ParseDropPolicy(policyStr, dropPolicy)) {
+        Napi::TypeError::New(env, "Unknown dropPolicy. Use 'drop-oldest', 'drop-newest', 'latest-only' or 'block'.").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+    }
+    if (opts.Has("conversionThreads") && opts.Get("conversionThreads").IsNumber()) {
+      conversionThreads = opts.Get("conversionThreads").As<Napi::Number>().Uint32Value();
+    }
+    if (opts.Has("conversionBandHeight") && opts.Get("conversionBandHeight").IsNumber()) {
+      conversionBandHeight = opts.Get("conversionBandHeight").As<Napi::Number>().Uint32Value();
+    }
+    if (opts.Has("deviceBufferCount") && opts.Get("deviceBufferCount").IsNumber()) {
+      deviceBufferCount = opts.Get("deviceBufferCount").As<Napi::Number>().Uint32Value();
+    }
+    if (opts.Has("record") && opts.Get("record").IsString()) {
+      recordPath = opts.Get("record").As<Napi::String>().Utf8Value();
+    }
+    if (opts.Has("jpegQuality") && opts.Get("jpegQuality").IsNumber()) {
+      double quality = opts.Get("jpegQuality").As<Napi::Number>().DoubleValue();
+      if (!(quality >= 0.0 && quality <= 1.0)) {
+        Napi::TypeError::New(env, "jpegQuality must be between 0 and 1").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+      jpegOptions.quality = static_cast<float>(quality);
+    }
+    if (opts.Has("jpegSubsampling") && opts.Get("jpegSubsampling").IsString()) {
+      std::string subsamplingStr = opts.Get("jpegSubsampling").As<Napi::String>().Utf8Value();
+      if (!ParseJpegSubsampling(subsamplingStr, jpegOptions.subsampling)) {
+        Napi::TypeError::New(env, "Unknown jpegSubsampling. Use '420', '422', '444', '440' or 'default'.").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+    }
+    if (opts.Has("ring") && !opts.Get("ring").IsUndefined() && !opts.Get("ring").IsNull()) {
+      Napi::Value ringValue = opts.Get("ring");
+      if (!ringValue.IsTypedArray() || ringValue.As<Napi::TypedArray>().TypedArrayType() != napi_int32_array) {
+        Napi::TypeError::New(env, "ring must be a SharedArrayBuffer created by createFrameRing()").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+      ringControl = ringValue.As<Napi::Int32Array>();
+    }
+    if (opts.Has("target") && !opts.Get("target").IsUndefined() && !opts.Get("target").IsNull()) {
+      Napi::Value targetValue = opts.Get("target");
+      if (targetValue.IsNumber()) sinkTarget = FrameTarget::Find(targetValue.As<Napi::Number>().Uint32Value());
+      if (!sinkTarget) {
+        Napi::TypeError::New(env, "target must be the id of an open FrameSink").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+      if (!ringControl.IsEmpty()) {
+        Napi::TypeError::New(env, "ring and target cannot be used together").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+    }
+    if (opts.Has("pull") && opts.Get("pull").IsObject()) {
+      Napi::Object pullOpts = opts.Get("pull").As<Napi::Object>();
+      pull = true;
+      if (pullOpts.Has("latestOnly") && pullOpts.Get("latestOnly").IsBoolean()) {
+        pullLatestOnly = pullOpts.Get("latestOnly").As<Napi::Boolean>().Value();
+      }
+      if (!ringControl.IsEmpty() || sinkTarget) {
+        Napi::TypeError::New(env, "pull cannot be combined with ring or target").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+    }
+    const bool hasDecimate = opts.Has("decimate") && !opts.Get("decimate").IsUndefined() && !opts.Get("decimate").IsNull();
+    const bool hasTargetRate = opts.Has("targetFrameRate") && !opts.Get("targetFrameRate").IsUndefined() && !opts.Get("targetFrameRate").IsNull();
+    if (hasDecimate && hasTargetRate) {
+      Napi::TypeError::New(env, "decimate and targetFrameRate cannot be used together").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    if (hasDecimate) {
+      double step = opts.Get("decimate").IsNumber() ? opts.Get("decimate").As<Napi::Number>().DoubleValue() : 0.0;
+      if (!(step >= 1.0 && step <= 4294967295.0) || step != static_cast<double>(static_cast<uint32_t>(step))) {
+        Napi::TypeError::New(env, "decimate must be a positive integer").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+      if (step > 1.0) decimator = FrameDecimator::EveryNth(static_cast<uint32_t>(step));
+    }
+    if (hasTargetRate) {
+      double rate = opts.Get("targetFrameRate").IsNumber() ? opts.Get("targetFrameRate").As<Napi::Number>().DoubleValue() : 0.0;
+      if (!(rate > 0.0) || !std::isfinite(rate)) {
+        Napi::TypeError::New(env, "targetFrameRate must be a positive number").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+      decimator = FrameDecimator::TargetRate(rate);
+    }
+  }
+
+  // A ring left over from a session that failed to start is closed first.
+  CloseFrameRing(env);
+  std::shared_ptr<FrameRing> ring;
+  if (!ringControl.IsEmpty()) {
+    ring = std::make_shared<FrameRing>();
+    HRESULT hr = ring->Attach(reinterpret_cast<uint8_t*>(ringControl.Data()), ringControl.ElementLength() * sizeof(int32_t));
+    if (FAILED(hr)) {
+      const char* message = hr == CAPTURE_E_BUSY ? "ring is already written by another capture" : "ring is not a frame ring created by createFrameRing()";
+      Napi::TypeError::New(env, message).ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    this->frameRingControl = Napi::Persistent(ringControl);
+  }
+  this->frameRing = ring;
+
   // Create a TSFN to resolve/reject the start promise from the worker thread.
   auto tsfnPromise = Napi::ThreadSafeFunction::New(env, Napi::Function(), "StartCaptureAsync", 0, 1);
 
-  // Expect a JS function to receive frames as first arg (optional)
-  if (info.Length() > 0 && info[0].IsFunction()) {
-    // Store the TSFN on the Camera instance for lifecycle management
-    this->frameTsfn = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "FrameCallback", 0, 1);
+  // Stored on the Camera instance for lifecycle management; it also keeps
+  // this environment alive while capturing, whatever the frames' target.
+  this->frameTsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "FrameCallback", 0, 1);
+
+  // Frames go to the first argument (optional) in this environment unless
+  // a sink or the ring takes them.
+  ReleaseFrameTarget();
+  if (this->framePull) this->framePull->Close(env);
+  this->framePull = pull ? FramePullSource::Create(env, pullLatestOnly, queueSize, zeroCopy) : nullptr;
+  if (sinkTarget) {
+    this->frameTarget = sinkTarget;
+    this->ownsFrameTarget = false;
+  } else if (!ring && !pull) {
+    Napi::Function callback = info.Length() > 0 && info[0].IsFunction() ? info[0].As<Napi::Function>() : Napi::Function::New(env, [](const Napi::CallbackInfo&) {});
+    this->frameTarget = FrameTarget::Create(env, callback, queueSize, dropPolicy, zeroCopy, this->frameInfoSlots);
+    this->ownsFrameTarget = true;
   } else {
-    // Create a no-op TSFN stored on the Camera instance
-    this->frameTsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "FrameCallback", 0, 1);
+    this->frameTarget = nullptr;
   }
+  this->deliveryCancel = std::make_shared<std::atomic<bool>>(false);
+
+  this->backend->SetMaxInFlightFrames(maxInFlight);
+  this->backend->SetConversionThreads(conversionThreads, conversionBandHeight);
+  this->backend->SetJpegOptions(jpegOptions);
+  this->backend->SetDeviceBufferCount(deviceBufferCount);
 
-  // Register CCapture frame callback which forwards buffers via the stored TSFN
+  // Register the backend frame callback: frames go into the target's bounded
+  // queue, whose environment is only poked when it is not already draining it.
   Napi::ThreadSafeFunction tsfnLocal = this->frameTsfn;
-  this->device->SetFrameCallback([tsfnLocal](std::vector<uint8_t>&& buf) mutable {
-    // Move vector into heap and pass pointer to TSFN
-    std::vector<uint8_t>* heapBuf = new std::vector<uint8_t>(std::move(buf));
-    auto cb = [](Napi::Env env, Napi::Function jsCallback, std::vector<uint8_t>* data) {
-      Napi::Buffer<uint8_t> nodeBuf = Napi::Buffer<uint8_t>::Copy(env, data->data(), data->size());
-      jsCallback.Call({nodeBuf});
-      delete data;
-    };
-    // Use non-blocking call to avoid deadlocks
-    tsfnLocal.NonBlockingCall(heapBuf, cb);
-  });
-
-  // Move the actual StartCapture call to a worker thread that initializes COM.
-  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise)]() mutable {
-    HRESULT hrCo = CoInitializeEx(NULL, COINIT_MULTITHREADED);
-    bool coInitialized = SUCCEEDED(hrCo);
+  std::shared_ptr<FrameTarget> target = this->frameTarget;
+  std::shared_ptr<std::atomic<bool>> cancel = this->deliveryCancel;
+  // Opened on the worker thread once the delivered format is known
+  std::shared_ptr<FrameRecorder> recorder = recordPath.empty() ? nullptr : std::make_shared<FrameRecorder>();
+  this->recorder = recorder;
+  std::shared_ptr<FramePullSource> pullSource = this->framePull;
+  this->frameDecimator = decimator;
+  if (pullSource || decimator) {
+    // Decimation first: pulls only wait for (and count) frames it keeps
+    this->backend->SetFrameGate([pullSource, decimator](int64_t deviceTimeUs) {
+      if (decimator && !decimator->Admit(deviceTimeUs)) return false;
+      return !pullSource || pullSource->Wanted();
+    });
+  } else {
+    this->backend->SetFrameGate(nullptr);
+  }
+  // Recorded where the backend receives each frame: device timing and
+  // format, before the gate, conversion and any queue drop
+  if (recorder) {
+    this->backend->SetFrameTap([recorder](const uint8_t* data, size_t size, const FrameInfo& info) { recorder->Write(data, size, info); });
+  } else {
+    this->backend->SetFrameTap(nullptr);
+  }
+  // readInto requests over shared memory take the frames they answer
+  // straight into their buffers
+  this->backend->SetFrameDestination(pullSource);
+  if (pullSource) {
+    this->backend->SetFrameCallback([pullSource](FramePtr frame) {
+      pullSource->Push(std::move(frame));
+    });
+  } else if (ring) {
+    // Frames are copied into the ring and go back to the pool right away; JS
+    // is only called when a consumer is blocked waiting.
+    Camera* camera = this;
+    this->backend->SetFrameCallback([tsfnLocal, ring, camera](FramePtr frame) {
+      if (ring->Publish(*frame)) ScheduleRingWake(tsfnLocal, ring, camera);
+    });
+  } else {
+    this->backend->SetFrameCallback([target, cancel](FramePtr frame) {
+      target->Push(std::move(frame), cancel.get());
+    });
+  }
 
+  // Move the actual StartCapture call to a worker thread; backends may block
+  // while the device spins up.
+  std::thread([this, deferred = std::move(deferred), tsfnPromise = std::move(tsfnPromise), recorder, recordPath, decimator]() mutable {
     HRESULT hr = S_OK;
-    EncodingParameters params = {0, 0};
-
-    if (!this->device) {
-      hr = E_FAIL;
-    } else {
-      // about to call device->StartCapture
-      hr = this->device->StartCapture(this->claimedActivate, params);
-      // device->StartCapture returned (hr logged by caller if needed)
+    if (decimator) {
+      // targetFrameRate places frames by the format's frame period
+      CaptureFormat format;
+      if (SUCCEEDED(this->backend->GetCurrentFormat(format))) decimator->SetSourceRate(format.frameRate);
+    }
+    if (recorder) {
+      // Frames are recorded in the device format
+      CaptureFormat format;
+      hr = this->backend->GetCurrentFormat(format);
+      if (SUCCEEDED(hr)) hr = recorder->Open(recordPath, format);
     }
+    if (SUCCEEDED(hr)) hr = this->backend->StartCapture();
 
     if (FAILED(hr)) {
-      // On failure, cleanup the TSFN stored on the instance
+      // On failure, cleanup the delivery target and TSFN stored on the instance
+      this->ReleaseFrameTarget();
+      if (recorder) recorder->Close();
       if (this->frameTsfn) {
         this->frameTsfn.Release();
         this->frameTsfn = Napi::ThreadSafeFunction();
       }
 
-      auto callback = [deferred = std::move(deferred), hr](Napi::Env env, Napi::Function) mutable {
+      auto callback = [deferred = std::move(deferred), hr, this](Napi::Env env, Napi::Function) mutable {
+        this->CloseFrameRing(env);
+        if (this->framePull) this->framePull->Close(env);
         deferred.Reject(Napi::Error::New(env, HResultToString(hr)).Value());
       };
       tsfnPromise.BlockingCall(callback);
@@ -880,9 +930,6 @@ Napi::Value Camera::StartCaptureAsync(const Napi::CallbackInfo& info) {
       tsfnPromise.BlockingCall(callback);
     }
 
-    if (coInitialized) {
-      CoUninitialize();
-    }
     tsfnPromise.Release();
   }).detach();
 
@@ -893,14 +940,32 @@ Napi::Value Camera::StopCaptureAsync(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   auto deferred = Napi::Promise::Deferred::New(env);
 
-  if (!this->device) {
+  if (!this->claimed) {
     deferred.Reject(Napi::Error::New(env, "Device not initialized").Value());
     return deferred.Promise();
   }
 
-  // Clear the device frame callback first so internal state is reset cleanly.
-  this->device->SetFrameCallback(nullptr);
-  HRESULT hr = this->device->EndCaptureSession();
+  // Release the delivery target first: it releases a capture thread blocked
+  // by the 'block' policy, which would otherwise hold the capture lock that
+  // StopCapture needs (and drops queued frames unless a FrameSink owns them).
+  ReleaseFrameTarget();
+  // Clear the device frame callback so internal state is reset cleanly.
+  this->backend->SetFrameCallback(nullptr);
+  this->backend->SetFrameGate(nullptr);
+  this->backend->SetFrameTap(nullptr);
+  this->backend->SetFrameDestination(nullptr);
+  HRESULT hr = this->backend->StopCapture();
+  // Pending pulls resolve with null, ending cam.frames(). Closed only once
+  // the capture threads are done with the shared readInto buffers.
+  if (this->framePull) this->framePull->Close(env);
+  // Consumers blocked on the ring wake up and see it stopped
+  CloseFrameRing(env);
+  if (this->recorder) {
+    // No frame callback runs once StopCapture has returned
+    HRESULT recordHr = this->recorder->Close();
+    this->recorder.reset();
+    if (SUCCEEDED(hr) && FAILED(recordHr)) hr = recordHr;
+  }
   if (FAILED(hr)) {
     deferred.Reject(Napi::Error::New(env, HResultToString(hr)).Value());
   } else {
@@ -918,3 +983,120 @@ Napi::Value Camera::StopCaptureAsync(const Napi::CallbackInfo& info) {
 
   return deferred.Promise();
 }
+
+Napi::Value Camera::GetStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object result = Napi::Object::New(env);
+  if (!this->claimed) return result;
+
+  FramePoolStats ps = this->backend->GetFramePoolStats();
+  Napi::Object pool = Napi::Object::New(env);
+  pool.Set("hits", Napi::Number::New(env, static_cast<double>(ps.hits)));
+  pool.Set("misses", Napi::Number::New(env, static_cast<double>(ps.misses)));
+  pool.Set("exhausted", Napi::Number::New(env, static_cast<double>(ps.exhausted)));
+  pool.Set("inFlight", Napi::Number::New(env, static_cast<double>(ps.inFlight)));
+  pool.Set("highWater", Napi::Number::New(env, static_cast<double>(ps.highWater)));
+  pool.Set("maxInFlight", Napi::Number::New(env, static_cast<double>(ps.maxInFlight)));
+  pool.Set("cached", Napi::Number::New(env, static_cast<double>(ps.cached)));
+  pool.Set("cachedBytes", Napi::Number::New(env, static_cast<double>(ps.cachedBytes)));
+  result.Set("pool", pool);
+
+  if (this->frameTarget) {
+    result.Set("delivery", FrameTargetStatsToObject(env, *this->frameTarget));
+  }
+
+  if (this->framePull) {
+    FramePullStats fs = this->framePull->GetStats();
+    Napi::Object pull = Napi::Object::New(env);
+    pull.Set("requested", Napi::Number::New(env, static_cast<double>(fs.requested)));
+    pull.Set("delivered", Napi::Number::New(env, static_cast<double>(fs.delivered)));
+    pull.Set("skipped", Napi::Number::New(env, static_cast<double>(fs.skipped)));
+    pull.Set("superseded", Napi::Number::New(env, static_cast<double>(fs.superseded)));
+    pull.Set("direct", Napi::Number::New(env, static_cast<double>(fs.direct)));
+    pull.Set("copied", Napi::Number::New(env, static_cast<double>(fs.copied)));
+    pull.Set("ready", Napi::Number::New(env, static_cast<double>(fs.ready)));
+    pull.Set("capacity", Napi::Number::New(env, static_cast<double>(fs.capacity)));
+    pull.Set("latestOnly", Napi::Boolean::New(env, fs.latestOnly));
+    result.Set("pull", pull);
+  }
+
+  if (this->frameDecimator) {
+    FrameDecimatorStats ds = this->frameDecimator->GetStats();
+    Napi::Object decimation = Napi::Object::New(env);
+    decimation.Set("admitted", Napi::Number::New(env, static_cast<double>(ds.admitted)));
+    decimation.Set("skipped", Napi::Number::New(env, static_cast<double>(ds.skipped)));
+    if (ds.step != 0) decimation.Set("decimate", Napi::Number::New(env, ds.step));
+    if (ds.targetRate > 0.0) decimation.Set("targetFrameRate", Napi::Number::New(env, ds.targetRate));
+    result.Set("decimation", decimation);
+  }
+
+  if (this->frameRing) {
+    FrameRingStats rs = this->frameRing->GetStats();
+    Napi::Object ring = Napi::Object::New(env);
+    ring.Set("published", Napi::Number::New(env, static_cast<double>(rs.published)));
+    ring.Set("tooLarge", Napi::Number::New(env, static_cast<double>(rs.tooLarge)));
+    ring.Set("wakes", Napi::Number::New(env, static_cast<double>(rs.wakes)));
+    ring.Set("slots", Napi::Number::New(env, rs.slots));
+    ring.Set("slotBytes", Napi::Number::New(env, rs.slotBytes));
+    result.Set("ring", ring);
+  }
+
+  ProcessingStageStats st = this->backend->GetProcessingStats();
+  if (st.capacity > 0) {
+    Napi::Object processing = Napi::Object::New(env);
+    processing.Set("queued", Napi::Number::New(env, static_cast<double>(st.queued)));
+    processing.Set("processed", Napi::Number::New(env, static_cast<double>(st.processed)));
+    processing.Set("dropped", Napi::Number::New(env, static_cast<double>(st.dropped)));
+    processing.Set("depth", Napi::Number::New(env, static_cast<double>(st.depth)));
+    processing.Set("highWater", Napi::Number::New(env, static_cast<double>(st.highWater)));
+    processing.Set("capacity", Napi::Number::New(env, static_cast<double>(st.capacity)));
+    processing.Set("meanWaitUs", Napi::Number::New(env, st.meanWaitUs));
+    processing.Set("maxWaitUs", Napi::Number::New(env, st.maxWaitUs));
+    processing.Set("meanProcessUs", Napi::Number::New(env, st.meanProcessUs));
+    processing.Set("maxProcessUs", Napi::Number::New(env, st.maxProcessUs));
+    result.Set("processing", processing);
+  }
+  return result;
+}
+
+Napi::Value Camera::GetBackend(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), this->backend->Name());
+}
+
+Napi::Value Camera::GetFrameInfoArray(const Napi::CallbackInfo& info) {
+  (void)info;
+  return this->frameInfo.Value();
+}
+
+Napi::Value Camera::PullFrameAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!this->framePull) {
+    Napi::Error::New(env, "Capture was not started with { pull }").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return this->framePull->Request(env);
+}
+
+Napi::Value Camera::ReadIntoAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!this->framePull) {
+    Napi::Error::New(env, "readInto needs capture started by readInto() or frames(), not 'frame' events, a ring or a FrameSink").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  // SharedArrayBuffers arrive wrapped in a Uint8Array (addon.js): N-API
+  // only recognizes them behind a view
+  if (info.Length() == 0 || !(info[0].IsArrayBuffer() || info[0].IsTypedArray() || info[0].IsDataView())) {
+    Napi::TypeError::New(env, "readInto needs an ArrayBuffer, a SharedArrayBuffer, a Buffer or another view").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  const uint32_t id = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Uint32Value() : 0;
+  return this->framePull->ReadInto(env, info[0], id);
+}
+
+Napi::Value Camera::CancelReadInto(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (this->framePull && info.Length() > 0 && info[0].IsNumber()) {
+    this->framePull->Expire(env, info[0].As<Napi::Number>().Uint32Value());
+  }
+  return env.Undefined();
+}
@@ -2,7 +2,14 @@
 #define CAMERA_H
 
 #include <napi.h>
-#include "capture.h"
+#include <atomic>
+#include <memory>
+#include "capture_backend.h"
+#include "frame_decimator.h"
+#include "frame_pull.h"
+#include "frame_recording.h"
+#include "frame_ring.h"
+#include "frame_target.h"
 
 class Camera : public Napi::ObjectWrap<Camera> {
  public:
@@ -10,9 +17,11 @@ class Camera : public Napi::ObjectWrap<Camera> {
   Camera(const Napi::CallbackInfo& info);
   ~Camera();
 
-  CCapture* device;
-  IMFActivate* claimedActivate = nullptr;
-  // Camera delegates supported-format and format-setting operations to CCapture
+  // Platform capture implementation chosen at construction
+  // ({ backend: 'mediafoundation' | 'v4l2' | 'synthetic' | 'replay' | 'auto' })
+  std::unique_ptr<CaptureBackend> backend;
+  // Set once claimDeviceAsync succeeds, cleared by releaseDeviceAsync
+  std::atomic<bool> claimed{false};
 
   Napi::Value EnumerateDevicesAsync(const Napi::CallbackInfo& info);
   Napi::Value ClaimDeviceAsync(const Napi::CallbackInfo& info);
@@ -24,8 +33,47 @@ class Camera : public Napi::ObjectWrap<Camera> {
   Napi::Value GetCameraInfoAsync(const Napi::CallbackInfo& info);
   Napi::Value SetFormatAsync(const Napi::CallbackInfo& info);
   Napi::Value SetOutputFormatAsync(const Napi::CallbackInfo& info);
-  // Thread-safe function used to deliver frames from native code to JS
+  Napi::Value GetStats(const Napi::CallbackInfo& info);
+  Napi::Value GetBackend(const Napi::CallbackInfo& info);
+  Napi::Value GetFrameInfoArray(const Napi::CallbackInfo& info);
+  Napi::Value PullFrameAsync(const Napi::CallbackInfo& info);
+  // readIntoAsync(buffer, id): the next frame written into `buffer`;
+  // cancelReadInto(id) answers it with null (cam.readInto timeouts)
+  Napi::Value ReadIntoAsync(const Napi::CallbackInfo& info);
+  Napi::Value CancelReadInto(const Napi::CallbackInfo& info);
+  // Thread-safe function for calls back into this camera's environment
+  // (ring wake-ups)
   Napi::ThreadSafeFunction frameTsfn;
+  // Where this capture session's frames go: the camera's own target (frame
+  // callback in this environment) or a FrameSink's (startCapture { target }),
+  // possibly in another environment. Null in ring mode.
+  std::shared_ptr<FrameTarget> frameTarget;
+  bool ownsFrameTarget = false;
+  // Set when the session stops, so a capture thread blocked on a FrameSink
+  // it does not own (the 'block' policy) gives up its frame
+  std::shared_ptr<std::atomic<bool>> deliveryCancel;
+  // Stop delivering to frameTarget; closes it when owned
+  void ReleaseFrameTarget();
+  // On-demand delivery (startCapture { pull }, behind cam.frames() and
+  // cam.readInto()): the backend's frame gate skips frames no pending
+  // pullFrameAsync or readIntoAsync wants. Replaces frameTarget.
+  std::shared_ptr<FramePullSource> framePull;
+  // Frame-rate reduction in the backend's frame gate (startCapture
+  // { decimate, targetFrameRate }); null when every frame is wanted
+  std::shared_ptr<FrameDecimator> frameDecimator;
+  // Shared-memory delivery (startCapture { ring }); replaces frameTarget and
+  // 'frame' events. frameRingControl is the Int32Array over the ring, kept
+  // for Atomics.notify and to hold the SharedArrayBuffer while it is written.
+  std::shared_ptr<FrameRing> frameRing;
+  Napi::Reference<Napi::Int32Array> frameRingControl;
+  // Stop writing to the ring and wake its blocked consumers
+  void CloseFrameRing(Napi::Env env);
+  // Recording of the current capture session (startCapture { record })
+  std::shared_ptr<FrameRecorder> recorder;
+  // Metadata of the frame being delivered, rewritten before each frame
+  // callback (FrameInfoSlot in frame_target.h); frameInfoSlots is its storage.
+  Napi::Reference<Napi::Float64Array> frameInfo;
+  double* frameInfoSlots = nullptr;
   bool isCapturing = false;
 };
 
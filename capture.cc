@@ -26,15 +26,58 @@
 #include <cstring>
 
 #include "capture.h"
-#include "convert.h"
 
 // Use SDK QISearch implementation (link to SDK libs via binding.gyp)
 
 HRESULT CopyAttribute(IMFAttributes* pSrc, IMFAttributes* pDest, const GUID& key);
 // Forward declaration for ConfigureSourceReader so StartCapture can call it.
 HRESULT ConfigureSourceReader(IMFSourceReader* pReader);
-// Forward declaration for helper used to deliver samples to frame callback
-static HRESULT DeliverSampleToCallback(IMFSample* pSample, std::function<void(std::vector<uint8_t>&&)>& callback);
+
+PixelFormat PixelFormatFromSubtype(const GUID& subtype) {
+  if (IsEqualGUID(subtype, MFVideoFormat_NV12)) return PixelFormat::NV12;
+  if (IsEqualGUID(subtype, MFVideoFormat_YUY2)) return PixelFormat::YUY2;
+  if (IsEqualGUID(subtype, MFVideoFormat_UYVY)) return PixelFormat::UYVY;
+  if (IsEqualGUID(subtype, MFVideoFormat_RGB24)) return PixelFormat::RGB24;
+  if (IsEqualGUID(subtype, MFVideoFormat_RGB32)) return PixelFormat::RGB32;
+  if (IsEqualGUID(subtype, MFVideoFormat_MJPG)) return PixelFormat::MJPEG;
+  if (IsEqualGUID(subtype, MFVideoFormat_IYUV) || IsEqualGUID(subtype, MFVideoFormat_I420)) return PixelFormat::IYUV;
+  return PixelFormat::Unknown;
+}
+
+GUID SubtypeFromPixelFormat(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::NV12:
+      return MFVideoFormat_NV12;
+    case PixelFormat::YUY2:
+      return MFVideoFormat_YUY2;
+    case PixelFormat::UYVY:
+      return MFVideoFormat_UYVY;
+    case PixelFormat::RGB24:
+      return MFVideoFormat_RGB24;
+    case PixelFormat::RGB32:
+      return MFVideoFormat_RGB32;
+    case PixelFormat::MJPEG:
+      return MFVideoFormat_MJPG;
+    case PixelFormat::IYUV:
+      return MFVideoFormat_IYUV;
+    case PixelFormat::RGBA:  // output only; no Media Foundation subtype
+    case PixelFormat::Unknown:
+      break;
+  }
+  return GUID_NULL;
+}
+
+// Copy a bottom-up frame (last row first, rows `stride` bytes apart) into
+// top-down, tightly packed storage of `rowBytes` * `height` bytes. False
+// when the buffer is shorter than the frame.
+static bool CopyRowsTopDown(const BYTE* src, size_t size, UINT32 stride, UINT32 rowBytes, UINT32 height, uint8_t* dst) {
+  if (rowBytes == 0 || height == 0 || stride < rowBytes) return false;
+  if (size < static_cast<size_t>(stride) * (height - 1) + rowBytes) return false;
+  for (UINT32 y = 0; y < height; ++y) {
+    memcpy(dst + static_cast<size_t>(y) * rowBytes, src + static_cast<size_t>(height - 1 - y) * stride, rowBytes);
+  }
+  return true;
+}
 
 void DeviceList::Clear() {
   for (UINT32 i = 0; i < m_cDevices; i++) {
@@ -199,10 +242,18 @@ CCapture::CCapture(HWND hwnd) : m_pReader(NULL),
                                 m_nRefCount(1),
                                 m_bFirstSample(FALSE),
                                 m_llBaseTime(0),
+                                m_pendingDiscontinuity(false),
+                                m_outputFormat(PixelFormat::Unknown),
                                 m_pwszSymbolicLink(NULL),
-                                m_outputFormat(GUID_NULL),
-                                m_pWicFactory(NULL) {
+                                m_framePool(FramePool::Create()),
+                                m_converter(m_framePool),
+                                m_jpegEncoder(m_framePool),
+                                m_stage(kProcessingDepth, [this](PendingSample& pending) { ProcessSample(pending); }) {
   InitializeCriticalSection(&m_critsec);
+  InitializeCriticalSection(&m_processCritsec);
+  m_converter.SetJpegEncoder([this](const uint8_t* pixels, uint32_t width, uint32_t height, bool bgra, const JpegOptions& options, FramePtr& outFrame) {
+    return m_jpegEncoder.Encode(pixels, width, height, bgra, options, outFrame);
+  });
 }
 
 //-------------------------------------------------------------------
@@ -211,7 +262,8 @@ CCapture::CCapture(HWND hwnd) : m_pReader(NULL),
 
 CCapture::~CCapture() {
   assert(m_pReader == NULL);
-  SafeRelease(&m_pWicFactory);
+  m_stage.Stop();
+  DeleteCriticalSection(&m_processCritsec);
   DeleteCriticalSection(&m_critsec);
 }
 
@@ -261,7 +313,7 @@ HRESULT CCapture::QueryInterface(REFIID riid, void** ppv) {
 HRESULT CCapture::OnReadSample(
     HRESULT hrStatus,
     DWORD /*dwStreamIndex*/,
-    DWORD /*dwStreamFlags*/,
+    DWORD dwStreamFlags,
     LONGLONG llTimeStamp,
     IMFSample* pSample  // Can be NULL
 ) {
@@ -279,7 +331,21 @@ HRESULT CCapture::OnReadSample(
     goto done;
   }
 
-  if (pSample) {
+  // A stream tick stands in for samples the source did not deliver
+  if (dwStreamFlags & MF_SOURCE_READERF_STREAMTICK) m_pendingDiscontinuity = true;
+  // The only per-session event that invalidates the stream descriptor
+  if (dwStreamFlags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) RefreshStreamDescriptor();
+
+  // A sample nobody wants (not even the tap) goes back to the reader untouched
+  const bool deliver = pSample && (!m_frameGate || m_frameGate(llTimeStamp / 10));
+  if (pSample && (deliver || m_frameTap)) {
+    PendingSample pending;
+    pending.arrivalUs = MonotonicMicros();
+    // Sample time is in 100 ns units
+    pending.deviceTimeUs = llTimeStamp / 10;
+    pending.deliver = deliver;
+    pending.discontinuity = deliver && (m_pendingDiscontinuity || MFGetAttributeUINT32(pSample, MFSampleExtension_Discontinuity, FALSE) != FALSE);
+
     if (m_bFirstSample) {
       m_llBaseTime = llTimeStamp;
       m_bFirstSample = FALSE;
@@ -293,42 +359,20 @@ HRESULT CCapture::OnReadSample(
     if (FAILED(hr)) {
       goto done;
     }
-    if (m_frameCallback) {
-      // Get current input format
-      IMFMediaType* pType = NULL;
-      GUID subtype = GUID_NULL;
-      UINT32 width = 0, height = 0;
-      if (SUCCEEDED(m_pReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &pType)) && pType) {
-        pType->GetGUID(MF_MT_SUBTYPE, &subtype);
-        MFGetAttributeSize(pType, MF_MT_FRAME_SIZE, &width, &height);
-        SafeRelease(&pType);
-      }
-
-      // Check if conversion needed
-      bool needsConversion = !IsEqualGUID(m_outputFormat, GUID_NULL) && !IsEqualGUID(subtype, m_outputFormat);
 
-      if (needsConversion && width > 0 && height > 0) {
-        std::vector<uint8_t> converted;
-        if (SUCCEEDED(ConvertFrame(pSample, subtype, width, height, converted)) && !converted.empty()) {
-          try { m_frameCallback(std::move(converted)); } catch (...) {}
-        }
-      } else {
-        // No conversion; deliver raw buffer
-        IMFMediaBuffer* pBuffer = NULL;
-        if (SUCCEEDED(pSample->ConvertToContiguousBuffer(&pBuffer)) && pBuffer) {
-          BYTE* pData = NULL;
-          DWORD curLen = 0;
-          if (SUCCEEDED(pBuffer->Lock(&pData, NULL, &curLen)) && pData && curLen > 0) {
-            try {
-              std::vector<uint8_t> out(pData, pData + curLen);
-              m_frameCallback(std::move(out));
-            } catch (...) {}
-            pBuffer->Unlock();
-          }
-          SafeRelease(&pBuffer);
-        }
-      }
-    }
+    // Hand the sample to the processing stage and go straight back to the
+    // reader: conversion, encoding and the callback overlap with the capture
+    // of the next frame. The negotiated format travels with the sample as a
+    // snapshot, so a type change cannot affect samples already queued.
+    pending.descriptor = m_descriptor;
+    if (!pending.descriptor) pending.descriptor = RefreshStreamDescriptor();
+    pending.callback = m_frameCallback;
+    pending.tap = m_frameTap;
+    pending.sample = pSample;
+    pSample->AddRef();
+    // A full stage drops the sample, which shows up as a discontinuity
+    const bool queued = m_stage.Push(std::move(pending));
+    if (deliver) m_pendingDiscontinuity = !queued;
   }
 
   // Read another sample.
@@ -350,6 +394,102 @@ done:
   return hr;
 }
 
+//-------------------------------------------------------------------
+// ProcessSample
+//
+// Processing stage handler: turn a queued sample into a frame and deliver
+// it. Runs on the stage thread without m_critsec, so a slow conversion or
+// JPEG encode never holds up the source reader or the API calls.
+//-------------------------------------------------------------------
+
+void CCapture::ProcessSample(PendingSample& pending) {
+  const StreamDescriptor none;
+  const StreamDescriptor& d = pending.descriptor ? *pending.descriptor : none;
+  FramePtr frame;
+
+  if (pending.tap) {
+    // The native sample, before the gate's verdict and any conversion
+    IMFMediaBuffer* pBuffer = NULL;
+    if (SUCCEEDED(pending.sample->ConvertToContiguousBuffer(&pBuffer)) && pBuffer) {
+      BYTE* pData = NULL;
+      DWORD curLen = 0;
+      if (SUCCEEDED(pBuffer->Lock(&pData, NULL, &curLen)) && pData && curLen > 0) {
+        FrameInfo raw;
+        raw.deviceTimeUs = pending.deviceTimeUs;
+        raw.arrivalUs = pending.arrivalUs;
+        raw.format = d.inputFormat;
+        raw.width = d.width;
+        raw.height = d.height;
+        raw.stride = d.stride;
+        const uint8_t* tapped = pData;
+        size_t tappedSize = curLen;
+        if (d.bottomUp) {
+          // Tapped top-down, as it is delivered
+          raw.stride = PixelFormatStride(d.inputFormat, d.width);
+          m_flipped.resize(static_cast<size_t>(raw.stride) * d.height);
+          tapped = CopyRowsTopDown(pData, curLen, d.stride, raw.stride, d.height, m_flipped.data()) ? m_flipped.data() : NULL;
+          tappedSize = m_flipped.size();
+        }
+        if (tapped) {
+          try { (*pending.tap)(tapped, tappedSize, raw); } catch (...) {}
+        }
+        pBuffer->Unlock();
+      }
+      SafeRelease(&pBuffer);
+    }
+  }
+  if (!pending.deliver) {
+    SafeRelease(&pending.sample);
+    return;
+  }
+
+  EnterCriticalSection(&m_processCritsec);
+  if (d.needsConversion && d.width > 0 && d.height > 0) {
+    m_converter.SetOutputFormat(d.outputFormat);
+    if (FAILED(ConvertFrame(pending.sample, d, frame)) || (frame && frame->size == 0)) frame.reset();
+  } else {
+    // No conversion; deliver raw buffer
+    IMFMediaBuffer* pBuffer = NULL;
+    if (SUCCEEDED(pending.sample->ConvertToContiguousBuffer(&pBuffer)) && pBuffer) {
+      BYTE* pData = NULL;
+      DWORD curLen = 0;
+      if (SUCCEEDED(pBuffer->Lock(&pData, NULL, &curLen)) && pData && curLen > 0) {
+        // Single copy out of the locked media buffer into pooled storage;
+        // the frame is handed to JS without further copies. A null lease
+        // means the in-flight cap is reached: drop.
+        if (d.bottomUp) {
+          // Rows turned top-down by the copy
+          const UINT32 rowBytes = PixelFormatStride(d.inputFormat, d.width);
+          frame = m_framePool->Acquire(static_cast<size_t>(rowBytes) * d.height);
+          if (frame && !CopyRowsTopDown(pData, curLen, d.stride, rowBytes, d.height, frame->data())) frame.reset();
+        } else {
+          frame = m_framePool->Acquire(curLen);
+          if (frame) memcpy(frame->data(), pData, curLen);
+        }
+        pBuffer->Unlock();
+      }
+      SafeRelease(&pBuffer);
+    }
+  }
+  // Done with the sample: let the reader recycle it
+  SafeRelease(&pending.sample);
+
+  if (frame) {
+    frame->info.format = d.outputFormat;
+    frame->info.width = d.width;
+    frame->info.height = d.height;
+    frame->info.stride = d.outputStride;
+    m_stamper.Stamp(frame->info, pending.deviceTimeUs, pending.arrivalUs, pending.discontinuity);
+  } else {
+    m_stamper.MarkDiscontinuity();
+  }
+  LeaveCriticalSection(&m_processCritsec);
+
+  if (frame && pending.callback) {
+    try { (*pending.callback)(std::move(frame)); } catch (...) {}
+  }
+}
+
 //-------------------------------------------------------------------
 // OpenMediaSource
 //
@@ -454,6 +594,12 @@ HRESULT CCapture::StartCapture(
   if (SUCCEEDED(hr)) {
     m_bFirstSample = TRUE;
     m_llBaseTime = 0;
+    m_pendingDiscontinuity = false;
+    EnterCriticalSection(&m_processCritsec);
+    m_stamper.Reset();
+    LeaveCriticalSection(&m_processCritsec);
+    RefreshStreamDescriptor();
+    m_stage.Start();
 
     // Request the first video frame.
 
@@ -477,27 +623,6 @@ HRESULT CCapture::StartCapture(
   return hr;
 }
 
-// Helper to extract contiguous buffer from an IMFSample and call the frame callback
-static HRESULT DeliverSampleToCallback(IMFSample* pSample, std::function<void(std::vector<uint8_t>&&)>& callback) {
-  if (!pSample || !callback) return E_POINTER;
-
-  IMFMediaBuffer* pBuffer = NULL;
-  HRESULT hr = pSample->ConvertToContiguousBuffer(&pBuffer);
-  if (FAILED(hr)) return hr;
-
-  BYTE* pData = NULL;
-  DWORD maxLen = 0, curLen = 0;
-  hr = pBuffer->Lock(&pData, &maxLen, &curLen);
-  if (SUCCEEDED(hr)) {
-    std::vector<uint8_t> vec(pData, pData + curLen);
-    callback(std::move(vec));
-    pBuffer->Unlock();
-  }
-
-  SafeRelease(&pBuffer);
-  return hr;
-}
-
 // Initialize the CCapture instance from an IMFActivate without starting capture.
 // This creates the media source and source reader so GetSupportedFormats can
 // enumerate native types without beginning an actual capture session.
@@ -541,9 +666,19 @@ HRESULT CCapture::EndCaptureSession() {
     (void)hrSel;  // non-fatal
   }
 
+  // Stop the processing stage and drop the samples it still holds. Under
+  // m_critsec so OnReadSample cannot queue behind the stop; the stage never
+  // takes m_critsec, so this cannot deadlock. Once this returns no frame
+  // callback is running.
+  m_stage.Stop();
+
   // Reset internal timing state so next start will rebase timestamps.
   m_bFirstSample = TRUE;
   m_llBaseTime = 0;
+  m_pendingDiscontinuity = false;
+  EnterCriticalSection(&m_processCritsec);
+  m_stamper.Reset();
+  LeaveCriticalSection(&m_processCritsec);
 
   LeaveCriticalSection(&m_critsec);
 
@@ -675,6 +810,9 @@ HRESULT CCapture::EndCaptureInternal() {
   HRESULT hr = S_OK;
 
   SafeRelease(&m_pReader);
+  EnterCriticalSection(&m_critsec);
+  m_descriptor.reset();
+  LeaveCriticalSection(&m_critsec);
 
   CoTaskMemFree(m_pwszSymbolicLink);
   m_pwszSymbolicLink = NULL;
@@ -765,6 +903,11 @@ HRESULT CCapture::SetFormat(const GUID& subtypeReq, UINT32 width, UINT32 height,
     if (IsEqualGUID(subtype, subtypeReq) && w == width && h == height && std::abs(fr - frameRate) < 1e-6) {
       hr = m_pReader->SetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, NULL, pType);
       SafeRelease(&pType);
+      if (SUCCEEDED(hr)) {
+        EnterCriticalSection(&m_critsec);
+        RefreshStreamDescriptor();
+        LeaveCriticalSection(&m_critsec);
+      }
       break;
     }
 
@@ -775,13 +918,27 @@ HRESULT CCapture::SetFormat(const GUID& subtypeReq, UINT32 width, UINT32 height,
   return hr;
 }
 
-HRESULT CCapture::GetCurrentDimensions(UINT32* pWidth, UINT32* pHeight, double* pFrameRate) {
+HRESULT CCapture::GetCurrentDimensions(UINT32* pWidth, UINT32* pHeight, double* pFrameRate, GUID* pSubtype) {
   if (pWidth) *pWidth = 0;
   if (pHeight) *pHeight = 0;
   if (pFrameRate) *pFrameRate = 0.0;
+  if (pSubtype) *pSubtype = GUID_NULL;
 
   if (m_pReader == NULL) return E_FAIL;
 
+  // Answer from the snapshot when one is published. m_critsec is only held
+  // to queue a sample and request the next one, so this waits briefly at most.
+  EnterCriticalSection(&m_critsec);
+  std::shared_ptr<const StreamDescriptor> desc = m_descriptor;
+  LeaveCriticalSection(&m_critsec);
+  if (desc) {
+    if (pWidth) *pWidth = desc->width;
+    if (pHeight) *pHeight = desc->height;
+    if (pFrameRate) *pFrameRate = desc->frameRate;
+    if (pSubtype) *pSubtype = desc->subtype;
+    return S_OK;
+  }
+
   IMFMediaType* pType = NULL;
   HRESULT hr = m_pReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &pType);
   if (FAILED(hr) || pType == NULL) {
@@ -799,6 +956,7 @@ HRESULT CCapture::GetCurrentDimensions(UINT32* pWidth, UINT32* pHeight, double*
   if (pWidth) *pWidth = w;
   if (pHeight) *pHeight = h;
   if (pFrameRate) *pFrameRate = fr;
+  if (pSubtype) pType->GetGUID(MF_MT_SUBTYPE, pSubtype);
 
   SafeRelease(&pType);
   return S_OK;
@@ -816,11 +974,23 @@ HRESULT CCapture::ReleaseDevice() {
     CoTaskMemFree(m_pwszSymbolicLink);
     m_pwszSymbolicLink = nullptr;
   }
-  m_rgbaBuffer.clear();
+  EnterCriticalSection(&m_critsec);
+  m_outputFormat = PixelFormat::Unknown;
+  m_descriptor.reset();
   m_frameCallback = nullptr;
+  m_frameGate = nullptr;
+  m_frameTap = nullptr;
   m_bFirstSample = TRUE;
   m_llBaseTime = 0;
-  m_outputFormat = GUID_NULL;
+  LeaveCriticalSection(&m_critsec);
+
+  EnterCriticalSection(&m_processCritsec);
+  m_converter.Reset();
+  m_converter.SetOutputFormat(PixelFormat::Unknown);
+  m_jpegEncoder.Reset();
+  m_stamper.Reset();
+  LeaveCriticalSection(&m_processCritsec);
+  m_framePool->Trim();
   return S_OK;
 }
 
@@ -831,128 +1001,122 @@ HRESULT CCapture::ReleaseDevice() {
 // SetOutputFormat
 //-------------------------------------------------------------------
 
-HRESULT CCapture::SetOutputFormat(const GUID& outputSubtype) {
+HRESULT CCapture::SetOutputFormat(PixelFormat outputFormat) {
+  // Recorded in the descriptor; the stage applies it from the next sample
   EnterCriticalSection(&m_critsec);
-  m_outputFormat = outputSubtype;
+  m_outputFormat = outputFormat;
+  if (m_pReader) RefreshStreamDescriptor();
   LeaveCriticalSection(&m_critsec);
   return S_OK;
 }
 
+//-------------------------------------------------------------------
+// SetConversionThreads
+//-------------------------------------------------------------------
+
+void CCapture::SetConversionThreads(size_t threads, size_t bandHeight) {
+  EnterCriticalSection(&m_processCritsec);
+  m_converter.SetThreads(threads, bandHeight);
+  LeaveCriticalSection(&m_processCritsec);
+}
+
+//-------------------------------------------------------------------
+// SetJpegOptions
+//-------------------------------------------------------------------
+
+void CCapture::SetJpegOptions(const JpegOptions& options) {
+  EnterCriticalSection(&m_processCritsec);
+  m_converter.SetJpegOptions(options);
+  LeaveCriticalSection(&m_processCritsec);
+}
+
 //-------------------------------------------------------------------
 // ClearOutputFormat
 //-------------------------------------------------------------------
 
 void CCapture::ClearOutputFormat() {
   EnterCriticalSection(&m_critsec);
-  m_outputFormat = GUID_NULL;
+  m_outputFormat = PixelFormat::Unknown;
+  if (m_pReader) RefreshStreamDescriptor();
   LeaveCriticalSection(&m_critsec);
 }
 
 //-------------------------------------------------------------------
-// EncodeToJpeg - Encode RGB/BGRA data to JPEG using WIC
+// SetFrameGate
 //-------------------------------------------------------------------
 
-HRESULT CCapture::EncodeToJpeg(const uint8_t* rgbData, UINT32 width, UINT32 height, bool isBGRA, std::vector<uint8_t>& outBuffer) {
-  HRESULT hr = S_OK;
-
-  // Create WIC factory if needed
-  if (!m_pWicFactory) {
-    hr = CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&m_pWicFactory));
-    if (FAILED(hr)) return hr;
-  }
-
-  IWICStream* pStream = NULL;
-  IWICBitmapEncoder* pEncoder = NULL;
-  IWICBitmapFrameEncode* pFrame = NULL;
-  IPropertyBag2* pPropertyBag = NULL;
-
-  // Create memory stream
-  hr = m_pWicFactory->CreateStream(&pStream);
-  if (FAILED(hr)) goto cleanup;
+void CCapture::SetFrameGate(FrameGate gate) {
+  EnterCriticalSection(&m_critsec);
+  m_frameGate = std::move(gate);
+  LeaveCriticalSection(&m_critsec);
+}
 
-  hr = pStream->InitializeFromMemory(NULL, 0);
-  if (FAILED(hr)) {
-    // Use IStream instead
-    IStream* pMemStream = NULL;
-    hr = CreateStreamOnHGlobal(NULL, TRUE, &pMemStream);
-    if (FAILED(hr)) goto cleanup;
-    hr = pStream->InitializeFromIStream(pMemStream);
-    pMemStream->Release();
-    if (FAILED(hr)) goto cleanup;
-  }
+//-------------------------------------------------------------------
+// SetFrameTap
+//-------------------------------------------------------------------
 
-  // Create JPEG encoder
-  hr = m_pWicFactory->CreateEncoder(GUID_ContainerFormatJpeg, NULL, &pEncoder);
-  if (FAILED(hr)) goto cleanup;
-
-  hr = pEncoder->Initialize(pStream, WICBitmapEncoderNoCache);
-  if (FAILED(hr)) goto cleanup;
-
-  hr = pEncoder->CreateNewFrame(&pFrame, &pPropertyBag);
-  if (FAILED(hr)) goto cleanup;
-
-  // Set quality
-  if (pPropertyBag) {
-    PROPBAG2 option = {0};
-    option.pstrName = const_cast<LPOLESTR>(L"ImageQuality");
-    VARIANT value;
-    VariantInit(&value);
-    value.vt = VT_R4;
-    value.fltVal = 0.85f;
-    pPropertyBag->Write(1, &option, &value);
+void CCapture::SetFrameTap(FrameTap tap) {
+  EnterCriticalSection(&m_critsec);
+  if (tap) {
+    m_frameTap = std::make_shared<const FrameTap>(std::move(tap));
+  } else {
+    m_frameTap = nullptr;
   }
+  LeaveCriticalSection(&m_critsec);
+}
 
-  hr = pFrame->Initialize(pPropertyBag);
-  if (FAILED(hr)) goto cleanup;
-
-  hr = pFrame->SetSize(width, height);
-  if (FAILED(hr)) goto cleanup;
-
-  {
-    WICPixelFormatGUID pixelFormat = isBGRA ? GUID_WICPixelFormat32bppBGRA : GUID_WICPixelFormat24bppBGR;
-    hr = pFrame->SetPixelFormat(&pixelFormat);
-    if (FAILED(hr)) goto cleanup;
+//-------------------------------------------------------------------
+// SetFrameCallback
+//-------------------------------------------------------------------
 
-    UINT stride = width * (isBGRA ? 4 : 3);
-    UINT bufferSize = stride * height;
-    hr = pFrame->WritePixels(height, stride, bufferSize, const_cast<BYTE*>(rgbData));
-    if (FAILED(hr)) goto cleanup;
+void CCapture::SetFrameCallback(std::function<void(FramePtr)> cb) {
+  EnterCriticalSection(&m_critsec);
+  if (cb) {
+    m_frameCallback = std::make_shared<const std::function<void(FramePtr)>>(std::move(cb));
+  } else {
+    m_frameCallback = nullptr;
   }
+  LeaveCriticalSection(&m_critsec);
+}
 
-  hr = pFrame->Commit();
-  if (FAILED(hr)) goto cleanup;
-
-  hr = pEncoder->Commit();
-  if (FAILED(hr)) goto cleanup;
-
-  // Read back from stream
-  {
-    LARGE_INTEGER zero = {0};
-    ULARGE_INTEGER size;
-    pStream->Seek(zero, STREAM_SEEK_END, &size);
-    pStream->Seek(zero, STREAM_SEEK_SET, NULL);
+//-------------------------------------------------------------------
+// RefreshStreamDescriptor
+//
+// Snapshot the reader's current media type and the conversion plan.
+// Called with m_critsec held.
+//-------------------------------------------------------------------
 
-    outBuffer.resize(static_cast<size_t>(size.QuadPart));
-    ULONG bytesRead = 0;
-    hr = pStream->Read(outBuffer.data(), static_cast<ULONG>(size.QuadPart), &bytesRead);
-    if (SUCCEEDED(hr)) outBuffer.resize(bytesRead);
+std::shared_ptr<const StreamDescriptor> CCapture::RefreshStreamDescriptor() {
+  std::shared_ptr<const StreamDescriptor> published;
+  IMFMediaType* pType = NULL;
+  if (m_pReader && SUCCEEDED(m_pReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &pType)) && pType) {
+    auto desc = std::make_shared<StreamDescriptor>();
+    pType->GetGUID(MF_MT_SUBTYPE, &desc->subtype);
+    MFGetAttributeSize(pType, MF_MT_FRAME_SIZE, &desc->width, &desc->height);
+    UINT32 num = 0, denom = 0;
+    MFGetAttributeRatio(pType, MF_MT_FRAME_RATE, &num, &denom);
+    if (denom != 0) desc->frameRate = static_cast<double>(num) / static_cast<double>(denom);
+    desc->inputFormat = PixelFormatFromSubtype(desc->subtype);
+    // Stored as a UINT32; negative for bottom-up RGB
+    INT32 defaultStride = static_cast<INT32>(MFGetAttributeUINT32(pType, MF_MT_DEFAULT_STRIDE, 0));
+    desc->stride = defaultStride != 0 ? static_cast<UINT32>(defaultStride < 0 ? -defaultStride : defaultStride) : PixelFormatStride(desc->inputFormat, desc->width);
+    desc->bottomUp = defaultStride < 0;
+    desc->needsConversion = m_outputFormat != PixelFormat::Unknown && desc->inputFormat != m_outputFormat;
+    desc->outputFormat = desc->needsConversion ? m_outputFormat : desc->inputFormat;
+    // Bottom-up frames are delivered top-down and packed
+    desc->outputStride = desc->needsConversion || desc->bottomUp ? PixelFormatStride(desc->outputFormat, desc->width) : desc->stride;
+    SafeRelease(&pType);
+    published = std::move(desc);
   }
-
-cleanup:
-  SafeRelease(&pFrame);
-  SafeRelease(&pPropertyBag);
-  SafeRelease(&pEncoder);
-  SafeRelease(&pStream);
-  return hr;
+  m_descriptor = published;
+  return published;
 }
 
 //-------------------------------------------------------------------
 // ConvertFrame - Convert sample to output format
 //-------------------------------------------------------------------
 
-HRESULT CCapture::ConvertFrame(IMFSample* pSample, const GUID& inputSubtype, UINT32 width, UINT32 height, std::vector<uint8_t>& outBuffer) {
-  bool isMjpegOutput = IsEqualGUID(m_outputFormat, MFVideoFormat_MJPG);
-
+HRESULT CCapture::ConvertFrame(IMFSample* pSample, const StreamDescriptor& d, FramePtr& outFrame) {
   IMFMediaBuffer* pBuffer = NULL;
   HRESULT hr = pSample->ConvertToContiguousBuffer(&pBuffer);
   if (FAILED(hr) || !pBuffer) return hr;
@@ -965,63 +1129,19 @@ HRESULT CCapture::ConvertFrame(IMFSample* pSample, const GUID& inputSubtype, UIN
     return hr;
   }
 
-  if (isMjpegOutput) {
-    // Convert to JPEG
-    // First need to get to RGB format
-    if (IsEqualGUID(inputSubtype, MFVideoFormat_RGB32)) {
-      // BGRA -> JPEG
-      hr = EncodeToJpeg(pData, width, height, true, outBuffer);
-    } else if (IsEqualGUID(inputSubtype, MFVideoFormat_RGB24)) {
-      // BGR24 -> JPEG
-      hr = EncodeToJpeg(pData, width, height, false, outBuffer);
-    } else if (IsEqualGUID(inputSubtype, MFVideoFormat_YUY2)) {
-      // YUY2 -> RGB -> JPEG
-      size_t pixelCount = width * height;
-      m_rgbaBuffer.resize(pixelCount * 3);
-      // Simple YUY2 to BGR conversion
-      for (UINT32 i = 0; i < pixelCount / 2; i++) {
-        int y0 = pData[i * 4 + 0];
-        int u  = pData[i * 4 + 1];
-        int y1 = pData[i * 4 + 2];
-        int v  = pData[i * 4 + 3];
-        int c0 = y0 - 16, c1 = y1 - 16;
-        int d = u - 128, e = v - 128;
-        auto clamp = [](int x) { return x < 0 ? 0 : (x > 255 ? 255 : x); };
-        m_rgbaBuffer[i * 6 + 0] = clamp((298 * c0 + 516 * d + 128) >> 8);           // B
-        m_rgbaBuffer[i * 6 + 1] = clamp((298 * c0 - 100 * d - 208 * e + 128) >> 8); // G
-        m_rgbaBuffer[i * 6 + 2] = clamp((298 * c0 + 409 * e + 128) >> 8);           // R
-        m_rgbaBuffer[i * 6 + 3] = clamp((298 * c1 + 516 * d + 128) >> 8);           // B
-        m_rgbaBuffer[i * 6 + 4] = clamp((298 * c1 - 100 * d - 208 * e + 128) >> 8); // G
-        m_rgbaBuffer[i * 6 + 5] = clamp((298 * c1 + 409 * e + 128) >> 8);           // R
-      }
-      hr = EncodeToJpeg(m_rgbaBuffer.data(), width, height, false, outBuffer);
-    } else if (IsEqualGUID(inputSubtype, MFVideoFormat_NV12)) {
-      // NV12 -> RGB -> JPEG
-      size_t pixelCount = width * height;
-      m_rgbaBuffer.resize(pixelCount * 3);
-      const uint8_t* yPlane = pData;
-      const uint8_t* uvPlane = pData + pixelCount;
-      for (UINT32 row = 0; row < height; row++) {
-        for (UINT32 col = 0; col < width; col++) {
-          int y = yPlane[row * width + col];
-          int uvIdx = (row / 2) * width + (col & ~1);
-          int u = uvPlane[uvIdx] - 128;
-          int v = uvPlane[uvIdx + 1] - 128;
-          int c = y - 16;
-          auto clamp = [](int x) { return x < 0 ? 0 : (x > 255 ? 255 : x); };
-          size_t idx = (row * width + col) * 3;
-          m_rgbaBuffer[idx + 0] = clamp((298 * c + 516 * u + 128) >> 8);           // B
-          m_rgbaBuffer[idx + 1] = clamp((298 * c - 100 * u - 208 * v + 128) >> 8); // G
-          m_rgbaBuffer[idx + 2] = clamp((298 * c + 409 * v + 128) >> 8);           // R
-        }
-      }
-      hr = EncodeToJpeg(m_rgbaBuffer.data(), width, height, false, outBuffer);
+  // Pixel conversion (banded SIMD) or JPEG encoding via m_jpegEncoder.
+  // Rows padded to the media type's default stride are read in place;
+  // bottom-up rows are turned top-down first.
+  const UINT32 rowBytes = PixelFormatStride(d.inputFormat, d.width);
+  if (d.bottomUp) {
+    m_flipped.resize(static_cast<size_t>(rowBytes) * d.height);
+    if (CopyRowsTopDown(pData, curLen, d.stride, rowBytes, d.height, m_flipped.data())) {
+      hr = m_converter.Convert(d.inputFormat, m_flipped.data(), m_flipped.size(), d.width, d.height, outFrame);
     } else {
-      hr = E_NOTIMPL;
+      hr = E_UNEXPECTED;
     }
   } else {
-    // Other format conversions not implemented yet
-    hr = E_NOTIMPL;
+    hr = m_converter.Convert(d.inputFormat, pData, curLen, d.width, d.height, outFrame, d.stride == rowBytes ? 0 : d.stride);
   }
 
   pBuffer->Unlock();
@@ -18,13 +18,19 @@
 #include <mfapi.h>
 #include <mfidl.h>
 #include <mfreadwrite.h>
-#include <wincodec.h>
 #include <string>
 #include <functional>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <tuple>
 
+#include "capture_backend.h"
+#include "frame.h"
+#include "frame_converter.h"
+#include "processing_stage.h"
+#include "wic_jpeg_encoder.h"
+
 template <class T>
 inline void SafeRelease(T** ppT) {
   if (ppT && *ppT) {
@@ -35,6 +41,11 @@ inline void SafeRelease(T** ppT) {
 
 const UINT WM_APP_PREVIEW_ERROR = WM_APP + 1;  // wparam = HRESULT
 
+// Map a Media Foundation subtype to a PixelFormat (Unknown when unmapped).
+PixelFormat PixelFormatFromSubtype(const GUID& subtype);
+// Media Foundation subtype for a PixelFormat (GUID_NULL for Unknown).
+GUID SubtypeFromPixelFormat(PixelFormat format);
+
 class DeviceList {
   UINT32 m_cDevices;
   IMFActivate** m_ppDevices;
@@ -61,6 +72,59 @@ struct EncodingParameters {
   UINT32 bitrate;
 };
 
+// Snapshot of the negotiated stream, built once per media type rather than
+// queried from the source reader for every sample. Immutable once published;
+// a new descriptor replaces it when the type changes.
+struct StreamDescriptor {
+  GUID subtype = GUID_NULL;
+  PixelFormat inputFormat = PixelFormat::Unknown;
+  UINT32 width = 0;
+  UINT32 height = 0;
+  UINT32 stride = 0;  // bytes per row of native frames (0 = compressed)
+  // Negative MF_MT_DEFAULT_STRIDE (RGB): rows are stored last to first.
+  // Frames are turned top-down before they are tapped, converted or copied.
+  bool bottomUp = false;
+  double frameRate = 0.0;
+  // Conversion plan: what delivered frames look like
+  bool needsConversion = false;
+  PixelFormat outputFormat = PixelFormat::Unknown;
+  UINT32 outputStride = 0;
+};
+
+// A sample on its way from OnReadSample to the processing stage. Holds a
+// reference on the sample until the stage is done with it.
+struct PendingSample {
+  IMFSample* sample = NULL;
+  std::shared_ptr<const StreamDescriptor> descriptor;
+  std::shared_ptr<const std::function<void(FramePtr)>> callback;
+  // Shown the sample before conversion (CCapture::SetFrameTap)
+  std::shared_ptr<const FrameTap> tap;
+  int64_t deviceTimeUs = 0;
+  int64_t arrivalUs = 0;
+  bool discontinuity = false;
+  // False when the gate refused the sample and it is only queued for the tap
+  bool deliver = true;
+
+  PendingSample() = default;
+  PendingSample(PendingSample&& other) noexcept { *this = std::move(other); }
+  PendingSample& operator=(PendingSample&& other) noexcept {
+    if (this != &other) {
+      SafeRelease(&sample);
+      sample = other.sample;
+      other.sample = NULL;
+      descriptor = std::move(other.descriptor);
+      callback = std::move(other.callback);
+      tap = std::move(other.tap);
+      deviceTimeUs = other.deviceTimeUs;
+      arrivalUs = other.arrivalUs;
+      discontinuity = other.discontinuity;
+      deliver = other.deliver;
+    }
+    return *this;
+  }
+  ~PendingSample() { SafeRelease(&sample); }
+};
+
 class CCapture : public IMFSourceReaderCallback {
  public:
   static HRESULT CreateInstance(
@@ -100,13 +164,36 @@ class CCapture : public IMFSourceReaderCallback {
   HRESULT GetSupportedFormats(std::vector<std::tuple<GUID, UINT32, UINT32, double>>& outTypes);
   // Set the desired native media type on the source reader by explicit native subtype GUID
   HRESULT SetFormat(const GUID& subtype, UINT32 width, UINT32 height, double frameRate);
-  // Get current dimensions from the source reader (width, height, frameRate)
-  HRESULT GetCurrentDimensions(UINT32* pWidth, UINT32* pHeight, double* pFrameRate);
-  // Provide a callback to receive raw frame buffers (moved into the callback)
-  void SetFrameCallback(std::function<void(std::vector<uint8_t>&&)> cb) { m_frameCallback = std::move(cb); }
-  // Set output format for conversion (GUID_NULL = no conversion, pass-through)
-  // Supported: MFVideoFormat_RGB32, MFVideoFormat_RGB24, MFVideoFormat_NV12, MFVideoFormat_YUY2, etc.
-  HRESULT SetOutputFormat(const GUID& outputSubtype);
+  // Get current dimensions (width, height, frameRate and, optionally, the
+  // subtype GUID); served from the stream descriptor once one is published
+  HRESULT GetCurrentDimensions(UINT32* pWidth, UINT32* pHeight, double* pFrameRate, GUID* pSubtype = NULL);
+  // Provide a callback to receive frames (ownership is moved into the callback).
+  // Frames are delivered on the processing stage's thread.
+  void SetFrameCallback(std::function<void(FramePtr)> cb);
+  // Asked in OnReadSample before a sample is queued for processing; false
+  // skips it without locking its buffer (see CaptureBackend::SetFrameGate).
+  void SetFrameGate(FrameGate gate);
+  // Shown every sample, including those the gate refuses, on the processing
+  // stage's thread before conversion (see CaptureBackend::SetFrameTap).
+  void SetFrameTap(FrameTap tap);
+  // Storage the delivered frames are written into when it offers some
+  // (see FramePool::SetDestination).
+  void SetFrameDestination(std::shared_ptr<FrameDestination> destination) { m_framePool->SetDestination(std::move(destination)); }
+  // Cap the number of frames leased to the delivery path at once (0 = unbounded).
+  // Frames that arrive while the cap is reached are dropped.
+  void SetMaxInFlightFrames(size_t maxInFlight) { m_framePool->SetMaxInFlight(maxInFlight); }
+  // Worker threads (0 = one per hardware thread) and band height in rows
+  // (0 = automatic) used to convert frames. Applied before the next frame.
+  void SetConversionThreads(size_t threads, size_t bandHeight);
+  // Quality and chroma subsampling for PixelFormat::JPEG output. Applied
+  // before the next frame.
+  void SetJpegOptions(const JpegOptions& options);
+  // Snapshot of the frame pool counters (hits, misses, high-water mark, ...)
+  FramePoolStats GetFramePoolStats() const { return m_framePool->GetStats(); }
+  // Hand-off and processing counters of the stage behind OnReadSample
+  ProcessingStageStats GetProcessingStats() const { return m_stage.GetStats(); }
+  // Set output format for conversion (PixelFormat::Unknown = no conversion, pass-through)
+  HRESULT SetOutputFormat(PixelFormat outputFormat);
   // Clear output format (disable conversion, return raw frames)
   void ClearOutputFormat();
   // Return last enumerated supported formats (stored internally)
@@ -133,9 +220,22 @@ class CCapture : public IMFSourceReaderCallback {
 
   HRESULT OpenMediaSource(IMFMediaSource* pSource);
   HRESULT ConfigureCapture(const EncodingParameters& param);
+  // Processing stage handler: convert or copy the sample, stamp it and call
+  // the frame callback. Runs on the stage thread, outside m_critsec.
+  void ProcessSample(PendingSample& pending);
+  // Rebuild the stream descriptor from the reader's current media type and
+  // the converter settings, publish it and return it (null without a type).
+  std::shared_ptr<const StreamDescriptor> RefreshStreamDescriptor();
+
+  // Samples queued between OnReadSample and the processing stage
+  static const size_t kProcessingDepth = 4;
 
   long m_nRefCount;  // Reference count.
+  // Guards the reader and the session state OnReadSample touches. Held only
+  // long enough to queue a sample and request the next one.
   CRITICAL_SECTION m_critsec;
+  // Guards the processing side: converter, stamper and JPEG encoder state
+  CRITICAL_SECTION m_processCritsec;
 
   HWND m_hwndEvent;  // Application window to receive events.
 
@@ -143,18 +243,42 @@ class CCapture : public IMFSourceReaderCallback {
 
   BOOL m_bFirstSample;
   LONGLONG m_llBaseTime;
+  // A stream tick or a sample the stage refused; carried to the next sample
+  bool m_pendingDiscontinuity;
+  // Output format requested through SetOutputFormat (m_critsec); the stage
+  // applies it to m_converter from the descriptor it receives
+  PixelFormat m_outputFormat;
+  // Sequence numbers, rebased times and gaps for delivered frames
+  FrameStamper m_stamper;
+
+  // Negotiated format and conversion plan; replaced (never mutated) on
+  // MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED, SetFormat and output format
+  // changes. Guarded by m_critsec; each queued sample carries its own
+  // reference, so the stage reads it without the lock.
+  std::shared_ptr<const StreamDescriptor> m_descriptor;
 
   WCHAR* m_pwszSymbolicLink;
   // (removed) cache of last enumerated formats
-  // Frame callback used when delivering frames to the embedding (JS)
-  std::function<void(std::vector<uint8_t>&&)> m_frameCallback;
-  // Reusable buffer for frame conversion
-  std::vector<uint8_t> m_rgbaBuffer;
-  // Output format conversion
-  GUID m_outputFormat;           // Target output subtype (GUID_NULL = no conversion)
-  IWICImagingFactory* m_pWicFactory;  // WIC factory for JPEG encoding
-  // Internal: encode frame to JPEG using WIC
-  HRESULT EncodeToJpeg(const uint8_t* rgbData, UINT32 width, UINT32 height, bool isBGRA, std::vector<uint8_t>& outBuffer);
-  // Internal: convert sample to output format
-  HRESULT ConvertFrame(IMFSample* pSample, const GUID& inputSubtype, UINT32 width, UINT32 height, std::vector<uint8_t>& outBuffer);
+  // Frame callback used when delivering frames to the embedding (JS). Held
+  // through a shared_ptr so the stage can call it after it is replaced.
+  std::shared_ptr<const std::function<void(FramePtr)>> m_frameCallback;
+  // Frame gate, asked with m_critsec held
+  FrameGate m_frameGate;
+  // Frame tap, carried by each queued sample like the callback
+  std::shared_ptr<const FrameTap> m_frameTap;
+  // Recycling storage for delivered frames (shared so leases outlive us)
+  std::shared_ptr<FramePool> m_framePool;
+  // Output format conversion (shared with the other backends); JPEG output
+  // goes through m_jpegEncoder
+  FrameConverter m_converter;
+  // WIC encoder session reused across frames (m_processCritsec)
+  WicJpegEncoder m_jpegEncoder;
+  // A bottom-up sample turned top-down for the tap or the converter (stage
+  // thread)
+  std::vector<uint8_t> m_flipped;
+  // Internal: convert sample to output format (output frame leased from m_framePool)
+  HRESULT ConvertFrame(IMFSample* pSample, const StreamDescriptor& d, FramePtr& outFrame);
+  // Conversion, encoding and delivery off the source reader callback. Last
+  // member: stopped before the state its handler uses is destroyed.
+  ProcessingStage<PendingSample> m_stage;
 };
@@ -0,0 +1,286 @@
+#include "capture_backend.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <comdef.h>
+#include "backend_mf.h"
+#endif
+#ifdef __linux__
+#include "backend_v4l2.h"
+#endif
+#include "backend_replay.h"
+#include "backend_synthetic.h"
+
+bool ParsePixelFormat(const std::string& s, PixelFormat& out) {
+  // Accept several common names (case-insensitive)
+  std::string u = s;
+  for (auto& c : u) c = (char)tolower((unsigned char)c);
+  if (u == "nv12") {
+    out = PixelFormat::NV12;
+    return true;
+  }
+  if (u == "rgb24" || u == "bgr24") {
+    out = PixelFormat::RGB24;
+    return true;
+  }
+  if (u == "rgb32" || u == "bgra") {
+    out = PixelFormat::RGB32;
+    return true;
+  }
+  if (u == "rgba") {
+    out = PixelFormat::RGBA;
+    return true;
+  }
+  if (u == "yuy2" || u == "yuyv" || u == "yuv2" || u == "yuv") {
+    out = PixelFormat::YUY2;
+    return true;
+  }
+  if (u == "uyvy") {
+    out = PixelFormat::UYVY;
+    return true;
+  }
+  if (u == "mjpg" || u == "mjpeg" || u == "mjepg") {
+    out = PixelFormat::MJPEG;
+    return true;
+  }
+  if (u == "iyuv" || u == "i420") {
+    out = PixelFormat::IYUV;
+    return true;
+  }
+  return false;
+}
+
+bool ParseJpegSubsampling(const std::string& s, JpegSubsampling& out) {
+  std::string u;
+  for (char c : s) {
+    if (c != ':') u += (char)tolower((unsigned char)c);
+  }
+  if (u == "default") {
+    out = JpegSubsampling::Default;
+    return true;
+  }
+  if (u == "420") {
+    out = JpegSubsampling::Yuv420;
+    return true;
+  }
+  if (u == "422") {
+    out = JpegSubsampling::Yuv422;
+    return true;
+  }
+  if (u == "444") {
+    out = JpegSubsampling::Yuv444;
+    return true;
+  }
+  if (u == "440") {
+    out = JpegSubsampling::Yuv440;
+    return true;
+  }
+  return false;
+}
+
+const char* PixelFormatName(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::NV12:
+      return "NV12";
+    case PixelFormat::YUY2:
+      return "YUY2";
+    case PixelFormat::UYVY:
+      return "UYVY";
+    case PixelFormat::RGB24:
+      return "RGB24";
+    case PixelFormat::RGB32:
+      return "RGB32";
+    case PixelFormat::MJPEG:
+      return "MJPEG";
+    case PixelFormat::IYUV:
+      return "IYUV";
+    case PixelFormat::RGBA:
+      return "RGBA";
+    case PixelFormat::Unknown:
+      break;
+  }
+  return "";
+}
+
+size_t PixelFormatFrameSize(PixelFormat format, uint32_t width, uint32_t height) {
+  const size_t w = width, h = height;
+  const size_t chromaW = (w + 1) / 2, chromaH = (h + 1) / 2;
+  switch (format) {
+    case PixelFormat::NV12:
+      return w * h + chromaW * 2 * chromaH;
+    case PixelFormat::IYUV:
+      return w * h + chromaW * chromaH * 2;
+    case PixelFormat::YUY2:
+    case PixelFormat::UYVY:
+      return chromaW * 4 * h;
+    case PixelFormat::RGB24:
+      return w * h * 3;
+    case PixelFormat::RGB32:
+    case PixelFormat::RGBA:
+      return w * h * 4;
+    case PixelFormat::MJPEG:
+    case PixelFormat::Unknown:
+      break;
+  }
+  return 0;
+}
+
+uint32_t PixelFormatStride(PixelFormat format, uint32_t width) {
+  const uint32_t chromaW = width / 2 + (width & 1);
+  switch (format) {
+    case PixelFormat::NV12:
+    case PixelFormat::IYUV:
+      return width;
+    case PixelFormat::YUY2:
+    case PixelFormat::UYVY:
+      return chromaW * 4;
+    case PixelFormat::RGB24:
+      return width * 3;
+    case PixelFormat::RGB32:
+    case PixelFormat::RGBA:
+      return width * 4;
+    case PixelFormat::MJPEG:
+    case PixelFormat::Unknown:
+      break;
+  }
+  return 0;
+}
+
+size_t PixelFormatStridedFrameSize(PixelFormat format, size_t stride, uint32_t height) {
+  const size_t h = height, chromaH = (h + 1) / 2;
+  switch (format) {
+    case PixelFormat::NV12:
+      return stride * h + stride * chromaH;
+    case PixelFormat::IYUV:
+      return stride * h + (stride / 2) * chromaH * 2;
+    case PixelFormat::YUY2:
+    case PixelFormat::UYVY:
+    case PixelFormat::RGB24:
+    case PixelFormat::RGB32:
+    case PixelFormat::RGBA:
+      return stride * h;
+    case PixelFormat::MJPEG:
+    case PixelFormat::Unknown:
+      break;
+  }
+  return 0;
+}
+
+void PackPixelRows(PixelFormat format, const uint8_t* src, size_t stride, uint32_t width, uint32_t height, uint8_t* dst) {
+  auto copyPlane = [](const uint8_t* s, size_t sStride, uint8_t* d, size_t rowBytes, size_t rows) {
+    for (size_t y = 0; y < rows; ++y) memcpy(d + y * rowBytes, s + y * sStride, rowBytes);
+  };
+  const size_t h = height, chromaH = (h + 1) / 2, chromaW = (static_cast<size_t>(width) + 1) / 2;
+  const size_t row = PixelFormatStride(format, width);
+  copyPlane(src, stride, dst, row, h);
+  if (format == PixelFormat::NV12) {
+    copyPlane(src + stride * h, stride, dst + row * h, chromaW * 2, chromaH);
+  } else if (format == PixelFormat::IYUV) {
+    const uint8_t* u = src + stride * h;
+    const uint8_t* v = u + (stride / 2) * chromaH;
+    uint8_t* du = dst + row * h;
+    copyPlane(u, stride / 2, du, chromaW, chromaH);
+    copyPlane(v, stride / 2, du + chromaW * chromaH, chromaW, chromaH);
+  }
+}
+
+std::string HResultToString(HRESULT hr) {
+  std::string messageBody;
+#ifdef _WIN32
+  _com_error err(hr);
+  LPCTSTR errMsg = err.ErrorMessage();
+#ifdef UNICODE
+  if (errMsg) {
+    int len = WideCharToMultiByte(CP_UTF8, 0, errMsg, -1, NULL, 0, NULL, NULL);
+    if (len > 0) {
+      std::string tmp(len, '\0');
+      WideCharToMultiByte(CP_UTF8, 0, errMsg, -1, &tmp[0], len, NULL, NULL);
+      if (!tmp.empty() && tmp.back() == '\0') tmp.pop_back();
+      messageBody = tmp;
+    }
+  }
+#else
+  if (errMsg) messageBody = errMsg;
+#endif
+#else
+  switch (hr) {
+    case E_NOTIMPL:
+      messageBody = "Not implemented";
+      break;
+    case E_POINTER:
+      messageBody = "Invalid pointer";
+      break;
+    case E_FAIL:
+      messageBody = "Unspecified error";
+      break;
+    case E_UNEXPECTED:
+      messageBody = "Catastrophic failure";
+      break;
+    case E_ACCESSDENIED:
+      messageBody = "Access is denied.";
+      break;
+    case E_OUTOFMEMORY:
+      messageBody = "Not enough memory resources are available to complete this operation.";
+      break;
+    case E_INVALIDARG:
+      messageBody = "The parameter is incorrect.";
+      break;
+    case CAPTURE_E_NOT_FOUND:
+      messageBody = "Element not found.";
+      break;
+    case CAPTURE_E_BUSY:
+      messageBody = "The requested resource is in use.";
+      break;
+    case CAPTURE_E_NOT_READY:
+      messageBody = "The device is not ready.";
+      break;
+    default:
+      break;
+  }
+#endif
+  char header[64];
+  snprintf(header, sizeof(header), "HRESULT=0x%08X: ", (unsigned)hr);
+  return std::string(header) + messageBody;
+}
+
+std::string CaptureBackendNames() {
+#if defined(_WIN32)
+  return "mediafoundation, synthetic, replay";
+#elif defined(__linux__)
+  return "v4l2, synthetic, replay";
+#else
+  return "synthetic, replay";
+#endif
+}
+
+std::unique_ptr<CaptureBackend> CreateCaptureBackend(const std::string& name) {
+  std::string u = name;
+  if (u.empty() || u == "auto") {
+    const char* env = std::getenv("CAMERA_BACKEND");
+    u = (env && *env) ? env : "";
+  }
+  for (auto& c : u) c = (char)tolower((unsigned char)c);
+  if (u.empty() || u == "auto") {
+#if defined(_WIN32)
+    u = "mediafoundation";
+#elif defined(__linux__)
+    u = "v4l2";
+#else
+    u = "synthetic";
+#endif
+  }
+
+  if (u == "synthetic") return std::unique_ptr<CaptureBackend>(new SyntheticCaptureBackend());
+  if (u == "replay") return std::unique_ptr<CaptureBackend>(new ReplayCaptureBackend());
+#ifdef _WIN32
+  if (u == "mediafoundation" || u == "mf") return std::unique_ptr<CaptureBackend>(new MediaFoundationBackend());
+#endif
+#ifdef __linux__
+  if (u == "v4l2") return std::unique_ptr<CaptureBackend>(new V4l2CaptureBackend());
+#endif
+  return nullptr;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame.h"
+#include "platform.h"
+#include "processing_stage.h"
+
+// Parse a short format name ('nv12', 'yuy2', 'mjpeg', 'rgb32', ...), case-insensitive.
+bool ParsePixelFormat(const std::string& s, PixelFormat& out);
+// Short display name ("NV12", "MJPEG", ...); empty for Unknown.
+const char* PixelFormatName(PixelFormat format);
+// Bytes in one tightly packed frame; 0 for compressed or unknown formats.
+size_t PixelFormatFrameSize(PixelFormat format, uint32_t width, uint32_t height);
+// Bytes per row of the first plane of a tightly packed frame; 0 for
+// compressed or unknown formats.
+uint32_t PixelFormatStride(PixelFormat format, uint32_t width);
+// Bytes in one frame whose rows are `stride` bytes apart (single-planar
+// layout: NV12 chroma rows follow luma at the same stride, IYUV U and V
+// planes at half of it); 0 for compressed or unknown formats.
+size_t PixelFormatStridedFrameSize(PixelFormat format, size_t stride, uint32_t height);
+// Copy a raw frame whose rows are `stride` bytes apart (layout as above) into
+// tightly packed storage of PixelFormatFrameSize bytes.
+void PackPixelRows(PixelFormat format, const uint8_t* src, size_t stride, uint32_t width, uint32_t height, uint8_t* dst);
+
+// Chroma subsampling of JPEG output. Default leaves the choice to the encoder
+// (4:2:0 for the built-in encoders).
+enum class JpegSubsampling {
+  Default,
+  Yuv420,
+  Yuv422,
+  Yuv444,
+  Yuv440,
+};
+
+// Parse '420' | '422' | '444' | '440' | 'default' (an optional '4:2:0' form too).
+bool ParseJpegSubsampling(const std::string& s, JpegSubsampling& out);
+
+// Encoder settings for MJPEG output (setOutputFormat('mjpeg')).
+struct JpegOptions {
+  float quality = 0.85f;  // 0..1
+  JpegSubsampling subsampling = JpegSubsampling::Default;
+};
+
+// HRESULT rendered as "HRESULT=0x80004005: <system message>".
+std::string HResultToString(HRESULT hr);
+
+struct CaptureDeviceInfo {
+  std::string friendlyName;
+  std::string symbolicLink;
+};
+
+struct CaptureFormat {
+  PixelFormat format = PixelFormat::Unknown;
+  // Short name; the native id for formats without a PixelFormat
+  std::string subtype;
+  // Backend-native identifier (MF subtype GUID string, FourCC, ...). Round-trips
+  // through SetFormat for formats the portable layer does not know.
+  std::string guid;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  double frameRate = 0.0;
+};
+
+// Frame gate (CaptureBackend::SetFrameGate): asked with the frame's
+// presentation time on the device clock (FrameInfo::deviceTimeUs), before it
+// is stamped; true admits the frame.
+using FrameGate = std::function<bool(int64_t deviceTimeUs)>;
+
+// Frame tap (CaptureBackend::SetFrameTap): sees every captured frame as the
+// device delivered it, before the gate, conversion or the frame pool. `info`
+// carries deviceTimeUs, arrivalUs, the native format and size, and stride
+// (the row pitch of `data`, possibly padded; 0 = tightly packed or
+// compressed); it is not stamped. `data` is only valid during the call.
+using FrameTap = std::function<void(const uint8_t* data, size_t size, const FrameInfo& info)>;
+
+// One capture device implementation (Media Foundation, synthetic, ...). A
+// backend serves one claimed device at a time. Methods may block and are
+// called from worker threads, never from the JS thread while it must stay
+// responsive; frames are delivered on a backend-owned thread.
+class CaptureBackend {
+ public:
+  virtual ~CaptureBackend() {}
+
+  // Short backend name ("mediafoundation", "synthetic")
+  virtual const char* Name() const = 0;
+
+  virtual HRESULT EnumerateDevices(std::vector<CaptureDeviceInfo>& outDevices) = 0;
+  // Open the device whose friendly name or symbolic link matches `identifier`
+  // (case-insensitive) so its formats can be queried and capture started.
+  virtual HRESULT ClaimDevice(const std::string& identifier) = 0;
+  // Stop capture and close the claimed device.
+  virtual HRESULT ReleaseDevice() = 0;
+  // Info of the claimed device; fails when nothing is claimed.
+  virtual HRESULT GetClaimedDevice(CaptureDeviceInfo& outDevice) = 0;
+
+  // Native formats of the claimed device, sorted by size then rate.
+  virtual HRESULT GetSupportedFormats(std::vector<CaptureFormat>& outFormats) = 0;
+  // Select a native format. Matches `guid` when set, otherwise `format`.
+  virtual HRESULT SetFormat(const CaptureFormat& format) = 0;
+  virtual HRESULT GetCurrentFormat(CaptureFormat& outFormat) = 0;
+  // Resolve a backend-native id (e.g. a GUID string) that is not a short name.
+  virtual bool ParseNativeFormat(const std::string& id, CaptureFormat& outFormat) const {
+    (void)id;
+    (void)outFormat;
+    return false;
+  }
+
+  // Convert frames to `format` before delivery (Unknown = deliver native frames).
+  virtual HRESULT SetOutputFormat(PixelFormat format) = 0;
+
+  virtual HRESULT StartCapture() = 0;
+  virtual HRESULT StopCapture() = 0;
+
+  // Receives every delivered frame (ownership moves into the callback).
+  virtual void SetFrameCallback(std::function<void(FramePtr)> cb) = 0;
+  // Asked for every captured frame before it is converted or copied out of
+  // the device buffer; false skips the frame at no further cost (it is
+  // neither delivered nor a discontinuity). Null admits every frame.
+  virtual void SetFrameGate(FrameGate gate) = 0;
+  // Called for every captured frame, including frames the gate refuses, on
+  // the thread that receives it from the device (recordings). Null = none.
+  virtual void SetFrameTap(FrameTap tap) = 0;
+  // Write converted or copied frames into `destination`'s storage whenever it
+  // offers some (see FramePool::SetDestination); null = pooled storage only.
+  virtual void SetFrameDestination(std::shared_ptr<FrameDestination> destination) = 0;
+  // See FramePool::SetMaxInFlight.
+  virtual void SetMaxInFlightFrames(size_t maxInFlight) = 0;
+  // Threads (0 = one per hardware thread) and band height (0 = automatic)
+  // of the conversion engine.
+  virtual void SetConversionThreads(size_t threads, size_t bandHeight) = 0;
+  // Quality and chroma subsampling of MJPEG output. Applied before the next frame.
+  virtual void SetJpegOptions(const JpegOptions& options) = 0;
+  // Kernel/driver buffers to stream through, for backends that own such a
+  // ring (V4L2). Applied at the next StartCapture.
+  virtual void SetDeviceBufferCount(size_t count) { (void)count; }
+  virtual FramePoolStats GetFramePoolStats() const = 0;
+  // Counters of the stage that converts and delivers frames off the capture
+  // thread; capacity 0 for backends that convert on the capture thread.
+  virtual ProcessingStageStats GetProcessingStats() const { return ProcessingStageStats(); }
+};
+
+// Names accepted by CreateCaptureBackend, e.g. "mediafoundation, synthetic".
+std::string CaptureBackendNames();
+// Create a backend by name ('mediafoundation' / 'mf', 'v4l2', 'synthetic',
+// 'replay'). An empty name uses CAMERA_BACKEND from the environment, then the
+// platform default.
+// Returns null for unknown or unavailable backends.
+std::unique_ptr<CaptureBackend> CreateCaptureBackend(const std::string& name);
@@ -1,74 +1,13 @@
 #include "convert.h"
 #include <immintrin.h>
-#include <intrin.h>
+#include <atomic>
+#include <cctype>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <cstddef>
-
-// CPU feature detection (Windows/MSVC)
-static void query_cpuid(int leaf, int subleaf, int regs[4]) {
-  __cpuidex(regs, leaf, subleaf);
-}
-
-bool cpu_has_avx2() {
-  int cpuInfo[4] = {0};
-  __cpuid(cpuInfo, 0);
-  int nIds = cpuInfo[0];
-  if (nIds >= 7) {
-    int regs[4] = {0};
-    __cpuidex(regs, 7, 0);
-    return (regs[1] & (1 << 5)) != 0;  // EBX bit 5 = AVX2
-  }
-  return false;
-}
-
-bool cpu_has_ssse3() {
-  int cpuInfo[4] = {0};
-  __cpuid(cpuInfo, 0);
-  int nIds = cpuInfo[0];
-  if (nIds >= 1) {
-    int regs[4] = {0};
-    __cpuidex(regs, 1, 0);
-    return (regs[2] & (1 << 9)) != 0;  // ECX bit 9 = SSSE3
-  }
-  return false;
-}
-
-bool cpu_has_sse2() {
-  int regs[4] = {0};
-  __cpuidex(regs, 1, 0);
-  return (regs[3] & (1 << 26)) != 0;  // EDX bit 26 = SSE2
-}
-
-bool cpu_has_sse3() {
-  int regs[4] = {0};
-  __cpuidex(regs, 1, 0);
-  return (regs[2] & (1 << 0)) != 0;  // ECX bit 0 = SSE3
-}
-
-bool cpu_has_sse41() {
-  int regs[4] = {0};
-  __cpuidex(regs, 1, 0);
-  return (regs[2] & (1 << 19)) != 0;  // ECX bit 19 = SSE4.1
-}
-
-bool cpu_has_avx() {
-  int regs[4] = {0};
-  __cpuidex(regs, 1, 0);
-  return (regs[2] & (1 << 28)) != 0;  // ECX bit 28 = AVX
-}
-
-bool cpu_has_bmi2() {
-  int cpuInfo[4] = {0};
-  __cpuid(cpuInfo, 0);
-  int nIds = cpuInfo[0];
-  if (nIds >= 7) {
-    int regs[4] = {0};
-    __cpuidex(regs, 7, 0);
-    return (regs[1] & (1 << 8)) != 0;  // EBX bit 8 = BMI2
-  }
-  return false;
-}
+#include <string>
 
 // Baseline per-byte RGB24 (BGR24) -> RGBA conversion
 void baseline_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels) {
@@ -196,199 +135,2190 @@ void optimized_rgb32_to_rgba(const uint8_t* srcBytes, uint8_t* dstBytes, size_t
   }
 }
 
-// SIMD BGRA->RGBA using AVX2 (preferred) or SSSE3 fallback
-void simd_rgb32_to_rgba(const uint8_t* srcBytes, uint8_t* dstBytes, size_t pixels) {
-  if (pixels == 0) return;
+// BGRA->RGBA, 8 pixels per AVX2 shuffle
+TARGET_AVX2 void avx2_rgb32_to_rgba(const uint8_t* srcBytes, uint8_t* dstBytes, size_t pixels) {
+  const size_t lanePixels = 8;  // 8 pixels per 256-bit
+  size_t vecCount = pixels / lanePixels;
+
+  const __m256i alpha_mask = _mm256_set1_epi32(0xFF000000u);
+  const __m256i shuffle_mask = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+  const __m256i* src = reinterpret_cast<const __m256i*>(srcBytes);
+  __m256i* dst = reinterpret_cast<__m256i*>(dstBytes);
+
+  for (size_t i = 0; i < vecCount; ++i) {
+    __m256i v = _mm256_loadu_si256(src + i);
+    __m256i sh = _mm256_shuffle_epi8(v, shuffle_mask);
+    __m256i out = _mm256_or_si256(sh, alpha_mask);
+    _mm256_storeu_si256(dst + i, out);
+  }
+
+  size_t processed = vecCount * lanePixels;
+  // remainder
+  for (size_t i = processed; i < pixels; ++i) {
+    const uint8_t* s = srcBytes + i * 4;
+    uint8_t* d = dstBytes + i * 4;
+    d[0] = s[2];
+    d[1] = s[1];
+    d[2] = s[0];
+    d[3] = 255;
+  }
+}
+
+// BGRA->RGBA, 4 pixels per SSSE3 shuffle
+TARGET_SSSE3 void ssse3_rgb32_to_rgba(const uint8_t* srcBytes, uint8_t* dstBytes, size_t pixels) {
+  const size_t lanePixels = 4;  // 4 pixels per 128-bit
+  size_t vecCount = pixels / lanePixels;
+
+  const __m128i alpha_mask = _mm_set1_epi32(0xFF000000u);
+  const __m128i shuffle_mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+  const __m128i* src = reinterpret_cast<const __m128i*>(srcBytes);
+  __m128i* dst = reinterpret_cast<__m128i*>(dstBytes);
+
+  for (size_t i = 0; i < vecCount; ++i) {
+    __m128i v = _mm_loadu_si128(src + i);
+    __m128i sh = _mm_shuffle_epi8(v, shuffle_mask);
+    __m128i out = _mm_or_si128(sh, alpha_mask);
+    _mm_storeu_si128(dst + i, out);
+  }
+
+  size_t processed = vecCount * lanePixels;
+  for (size_t i = processed; i < pixels; ++i) {
+    const uint8_t* s = srcBytes + i * 4;
+    uint8_t* d = dstBytes + i * 4;
+    d[0] = s[2];
+    d[1] = s[1];
+    d[2] = s[0];
+    d[3] = 255;
+  }
+}
+
+// Scalar BGR24 -> RGBA for the few pixels the vector kernels leave over
+static inline void rgb24_to_rgba_scalar(const uint8_t* s, uint8_t* d, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, s += 3, d += 4) {
+    d[0] = s[2];
+    d[1] = s[1];
+    d[2] = s[0];
+    d[3] = 255;
+  }
+}
+
+// pshufb mask expanding 4 packed BGR24 pixels (bytes 0..11) to RGBA; the
+// zeroed alpha bytes are OR-ed with 0xFF afterwards.
+#define RGB24_EXPAND_MASK 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1
+
+// Expand 8 BGR24 pixels to RGBA. Each 128-bit lane is loaded separately
+// (bytes 0..15 and 8..23) so no load reaches past the block's 24 bytes.
+TARGET_AVX2 static inline void rgb24_to_rgbax8_avx2(const uint8_t* s, uint8_t* d) {
+  // The high lane starts 8 bytes in, so its pixels 4..7 sit at bytes 4..15.
+  const __m256i shuffle_mask = _mm256_setr_epi8(
+      2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+      6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13, -1);
+  const __m256i alpha_mask = _mm256_set1_epi32(0xFF000000u);
+  __m256i v = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+  v = _mm256_inserti128_si256(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 8)), 1);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle_mask), alpha_mask));
+}
+
+// BGR24 -> RGBA, 8 pixels per AVX2 shuffle
+TARGET_AVX2 void avx2_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  if (pixels < 8) {
+    rgb24_to_rgba_scalar(src, dst, pixels);
+    return;
+  }
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) rgb24_to_rgbax8_avx2(src + i * 3, dst + i * 4);
+  // Tail: reconvert the last 8 pixels (src and dst never alias, 3 vs 4 bytes per pixel).
+  if (i < pixels) rgb24_to_rgbax8_avx2(src + (pixels - 8) * 3, dst + (pixels - 8) * 4);
+}
+
+// Expand 16 BGR24 pixels (48 bytes) to RGBA (64 bytes). palignr moves each
+// group of 4 pixels to the start of a register for the shared shuffle.
+TARGET_SSSE3 static inline void rgb24_to_rgbax16_ssse3(const uint8_t* src, uint8_t* dst) {
+  const __m128i shuffle_mask = _mm_setr_epi8(RGB24_EXPAND_MASK);
+  const __m128i alpha_mask = _mm_set1_epi32(0xFF000000u);
+  const __m128i* s = reinterpret_cast<const __m128i*>(src);
+  __m128i* d = reinterpret_cast<__m128i*>(dst);
+  __m128i in0 = _mm_loadu_si128(s);      // bytes  0..15
+  __m128i in1 = _mm_loadu_si128(s + 1);  // bytes 16..31
+  __m128i in2 = _mm_loadu_si128(s + 2);  // bytes 32..47
+  __m128i p1 = _mm_alignr_epi8(in1, in0, 12);  // pixels 4..7  (bytes 12..23)
+  __m128i p2 = _mm_alignr_epi8(in2, in1, 8);   // pixels 8..11 (bytes 24..35)
+  __m128i p3 = _mm_srli_si128(in2, 4);         // pixels 12..15 (bytes 36..47)
+  _mm_storeu_si128(d + 0, _mm_or_si128(_mm_shuffle_epi8(in0, shuffle_mask), alpha_mask));
+  _mm_storeu_si128(d + 1, _mm_or_si128(_mm_shuffle_epi8(p1, shuffle_mask), alpha_mask));
+  _mm_storeu_si128(d + 2, _mm_or_si128(_mm_shuffle_epi8(p2, shuffle_mask), alpha_mask));
+  _mm_storeu_si128(d + 3, _mm_or_si128(_mm_shuffle_epi8(p3, shuffle_mask), alpha_mask));
+}
+
+// BGR24 -> RGBA, 16 pixels per SSSE3 iteration
+TARGET_SSSE3 void ssse3_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  if (pixels < 16) {
+    rgb24_to_rgba_scalar(src, dst, pixels);
+    return;
+  }
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) rgb24_to_rgbax16_ssse3(src + i * 3, dst + i * 4);
+  if (i < pixels) rgb24_to_rgbax16_ssse3(src + (pixels - 16) * 3, dst + (pixels - 16) * 4);
+}
+
+#undef RGB24_EXPAND_MASK
 
-  if (cpu_has_avx2()) {
-    const size_t lanePixels = 8;  // 8 pixels per 256-bit
-    size_t vecCount = pixels / lanePixels;
+// ---------------------------------------------------------------------------
+// YUV -> RGB
+//
+// All YUV kernels share one fixed-point formulation so SIMD variants are
+// bit-exact with the scalar baseline:
+//   ys = Y - yOffset, u = U - 128, v = V - 128
+//   R = sat((ys*cy + v*crv          + 4096) >> 13)
+//   G = sat((ys*cy + u*cgu + v*cgv  + 4096) >> 13)
+//   B = sat((ys*cy + u*cbu          + 4096) >> 13)
+// Coefficients are scaled by 2^13 so every product pair fits _mm_madd_epi16.
+// ---------------------------------------------------------------------------
 
-    const __m256i alpha_mask = _mm256_set1_epi32(0xFF000000u);
-    const __m256i shuffle_mask = _mm256_setr_epi8(
-        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+struct YuvCoeffs {
+  int16_t yOffset;
+  int16_t cy;
+  int16_t crv;
+  int16_t cgu;
+  int16_t cgv;
+  int16_t cbu;
+};
 
-    const __m256i* src = reinterpret_cast<const __m256i*>(srcBytes);
-    __m256i* dst = reinterpret_cast<__m256i*>(dstBytes);
+static const YuvCoeffs kYuvCoeffs[2][2] = {
+    // BT.601: limited, full
+    {{16, 9539, 13075, -3209, -6660, 16525}, {0, 8192, 11485, -2819, -5850, 14516}},
+    // BT.709: limited, full
+    {{16, 9539, 14686, -1747, -4366, 17305}, {0, 8192, 12901, -1535, -3835, 15201}},
+};
 
-    for (size_t i = 0; i < vecCount; ++i) {
-      __m256i v = _mm256_loadu_si256(src + i);
-      __m256i sh = _mm256_shuffle_epi8(v, shuffle_mask);
-      __m256i out = _mm256_or_si256(sh, alpha_mask);
-      _mm256_storeu_si256(dst + i, out);
+static inline const YuvCoeffs& yuv_coeffs(YuvMatrix matrix, YuvRange range) {
+  return kYuvCoeffs[matrix == YuvMatrix::BT709 ? 1 : 0][range == YuvRange::Full ? 1 : 0];
+}
+
+static inline uint8_t clamp_u8(int x) {
+  return static_cast<uint8_t>(x < 0 ? 0 : (x > 255 ? 255 : x));
+}
+
+static inline void yuv_to_rgb(int y, int u, int v, const YuvCoeffs& c, uint8_t* r, uint8_t* g, uint8_t* b) {
+  int ys = (y - c.yOffset) * c.cy;
+  u -= 128;
+  v -= 128;
+  *r = clamp_u8((ys + v * c.crv + 4096) >> 13);
+  *g = clamp_u8((ys + u * c.cgu + v * c.cgv + 4096) >> 13);
+  *b = clamp_u8((ys + u * c.cbu + 4096) >> 13);
+}
+
+// Convert one pixel; `d` receives 4 bytes in `order`.
+static inline void yuv_to_rgb32_pixel(int y, int u, int v, const YuvCoeffs& c, uint8_t* d, Rgb32Order order) {
+  uint8_t r, g, b;
+  yuv_to_rgb(y, u, v, c, &r, &g, &b);
+  if (order == Rgb32Order::RGBA) {
+    d[0] = r;
+    d[2] = b;
+  } else {
+    d[0] = b;
+    d[2] = r;
+  }
+  d[1] = g;
+  d[3] = 255;
+}
+
+// Scalar NV12 row from pixel `col` to `width`; used by the baseline and as the
+// tail of every SIMD row.
+static inline void nv12_row_scalar(const uint8_t* y, const uint8_t* uv, uint8_t* d, size_t col, size_t width, const YuvCoeffs& c, Rgb32Order order) {
+  for (; col < width; ++col) {
+    const uint8_t* p = uv + (col & ~static_cast<size_t>(1));
+    yuv_to_rgb32_pixel(y[col], p[0], p[1], c, d + col * 4, order);
+  }
+}
+
+void baseline_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  for (size_t row = 0; row < height; ++row) {
+    nv12_row_scalar(srcY + row * strideY, srcUV + (row / 2) * strideUV, dst + row * dstStride, 0, width, c, order);
+  }
+}
+
+// 32-bit lane holding int16 `lo` in the low word and `hi` in the high word,
+// matching the operand order of _mm_madd_epi16 on unpacklo(a, b).
+static inline int madd_pair(int lo, int hi) {
+  return static_cast<int>((static_cast<uint32_t>(static_cast<uint16_t>(hi)) << 16) | static_cast<uint16_t>(lo));
+}
+
+// --- SSE2: 8 pixels per core step, 16 per loop iteration ---
+
+struct YuvConstsSse2 {
+  __m128i yOffset, c128, cyCrv, cyCbu, cyCgu, cgvRound, round, one, max255, alpha, lowWord;
+  explicit YuvConstsSse2(const YuvCoeffs& c)
+      : yOffset(_mm_set1_epi16(c.yOffset)),
+        c128(_mm_set1_epi16(128)),
+        cyCrv(_mm_set1_epi32(madd_pair(c.cy, c.crv))),
+        cyCbu(_mm_set1_epi32(madd_pair(c.cy, c.cbu))),
+        cyCgu(_mm_set1_epi32(madd_pair(c.cy, c.cgu))),
+        cgvRound(_mm_set1_epi32(madd_pair(c.cgv, 4096))),
+        round(_mm_set1_epi32(4096)),
+        one(_mm_set1_epi16(1)),
+        max255(_mm_set1_epi16(255)),
+        alpha(_mm_set1_epi16(static_cast<short>(0xFF00))),
+        lowWord(_mm_set1_epi32(0x0000FFFF)) {}
+};
+
+// Expand 4 interleaved (U,V) int16 pairs into per-pixel U and V (minus 128).
+static inline void chroma_pairs_sse2(__m128i uv, const YuvConstsSse2& k, __m128i* u, __m128i* v) {
+  __m128i uu = _mm_and_si128(uv, k.lowWord);
+  __m128i vv = _mm_srli_epi32(uv, 16);
+  *u = _mm_sub_epi16(_mm_or_si128(uu, _mm_slli_epi32(uu, 16)), k.c128);
+  *v = _mm_sub_epi16(_mm_or_si128(vv, _mm_slli_epi32(vv, 16)), k.c128);
+}
+
+// 8 pixels: y/u/v hold 8 int16 each (u/v already centred). out[0..1] receive
+// the 32 output bytes in pixel order.
+static inline void yuv8_to_rgb32_sse2(__m128i y, __m128i u, __m128i v, const YuvConstsSse2& k, Rgb32Order order, __m128i out[2]) {
+  __m128i ys = _mm_sub_epi16(y, k.yOffset);
+  __m128i yvLo = _mm_unpacklo_epi16(ys, v), yvHi = _mm_unpackhi_epi16(ys, v);
+  __m128i yuLo = _mm_unpacklo_epi16(ys, u), yuHi = _mm_unpackhi_epi16(ys, u);
+  __m128i v1Lo = _mm_unpacklo_epi16(v, k.one), v1Hi = _mm_unpackhi_epi16(v, k.one);
+
+  __m128i r = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yvLo, k.cyCrv), k.round), 13),
+                              _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yvHi, k.cyCrv), k.round), 13));
+  __m128i b = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo, k.cyCbu), k.round), 13),
+                              _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi, k.cyCbu), k.round), 13));
+  __m128i g = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo, k.cyCgu), _mm_madd_epi16(v1Lo, k.cgvRound)), 13),
+                              _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi, k.cyCgu), _mm_madd_epi16(v1Hi, k.cgvRound)), 13));
+
+  const __m128i zero = _mm_setzero_si128();
+  r = _mm_min_epi16(_mm_max_epi16(r, zero), k.max255);
+  g = _mm_min_epi16(_mm_max_epi16(g, zero), k.max255);
+  b = _mm_min_epi16(_mm_max_epi16(b, zero), k.max255);
+
+  __m128i first = order == Rgb32Order::RGBA ? r : b;
+  __m128i third = order == Rgb32Order::RGBA ? b : r;
+  __m128i lo = _mm_or_si128(first, _mm_slli_epi16(g, 8));  // bytes 0,1
+  __m128i hi = _mm_or_si128(third, k.alpha);               // bytes 2,3
+  out[0] = _mm_unpacklo_epi16(lo, hi);
+  out[1] = _mm_unpackhi_epi16(lo, hi);
+}
+
+static inline void store_rgb32x8_sse2(uint8_t* d, const __m128i px[2]) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(d), px[0]);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16), px[1]);
+}
+
+void sse2_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  const YuvConstsSse2 k(c);
+  const __m128i zero = _mm_setzero_si128();
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* y = srcY + row * strideY;
+    const uint8_t* uv = srcUV + (row / 2) * strideUV;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 16 <= width; col += 16) {
+      __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + col));
+      __m128i uv8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + col));
+      __m128i u, v, px[2];
+      chroma_pairs_sse2(_mm_unpacklo_epi8(uv8, zero), k, &u, &v);
+      yuv8_to_rgb32_sse2(_mm_unpacklo_epi8(y8, zero), u, v, k, order, px);
+      store_rgb32x8_sse2(d + col * 4, px);
+      chroma_pairs_sse2(_mm_unpackhi_epi8(uv8, zero), k, &u, &v);
+      yuv8_to_rgb32_sse2(_mm_unpackhi_epi8(y8, zero), u, v, k, order, px);
+      store_rgb32x8_sse2(d + col * 4 + 32, px);
     }
+    nv12_row_scalar(y, uv, d, col, width, c, order);
+  }
+}
+
+// --- AVX2: 16 pixels per core step, 32 per loop iteration ---
+
+struct YuvConstsAvx2 {
+  __m256i yOffset, c128, cyCrv, cyCbu, cyCgu, cgvRound, round, one, max255, alpha, lowWord;
+  TARGET_AVX2 explicit YuvConstsAvx2(const YuvCoeffs& c)
+      : yOffset(_mm256_set1_epi16(c.yOffset)),
+        c128(_mm256_set1_epi16(128)),
+        cyCrv(_mm256_set1_epi32(madd_pair(c.cy, c.crv))),
+        cyCbu(_mm256_set1_epi32(madd_pair(c.cy, c.cbu))),
+        cyCgu(_mm256_set1_epi32(madd_pair(c.cy, c.cgu))),
+        cgvRound(_mm256_set1_epi32(madd_pair(c.cgv, 4096))),
+        round(_mm256_set1_epi32(4096)),
+        one(_mm256_set1_epi16(1)),
+        max255(_mm256_set1_epi16(255)),
+        alpha(_mm256_set1_epi16(static_cast<short>(0xFF00))),
+        lowWord(_mm256_set1_epi32(0x0000FFFF)) {}
+};
+
+TARGET_AVX2 static inline void chroma_pairs_avx2(__m256i uv, const YuvConstsAvx2& k, __m256i* u, __m256i* v) {
+  __m256i uu = _mm256_and_si256(uv, k.lowWord);
+  __m256i vv = _mm256_srli_epi32(uv, 16);
+  *u = _mm256_sub_epi16(_mm256_or_si256(uu, _mm256_slli_epi32(uu, 16)), k.c128);
+  *v = _mm256_sub_epi16(_mm256_or_si256(vv, _mm256_slli_epi32(vv, 16)), k.c128);
+}
+
+// 16 pixels in order (int16 lanes). unpack/pack are lane-local inverses so the
+// channel vectors stay in pixel order; the final interleave is re-ordered
+// across 128-bit lanes so out[0..1] hold the 64 output bytes in pixel order.
+TARGET_AVX2 static inline void yuv16_to_rgb32_avx2(__m256i y, __m256i u, __m256i v, const YuvConstsAvx2& k, Rgb32Order order, __m256i out[2]) {
+  __m256i ys = _mm256_sub_epi16(y, k.yOffset);
+  __m256i yvLo = _mm256_unpacklo_epi16(ys, v), yvHi = _mm256_unpackhi_epi16(ys, v);
+  __m256i yuLo = _mm256_unpacklo_epi16(ys, u), yuHi = _mm256_unpackhi_epi16(ys, u);
+  __m256i v1Lo = _mm256_unpacklo_epi16(v, k.one), v1Hi = _mm256_unpackhi_epi16(v, k.one);
 
-    size_t processed = vecCount * lanePixels;
-    // remainder
-    for (size_t i = processed; i < pixels; ++i) {
-      const uint8_t* s = srcBytes + i * 4;
-      uint8_t* d = dstBytes + i * 4;
-      d[0] = s[2];
-      d[1] = s[1];
-      d[2] = s[0];
-      d[3] = 255;
+  __m256i r = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yvLo, k.cyCrv), k.round), 13),
+                                 _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yvHi, k.cyCrv), k.round), 13));
+  __m256i b = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo, k.cyCbu), k.round), 13),
+                                 _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi, k.cyCbu), k.round), 13));
+  __m256i g = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo, k.cyCgu), _mm256_madd_epi16(v1Lo, k.cgvRound)), 13),
+                                 _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi, k.cyCgu), _mm256_madd_epi16(v1Hi, k.cgvRound)), 13));
+
+  const __m256i zero = _mm256_setzero_si256();
+  r = _mm256_min_epi16(_mm256_max_epi16(r, zero), k.max255);
+  g = _mm256_min_epi16(_mm256_max_epi16(g, zero), k.max255);
+  b = _mm256_min_epi16(_mm256_max_epi16(b, zero), k.max255);
+
+  __m256i first = order == Rgb32Order::RGBA ? r : b;
+  __m256i third = order == Rgb32Order::RGBA ? b : r;
+  __m256i lo = _mm256_or_si256(first, _mm256_slli_epi16(g, 8));
+  __m256i hi = _mm256_or_si256(third, k.alpha);
+  __m256i p0 = _mm256_unpacklo_epi16(lo, hi);  // pixels 0-3 | 8-11
+  __m256i p1 = _mm256_unpackhi_epi16(lo, hi);  // pixels 4-7 | 12-15
+  out[0] = _mm256_permute2x128_si256(p0, p1, 0x20);
+  out[1] = _mm256_permute2x128_si256(p0, p1, 0x31);
+}
+
+TARGET_AVX2 static inline void store_rgb32x16_avx2(uint8_t* d, const __m256i px[2]) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), px[0]);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + 32), px[1]);
+}
+
+TARGET_AVX2 void avx2_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  const YuvConstsAvx2 k(c);
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* y = srcY + row * strideY;
+    const uint8_t* uv = srcUV + (row / 2) * strideUV;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      __m256i u, v, px[2];
+      chroma_pairs_avx2(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + col))), k, &u, &v);
+      yuv16_to_rgb32_avx2(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + col))), u, v, k, order, px);
+      store_rgb32x16_avx2(d + col * 4, px);
+      chroma_pairs_avx2(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + col + 16))), k, &u, &v);
+      yuv16_to_rgb32_avx2(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + col + 16))), u, v, k, order, px);
+      store_rgb32x16_avx2(d + col * 4 + 64, px);
     }
+    nv12_row_scalar(y, uv, d, col, width, c, order);
+  }
+}
+
+// --- AVX-512 (F+BW): 32 pixels per core step ---
+
+// Dword shifts go through the zero-masked forms with every lane selected
+// (same instruction): GCC 12's unmasked ones pass _mm512_undefined_epi32()
+// through, which -Wmaybe-uninitialized flags under target attributes.
+static const __mmask16 kAllDwords = 0xFFFF;
+
+struct YuvConstsAvx512 {
+  __m512i yOffset, c128, cyCrv, cyCbu, cyCgu, cgvRound, round, one, max255, alpha, lowWord, permLo, permHi;
+  TARGET_AVX512BW explicit YuvConstsAvx512(const YuvCoeffs& c)
+      : yOffset(_mm512_set1_epi16(c.yOffset)),
+        c128(_mm512_set1_epi16(128)),
+        cyCrv(_mm512_set1_epi32(madd_pair(c.cy, c.crv))),
+        cyCbu(_mm512_set1_epi32(madd_pair(c.cy, c.cbu))),
+        cyCgu(_mm512_set1_epi32(madd_pair(c.cy, c.cgu))),
+        cgvRound(_mm512_set1_epi32(madd_pair(c.cgv, 4096))),
+        round(_mm512_set1_epi32(4096)),
+        one(_mm512_set1_epi16(1)),
+        max255(_mm512_set1_epi16(255)),
+        alpha(_mm512_set1_epi16(static_cast<short>(0xFF00))),
+        lowWord(_mm512_set1_epi32(0x0000FFFF)),
+        // qword indices gathering 128-bit lanes of (lo, hi) back into pixel order
+        permLo(_mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11)),
+        permHi(_mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15)) {}
+};
+
+TARGET_AVX512BW static inline void chroma_pairs_avx512(__m512i uv, const YuvConstsAvx512& k, __m512i* u, __m512i* v) {
+  __m512i uu = _mm512_and_si512(uv, k.lowWord);
+  __m512i vv = _mm512_maskz_srli_epi32(kAllDwords, uv, 16);
+  *u = _mm512_sub_epi16(_mm512_or_si512(uu, _mm512_maskz_slli_epi32(kAllDwords, uu, 16)), k.c128);
+  *v = _mm512_sub_epi16(_mm512_or_si512(vv, _mm512_maskz_slli_epi32(kAllDwords, vv, 16)), k.c128);
+}
+
+TARGET_AVX512BW static inline void yuv32_to_rgb32_avx512(__m512i y, __m512i u, __m512i v, const YuvConstsAvx512& k, uint8_t* d, Rgb32Order order) {
+  __m512i ys = _mm512_sub_epi16(y, k.yOffset);
+  __m512i yvLo = _mm512_unpacklo_epi16(ys, v), yvHi = _mm512_unpackhi_epi16(ys, v);
+  __m512i yuLo = _mm512_unpacklo_epi16(ys, u), yuHi = _mm512_unpackhi_epi16(ys, u);
+  __m512i v1Lo = _mm512_unpacklo_epi16(v, k.one), v1Hi = _mm512_unpackhi_epi16(v, k.one);
+
+  __m512i r = _mm512_packs_epi32(_mm512_maskz_srai_epi32(kAllDwords, _mm512_add_epi32(_mm512_madd_epi16(yvLo, k.cyCrv), k.round), 13),
+                                 _mm512_maskz_srai_epi32(kAllDwords, _mm512_add_epi32(_mm512_madd_epi16(yvHi, k.cyCrv), k.round), 13));
+  __m512i b = _mm512_packs_epi32(_mm512_maskz_srai_epi32(kAllDwords, _mm512_add_epi32(_mm512_madd_epi16(yuLo, k.cyCbu), k.round), 13),
+                                 _mm512_maskz_srai_epi32(kAllDwords, _mm512_add_epi32(_mm512_madd_epi16(yuHi, k.cyCbu), k.round), 13));
+  __m512i g = _mm512_packs_epi32(_mm512_maskz_srai_epi32(kAllDwords, _mm512_add_epi32(_mm512_madd_epi16(yuLo, k.cyCgu), _mm512_madd_epi16(v1Lo, k.cgvRound)), 13),
+                                 _mm512_maskz_srai_epi32(kAllDwords, _mm512_add_epi32(_mm512_madd_epi16(yuHi, k.cyCgu), _mm512_madd_epi16(v1Hi, k.cgvRound)), 13));
+
+  const __m512i zero = _mm512_setzero_si512();
+  r = _mm512_min_epi16(_mm512_max_epi16(r, zero), k.max255);
+  g = _mm512_min_epi16(_mm512_max_epi16(g, zero), k.max255);
+  b = _mm512_min_epi16(_mm512_max_epi16(b, zero), k.max255);
+
+  __m512i first = order == Rgb32Order::RGBA ? r : b;
+  __m512i third = order == Rgb32Order::RGBA ? b : r;
+  __m512i lo = _mm512_or_si512(first, _mm512_slli_epi16(g, 8));
+  __m512i hi = _mm512_or_si512(third, k.alpha);
+  __m512i p0 = _mm512_unpacklo_epi16(lo, hi);  // pixels 0-3 | 8-11 | 16-19 | 24-27
+  __m512i p1 = _mm512_unpackhi_epi16(lo, hi);  // pixels 4-7 | 12-15 | 20-23 | 28-31
+  _mm512_storeu_si512(d, _mm512_permutex2var_epi64(p0, k.permLo, p1));
+  _mm512_storeu_si512(d + 64, _mm512_permutex2var_epi64(p0, k.permHi, p1));
+}
+
+TARGET_AVX512BW void avx512_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  const YuvConstsAvx512 k(c);
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* y = srcY + row * strideY;
+    const uint8_t* uv = srcUV + (row / 2) * strideUV;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      __m512i u, v;
+      chroma_pairs_avx512(_mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + col))), k, &u, &v);
+      yuv32_to_rgb32_avx512(_mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + col))), u, v, k, d + col * 4, order);
+    }
+    nv12_row_scalar(y, uv, d, col, width, c, order);
+  }
+}
+
+// --- Packed 4:2:2 (YUY2 / UYVY) ---
+//
+// Every 16-bit word of a packed 4:2:2 row holds one luma byte and one chroma
+// byte, alternating U and V. Splitting the words therefore yields luma in
+// pixel order plus interleaved (U,V) pairs, which is exactly the input the
+// NV12 chroma expansion and conversion cores already take.
+
+static inline size_t rgb_format_bpp(RgbFormat format) {
+  return format == RgbFormat::BGR24 ? 3 : 4;
+}
+
+static inline void yuv_to_rgb_format_pixel(int y, int u, int v, const YuvCoeffs& c, uint8_t* d, RgbFormat format) {
+  if (format == RgbFormat::BGR24) {
+    uint8_t r, g, b;
+    yuv_to_rgb(y, u, v, c, &r, &g, &b);
+    d[0] = b;
+    d[1] = g;
+    d[2] = r;
     return;
   }
+  yuv_to_rgb32_pixel(y, u, v, c, d, format == RgbFormat::RGBA ? Rgb32Order::RGBA : Rgb32Order::BGRA);
+}
 
-  if (cpu_has_ssse3()) {
-    const size_t lanePixels = 4;  // 4 pixels per 128-bit
-    size_t vecCount = pixels / lanePixels;
+// Scalar 4:2:2 row from pixel `col` to `width`; used by the baseline and as the
+// tail of every SIMD row. An odd final pixel uses its macropixel's chroma.
+static inline void yuv422_row_scalar(const uint8_t* s, uint8_t* d, size_t col, size_t width, Yuv422Layout layout, RgbFormat format, const YuvCoeffs& c) {
+  const size_t bpp = rgb_format_bpp(format);
+  const int yIdx = layout == Yuv422Layout::YUY2 ? 0 : 1;
+  const int uIdx = layout == Yuv422Layout::YUY2 ? 1 : 0;
+  for (; col < width; ++col) {
+    const uint8_t* p = s + (col >> 1) * 4;
+    yuv_to_rgb_format_pixel(p[yIdx + (col & 1) * 2], p[uIdx], p[uIdx + 2], c, d + col * bpp, format);
+  }
+}
+
+void baseline_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  for (size_t row = 0; row < height; ++row) {
+    yuv422_row_scalar(src + row * srcStride, dst + row * dstStride, 0, width, layout, format, c);
+  }
+}
 
-    const __m128i alpha_mask = _mm_set1_epi32(0xFF000000u);
-    const __m128i shuffle_mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+// --- SSSE3: 16 pixels per loop iteration (pshufb is only needed for BGR24) ---
 
-    const __m128i* src = reinterpret_cast<const __m128i*>(srcBytes);
-    __m128i* dst = reinterpret_cast<__m128i*>(dstBytes);
+// Split 8 packed 4:2:2 words into 8 int16 luma values and 4 (U,V) int16 pairs.
+static inline void split_yuv422_sse2(__m128i w, Yuv422Layout layout, const YuvConstsSse2& k, __m128i* y, __m128i* uv) {
+  __m128i lo = _mm_and_si128(w, k.max255);
+  __m128i hi = _mm_srli_epi16(w, 8);
+  *y = layout == Yuv422Layout::YUY2 ? lo : hi;
+  *uv = layout == Yuv422Layout::YUY2 ? hi : lo;
+}
+
+// Drop the alpha byte of 16 BGRA pixels and store them as 48 bytes of BGR24.
+TARGET_SSSE3 static inline void store_bgr24x16_ssse3(uint8_t* d, const __m128i px[4]) {
+  const __m128i drop = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  __m128i c0 = _mm_shuffle_epi8(px[0], drop);
+  __m128i c1 = _mm_shuffle_epi8(px[1], drop);
+  __m128i c2 = _mm_shuffle_epi8(px[2], drop);
+  __m128i c3 = _mm_shuffle_epi8(px[3], drop);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_or_si128(c0, _mm_slli_si128(c1, 12)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16), _mm_or_si128(_mm_srli_si128(c1, 4), _mm_slli_si128(c2, 8)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 32), _mm_or_si128(_mm_srli_si128(c2, 8), _mm_slli_si128(c3, 4)));
+}
 
-    for (size_t i = 0; i < vecCount; ++i) {
-      __m128i v = _mm_loadu_si128(src + i);
-      __m128i sh = _mm_shuffle_epi8(v, shuffle_mask);
-      __m128i out = _mm_or_si128(sh, alpha_mask);
-      _mm_storeu_si128(dst + i, out);
+TARGET_SSSE3 void ssse3_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  const YuvConstsSse2 k(c);
+  const Rgb32Order order = format == RgbFormat::RGBA ? Rgb32Order::RGBA : Rgb32Order::BGRA;
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* s = src + row * srcStride;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 16 <= width; col += 16) {
+      __m128i px[4];
+      for (int half = 0; half < 2; ++half) {
+        __m128i y, uv, u, v;
+        split_yuv422_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + col * 2 + half * 16)), layout, k, &y, &uv);
+        chroma_pairs_sse2(uv, k, &u, &v);
+        yuv8_to_rgb32_sse2(y, u, v, k, order, px + half * 2);
+      }
+      if (format == RgbFormat::BGR24) {
+        store_bgr24x16_ssse3(d + col * 3, px);
+      } else {
+        store_rgb32x8_sse2(d + col * 4, px);
+        store_rgb32x8_sse2(d + col * 4 + 32, px + 2);
+      }
     }
+    yuv422_row_scalar(s, d, col, width, layout, format, c);
+  }
+}
+
+// --- AVX2: 16 pixels per core step, 32 per loop iteration ---
+
+TARGET_AVX2 static inline void split_yuv422_avx2(__m256i w, Yuv422Layout layout, const YuvConstsAvx2& k, __m256i* y, __m256i* uv) {
+  __m256i lo = _mm256_and_si256(w, k.max255);
+  __m256i hi = _mm256_srli_epi16(w, 8);
+  *y = layout == Yuv422Layout::YUY2 ? lo : hi;
+  *uv = layout == Yuv422Layout::YUY2 ? hi : lo;
+}
 
-    size_t processed = vecCount * lanePixels;
-    for (size_t i = processed; i < pixels; ++i) {
-      const uint8_t* s = srcBytes + i * 4;
-      uint8_t* d = dstBytes + i * 4;
-      d[0] = s[2];
-      d[1] = s[1];
-      d[2] = s[0];
-      d[3] = 255;
+// Drop the alpha byte of 16 BGRA pixels and store them as 48 bytes of BGR24.
+// Each 8-pixel vector is compacted to its low 24 bytes; the first store spills
+// 8 bytes that the second one overwrites, so nothing is written past d + 48.
+TARGET_AVX2 static inline void store_bgr24x16_avx2(uint8_t* d, const __m256i px[2]) {
+  const __m256i drop = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  __m256i c0 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(px[0], drop), pack);
+  __m256i c1 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(px[1], drop), pack);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), c0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 24), _mm256_castsi256_si128(c1));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(d + 40), _mm256_extracti128_si256(c1, 1));
+}
+
+TARGET_AVX2 void avx2_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  const YuvConstsAvx2 k(c);
+  const Rgb32Order order = format == RgbFormat::RGBA ? Rgb32Order::RGBA : Rgb32Order::BGRA;
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* s = src + row * srcStride;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      for (size_t step = 0; step < 32; step += 16) {
+        __m256i y, uv, u, v, px[2];
+        split_yuv422_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + (col + step) * 2)), layout, k, &y, &uv);
+        chroma_pairs_avx2(uv, k, &u, &v);
+        yuv16_to_rgb32_avx2(y, u, v, k, order, px);
+        if (format == RgbFormat::BGR24) {
+          store_bgr24x16_avx2(d + (col + step) * 3, px);
+        } else {
+          store_rgb32x16_avx2(d + (col + step) * 4, px);
+        }
+      }
     }
-    return;
+    yuv422_row_scalar(s, d, col, width, layout, format, c);
+  }
+}
+
+// --- Planar or semi-planar 4:2:0 (NV12 / I420) ---
+//
+// I420's separate U and V rows are interleaved into (U,V) pairs as they are
+// loaded, so both layouts feed the NV12 chroma expansion and conversion cores.
+
+// Scalar 4:2:0 row from pixel `col` to `width`; used by the baseline and as the
+// tail of every SIMD row.
+static inline void yuv420_row_scalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t uvStep, uint8_t* d, size_t col, size_t width, RgbFormat format, const YuvCoeffs& c) {
+  const size_t bpp = rgb_format_bpp(format);
+  for (; col < width; ++col) {
+    const size_t i = (col >> 1) * uvStep;
+    yuv_to_rgb_format_pixel(y[col], u[i], v[i], c, d + col * bpp, format);
   }
+}
 
-  // Fallback to the optimized scalar/unrolled implementation
-  optimized_rgb32_to_rgba(srcBytes, dstBytes, pixels, 0, 0);
+void baseline_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  for (size_t row = 0; row < height; ++row) {
+    const size_t uvRow = (row / 2) * strideUV;
+    yuv420_row_scalar(srcY + row * strideY, srcU + uvRow, srcV + uvRow, uvStep, dst + row * dstStride, 0, width, format, c);
+  }
 }
 
-// SIMD BGR24 -> RGBA using AVX2/SSSE3. We load packed RGB triplets and rearrange
-// into 32-bit RGBA words. For simplicity and portability we operate on blocks
-// and fall back to optimized scalar when SIMD isn't available.
-void simd_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels) {
-  if (pixels == 0) return;
+// 8 (U,V) pairs for pixels 2*i .. 2*i + 15 of a 4:2:0 row
+static inline __m128i load_uv8_sse2(const uint8_t* u, const uint8_t* v, size_t uvStep, size_t i) {
+  if (uvStep == 2) return _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i * 2));
+  return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + i)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + i)));
+}
 
-  // AVX2 path: process 8 pixels (24 bytes per 8 pixels = 192 bytes) in a loop
-  if (cpu_has_avx2()) {
-    // AVX2 path: process 8 pixels (24 bytes input -> 32 bytes output) per loop
-    const uint8_t* s = src;
-    uint8_t* d = dst;
-    size_t totalBytes = pixels * 3;
-    size_t processedPixels = 0;
-    size_t offset = 0; // bytes consumed from src
-
-    // Shuffle mask: for each 128-bit lane (16 bytes) we expand 4 pixels -> 16 output bytes
-    const __m256i shuffle_mask = _mm256_setr_epi8(
-        // low 128-bit lane (pixels 0..3): r,g,b,alpha_placeholder for each
-        2, 1, 0, (char)0x80, 5, 4, 3, (char)0x80, 8, 7, 6, (char)0x80, 11, 10, 9, (char)0x80,
-        // high 128-bit lane (pixels 4..7)
-        14, 13, 12, (char)0x80, 17, 16, 15, (char)0x80, 20, 19, 18, (char)0x80, 23, 22, 21, (char)0x80
-    );
-    const __m256i alpha_mask = _mm256_set1_epi32(0xFF000000u);
-
-    // Each loop consumes 24 source bytes (8 pixels). Use safe loads for tail so we
-    // never read past the source buffer: when fewer than 32 bytes remain, copy to
-    // a small temp buffer and load from it.
-    while (processedPixels < pixels) {
-      size_t pixelsLeft = pixels - processedPixels;
-      size_t bytesLeft = totalBytes - offset;
-      if (pixelsLeft >= 8 && bytesLeft >= 32) {
-        // fast path: enough input to load 32 bytes safely
-        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + offset));
-        const __m256i sh = _mm256_shuffle_epi8(v, shuffle_mask);
-        const __m256i out = _mm256_or_si256(sh, alpha_mask);
-        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + processedPixels * 4), out);
-        processedPixels += 8;
-        offset += 24; // consumed 8 * 3 bytes
-        continue;
+TARGET_SSSE3 void ssse3_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  const YuvConstsSse2 k(c);
+  const Rgb32Order order = format == RgbFormat::RGBA ? Rgb32Order::RGBA : Rgb32Order::BGRA;
+  const __m128i zero = _mm_setzero_si128();
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* y = srcY + row * strideY;
+    const uint8_t* u = srcU + (row / 2) * strideUV;
+    const uint8_t* v = srcV + (row / 2) * strideUV;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 16 <= width; col += 16) {
+      __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + col));
+      __m128i uv8 = load_uv8_sse2(u, v, uvStep, col / 2);
+      __m128i cu, cv, px[4];
+      chroma_pairs_sse2(_mm_unpacklo_epi8(uv8, zero), k, &cu, &cv);
+      yuv8_to_rgb32_sse2(_mm_unpacklo_epi8(y8, zero), cu, cv, k, order, px);
+      chroma_pairs_sse2(_mm_unpackhi_epi8(uv8, zero), k, &cu, &cv);
+      yuv8_to_rgb32_sse2(_mm_unpackhi_epi8(y8, zero), cu, cv, k, order, px + 2);
+      if (format == RgbFormat::BGR24) {
+        store_bgr24x16_ssse3(d + col * 3, px);
+      } else {
+        store_rgb32x8_sse2(d + col * 4, px);
+        store_rgb32x8_sse2(d + col * 4 + 32, px + 2);
       }
+    }
+    yuv420_row_scalar(y, u, v, uvStep, d, col, width, format, c);
+  }
+}
 
-      // tail or not enough bytes to safely load 32 bytes: use temp buffer
-      alignas(32) uint8_t tmpIn[32];
-      alignas(32) uint8_t tmpOut[32];
-      // zero pad
-      std::memset(tmpIn, 0, sizeof(tmpIn));
-      // copy available bytes (may be <32)
-      size_t toCopy = (bytesLeft < sizeof(tmpIn)) ? bytesLeft : sizeof(tmpIn);
-      if (toCopy > 0) std::memcpy(tmpIn, s + offset, toCopy);
-
-      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tmpIn));
-      const __m256i sh = _mm256_shuffle_epi8(v, shuffle_mask);
-      const __m256i out = _mm256_or_si256(sh, alpha_mask);
-      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmpOut), out);
-
-      // how many pixels can we produce from the copied bytes?
-      size_t producedPixels = (toCopy / 3);
-      if (producedPixels == 0) break;
-      if (producedPixels > pixelsLeft) producedPixels = pixelsLeft;
-
-      // copy only produced pixels to destination
-      std::memcpy(d + processedPixels * 4, tmpOut, producedPixels * 4);
-      processedPixels += producedPixels;
-      offset += producedPixels * 3;
-      // continue loop; if still pixels remain but insufficient bytes, next iter will fill tmpIn again
+TARGET_AVX2 void avx2_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const YuvCoeffs& c = yuv_coeffs(matrix, range);
+  const YuvConstsAvx2 k(c);
+  const Rgb32Order order = format == RgbFormat::RGBA ? Rgb32Order::RGBA : Rgb32Order::BGRA;
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* y = srcY + row * strideY;
+    const uint8_t* u = srcU + (row / 2) * strideUV;
+    const uint8_t* v = srcV + (row / 2) * strideUV;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      for (size_t step = 0; step < 32; step += 16) {
+        __m256i cu, cv, px[2];
+        chroma_pairs_avx2(_mm256_cvtepu8_epi16(load_uv8_sse2(u, v, uvStep, (col + step) / 2)), k, &cu, &cv);
+        yuv16_to_rgb32_avx2(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + col + step))), cu, cv, k, order, px);
+        if (format == RgbFormat::BGR24) {
+          store_bgr24x16_avx2(d + (col + step) * 3, px);
+        } else {
+          store_rgb32x16_avx2(d + (col + step) * 4, px);
+        }
+      }
     }
+    yuv420_row_scalar(y, u, v, uvStep, d, col, width, format, c);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// RGB -> YUV
+//
+// The inverse transform uses 15-bit coefficients. Chroma is computed from
+// the channel sums of the n pixels a sample covers (2 for 4:2:2, 4 for
+// 4:2:0), which folds the average into the final shift:
+//   Y = sat((yr*R + yg*G + yb*B + (yOffset << 15) + (1 << 14)) >> 15)
+//   U = sat((ur*sR + ug*sG + ub*sB + (128 << s) + (1 << (s - 1))) >> s)
+// with s = 15 + log2(n), V likewise. Each chroma row of coefficients sums to
+// zero, so grey maps to exactly 128. Pixels are widened to four int16
+// channels and multiplied with _mm_madd_epi16; the sums of up to 4 pixels
+// stay below 2^10, so no product pair overflows.
+// ---------------------------------------------------------------------------
+
+struct RgbToYuvCoeffs {
+  int16_t yOffset;
+  int16_t yr, yg, yb;
+  int16_t ur, ug, ub;
+  int16_t vr, vg, vb;
+};
+
+static const RgbToYuvCoeffs kRgbToYuvCoeffs[2][2] = {
+    // BT.601: limited, full
+    {{16, 8414, 16520, 3208, -4857, -9535, 14392, 14392, -12051, -2341},
+     {0, 9798, 19234, 3736, -5529, -10855, 16384, 16384, -13720, -2664}},
+    // BT.709: limited, full
+    {{16, 5983, 20127, 2032, -3298, -11094, 14392, 14392, -13072, -1320},
+     {0, 6966, 23436, 2366, -3754, -12630, 16384, 16384, -14882, -1502}},
+};
 
-    // fallback for remaining pixels
-    if (processedPixels < pixels) {
-      optimized_rgb24_to_rgba(s + offset, d + processedPixels * 4, pixels - processedPixels);
+static inline const RgbToYuvCoeffs& rgb_to_yuv_coeffs(YuvMatrix matrix, YuvRange range) {
+  return kRgbToYuvCoeffs[matrix == YuvMatrix::BT709 ? 1 : 0][range == YuvRange::Full ? 1 : 0];
+}
+
+// Byte offsets of R and B within a pixel (G is always byte 1)
+static inline size_t red_offset(RgbFormat format) {
+  return format == RgbFormat::RGBA ? 0 : 2;
+}
+
+static inline size_t blue_offset(RgbFormat format) {
+  return format == RgbFormat::RGBA ? 2 : 0;
+}
+
+static inline uint8_t rgb_to_luma(const uint8_t* p, size_t ro, size_t bo, const RgbToYuvCoeffs& c) {
+  return clamp_u8((p[ro] * c.yr + p[1] * c.yg + p[bo] * c.yb + (c.yOffset << 15) + (1 << 14)) >> 15);
+}
+
+// U and V from channel sums over 2^(shift - 15) pixels
+static inline void rgb_sums_to_uv(int r, int g, int b, int shift, const RgbToYuvCoeffs& c, uint8_t* u, uint8_t* v) {
+  const int bias = (128 << shift) + (1 << (shift - 1));
+  *u = clamp_u8((r * c.ur + g * c.ug + b * c.ub + bias) >> shift);
+  *v = clamp_u8((r * c.vr + g * c.vg + b * c.vb + bias) >> shift);
+}
+
+// Scalar 4:2:0 row pair from pixel `col` (even) to `width`. `s1` is `s0` and
+// `y1` null for the last row of an odd-height frame; an odd final column is
+// counted twice.
+static inline void rgb_to_yuv420_rows_scalar(const uint8_t* s0, const uint8_t* s1, RgbFormat format, uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, size_t uvStep, size_t col, size_t width, const RgbToYuvCoeffs& c) {
+  const size_t bpp = rgb_format_bpp(format), ro = red_offset(format), bo = blue_offset(format);
+  for (; col < width; col += 2) {
+    const size_t col1 = col + 1 < width ? col + 1 : col;
+    const uint8_t* a0 = s0 + col * bpp;
+    const uint8_t* a1 = s0 + col1 * bpp;
+    const uint8_t* b0 = s1 + col * bpp;
+    const uint8_t* b1 = s1 + col1 * bpp;
+    y0[col] = rgb_to_luma(a0, ro, bo, c);
+    if (col1 != col) y0[col1] = rgb_to_luma(a1, ro, bo, c);
+    if (y1) {
+      y1[col] = rgb_to_luma(b0, ro, bo, c);
+      if (col1 != col) y1[col1] = rgb_to_luma(b1, ro, bo, c);
     }
+    const size_t i = (col >> 1) * uvStep;
+    rgb_sums_to_uv(a0[ro] + a1[ro] + b0[ro] + b1[ro], a0[1] + a1[1] + b0[1] + b1[1], a0[bo] + a1[bo] + b0[bo] + b1[bo], 17, c, u + i, v + i);
+  }
+}
+
+void baseline_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range) {
+  const RgbToYuvCoeffs& c = rgb_to_yuv_coeffs(matrix, range);
+  for (size_t row = 0; row < height; row += 2) {
+    const bool pair = row + 1 < height;
+    const uint8_t* s0 = src + row * srcStride;
+    const size_t uvRow = (row / 2) * strideUV;
+    rgb_to_yuv420_rows_scalar(s0, pair ? s0 + srcStride : s0, format, dstY + row * strideY, pair ? dstY + (row + 1) * strideY : nullptr, dstU + uvRow, dstV + uvRow, uvStep, 0, width, c);
+  }
+}
+
+// Scalar 4:2:2 row from pixel `col` (even) to `width`
+static inline void rgb_to_yuv422_row_scalar(const uint8_t* s, RgbFormat format, uint8_t* d, size_t col, size_t width, Yuv422Layout layout, const RgbToYuvCoeffs& c) {
+  const size_t bpp = rgb_format_bpp(format), ro = red_offset(format), bo = blue_offset(format);
+  const int yIdx = layout == Yuv422Layout::YUY2 ? 0 : 1;
+  const int uIdx = layout == Yuv422Layout::YUY2 ? 1 : 0;
+  for (; col < width; col += 2) {
+    const uint8_t* a0 = s + col * bpp;
+    const uint8_t* a1 = col + 1 < width ? a0 + bpp : a0;
+    uint8_t* p = d + (col >> 1) * 4;
+    p[yIdx] = rgb_to_luma(a0, ro, bo, c);
+    p[yIdx + 2] = rgb_to_luma(a1, ro, bo, c);
+    rgb_sums_to_uv(a0[ro] + a1[ro], a0[1] + a1[1], a0[bo] + a1[bo], 16, c, p + uIdx, p + uIdx + 2);
+  }
+}
+
+void baseline_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range) {
+  const RgbToYuvCoeffs& c = rgb_to_yuv_coeffs(matrix, range);
+  for (size_t row = 0; row < height; ++row) {
+    rgb_to_yuv422_row_scalar(src + row * srcStride, format, dst + row * dstStride, 0, width, layout, c);
+  }
+}
+
+// madd_pair-style lane holding the weights of the first two channels of a
+// pixel widened to int16: B,G for BGRA/BGR24 and R,G for RGBA. The second lane
+// pairs the third channel with the (ignored or zero) fourth.
+static inline void rgb_madd_weights(RgbFormat format, int r, int g, int b, int* first, int* second) {
+  const bool rgba = format == RgbFormat::RGBA;
+  *first = madd_pair(rgba ? r : b, g);
+  *second = madd_pair(rgba ? b : r, 0);
+}
+
+// --- SSSE3: 16 pixels per loop iteration ---
+
+struct RgbToYuvConstsSse2 {
+  __m128i ky, ku, kv, yBias, uvBias420, uvBias422;
+  RgbToYuvConstsSse2(const RgbToYuvCoeffs& c, RgbFormat format) {
+    int a, b;
+    rgb_madd_weights(format, c.yr, c.yg, c.yb, &a, &b);
+    ky = _mm_setr_epi32(a, b, a, b);
+    rgb_madd_weights(format, c.ur, c.ug, c.ub, &a, &b);
+    ku = _mm_setr_epi32(a, b, a, b);
+    rgb_madd_weights(format, c.vr, c.vg, c.vb, &a, &b);
+    kv = _mm_setr_epi32(a, b, a, b);
+    yBias = _mm_set1_epi32((c.yOffset << 15) + (1 << 14));
+    uvBias420 = _mm_set1_epi32((128 << 17) + (1 << 16));
+    uvBias422 = _mm_set1_epi32((128 << 16) + (1 << 15));
+  }
+};
+
+// Load 16 pixels as four vectors of 4 four-byte pixels; BGR24 is expanded in
+// channel order with a zero fourth byte, loading exactly its 48 bytes.
+TARGET_SSSE3 static inline void load_rgbx16_ssse3(const uint8_t* s, RgbFormat format, __m128i px[4]) {
+  const __m128i* p = reinterpret_cast<const __m128i*>(s);
+  if (format != RgbFormat::BGR24) {
+    for (int i = 0; i < 4; ++i) px[i] = _mm_loadu_si128(p + i);
     return;
   }
+  const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  __m128i in0 = _mm_loadu_si128(p), in1 = _mm_loadu_si128(p + 1), in2 = _mm_loadu_si128(p + 2);
+  px[0] = _mm_shuffle_epi8(in0, expand);
+  px[1] = _mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), expand);
+  px[2] = _mm_shuffle_epi8(_mm_alignr_epi8(in2, in1, 8), expand);
+  px[3] = _mm_shuffle_epi8(_mm_srli_si128(in2, 4), expand);
+}
 
-  if (cpu_has_ssse3()) {
-    // SSSE3 path: process 4 pixels per iteration (12 bytes -> expand to 16 bytes)
-    size_t i = 0;
-    uint32_t* d32 = reinterpret_cast<uint32_t*>(dst);
-    const uint8_t* s = src;
-    const size_t vectorPixels = pixels & ~3u;
-
-    for (; i < vectorPixels; i += 4) {
-      // Load 12 bytes into three 32-bit reads
-      uint32_t a = *(const uint32_t*)(s + 0);
-      uint32_t b = *(const uint32_t*)(s + 4);
-      uint32_t c = *(const uint32_t*)(s + 8);
-
-      // Extract bytes (little-endian): a = b0 g0 r0 ? ; but we assume src is packed
-      uint8_t b0 = (a & 0xFFu);
-      uint8_t g0 = ((a >> 8) & 0xFFu);
-      uint8_t r0 = ((a >> 16) & 0xFFu);
-
-      uint8_t b1 = (b & 0xFFu);
-      uint8_t g1 = ((b >> 8) & 0xFFu);
-      uint8_t r1 = ((b >> 16) & 0xFFu);
-
-      uint8_t b2 = (c & 0xFFu);
-      uint8_t g2 = ((c >> 8) & 0xFFu);
-      uint8_t r2 = ((c >> 16) & 0xFFu);
-
-      // The 4th pixel's bytes come from combining the high byte of c and next byte
-      uint32_t dword4bytes = *(const uint32_t*)(s + 12);
-      uint8_t b3 = (dword4bytes & 0xFFu);
-      uint8_t g3 = ((dword4bytes >> 8) & 0xFFu);
-      uint8_t r3 = ((dword4bytes >> 16) & 0xFFu);
-
-      d32[i + 0] = (r0) | (g0 << 8) | (b0 << 16) | (0xFFu << 24);
-      d32[i + 1] = (r1) | (g1 << 8) | (b1 << 16) | (0xFFu << 24);
-      d32[i + 2] = (r2) | (g2 << 8) | (b2 << 16) | (0xFFu << 24);
-      d32[i + 3] = (r3) | (g3 << 8) | (b3 << 16) | (0xFFu << 24);
-
-      s += 16; // advanced by 16 bytes read (we overlapped reads intentionally)
+// Weighted sums of 4 pixels of int16 channels (2 per vector) -> 4 int32
+TARGET_SSSE3 static inline __m128i rgb_dot4_ssse3(__m128i lo, __m128i hi, __m128i k) {
+  return _mm_hadd_epi32(_mm_madd_epi16(lo, k), _mm_madd_epi16(hi, k));
+}
+
+// 16 luma bytes from 16 four-byte pixels
+TARGET_SSSE3 static inline __m128i rgb16_to_luma_ssse3(const __m128i px[4], const RgbToYuvConstsSse2& k) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i y[4];
+  for (int i = 0; i < 4; ++i) {
+    __m128i dot = rgb_dot4_ssse3(_mm_unpacklo_epi8(px[i], zero), _mm_unpackhi_epi8(px[i], zero), k.ky);
+    y[i] = _mm_srai_epi32(_mm_add_epi32(dot, k.yBias), 15);
+  }
+  return _mm_packus_epi16(_mm_packs_epi32(y[0], y[1]), _mm_packs_epi32(y[2], y[3]));
+}
+
+// Channel sums of horizontal pixel pairs: `lo`/`hi` hold pixels 0,1 and 2,3
+// as int16; the result holds pair (0,1) then pair (2,3).
+static inline __m128i pair_sums_sse2(__m128i lo, __m128i hi) {
+  return _mm_unpacklo_epi64(_mm_add_epi16(lo, _mm_srli_si128(lo, 8)), _mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+}
+
+// 8 chroma samples from 8 vectors of 2 pixel-group sums -> interleaved
+// (U,V) bytes
+TARGET_SSSE3 static inline __m128i sums_to_uv8_ssse3(const __m128i sums[4], __m128i bias, int shift, const RgbToYuvConstsSse2& k) {
+  const __m128i count = _mm_cvtsi32_si128(shift);
+  __m128i u0 = _mm_sra_epi32(_mm_add_epi32(rgb_dot4_ssse3(sums[0], sums[1], k.ku), bias), count);
+  __m128i u1 = _mm_sra_epi32(_mm_add_epi32(rgb_dot4_ssse3(sums[2], sums[3], k.ku), bias), count);
+  __m128i v0 = _mm_sra_epi32(_mm_add_epi32(rgb_dot4_ssse3(sums[0], sums[1], k.kv), bias), count);
+  __m128i v1 = _mm_sra_epi32(_mm_add_epi32(rgb_dot4_ssse3(sums[2], sums[3], k.kv), bias), count);
+  __m128i uv = _mm_packus_epi16(_mm_packs_epi32(u0, u1), _mm_packs_epi32(v0, v1));  // U0..7 V0..7
+  return _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 8));
+}
+
+// Store 8 interleaved (U,V) pairs to NV12 (uvStep 2) or I420 chroma rows
+static inline void store_uv8_sse2(__m128i uv, uint8_t* u, uint8_t* v, size_t uvStep, size_t i) {
+  if (uvStep == 2) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(u + i * 2), uv);
+    return;
+  }
+  const __m128i lowByte = _mm_set1_epi16(0x00FF);
+  __m128i split = _mm_packus_epi16(_mm_and_si128(uv, lowByte), _mm_srli_epi16(uv, 8));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(u + i), split);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(v + i), _mm_srli_si128(split, 8));
+}
+
+TARGET_SSSE3 void ssse3_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range) {
+  const RgbToYuvCoeffs& c = rgb_to_yuv_coeffs(matrix, range);
+  const RgbToYuvConstsSse2 k(c, format);
+  const size_t bpp = rgb_format_bpp(format);
+  const __m128i zero = _mm_setzero_si128();
+  for (size_t row = 0; row < height; row += 2) {
+    const bool pair = row + 1 < height;
+    const uint8_t* s0 = src + row * srcStride;
+    const uint8_t* s1 = pair ? s0 + srcStride : s0;
+    uint8_t* y0 = dstY + row * strideY;
+    uint8_t* y1 = pair ? y0 + strideY : nullptr;
+    uint8_t* u = dstU + (row / 2) * strideUV;
+    uint8_t* v = dstV + (row / 2) * strideUV;
+    size_t col = 0;
+    for (; col + 16 <= width; col += 16) {
+      __m128i a[4], b[4], sums[4];
+      load_rgbx16_ssse3(s0 + col * bpp, format, a);
+      load_rgbx16_ssse3(s1 + col * bpp, format, b);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + col), rgb16_to_luma_ssse3(a, k));
+      if (y1) _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + col), rgb16_to_luma_ssse3(b, k));
+      for (int i = 0; i < 4; ++i) {
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a[i], zero), _mm_unpacklo_epi8(b[i], zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a[i], zero), _mm_unpackhi_epi8(b[i], zero));
+        sums[i] = pair_sums_sse2(lo, hi);
+      }
+      store_uv8_sse2(sums_to_uv8_ssse3(sums, k.uvBias420, 17, k), u, v, uvStep, col / 2);
     }
+    rgb_to_yuv420_rows_scalar(s0, s1, format, y0, y1, u, v, uvStep, col, width, c);
+  }
+}
 
-    // tail
-    for (; i < pixels; ++i) {
-      uint8_t bb = s[0];
-      uint8_t gg = s[1];
-      uint8_t rr = s[2];
-      d32[i] = (rr) | (gg << 8) | (bb << 16) | (0xFFu << 24);
-      s += 3;
+TARGET_SSSE3 void ssse3_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range) {
+  const RgbToYuvCoeffs& c = rgb_to_yuv_coeffs(matrix, range);
+  const RgbToYuvConstsSse2 k(c, format);
+  const size_t bpp = rgb_format_bpp(format);
+  const __m128i zero = _mm_setzero_si128();
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* s = src + row * srcStride;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 16 <= width; col += 16) {
+      __m128i a[4], sums[4];
+      load_rgbx16_ssse3(s + col * bpp, format, a);
+      __m128i y = rgb16_to_luma_ssse3(a, k);
+      for (int i = 0; i < 4; ++i) sums[i] = pair_sums_sse2(_mm_unpacklo_epi8(a[i], zero), _mm_unpackhi_epi8(a[i], zero));
+      __m128i uv = sums_to_uv8_ssse3(sums, k.uvBias422, 16, k);
+      __m128i* out = reinterpret_cast<__m128i*>(d + col * 2);
+      if (layout == Yuv422Layout::YUY2) {
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(y, uv));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(y, uv));
+      } else {
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(uv, y));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(uv, y));
+      }
     }
+    rgb_to_yuv422_row_scalar(s, format, d, col, width, layout, c);
+  }
+}
+
+// --- AVX2: 32 pixels per loop iteration ---
+//
+// unpack/madd/hadd work within 128-bit lanes, so luma comes out in groups of
+// 4 pixels and chroma in pairs of samples that one permutevar8x32 puts back
+// in order.
+
+struct RgbToYuvConstsAvx2 {
+  __m256i ky, ku, kv, yBias, uvBias420, uvBias422, order;
+  TARGET_AVX2 RgbToYuvConstsAvx2(const RgbToYuvCoeffs& c, RgbFormat format) {
+    int a, b;
+    rgb_madd_weights(format, c.yr, c.yg, c.yb, &a, &b);
+    ky = _mm256_setr_epi32(a, b, a, b, a, b, a, b);
+    rgb_madd_weights(format, c.ur, c.ug, c.ub, &a, &b);
+    ku = _mm256_setr_epi32(a, b, a, b, a, b, a, b);
+    rgb_madd_weights(format, c.vr, c.vg, c.vb, &a, &b);
+    kv = _mm256_setr_epi32(a, b, a, b, a, b, a, b);
+    yBias = _mm256_set1_epi32((c.yOffset << 15) + (1 << 14));
+    uvBias420 = _mm256_set1_epi32((128 << 17) + (1 << 16));
+    uvBias422 = _mm256_set1_epi32((128 << 16) + (1 << 15));
+    order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  }
+};
+
+// Load 32 pixels as four vectors of 8 four-byte pixels. Each BGR24 lane is
+// loaded separately (bytes 0..15 and 8..23 of its 24) so no load reaches past
+// the 96-byte block.
+TARGET_AVX2 static inline void load_rgbx32_avx2(const uint8_t* s, RgbFormat format, __m256i px[4]) {
+  if (format != RgbFormat::BGR24) {
+    for (int i = 0; i < 4; ++i) px[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i * 32));
     return;
   }
+  const __m256i expand = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                          4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+  for (int i = 0; i < 4; ++i) {
+    const uint8_t* p = s + i * 24;
+    __m256i v = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    v = _mm256_inserti128_si256(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8)), 1);
+    px[i] = _mm256_shuffle_epi8(v, expand);
+  }
+}
+
+TARGET_AVX2 static inline __m256i rgb_dot8_avx2(__m256i lo, __m256i hi, __m256i k) {
+  return _mm256_hadd_epi32(_mm256_madd_epi16(lo, k), _mm256_madd_epi16(hi, k));
+}
+
+// 32 luma bytes in pixel order from 32 four-byte pixels
+TARGET_AVX2 static inline __m256i rgb32_to_luma_avx2(const __m256i px[4], const RgbToYuvConstsAvx2& k) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i y[4];
+  for (int i = 0; i < 4; ++i) {
+    __m256i dot = rgb_dot8_avx2(_mm256_unpacklo_epi8(px[i], zero), _mm256_unpackhi_epi8(px[i], zero), k.ky);
+    y[i] = _mm256_srai_epi32(_mm256_add_epi32(dot, k.yBias), 15);  // pixels 8i..8i+3 | 8i+4..8i+7
+  }
+  __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(y[0], y[1]), _mm256_packs_epi32(y[2], y[3]));
+  return _mm256_permutevar8x32_epi32(packed, k.order);
+}
+
+TARGET_AVX2 static inline __m256i pair_sums_avx2(__m256i lo, __m256i hi) {
+  return _mm256_unpacklo_epi64(_mm256_add_epi16(lo, _mm256_srli_si256(lo, 8)), _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8)));
+}
+
+// 16 chroma samples from 4 vectors of 4 pixel-group sums -> 16 interleaved
+// (U,V) pairs in order
+TARGET_AVX2 static inline __m256i sums_to_uv16_avx2(const __m256i sums[4], __m256i bias, int shift, const RgbToYuvConstsAvx2& k) {
+  const __m256i interleave = _mm256_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15,
+                                              0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+  __m256i u0 = _mm256_sra_epi32(_mm256_add_epi32(rgb_dot8_avx2(sums[0], sums[1], k.ku), bias), count);
+  __m256i u1 = _mm256_sra_epi32(_mm256_add_epi32(rgb_dot8_avx2(sums[2], sums[3], k.ku), bias), count);
+  __m256i v0 = _mm256_sra_epi32(_mm256_add_epi32(rgb_dot8_avx2(sums[0], sums[1], k.kv), bias), count);
+  __m256i v1 = _mm256_sra_epi32(_mm256_add_epi32(rgb_dot8_avx2(sums[2], sums[3], k.kv), bias), count);
+  __m256i uv = _mm256_packus_epi16(_mm256_packs_epi32(u0, u1), _mm256_packs_epi32(v0, v1));
+  // Each lane holds samples (0,1,4,5,8,9,12,13) or (2,3,6,7,10,11,14,15) of U
+  // then V; interleaving leaves 4-byte (U,V,U,V) groups for the permute.
+  return _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(uv, interleave), k.order);
+}
+
+TARGET_AVX2 static inline void store_uv16_avx2(__m256i uv, uint8_t* u, uint8_t* v, size_t uvStep, size_t i) {
+  if (uvStep == 2) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(u + i * 2), uv);
+    return;
+  }
+  const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+  __m256i split = _mm256_packus_epi16(_mm256_and_si256(uv, lowByte), _mm256_srli_epi16(uv, 8));
+  split = _mm256_permute4x64_epi64(split, 0xD8);  // U0..15 | V0..15
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(u + i), _mm256_castsi256_si128(split));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(v + i), _mm256_extracti128_si256(split, 1));
+}
+
+TARGET_AVX2 void avx2_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range) {
+  const RgbToYuvCoeffs& c = rgb_to_yuv_coeffs(matrix, range);
+  const RgbToYuvConstsAvx2 k(c, format);
+  const size_t bpp = rgb_format_bpp(format);
+  const __m256i zero = _mm256_setzero_si256();
+  for (size_t row = 0; row < height; row += 2) {
+    const bool pair = row + 1 < height;
+    const uint8_t* s0 = src + row * srcStride;
+    const uint8_t* s1 = pair ? s0 + srcStride : s0;
+    uint8_t* y0 = dstY + row * strideY;
+    uint8_t* y1 = pair ? y0 + strideY : nullptr;
+    uint8_t* u = dstU + (row / 2) * strideUV;
+    uint8_t* v = dstV + (row / 2) * strideUV;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      __m256i a[4], b[4], sums[4];
+      load_rgbx32_avx2(s0 + col * bpp, format, a);
+      load_rgbx32_avx2(s1 + col * bpp, format, b);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + col), rgb32_to_luma_avx2(a, k));
+      if (y1) _mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + col), rgb32_to_luma_avx2(b, k));
+      for (int i = 0; i < 4; ++i) {
+        __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a[i], zero), _mm256_unpacklo_epi8(b[i], zero));
+        __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a[i], zero), _mm256_unpackhi_epi8(b[i], zero));
+        sums[i] = pair_sums_avx2(lo, hi);
+      }
+      store_uv16_avx2(sums_to_uv16_avx2(sums, k.uvBias420, 17, k), u, v, uvStep, col / 2);
+    }
+    rgb_to_yuv420_rows_scalar(s0, s1, format, y0, y1, u, v, uvStep, col, width, c);
+  }
+}
+
+TARGET_AVX2 void avx2_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range) {
+  const RgbToYuvCoeffs& c = rgb_to_yuv_coeffs(matrix, range);
+  const RgbToYuvConstsAvx2 k(c, format);
+  const size_t bpp = rgb_format_bpp(format);
+  const __m256i zero = _mm256_setzero_si256();
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* s = src + row * srcStride;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      __m256i a[4], sums[4];
+      load_rgbx32_avx2(s + col * bpp, format, a);
+      __m256i y = rgb32_to_luma_avx2(a, k);
+      for (int i = 0; i < 4; ++i) sums[i] = pair_sums_avx2(_mm256_unpacklo_epi8(a[i], zero), _mm256_unpackhi_epi8(a[i], zero));
+      __m256i uv = sums_to_uv16_avx2(sums, k.uvBias422, 16, k);
+      __m256i lo = layout == Yuv422Layout::YUY2 ? _mm256_unpacklo_epi8(y, uv) : _mm256_unpacklo_epi8(uv, y);  // px 0-7 | 16-23
+      __m256i hi = layout == Yuv422Layout::YUY2 ? _mm256_unpackhi_epi8(y, uv) : _mm256_unpackhi_epi8(uv, y);  // px 8-15 | 24-31
+      __m256i* out = reinterpret_cast<__m256i*>(d + col * 2);
+      _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+      _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    rgb_to_yuv422_row_scalar(s, format, d, col, width, layout, c);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// YUV <-> YUV repacking
+//
+// Layout changes between 4:2:0 and 4:2:2 move bytes without touching the
+// colour maths: 4:2:0 -> 4:2:2 shares each chroma row between two output
+// rows, 4:2:2 -> 4:2:0 averages the chroma of each row pair (pavgb rounding,
+// (a + b + 1) >> 1).
+// ---------------------------------------------------------------------------
+
+// Scalar 4:2:0 -> 4:2:2 row from pixel `col` (even) to `width`
+static inline void yuv420_to_yuv422_row_scalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t uvStep, uint8_t* d, size_t col, size_t width, Yuv422Layout layout) {
+  const int yIdx = layout == Yuv422Layout::YUY2 ? 0 : 1;
+  const int uIdx = layout == Yuv422Layout::YUY2 ? 1 : 0;
+  for (; col < width; col += 2) {
+    uint8_t* p = d + (col >> 1) * 4;
+    const size_t i = (col >> 1) * uvStep;
+    p[yIdx] = y[col];
+    p[yIdx + 2] = y[col + 1 < width ? col + 1 : col];
+    p[uIdx] = u[i];
+    p[uIdx + 2] = v[i];
+  }
+}
+
+void baseline_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout) {
+  for (size_t row = 0; row < height; ++row) {
+    const size_t uvRow = (row / 2) * strideUV;
+    yuv420_to_yuv422_row_scalar(srcY + row * strideY, srcU + uvRow, srcV + uvRow, uvStep, dst + row * dstStride, 0, width, layout);
+  }
+}
+
+void sse2_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout) {
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* y = srcY + row * strideY;
+    const uint8_t* u = srcU + (row / 2) * strideUV;
+    const uint8_t* v = srcV + (row / 2) * strideUV;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 16 <= width; col += 16) {
+      __m128i y16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + col));
+      __m128i uv = load_uv8_sse2(u, v, uvStep, col / 2);
+      __m128i* out = reinterpret_cast<__m128i*>(d + col * 2);
+      if (layout == Yuv422Layout::YUY2) {
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(y16, uv));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(y16, uv));
+      } else {
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(uv, y16));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(uv, y16));
+      }
+    }
+    yuv420_to_yuv422_row_scalar(y, u, v, uvStep, d, col, width, layout);
+  }
+}
+
+// 16 (U,V) pairs for pixels 2*i .. 2*i + 31 of a 4:2:0 row, in order
+TARGET_AVX2 static inline __m256i load_uv16_avx2(const uint8_t* u, const uint8_t* v, size_t uvStep, size_t i) {
+  if (uvStep == 2) return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + i * 2));
+  __m128i u16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i));
+  __m128i v16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(u16, v16)), _mm_unpackhi_epi8(u16, v16), 1);
+}
+
+TARGET_AVX2 void avx2_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout) {
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* y = srcY + row * strideY;
+    const uint8_t* u = srcU + (row / 2) * strideUV;
+    const uint8_t* v = srcV + (row / 2) * strideUV;
+    uint8_t* d = dst + row * dstStride;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      __m256i y32 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + col));
+      __m256i uv = load_uv16_avx2(u, v, uvStep, col / 2);
+      __m256i lo = layout == Yuv422Layout::YUY2 ? _mm256_unpacklo_epi8(y32, uv) : _mm256_unpacklo_epi8(uv, y32);  // px 0-7 | 16-23
+      __m256i hi = layout == Yuv422Layout::YUY2 ? _mm256_unpackhi_epi8(y32, uv) : _mm256_unpackhi_epi8(uv, y32);  // px 8-15 | 24-31
+      __m256i* out = reinterpret_cast<__m256i*>(d + col * 2);
+      _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+      _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    yuv420_to_yuv422_row_scalar(y, u, v, uvStep, d, col, width, layout);
+  }
+}
+
+// Scalar 4:2:2 -> 4:2:0 row pair from pixel `col` (even) to `width`. `s1` is
+// `s0` and `y1` null for the last row of an odd-height frame.
+static inline void yuv422_to_yuv420_rows_scalar(const uint8_t* s0, const uint8_t* s1, uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, size_t uvStep, size_t col, size_t width, Yuv422Layout layout) {
+  const int yIdx = layout == Yuv422Layout::YUY2 ? 0 : 1;
+  const int uIdx = layout == Yuv422Layout::YUY2 ? 1 : 0;
+  for (; col < width; col += 2) {
+    const uint8_t* a = s0 + (col >> 1) * 4;
+    const uint8_t* b = s1 + (col >> 1) * 4;
+    const bool pair = col + 1 < width;
+    y0[col] = a[yIdx];
+    if (pair) y0[col + 1] = a[yIdx + 2];
+    if (y1) {
+      y1[col] = b[yIdx];
+      if (pair) y1[col + 1] = b[yIdx + 2];
+    }
+    const size_t i = (col >> 1) * uvStep;
+    u[i] = static_cast<uint8_t>((a[uIdx] + b[uIdx] + 1) >> 1);
+    v[i] = static_cast<uint8_t>((a[uIdx + 2] + b[uIdx + 2] + 1) >> 1);
+  }
+}
+
+void baseline_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout) {
+  for (size_t row = 0; row < height; row += 2) {
+    const bool pair = row + 1 < height;
+    const uint8_t* s0 = src + row * srcStride;
+    const size_t uvRow = (row / 2) * strideUV;
+    yuv422_to_yuv420_rows_scalar(s0, pair ? s0 + srcStride : s0, dstY + row * strideY, pair ? dstY + (row + 1) * strideY : nullptr, dstU + uvRow, dstV + uvRow, uvStep, 0, width, layout);
+  }
+}
+
+// Split 16 packed 4:2:2 pixels (32 bytes) into 16 luma bytes and 8 (U,V) pairs
+static inline void split_yuv422x16_sse2(const uint8_t* s, Yuv422Layout layout, __m128i* y, __m128i* uv) {
+  const __m128i lowByte = _mm_set1_epi16(0x00FF);
+  __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+  __m128i w1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+  __m128i lo = _mm_packus_epi16(_mm_and_si128(w0, lowByte), _mm_and_si128(w1, lowByte));
+  __m128i hi = _mm_packus_epi16(_mm_srli_epi16(w0, 8), _mm_srli_epi16(w1, 8));
+  *y = layout == Yuv422Layout::YUY2 ? lo : hi;
+  *uv = layout == Yuv422Layout::YUY2 ? hi : lo;
+}
+
+void sse2_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout) {
+  for (size_t row = 0; row < height; row += 2) {
+    const bool pair = row + 1 < height;
+    const uint8_t* s0 = src + row * srcStride;
+    const uint8_t* s1 = pair ? s0 + srcStride : s0;
+    uint8_t* y0 = dstY + row * strideY;
+    uint8_t* y1 = pair ? y0 + strideY : nullptr;
+    uint8_t* u = dstU + (row / 2) * strideUV;
+    uint8_t* v = dstV + (row / 2) * strideUV;
+    size_t col = 0;
+    for (; col + 16 <= width; col += 16) {
+      __m128i ya, uva, yb, uvb;
+      split_yuv422x16_sse2(s0 + col * 2, layout, &ya, &uva);
+      split_yuv422x16_sse2(s1 + col * 2, layout, &yb, &uvb);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + col), ya);
+      if (y1) _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + col), yb);
+      store_uv8_sse2(_mm_avg_epu8(uva, uvb), u, v, uvStep, col / 2);
+    }
+    yuv422_to_yuv420_rows_scalar(s0, s1, y0, y1, u, v, uvStep, col, width, layout);
+  }
+}
+
+// Split 32 packed 4:2:2 pixels (64 bytes) into 32 luma bytes and 16 (U,V)
+// pairs, both in order
+TARGET_AVX2 static inline void split_yuv422x32_avx2(const uint8_t* s, Yuv422Layout layout, __m256i* y, __m256i* uv) {
+  const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+  __m256i w0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+  __m256i w1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 32));
+  __m256i lo = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_and_si256(w0, lowByte), _mm256_and_si256(w1, lowByte)), 0xD8);
+  __m256i hi = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(w0, 8), _mm256_srli_epi16(w1, 8)), 0xD8);
+  *y = layout == Yuv422Layout::YUY2 ? lo : hi;
+  *uv = layout == Yuv422Layout::YUY2 ? hi : lo;
+}
+
+TARGET_AVX2 void avx2_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout) {
+  for (size_t row = 0; row < height; row += 2) {
+    const bool pair = row + 1 < height;
+    const uint8_t* s0 = src + row * srcStride;
+    const uint8_t* s1 = pair ? s0 + srcStride : s0;
+    uint8_t* y0 = dstY + row * strideY;
+    uint8_t* y1 = pair ? y0 + strideY : nullptr;
+    uint8_t* u = dstU + (row / 2) * strideUV;
+    uint8_t* v = dstV + (row / 2) * strideUV;
+    size_t col = 0;
+    for (; col + 32 <= width; col += 32) {
+      __m256i ya, uva, yb, uvb;
+      split_yuv422x32_avx2(s0 + col * 2, layout, &ya, &uva);
+      split_yuv422x32_avx2(s1 + col * 2, layout, &yb, &uvb);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + col), ya);
+      if (y1) _mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + col), yb);
+      store_uv16_avx2(_mm256_avg_epu8(uva, uvb), u, v, uvStep, col / 2);
+    }
+    yuv422_to_yuv420_rows_scalar(s0, s1, y0, y1, u, v, uvStep, col, width, layout);
+  }
+}
+
+void baseline_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs) {
+  for (size_t i = 0; i < pairs; ++i) {
+    dstUV[i * 2] = srcU[i];
+    dstUV[i * 2 + 1] = srcV[i];
+  }
+}
+
+void sse2_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs) {
+  size_t i = 0;
+  for (; i + 16 <= pairs; i += 16) {
+    __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcU + i));
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcV + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dstUV + i * 2), _mm_unpacklo_epi8(u, v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dstUV + i * 2 + 16), _mm_unpackhi_epi8(u, v));
+  }
+  baseline_uv_interleave(srcU + i, srcV + i, dstUV + i * 2, pairs - i);
+}
+
+TARGET_AVX2 void avx2_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs) {
+  size_t i = 0;
+  for (; i + 32 <= pairs; i += 32) {
+    __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcU + i));
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcV + i));
+    __m256i lo = _mm256_unpacklo_epi8(u, v);  // pairs 0-7 | 16-23
+    __m256i hi = _mm256_unpackhi_epi8(u, v);  // pairs 8-15 | 24-31
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstUV + i * 2), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstUV + i * 2 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  baseline_uv_interleave(srcU + i, srcV + i, dstUV + i * 2, pairs - i);
+}
+
+void baseline_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs) {
+  for (size_t i = 0; i < pairs; ++i) {
+    dstU[i] = srcUV[i * 2];
+    dstV[i] = srcUV[i * 2 + 1];
+  }
+}
+
+void sse2_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs) {
+  const __m128i lowByte = _mm_set1_epi16(0x00FF);
+  size_t i = 0;
+  for (; i + 16 <= pairs; i += 16) {
+    __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcUV + i * 2));
+    __m128i w1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcUV + i * 2 + 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dstU + i), _mm_packus_epi16(_mm_and_si128(w0, lowByte), _mm_and_si128(w1, lowByte)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dstV + i), _mm_packus_epi16(_mm_srli_epi16(w0, 8), _mm_srli_epi16(w1, 8)));
+  }
+  baseline_uv_deinterleave(srcUV + i * 2, dstU + i, dstV + i, pairs - i);
+}
+
+TARGET_AVX2 void avx2_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs) {
+  const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+  size_t i = 0;
+  for (; i + 32 <= pairs; i += 32) {
+    __m256i w0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcUV + i * 2));
+    __m256i w1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcUV + i * 2 + 32));
+    __m256i u = _mm256_packus_epi16(_mm256_and_si256(w0, lowByte), _mm256_and_si256(w1, lowByte));
+    __m256i v = _mm256_packus_epi16(_mm256_srli_epi16(w0, 8), _mm256_srli_epi16(w1, 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstU + i), _mm256_permute4x64_epi64(u, 0xD8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstV + i), _mm256_permute4x64_epi64(v, 0xD8));
+  }
+  baseline_uv_deinterleave(srcUV + i * 2, dstU + i, dstV + i, pairs - i);
+}
+
+void baseline_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels) {
+  for (size_t i = 0; i < macropixels * 2; ++i) {
+    const uint8_t a = src[i * 2], b = src[i * 2 + 1];
+    dst[i * 2] = b;
+    dst[i * 2 + 1] = a;
+  }
+}
+
+void sse2_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels) {
+  size_t i = 0;
+  for (; i + 4 <= macropixels; i += 4) {
+    __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_slli_epi16(w, 8), _mm_srli_epi16(w, 8)));
+  }
+  baseline_yuv422_swap(src + i * 4, dst + i * 4, macropixels - i);
+}
+
+TARGET_AVX2 void avx2_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels) {
+  const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  size_t i = 0;
+  for (; i + 8 <= macropixels; i += 8) {
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(w, swap));
+  }
+  baseline_yuv422_swap(src + i * 4, dst + i * 4, macropixels - i);
+}
+
+// ---------------------------------------------------------------------------
+// RGB repacking
+//
+// Channel reorders between the packed RGB formats are a single pshufb per
+// 4 (SSSE3) or 8 (AVX2) pixels with a mask built from the two layouts.
+// ---------------------------------------------------------------------------
+
+// Byte offset of the channel that output byte `k` of `format` holds, in a
+// pixel of `src` (alpha, k == 3, has none)
+static inline int repack_source_offset(RgbFormat src, RgbFormat format, int k) {
+  if (k == 1) return 1;
+  const bool red = (k == 0) == (format == RgbFormat::RGBA);
+  return static_cast<int>(red ? red_offset(src) : blue_offset(src));
+}
+
+static inline void rgb_repack_scalar(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels) {
+  const size_t sb = rgb_format_bpp(srcFormat), db = rgb_format_bpp(dstFormat);
+  const int o0 = repack_source_offset(srcFormat, dstFormat, 0);
+  const int o2 = repack_source_offset(srcFormat, dstFormat, 2);
+  for (size_t i = 0; i < pixels; ++i, src += sb, dst += db) {
+    const uint8_t c0 = src[o0], c1 = src[1], c2 = src[o2];
+    dst[0] = c0;
+    dst[1] = c1;
+    dst[2] = c2;
+    if (db == 4) dst[3] = 255;
+  }
+}
+
+void baseline_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels) {
+  if (srcFormat == dstFormat) {
+    std::memcpy(dst, src, pixels * rgb_format_bpp(srcFormat));
+    return;
+  }
+  rgb_repack_scalar(src, srcFormat, dst, dstFormat, pixels);
+}
+
+// pshufb mask for 4 pixels: output byte i*dstBpp + k takes source byte
+// i*srcBpp + offset; alpha and the unused tail of a 3-byte output are zero.
+static inline void build_repack_mask(RgbFormat srcFormat, RgbFormat dstFormat, int8_t mask[16]) {
+  const int sb = static_cast<int>(rgb_format_bpp(srcFormat)), db = static_cast<int>(rgb_format_bpp(dstFormat));
+  for (int i = 0; i < 16; ++i) mask[i] = -1;
+  for (int i = 0; i < 4; ++i) {
+    for (int k = 0; k < 3; ++k) mask[i * db + k] = static_cast<int8_t>(i * sb + repack_source_offset(srcFormat, dstFormat, k));
+  }
+}
+
+TARGET_SSSE3 void ssse3_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels) {
+  if (srcFormat == dstFormat || pixels < 16) {
+    baseline_rgb_repack(src, srcFormat, dst, dstFormat, pixels);
+    return;
+  }
+  int8_t m[16];
+  build_repack_mask(srcFormat, dstFormat, m);
+  const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m));
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  const size_t sb = rgb_format_bpp(srcFormat), db = rgb_format_bpp(dstFormat);
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    const uint8_t* s = src + i * sb;
+    uint8_t* d = dst + i * db;
+    if (sb == 3) {
+      // Expand: palignr brings each group of 4 pixels to the start of a register
+      __m128i px[4];
+      __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+      __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+      __m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+      px[0] = in0;
+      px[1] = _mm_alignr_epi8(in1, in0, 12);
+      px[2] = _mm_alignr_epi8(in2, in1, 8);
+      px[3] = _mm_srli_si128(in2, 4);
+      for (int j = 0; j < 4; ++j) _mm_storeu_si128(reinterpret_cast<__m128i*>(d + j * 16), _mm_or_si128(_mm_shuffle_epi8(px[j], mask), alpha));
+    } else if (db == 3) {
+      __m128i c[4];
+      for (int j = 0; j < 4; ++j) c[j] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + j * 16)), mask);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_or_si128(c[0], _mm_slli_si128(c[1], 12)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16), _mm_or_si128(_mm_srli_si128(c[1], 4), _mm_slli_si128(c[2], 8)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 32), _mm_or_si128(_mm_srli_si128(c[2], 8), _mm_slli_si128(c[3], 4)));
+    } else {
+      for (int j = 0; j < 4; ++j) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + j * 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + j * 16), _mm_or_si128(_mm_shuffle_epi8(px, mask), alpha));
+      }
+    }
+  }
+  rgb_repack_scalar(src + i * sb, srcFormat, dst + i * db, dstFormat, pixels - i);
+}
+
+TARGET_AVX2 void avx2_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels) {
+  if (srcFormat == dstFormat || pixels < 8) {
+    baseline_rgb_repack(src, srcFormat, dst, dstFormat, pixels);
+    return;
+  }
+  int8_t m[32];
+  build_repack_mask(srcFormat, dstFormat, m);
+  const size_t sb = rgb_format_bpp(srcFormat), db = rgb_format_bpp(dstFormat);
+  // A 3-byte source loads its high lane 8 bytes in (as rgb24_to_rgbax8_avx2
+  // does), so pixels 4..7 sit 4 bytes further along than in the low lane.
+  for (int i = 0; i < 16; ++i) m[16 + i] = m[i] < 0 ? m[i] : static_cast<int8_t>(m[i] + (sb == 3 ? 4 : 0));
+  const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m));
+  const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+  const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    const uint8_t* s = src + i * sb;
+    uint8_t* d = dst + i * db;
+    if (sb == 3) {
+      __m256i v = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+      v = _mm256_inserti128_si256(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 8)), 1);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), _mm256_or_si256(_mm256_shuffle_epi8(v, mask), alpha));
+    } else if (db == 3) {
+      // 24 packed bytes; the upper 8 of the 32-byte vector are zero
+      __m256i c = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s)), mask), pack);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm256_castsi256_si128(c));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(d + 16), _mm256_extracti128_si256(c, 1));
+    } else {
+      __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), _mm256_or_si256(_mm256_shuffle_epi8(px, mask), alpha));
+    }
+  }
+  rgb_repack_scalar(src + i * sb, srcFormat, dst + i * db, dstFormat, pixels - i);
+}
+
+// ---------------------------------------------------------------------------
+// JPEG forward DCT + quantization
+//
+// Float AAN transform (the factorization of libjpeg's jfdctflt.c): a column
+// pass then a row pass, each the same butterfly. The AAN output scale and the
+// quantizer are folded into `divisors`. Every variant performs the same
+// operations in the same order and rounds with the current (nearest-even)
+// mode, so they are bit-exact with the baseline.
+
+static const float kAanC4 = 0.707106781f;   // cos(4*pi/16)
+static const float kAanC6 = 0.382683433f;   // cos(6*pi/16)
+static const float kAanC2mC6 = 0.541196100f;  // cos(2*pi/16) - cos(6*pi/16)
+static const float kAanC2pC6 = 1.306562965f;  // cos(2*pi/16) + cos(6*pi/16)
+
+static inline void aan_fdct8(float* p, size_t step) {
+  float tmp0 = p[0 * step] + p[7 * step];
+  float tmp7 = p[0 * step] - p[7 * step];
+  float tmp1 = p[1 * step] + p[6 * step];
+  float tmp6 = p[1 * step] - p[6 * step];
+  float tmp2 = p[2 * step] + p[5 * step];
+  float tmp5 = p[2 * step] - p[5 * step];
+  float tmp3 = p[3 * step] + p[4 * step];
+  float tmp4 = p[3 * step] - p[4 * step];
+
+  // Even part
+  float tmp10 = tmp0 + tmp3;
+  float tmp13 = tmp0 - tmp3;
+  float tmp11 = tmp1 + tmp2;
+  float tmp12 = tmp1 - tmp2;
+  p[0 * step] = tmp10 + tmp11;
+  p[4 * step] = tmp10 - tmp11;
+  float z1 = (tmp12 + tmp13) * kAanC4;
+  p[2 * step] = tmp13 + z1;
+  p[6 * step] = tmp13 - z1;
+
+  // Odd part
+  tmp10 = tmp4 + tmp5;
+  tmp11 = tmp5 + tmp6;
+  tmp12 = tmp6 + tmp7;
+  float z5 = (tmp10 - tmp12) * kAanC6;
+  float z2 = tmp10 * kAanC2mC6 + z5;
+  float z4 = tmp12 * kAanC2pC6 + z5;
+  float z3 = tmp11 * kAanC4;
+  float z11 = tmp7 + z3;
+  float z13 = tmp7 - z3;
+  p[5 * step] = z13 + z2;
+  p[3 * step] = z13 - z2;
+  p[1 * step] = z11 + z4;
+  p[7 * step] = z11 - z4;
+}
+
+void baseline_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs) {
+  float ws[64];
+  for (int i = 0; i < 64; ++i) ws[i] = static_cast<float>(samples[i]) - offset;
+  for (int col = 0; col < 8; ++col) aan_fdct8(ws + col, 8);
+  for (int row = 0; row < 8; ++row) aan_fdct8(ws + row * 8, 1);
+  for (int i = 0; i < 64; ++i) coefs[i] = static_cast<int16_t>(std::lrintf(ws[i] * divisors[i]));
+}
+
+// The butterfly on eight vectors at once: v[k] is element k of 4 (SSE2) or 8
+// (AVX2) independent transforms, one per lane.
+static inline void aan_fdct8_sse2(__m128* v) {
+  const __m128 c4 = _mm_set1_ps(kAanC4);
+  const __m128 c6 = _mm_set1_ps(kAanC6);
+  const __m128 c2mc6 = _mm_set1_ps(kAanC2mC6);
+  const __m128 c2pc6 = _mm_set1_ps(kAanC2pC6);
+  __m128 tmp0 = _mm_add_ps(v[0], v[7]);
+  __m128 tmp7 = _mm_sub_ps(v[0], v[7]);
+  __m128 tmp1 = _mm_add_ps(v[1], v[6]);
+  __m128 tmp6 = _mm_sub_ps(v[1], v[6]);
+  __m128 tmp2 = _mm_add_ps(v[2], v[5]);
+  __m128 tmp5 = _mm_sub_ps(v[2], v[5]);
+  __m128 tmp3 = _mm_add_ps(v[3], v[4]);
+  __m128 tmp4 = _mm_sub_ps(v[3], v[4]);
+
+  __m128 tmp10 = _mm_add_ps(tmp0, tmp3);
+  __m128 tmp13 = _mm_sub_ps(tmp0, tmp3);
+  __m128 tmp11 = _mm_add_ps(tmp1, tmp2);
+  __m128 tmp12 = _mm_sub_ps(tmp1, tmp2);
+  v[0] = _mm_add_ps(tmp10, tmp11);
+  v[4] = _mm_sub_ps(tmp10, tmp11);
+  __m128 z1 = _mm_mul_ps(_mm_add_ps(tmp12, tmp13), c4);
+  v[2] = _mm_add_ps(tmp13, z1);
+  v[6] = _mm_sub_ps(tmp13, z1);
+
+  tmp10 = _mm_add_ps(tmp4, tmp5);
+  tmp11 = _mm_add_ps(tmp5, tmp6);
+  tmp12 = _mm_add_ps(tmp6, tmp7);
+  __m128 z5 = _mm_mul_ps(_mm_sub_ps(tmp10, tmp12), c6);
+  __m128 z2 = _mm_add_ps(_mm_mul_ps(tmp10, c2mc6), z5);
+  __m128 z4 = _mm_add_ps(_mm_mul_ps(tmp12, c2pc6), z5);
+  __m128 z3 = _mm_mul_ps(tmp11, c4);
+  __m128 z11 = _mm_add_ps(tmp7, z3);
+  __m128 z13 = _mm_sub_ps(tmp7, z3);
+  v[5] = _mm_add_ps(z13, z2);
+  v[3] = _mm_sub_ps(z13, z2);
+  v[1] = _mm_add_ps(z11, z4);
+  v[7] = _mm_sub_ps(z11, z4);
+}
+
+// 8x8 transpose of a block held as left (columns 0-3) and right (4-7) halves
+static inline void transpose8x8_sse2(__m128* left, __m128* right) {
+  __m128 a0 = left[0], a1 = left[1], a2 = left[2], a3 = left[3];
+  __m128 b0 = right[0], b1 = right[1], b2 = right[2], b3 = right[3];
+  __m128 c0 = left[4], c1 = left[5], c2 = left[6], c3 = left[7];
+  __m128 d0 = right[4], d1 = right[5], d2 = right[6], d3 = right[7];
+  _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+  _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  _MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+  left[0] = a0, left[1] = a1, left[2] = a2, left[3] = a3;
+  right[0] = c0, right[1] = c1, right[2] = c2, right[3] = c3;
+  left[4] = b0, left[5] = b1, left[6] = b2, left[7] = b3;
+  right[4] = d0, right[5] = d1, right[6] = d2, right[7] = d3;
+}
+
+void sse2_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 off = _mm_set1_ps(offset);
+  __m128 left[8], right[8];
+  for (int row = 0; row < 8; ++row) {
+    __m128i px = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples + row * 8)), zero);
+    left[row] = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(px, zero)), off);
+    right[row] = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(px, zero)), off);
+  }
+  aan_fdct8_sse2(left);   // columns 0-3
+  aan_fdct8_sse2(right);  // columns 4-7
+  transpose8x8_sse2(left, right);
+  aan_fdct8_sse2(left);   // rows 0-3
+  aan_fdct8_sse2(right);  // rows 4-7
+  transpose8x8_sse2(left, right);
+  for (int row = 0; row < 8; ++row) {
+    __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(left[row], _mm_loadu_ps(divisors + row * 8)));
+    __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(right[row], _mm_loadu_ps(divisors + row * 8 + 4)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(coefs + row * 8), _mm_packs_epi32(lo, hi));
+  }
+}
+
+TARGET_AVX2 static inline void aan_fdct8_avx2(__m256* v) {
+  const __m256 c4 = _mm256_set1_ps(kAanC4);
+  const __m256 c6 = _mm256_set1_ps(kAanC6);
+  const __m256 c2mc6 = _mm256_set1_ps(kAanC2mC6);
+  const __m256 c2pc6 = _mm256_set1_ps(kAanC2pC6);
+  __m256 tmp0 = _mm256_add_ps(v[0], v[7]);
+  __m256 tmp7 = _mm256_sub_ps(v[0], v[7]);
+  __m256 tmp1 = _mm256_add_ps(v[1], v[6]);
+  __m256 tmp6 = _mm256_sub_ps(v[1], v[6]);
+  __m256 tmp2 = _mm256_add_ps(v[2], v[5]);
+  __m256 tmp5 = _mm256_sub_ps(v[2], v[5]);
+  __m256 tmp3 = _mm256_add_ps(v[3], v[4]);
+  __m256 tmp4 = _mm256_sub_ps(v[3], v[4]);
+
+  __m256 tmp10 = _mm256_add_ps(tmp0, tmp3);
+  __m256 tmp13 = _mm256_sub_ps(tmp0, tmp3);
+  __m256 tmp11 = _mm256_add_ps(tmp1, tmp2);
+  __m256 tmp12 = _mm256_sub_ps(tmp1, tmp2);
+  v[0] = _mm256_add_ps(tmp10, tmp11);
+  v[4] = _mm256_sub_ps(tmp10, tmp11);
+  __m256 z1 = _mm256_mul_ps(_mm256_add_ps(tmp12, tmp13), c4);
+  v[2] = _mm256_add_ps(tmp13, z1);
+  v[6] = _mm256_sub_ps(tmp13, z1);
+
+  tmp10 = _mm256_add_ps(tmp4, tmp5);
+  tmp11 = _mm256_add_ps(tmp5, tmp6);
+  tmp12 = _mm256_add_ps(tmp6, tmp7);
+  __m256 z5 = _mm256_mul_ps(_mm256_sub_ps(tmp10, tmp12), c6);
+  __m256 z2 = _mm256_add_ps(_mm256_mul_ps(tmp10, c2mc6), z5);
+  __m256 z4 = _mm256_add_ps(_mm256_mul_ps(tmp12, c2pc6), z5);
+  __m256 z3 = _mm256_mul_ps(tmp11, c4);
+  __m256 z11 = _mm256_add_ps(tmp7, z3);
+  __m256 z13 = _mm256_sub_ps(tmp7, z3);
+  v[5] = _mm256_add_ps(z13, z2);
+  v[3] = _mm256_sub_ps(z13, z2);
+  v[1] = _mm256_add_ps(z11, z4);
+  v[7] = _mm256_sub_ps(z11, z4);
+}
+
+TARGET_AVX2 static inline void transpose8x8_avx2(__m256* v) {
+  __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+  __m256 t1 = _mm256_unpackhi_ps(v[0], v[1]);
+  __m256 t2 = _mm256_unpacklo_ps(v[2], v[3]);
+  __m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+  __m256 t4 = _mm256_unpacklo_ps(v[4], v[5]);
+  __m256 t5 = _mm256_unpackhi_ps(v[4], v[5]);
+  __m256 t6 = _mm256_unpacklo_ps(v[6], v[7]);
+  __m256 t7 = _mm256_unpackhi_ps(v[6], v[7]);
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  v[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  v[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  v[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  v[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  v[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  v[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  v[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  v[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+TARGET_AVX2 void avx2_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs) {
+  const __m256 off = _mm256_set1_ps(offset);
+  __m256 v[8];
+  for (int row = 0; row < 8; ++row) {
+    __m128i px = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples + row * 8));
+    v[row] = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(px)), off);
+  }
+  aan_fdct8_avx2(v);  // columns
+  transpose8x8_avx2(v);
+  aan_fdct8_avx2(v);  // rows
+  transpose8x8_avx2(v);
+  for (int row = 0; row < 8; row += 2) {
+    __m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(v[row], _mm256_loadu_ps(divisors + row * 8)));
+    __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(v[row + 1], _mm256_loadu_ps(divisors + row * 8 + 8)));
+    // packs works per 128-bit lane: a0-3 b0-3 a4-7 b4-7 -> a0-7 b0-7
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(coefs + row * 8), packed);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// JPEG dequantization + inverse DCT
+//
+// Float AAN inverse (libjpeg's jidctflt.c): coefficients are multiplied by
+// `multipliers` (quantizer, AAN input scale and the 1/8 normalization, plus
+// any range compression), then a column pass and a row pass. Output is
+// rounded to nearest-even after adding `offset` and saturated to 0..255, so
+// every variant is bit-exact with the baseline.
+
+static const float kAanSqrt2 = 1.414213562f;     // 2*c4
+static const float kAan2C2 = 1.847759065f;       // 2*c2
+static const float kAan2C2mC6 = 1.082392200f;    // 2*(c2-c6)
+static const float kAanM2C2pC6 = -2.613125930f;  // -2*(c2+c6)
+
+static inline void aan_idct8(float* p, size_t step) {
+  // Even part
+  float tmp10 = p[0 * step] + p[4 * step];
+  float tmp11 = p[0 * step] - p[4 * step];
+  float tmp13 = p[2 * step] + p[6 * step];
+  float tmp12 = (p[2 * step] - p[6 * step]) * kAanSqrt2 - tmp13;
+  float tmp0 = tmp10 + tmp13;
+  float tmp3 = tmp10 - tmp13;
+  float tmp1 = tmp11 + tmp12;
+  float tmp2 = tmp11 - tmp12;
+
+  // Odd part
+  float z13 = p[5 * step] + p[3 * step];
+  float z10 = p[5 * step] - p[3 * step];
+  float z11 = p[1 * step] + p[7 * step];
+  float z12 = p[1 * step] - p[7 * step];
+  float tmp7 = z11 + z13;
+  tmp11 = (z11 - z13) * kAanSqrt2;
+  float z5 = (z10 + z12) * kAan2C2;
+  tmp10 = z12 * kAan2C2mC6 - z5;
+  tmp12 = z10 * kAanM2C2pC6 + z5;
+  float tmp6 = tmp12 - tmp7;
+  float tmp5 = tmp11 - tmp6;
+  float tmp4 = tmp10 + tmp5;
+
+  p[0 * step] = tmp0 + tmp7;
+  p[7 * step] = tmp0 - tmp7;
+  p[1 * step] = tmp1 + tmp6;
+  p[6 * step] = tmp1 - tmp6;
+  p[2 * step] = tmp2 + tmp5;
+  p[5 * step] = tmp2 - tmp5;
+  p[4 * step] = tmp3 + tmp4;
+  p[3 * step] = tmp3 - tmp4;
+}
+
+void baseline_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride) {
+  float ws[64];
+  for (int i = 0; i < 64; ++i) ws[i] = static_cast<float>(coefs[i]) * multipliers[i];
+  for (int col = 0; col < 8; ++col) aan_idct8(ws + col, 8);
+  for (int row = 0; row < 8; ++row) aan_idct8(ws + row * 8, 1);
+  for (int row = 0; row < 8; ++row) {
+    for (int col = 0; col < 8; ++col) dst[row * dstStride + col] = clamp_u8(static_cast<int>(std::lrintf(ws[row * 8 + col] + offset)));
+  }
+}
+
+static inline void aan_idct8_sse2(__m128* v) {
+  const __m128 sqrt2 = _mm_set1_ps(kAanSqrt2);
+  const __m128 c2 = _mm_set1_ps(kAan2C2);
+  const __m128 c2mc6 = _mm_set1_ps(kAan2C2mC6);
+  const __m128 mc2pc6 = _mm_set1_ps(kAanM2C2pC6);
+  __m128 tmp10 = _mm_add_ps(v[0], v[4]);
+  __m128 tmp11 = _mm_sub_ps(v[0], v[4]);
+  __m128 tmp13 = _mm_add_ps(v[2], v[6]);
+  __m128 tmp12 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(v[2], v[6]), sqrt2), tmp13);
+  __m128 tmp0 = _mm_add_ps(tmp10, tmp13);
+  __m128 tmp3 = _mm_sub_ps(tmp10, tmp13);
+  __m128 tmp1 = _mm_add_ps(tmp11, tmp12);
+  __m128 tmp2 = _mm_sub_ps(tmp11, tmp12);
+
+  __m128 z13 = _mm_add_ps(v[5], v[3]);
+  __m128 z10 = _mm_sub_ps(v[5], v[3]);
+  __m128 z11 = _mm_add_ps(v[1], v[7]);
+  __m128 z12 = _mm_sub_ps(v[1], v[7]);
+  __m128 tmp7 = _mm_add_ps(z11, z13);
+  tmp11 = _mm_mul_ps(_mm_sub_ps(z11, z13), sqrt2);
+  __m128 z5 = _mm_mul_ps(_mm_add_ps(z10, z12), c2);
+  tmp10 = _mm_sub_ps(_mm_mul_ps(z12, c2mc6), z5);
+  tmp12 = _mm_add_ps(_mm_mul_ps(z10, mc2pc6), z5);
+  __m128 tmp6 = _mm_sub_ps(tmp12, tmp7);
+  __m128 tmp5 = _mm_sub_ps(tmp11, tmp6);
+  __m128 tmp4 = _mm_add_ps(tmp10, tmp5);
+
+  v[0] = _mm_add_ps(tmp0, tmp7);
+  v[7] = _mm_sub_ps(tmp0, tmp7);
+  v[1] = _mm_add_ps(tmp1, tmp6);
+  v[6] = _mm_sub_ps(tmp1, tmp6);
+  v[2] = _mm_add_ps(tmp2, tmp5);
+  v[5] = _mm_sub_ps(tmp2, tmp5);
+  v[4] = _mm_add_ps(tmp3, tmp4);
+  v[3] = _mm_sub_ps(tmp3, tmp4);
+}
+
+void sse2_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride) {
+  __m128 left[8], right[8];
+  for (int row = 0; row < 8; ++row) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + row * 8));
+    // Sign-extend the eight int16 to int32
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(c, c), 16);
+    left[row] = _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_loadu_ps(multipliers + row * 8));
+    right[row] = _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_loadu_ps(multipliers + row * 8 + 4));
+  }
+  aan_idct8_sse2(left);   // columns 0-3
+  aan_idct8_sse2(right);  // columns 4-7
+  transpose8x8_sse2(left, right);
+  aan_idct8_sse2(left);   // rows 0-3
+  aan_idct8_sse2(right);  // rows 4-7
+  transpose8x8_sse2(left, right);
+  const __m128 off = _mm_set1_ps(offset);
+  for (int row = 0; row < 8; ++row) {
+    __m128i lo = _mm_cvtps_epi32(_mm_add_ps(left[row], off));
+    __m128i hi = _mm_cvtps_epi32(_mm_add_ps(right[row], off));
+    __m128i words = _mm_packs_epi32(lo, hi);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + row * dstStride), _mm_packus_epi16(words, words));
+  }
+}
+
+TARGET_AVX2 static inline void aan_idct8_avx2(__m256* v) {
+  const __m256 sqrt2 = _mm256_set1_ps(kAanSqrt2);
+  const __m256 c2 = _mm256_set1_ps(kAan2C2);
+  const __m256 c2mc6 = _mm256_set1_ps(kAan2C2mC6);
+  const __m256 mc2pc6 = _mm256_set1_ps(kAanM2C2pC6);
+  __m256 tmp10 = _mm256_add_ps(v[0], v[4]);
+  __m256 tmp11 = _mm256_sub_ps(v[0], v[4]);
+  __m256 tmp13 = _mm256_add_ps(v[2], v[6]);
+  __m256 tmp12 = _mm256_sub_ps(_mm256_mul_ps(_mm256_sub_ps(v[2], v[6]), sqrt2), tmp13);
+  __m256 tmp0 = _mm256_add_ps(tmp10, tmp13);
+  __m256 tmp3 = _mm256_sub_ps(tmp10, tmp13);
+  __m256 tmp1 = _mm256_add_ps(tmp11, tmp12);
+  __m256 tmp2 = _mm256_sub_ps(tmp11, tmp12);
+
+  __m256 z13 = _mm256_add_ps(v[5], v[3]);
+  __m256 z10 = _mm256_sub_ps(v[5], v[3]);
+  __m256 z11 = _mm256_add_ps(v[1], v[7]);
+  __m256 z12 = _mm256_sub_ps(v[1], v[7]);
+  __m256 tmp7 = _mm256_add_ps(z11, z13);
+  tmp11 = _mm256_mul_ps(_mm256_sub_ps(z11, z13), sqrt2);
+  __m256 z5 = _mm256_mul_ps(_mm256_add_ps(z10, z12), c2);
+  tmp10 = _mm256_sub_ps(_mm256_mul_ps(z12, c2mc6), z5);
+  tmp12 = _mm256_add_ps(_mm256_mul_ps(z10, mc2pc6), z5);
+  __m256 tmp6 = _mm256_sub_ps(tmp12, tmp7);
+  __m256 tmp5 = _mm256_sub_ps(tmp11, tmp6);
+  __m256 tmp4 = _mm256_add_ps(tmp10, tmp5);
+
+  v[0] = _mm256_add_ps(tmp0, tmp7);
+  v[7] = _mm256_sub_ps(tmp0, tmp7);
+  v[1] = _mm256_add_ps(tmp1, tmp6);
+  v[6] = _mm256_sub_ps(tmp1, tmp6);
+  v[2] = _mm256_add_ps(tmp2, tmp5);
+  v[5] = _mm256_sub_ps(tmp2, tmp5);
+  v[4] = _mm256_add_ps(tmp3, tmp4);
+  v[3] = _mm256_sub_ps(tmp3, tmp4);
+}
+
+TARGET_AVX2 void avx2_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride) {
+  __m256 v[8];
+  for (int row = 0; row < 8; ++row) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + row * 8));
+    v[row] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(c)), _mm256_loadu_ps(multipliers + row * 8));
+  }
+  aan_idct8_avx2(v);  // columns
+  transpose8x8_avx2(v);
+  aan_idct8_avx2(v);  // rows
+  transpose8x8_avx2(v);
+  const __m256 off = _mm256_set1_ps(offset);
+  for (int row = 0; row < 8; row += 2) {
+    __m256i a = _mm256_cvtps_epi32(_mm256_add_ps(v[row], off));
+    __m256i b = _mm256_cvtps_epi32(_mm256_add_ps(v[row + 1], off));
+    // Per 128-bit lane: a0-3 b0-3 | a4-7 b4-7 as words, then bytes
+    __m256i words = _mm256_packs_epi32(a, b);
+    __m256i bytes = _mm256_packus_epi16(words, words);
+    // Low lane holds a0-3 b0-3 (twice), high lane a4-7 b4-7
+    __m128i lo = _mm256_castsi256_si128(bytes);
+    __m128i hi = _mm256_extracti128_si256(bytes, 1);
+    __m128i rows = _mm_unpacklo_epi32(lo, hi);  // a0-3 a4-7 b0-3 b4-7
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + row * dstStride), rows);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + (row + 1) * dstStride), _mm_unpackhi_epi64(rows, rows));
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Kernel dispatch table
+//
+// One table per ISA tier, each entry the best variant at or below that tier.
+// The active table is chosen once at module init; switching tiers swaps a
+// single pointer, so a conversion costs one load plus one indirect call.
+
+static void scalar_rgb32_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  optimized_rgb32_to_rgba(src, dst, pixels, 0, 0);
+}
+
+static const ConvertIsa kIsaTiers[] = {ConvertIsa::Scalar, ConvertIsa::SSE2, ConvertIsa::SSSE3, ConvertIsa::AVX2, ConvertIsa::AVX512};
+static const size_t kIsaTierCount = sizeof(kIsaTiers) / sizeof(kIsaTiers[0]);
+
+static ConvertKernels build_kernels(ConvertIsa isa) {
+  ConvertKernels k;
+  k.isa = isa;
+  k.rgb32ToRgba = scalar_rgb32_to_rgba;
+  k.rgb32ToRgbaName = "scalar";
+  k.rgb24ToRgba = optimized_rgb24_to_rgba;
+  k.rgb24ToRgbaName = "scalar";
+  k.nv12ToRgb32 = baseline_nv12_to_rgb32;
+  k.nv12ToRgb32Name = "baseline";
+  k.yuv422ToRgb = baseline_yuv422_to_rgb;
+  k.yuv422ToRgbName = "baseline";
+  k.jpegFdct = baseline_jpeg_fdct_quant;
+  k.jpegFdctName = "baseline";
+  k.jpegIdct = baseline_jpeg_idct;
+  k.jpegIdctName = "baseline";
+  k.yuv420ToRgb = baseline_yuv420_to_rgb;
+  k.yuv420ToRgbName = "baseline";
+  k.rgbToYuv420 = baseline_rgb_to_yuv420;
+  k.rgbToYuv420Name = "baseline";
+  k.rgbToYuv422 = baseline_rgb_to_yuv422;
+  k.rgbToYuv422Name = "baseline";
+  k.rgbRepack = baseline_rgb_repack;
+  k.rgbRepackName = "baseline";
+  k.yuv420ToYuv422 = baseline_yuv420_to_yuv422;
+  k.yuv420ToYuv422Name = "baseline";
+  k.yuv422ToYuv420 = baseline_yuv422_to_yuv420;
+  k.yuv422ToYuv420Name = "baseline";
+  k.uvInterleave = baseline_uv_interleave;
+  k.uvInterleaveName = "baseline";
+  k.uvDeinterleave = baseline_uv_deinterleave;
+  k.uvDeinterleaveName = "baseline";
+  k.yuv422Swap = baseline_yuv422_swap;
+  k.yuv422SwapName = "baseline";
+  if (isa >= ConvertIsa::SSE2) {
+    k.nv12ToRgb32 = sse2_nv12_to_rgb32;
+    k.nv12ToRgb32Name = "sse2";
+    k.jpegFdct = sse2_jpeg_fdct_quant;
+    k.jpegFdctName = "sse2";
+    k.jpegIdct = sse2_jpeg_idct;
+    k.jpegIdctName = "sse2";
+    k.yuv420ToYuv422 = sse2_yuv420_to_yuv422;
+    k.yuv420ToYuv422Name = "sse2";
+    k.yuv422ToYuv420 = sse2_yuv422_to_yuv420;
+    k.yuv422ToYuv420Name = "sse2";
+    k.uvInterleave = sse2_uv_interleave;
+    k.uvInterleaveName = "sse2";
+    k.uvDeinterleave = sse2_uv_deinterleave;
+    k.uvDeinterleaveName = "sse2";
+    k.yuv422Swap = sse2_yuv422_swap;
+    k.yuv422SwapName = "sse2";
+  }
+  if (isa >= ConvertIsa::SSSE3) {
+    k.rgb32ToRgba = ssse3_rgb32_to_rgba;
+    k.rgb32ToRgbaName = "ssse3";
+    k.rgb24ToRgba = ssse3_rgb24_to_rgba;
+    k.rgb24ToRgbaName = "ssse3";
+    k.yuv422ToRgb = ssse3_yuv422_to_rgb;
+    k.yuv422ToRgbName = "ssse3";
+    k.yuv420ToRgb = ssse3_yuv420_to_rgb;
+    k.yuv420ToRgbName = "ssse3";
+    k.rgbToYuv420 = ssse3_rgb_to_yuv420;
+    k.rgbToYuv420Name = "ssse3";
+    k.rgbToYuv422 = ssse3_rgb_to_yuv422;
+    k.rgbToYuv422Name = "ssse3";
+    k.rgbRepack = ssse3_rgb_repack;
+    k.rgbRepackName = "ssse3";
+  }
+  if (isa >= ConvertIsa::AVX2) {
+    k.rgb32ToRgba = avx2_rgb32_to_rgba;
+    k.rgb32ToRgbaName = "avx2";
+    k.rgb24ToRgba = avx2_rgb24_to_rgba;
+    k.rgb24ToRgbaName = "avx2";
+    k.nv12ToRgb32 = avx2_nv12_to_rgb32;
+    k.nv12ToRgb32Name = "avx2";
+    k.yuv422ToRgb = avx2_yuv422_to_rgb;
+    k.yuv422ToRgbName = "avx2";
+    k.jpegFdct = avx2_jpeg_fdct_quant;
+    k.jpegFdctName = "avx2";
+    k.jpegIdct = avx2_jpeg_idct;
+    k.jpegIdctName = "avx2";
+    k.yuv420ToRgb = avx2_yuv420_to_rgb;
+    k.yuv420ToRgbName = "avx2";
+    k.rgbToYuv420 = avx2_rgb_to_yuv420;
+    k.rgbToYuv420Name = "avx2";
+    k.rgbToYuv422 = avx2_rgb_to_yuv422;
+    k.rgbToYuv422Name = "avx2";
+    k.rgbRepack = avx2_rgb_repack;
+    k.rgbRepackName = "avx2";
+    k.yuv420ToYuv422 = avx2_yuv420_to_yuv422;
+    k.yuv420ToYuv422Name = "avx2";
+    k.yuv422ToYuv420 = avx2_yuv422_to_yuv420;
+    k.yuv422ToYuv420Name = "avx2";
+    k.uvInterleave = avx2_uv_interleave;
+    k.uvInterleaveName = "avx2";
+    k.uvDeinterleave = avx2_uv_deinterleave;
+    k.uvDeinterleaveName = "avx2";
+    k.yuv422Swap = avx2_yuv422_swap;
+    k.yuv422SwapName = "avx2";
+  }
+  if (isa >= ConvertIsa::AVX512) {
+    k.nv12ToRgb32 = avx512_nv12_to_rgb32;
+    k.nv12ToRgb32Name = "avx512";
+  }
+  return k;
+}
+
+struct KernelRegistry {
+  ConvertIsa detected;
+  ConvertKernels tables[kIsaTierCount];
+  KernelRegistry() {
+    const CpuFeatures& cpu = cpu_features();
+    detected = cpu.avx512bw ? ConvertIsa::AVX512
+             : cpu.avx2     ? ConvertIsa::AVX2
+             : cpu.ssse3    ? ConvertIsa::SSSE3
+             : cpu.sse2     ? ConvertIsa::SSE2
+                            : ConvertIsa::Scalar;
+    for (size_t i = 0; i < kIsaTierCount; ++i) tables[i] = build_kernels(kIsaTiers[i]);
+  }
+};
+
+static KernelRegistry& kernel_registry() {
+  static KernelRegistry registry;
+  return registry;
+}
+
+static std::atomic<const ConvertKernels*> g_activeKernels{nullptr};
+
+static const ConvertKernels* init_kernels() {
+  KernelRegistry& r = kernel_registry();
+  ConvertIsa isa = r.detected;
+  ConvertIsa requested;
+  const char* env = std::getenv("CAMERA_CONVERT_ISA");
+  if (env && *env && parse_convert_isa(env, requested) && requested <= r.detected) isa = requested;
+  const ConvertKernels* expected = nullptr;
+  g_activeKernels.compare_exchange_strong(expected, &r.tables[static_cast<size_t>(isa)], std::memory_order_acq_rel);
+  return g_activeKernels.load(std::memory_order_acquire);
+}
+
+// Populate the table at module init so the first frame does not pay for it.
+static const ConvertKernels* const g_initialKernels = init_kernels();
+
+const ConvertKernels& convert_kernels() {
+  const ConvertKernels* k = g_activeKernels.load(std::memory_order_acquire);
+  return k ? *k : *init_kernels();
+}
+
+bool parse_convert_isa(const char* name, ConvertIsa& out) {
+  if (!name) return false;
+  std::string n(name);
+  for (char& ch : n) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+  if (n == "auto") {
+    out = detected_convert_isa();
+  } else if (n == "scalar" || n == "baseline" || n == "c") {
+    out = ConvertIsa::Scalar;
+  } else if (n == "sse2") {
+    out = ConvertIsa::SSE2;
+  } else if (n == "ssse3") {
+    out = ConvertIsa::SSSE3;
+  } else if (n == "avx2") {
+    out = ConvertIsa::AVX2;
+  } else if (n == "avx512" || n == "avx512bw") {
+    out = ConvertIsa::AVX512;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* convert_isa_name(ConvertIsa isa) {
+  switch (isa) {
+    case ConvertIsa::Scalar:
+      return "scalar";
+    case ConvertIsa::SSE2:
+      return "sse2";
+    case ConvertIsa::SSSE3:
+      return "ssse3";
+    case ConvertIsa::AVX2:
+      return "avx2";
+    case ConvertIsa::AVX512:
+      return "avx512";
+  }
+  return "scalar";
+}
+
+ConvertIsa detected_convert_isa() {
+  return kernel_registry().detected;
+}
+
+bool set_convert_isa(ConvertIsa isa) {
+  KernelRegistry& r = kernel_registry();
+  if (isa > r.detected) return false;
+  g_activeKernels.store(&r.tables[static_cast<size_t>(isa)], std::memory_order_release);
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Dispatched entry points
+
+void simd_rgb32_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  if (pixels == 0) return;
+  convert_kernels().rgb32ToRgba(src, dst, pixels);
+}
+
+void simd_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  if (pixels == 0) return;
+  convert_kernels().rgb24ToRgba(src, dst, pixels);
+}
+
+void simd_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range) {
+  convert_kernels().nv12ToRgb32(srcY, strideY, srcUV, strideUV, dst, dstStride, width, height, order, matrix, range);
+}
+
+void simd_nv12_to_rgba(const uint8_t* src, uint8_t* dst, size_t width, size_t height, YuvMatrix matrix, YuvRange range) {
+  convert_kernels().nv12ToRgb32(src, width, src + width * height, width, dst, width * 4, width, height, Rgb32Order::RGBA, matrix, range);
+}
+
+void simd_nv12_to_bgra(const uint8_t* src, uint8_t* dst, size_t width, size_t height, YuvMatrix matrix, YuvRange range) {
+  convert_kernels().nv12ToRgb32(src, width, src + width * height, width, dst, width * 4, width, height, Rgb32Order::BGRA, matrix, range);
+}
+
+const char* nv12_kernel_name() {
+  return convert_kernels().nv12ToRgb32Name;
+}
+
+void simd_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  convert_kernels().yuv422ToRgb(src, srcStride, dst, dstStride, width, height, layout, format, matrix, range);
+}
+
+void simd_yuv422_to_rgb(const uint8_t* src, uint8_t* dst, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const size_t srcStride = ((width + 1) & ~static_cast<size_t>(1)) * 2;
+  convert_kernels().yuv422ToRgb(src, srcStride, dst, width * rgb_format_bpp(format), width, height, layout, format, matrix, range);
+}
+
+const char* yuv422_kernel_name() {
+  return convert_kernels().yuv422ToRgbName;
+}
+
+void simd_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs) {
+  convert_kernels().jpegFdct(samples, offset, divisors, coefs);
+}
+
+const char* jpeg_fdct_kernel_name() {
+  return convert_kernels().jpegFdctName;
+}
+
+void simd_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride) {
+  convert_kernels().jpegIdct(coefs, multipliers, offset, dst, dstStride);
+}
+
+const char* jpeg_idct_kernel_name() {
+  return convert_kernels().jpegIdctName;
+}
+
+void simd_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  convert_kernels().yuv420ToRgb(srcY, strideY, srcU, srcV, strideUV, uvStep, dst, dstStride, width, height, format, matrix, range);
+}
+
+void simd_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range) {
+  convert_kernels().rgbToYuv420(src, srcStride, format, dstY, strideY, dstU, dstV, strideUV, uvStep, width, height, matrix, range);
+}
+
+void simd_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range) {
+  convert_kernels().rgbToYuv422(src, srcStride, format, dst, dstStride, width, height, layout, matrix, range);
+}
+
+void simd_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels) {
+  if (pixels == 0) return;
+  convert_kernels().rgbRepack(src, srcFormat, dst, dstFormat, pixels);
+}
+
+void simd_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout) {
+  convert_kernels().yuv420ToYuv422(srcY, strideY, srcU, srcV, strideUV, uvStep, dst, dstStride, width, height, layout);
+}
+
+void simd_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout) {
+  convert_kernels().yuv422ToYuv420(src, srcStride, dstY, strideY, dstU, dstV, strideUV, uvStep, width, height, layout);
+}
+
+void simd_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs) {
+  if (pairs == 0) return;
+  convert_kernels().uvInterleave(srcU, srcV, dstUV, pairs);
+}
+
+void simd_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs) {
+  if (pairs == 0) return;
+  convert_kernels().uvDeinterleave(srcUV, dstU, dstV, pairs);
+}
 
-  // Fallback to scalar optimized implementation
-  optimized_rgb24_to_rgba(src, dst, pixels);
+void simd_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels) {
+  if (macropixels == 0) return;
+  convert_kernels().yuv422Swap(src, dst, macropixels);
 }
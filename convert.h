@@ -2,22 +2,216 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "cpu_features.h"
+
 // RGB32 (BGRA) -> RGBA conversion helpers
 // RGB24 (BGR24) -> RGBA conversion helpers
 void baseline_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
 void optimized_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
+void ssse3_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
+void avx2_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
 void simd_rgb24_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
 
 // RGB32 (BGRA) -> RGBA conversion helpers
 void baseline_rgb32_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
 void optimized_rgb32_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels, size_t width, size_t height);
+void ssse3_rgb32_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
+void avx2_rgb32_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
 void simd_rgb32_to_rgba(const uint8_t* src, uint8_t* dst, size_t pixels);
 
-// CPU feature queries
-bool cpu_has_avx2();
-bool cpu_has_ssse3();
-bool cpu_has_sse2();
-bool cpu_has_sse3();
-bool cpu_has_sse41();
-bool cpu_has_avx();
-bool cpu_has_bmi2();
+// YUV -> RGB colour conversion parameters
+enum class YuvMatrix { BT601, BT709 };
+enum class YuvRange { Limited, Full };
+// Byte order of packed 32-bit RGB output
+enum class Rgb32Order { RGBA, BGRA };
+
+// NV12 -> RGBA/BGRA. `srcY`/`srcUV` are the luma and interleaved chroma planes,
+// strides are in bytes. All variants are bit-exact with the baseline
+// (13-bit fixed point, round half up, saturate).
+void baseline_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range);
+void sse2_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range);
+void avx2_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range);
+void avx512_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range);
+// Active variant from the dispatch table, with explicit strides.
+void simd_nv12_to_rgb32(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range);
+// Contiguous NV12 input
+// (stride == width, UV plane directly after Y) and tightly packed output.
+void simd_nv12_to_rgba(const uint8_t* src, uint8_t* dst, size_t width, size_t height, YuvMatrix matrix = YuvMatrix::BT601, YuvRange range = YuvRange::Limited);
+void simd_nv12_to_bgra(const uint8_t* src, uint8_t* dst, size_t width, size_t height, YuvMatrix matrix = YuvMatrix::BT601, YuvRange range = YuvRange::Limited);
+// Name of the active NV12 variant ("avx512", "avx2", "sse2" or "baseline")
+const char* nv12_kernel_name();
+
+// Packed 4:2:2 byte layouts: YUY2 is Y0 U Y1 V, UYVY is U Y0 V Y1
+enum class Yuv422Layout { YUY2, UYVY };
+// Packed RGB output formats
+enum class RgbFormat { RGBA, BGRA, BGR24 };
+
+// YUY2/UYVY -> RGBA/BGRA/BGR24, strides in bytes. Same fixed-point maths as the
+// NV12 kernels; every variant is bit-exact with the baseline.
+void baseline_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range);
+void ssse3_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range);
+void avx2_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range);
+// Active variant from the dispatch table, with explicit strides.
+void simd_yuv422_to_rgb(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range);
+// Tightly packed input and output.
+void simd_yuv422_to_rgb(const uint8_t* src, uint8_t* dst, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix = YuvMatrix::BT601, YuvRange range = YuvRange::Limited);
+// Name of the active 4:2:2 variant ("avx2", "ssse3" or "baseline")
+const char* yuv422_kernel_name();
+
+// 4:2:0 (NV12 or I420) -> RGBA/BGRA/BGR24, strides in bytes. Chroma sample i
+// of a row is read at srcU[i * uvStep] and srcV[i * uvStep]: uvStep 2 with
+// srcV = srcU + 1 for NV12's interleaved plane, 1 for I420's separate planes.
+// Same fixed-point maths as the NV12 kernels; every variant is bit-exact with
+// the baseline.
+void baseline_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range);
+void ssse3_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range);
+void avx2_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range);
+// Active variant from the dispatch table.
+void simd_yuv420_to_rgb(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range);
+
+// RGBA/BGRA/BGR24 -> 4:2:0 (NV12 or I420, chroma addressed as above). Each
+// chroma sample is computed from the sum of the 2x2 pixels it covers (15-bit
+// fixed point, round half up, saturate); an odd last row or column is
+// counted twice. All variants are bit-exact with the baseline.
+void baseline_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range);
+void ssse3_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range);
+void avx2_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range);
+void simd_rgb_to_yuv420(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range);
+
+// RGBA/BGRA/BGR24 -> YUY2/UYVY; chroma from the sum of each pixel pair.
+void baseline_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range);
+void ssse3_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range);
+void avx2_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range);
+void simd_rgb_to_yuv422(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range);
+
+// Between packed RGB formats (channel reorder, alpha added as 255 or
+// dropped). The same format in and out is a copy.
+void baseline_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels);
+void ssse3_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels);
+void avx2_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels);
+void simd_rgb_repack(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels);
+
+// 4:2:0 (NV12 or I420) -> YUY2/UYVY: each chroma row serves both of its luma
+// rows. An odd last column repeats its luma sample.
+void baseline_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout);
+void sse2_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout);
+void avx2_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout);
+void simd_yuv420_to_yuv422(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout);
+
+// YUY2/UYVY -> 4:2:0 (NV12 or I420): chroma is the rounded average of each
+// row pair (an odd last row keeps its own).
+void baseline_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout);
+void sse2_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout);
+void avx2_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout);
+void simd_yuv422_to_yuv420(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout);
+
+// Separate U and V samples <-> interleaved (U,V) pairs (I420 <-> NV12 chroma)
+void baseline_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs);
+void sse2_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs);
+void avx2_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs);
+void simd_uv_interleave(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs);
+void baseline_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs);
+void sse2_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs);
+void avx2_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs);
+void simd_uv_deinterleave(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs);
+
+// YUY2 <-> UYVY (swaps the bytes of every 16-bit word)
+void baseline_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels);
+void sse2_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels);
+void avx2_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels);
+void simd_yuv422_swap(const uint8_t* src, uint8_t* dst, size_t macropixels);
+
+// JPEG forward DCT and quantization of one 8x8 block (float AAN). `samples`
+// are 64 bytes, row-major; `offset` is subtracted from each before the
+// transform (the level shift) and `divisors` (64 floats, natural order) fold
+// the AAN output scale, any range expansion and the quantizer. Quantized
+// coefficients are written in natural order. All variants are bit-exact with
+// the baseline.
+void baseline_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs);
+void sse2_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs);
+void avx2_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs);
+// Active variant from the dispatch table.
+void simd_jpeg_fdct_quant(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs);
+// Name of the active JPEG DCT variant ("avx2", "sse2" or "baseline")
+const char* jpeg_fdct_kernel_name();
+
+// JPEG dequantization and inverse DCT of one 8x8 block (float AAN). `coefs`
+// are in natural order; `multipliers` (64 floats) fold the quantizer, the AAN
+// input scale and any range compression; `offset` is added to each sample
+// (the level shift) before rounding and saturating to 0..255. Writes 8 rows
+// of 8 bytes at `dst`. All variants are bit-exact with the baseline.
+void baseline_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride);
+void sse2_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride);
+void avx2_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride);
+// Active variant from the dispatch table.
+void simd_jpeg_idct(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride);
+// Name of the active JPEG inverse DCT variant
+const char* jpeg_idct_kernel_name();
+
+// ---------------------------------------------------------------------------
+// Kernel dispatch table. The simd_* entry points above go through it.
+
+// Instruction set tiers, lowest first
+enum class ConvertIsa { Scalar, SSE2, SSSE3, AVX2, AVX512 };
+
+typedef void (*PackedToRgbaFn)(const uint8_t* src, uint8_t* dst, size_t pixels);
+typedef void (*Nv12ToRgb32Fn)(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, uint8_t* dst, size_t dstStride, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range);
+typedef void (*Yuv422ToRgbFn)(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range);
+typedef void (*JpegFdctFn)(const uint8_t* samples, float offset, const float* divisors, int16_t* coefs);
+typedef void (*JpegIdctFn)(const int16_t* coefs, const float* multipliers, float offset, uint8_t* dst, size_t dstStride);
+typedef void (*Yuv420ToRgbFn)(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, RgbFormat format, YuvMatrix matrix, YuvRange range);
+typedef void (*RgbToYuv420Fn)(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, YuvMatrix matrix, YuvRange range);
+typedef void (*RgbToYuv422Fn)(const uint8_t* src, size_t srcStride, RgbFormat format, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout, YuvMatrix matrix, YuvRange range);
+typedef void (*RgbRepackFn)(const uint8_t* src, RgbFormat srcFormat, uint8_t* dst, RgbFormat dstFormat, size_t pixels);
+typedef void (*Yuv420ToYuv422Fn)(const uint8_t* srcY, size_t strideY, const uint8_t* srcU, const uint8_t* srcV, size_t strideUV, size_t uvStep, uint8_t* dst, size_t dstStride, size_t width, size_t height, Yuv422Layout layout);
+typedef void (*Yuv422ToYuv420Fn)(const uint8_t* src, size_t srcStride, uint8_t* dstY, size_t strideY, uint8_t* dstU, uint8_t* dstV, size_t strideUV, size_t uvStep, size_t width, size_t height, Yuv422Layout layout);
+typedef void (*UvInterleaveFn)(const uint8_t* srcU, const uint8_t* srcV, uint8_t* dstUV, size_t pairs);
+typedef void (*UvDeinterleaveFn)(const uint8_t* srcUV, uint8_t* dstU, uint8_t* dstV, size_t pairs);
+typedef void (*Yuv422SwapFn)(const uint8_t* src, uint8_t* dst, size_t macropixels);
+
+// One kernel per source -> destination format pair, plus the variant names.
+struct ConvertKernels {
+  ConvertIsa isa;  // tier this table was built for
+  PackedToRgbaFn rgb32ToRgba;
+  PackedToRgbaFn rgb24ToRgba;
+  Nv12ToRgb32Fn nv12ToRgb32;
+  Yuv422ToRgbFn yuv422ToRgb;
+  JpegFdctFn jpegFdct;
+  JpegIdctFn jpegIdct;
+  Yuv420ToRgbFn yuv420ToRgb;
+  RgbToYuv420Fn rgbToYuv420;
+  RgbToYuv422Fn rgbToYuv422;
+  RgbRepackFn rgbRepack;
+  Yuv420ToYuv422Fn yuv420ToYuv422;
+  Yuv422ToYuv420Fn yuv422ToYuv420;
+  UvInterleaveFn uvInterleave;
+  UvDeinterleaveFn uvDeinterleave;
+  Yuv422SwapFn yuv422Swap;
+  const char* rgb32ToRgbaName;
+  const char* rgb24ToRgbaName;
+  const char* nv12ToRgb32Name;
+  const char* yuv422ToRgbName;
+  const char* jpegFdctName;
+  const char* jpegIdctName;
+  const char* yuv420ToRgbName;
+  const char* rgbToYuv420Name;
+  const char* rgbToYuv422Name;
+  const char* rgbRepackName;
+  const char* yuv420ToYuv422Name;
+  const char* yuv422ToYuv420Name;
+  const char* uvInterleaveName;
+  const char* uvDeinterleaveName;
+  const char* yuv422SwapName;
+};
+
+// Active table. Built at module init for the best tier the CPU supports, or
+// the tier named by the CAMERA_CONVERT_ISA environment variable when set.
+const ConvertKernels& convert_kernels();
+// Switch every format pair to the best variant at or below `isa` (for A/B
+// runs and for pinning a path in production). Returns false, leaving the
+// table unchanged, if the CPU does not support `isa`.
+bool set_convert_isa(ConvertIsa isa);
+ConvertIsa detected_convert_isa();
+// 'auto' | 'scalar' | 'sse2' | 'ssse3' | 'avx2' | 'avx512' ('auto' = detected)
+bool parse_convert_isa(const char* name, ConvertIsa& out);
+const char* convert_isa_name(ConvertIsa isa);
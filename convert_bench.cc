@@ -0,0 +1,676 @@
+// Standalone benchmark suite for the conversion library (no Node, no Media
+// Foundation), so it runs headless on Linux CI as well as on Windows.
+//
+//   convert_bench [options]
+//     --sizes WxH,WxH,...  resolutions to sweep (default 320x240 .. 7680x4320)
+//     --quick              sweep 640x480 and 1920x1080 only
+//     --filter TEXT        only run cases whose name contains TEXT
+//     --json PATH          write results as JSON (PATH "-" = stdout)
+//     --budget MS          time budget per measurement (default 250)
+//     --evict-mb N         cache eviction buffer for cold runs (default 64)
+//     --scaling            also sweep ConvertEngine threads 1..N
+//     --verify             only run the differential check below
+//     --jpeg PATH          time MJPEG decoding of a recording (CAMREC0x, see
+//                          frame_recording.h) or a .jpg file instead
+//
+// Before timing, every variant is checked against its conversion's baseline
+// on random sizes, data and buffer offsets (including writes past the frame).
+// A mismatch fails the run with exit code 2.
+//
+// Every case is measured aligned (64-byte) and unaligned (+1 byte), with warm
+// caches (back-to-back conversions) and cold caches (an eviction pass over a
+// large buffer before each sample). Each measurement reports median, p99 and
+// min time per frame, memory throughput in GB/s (source + destination bytes)
+// and TSC cycles per pixel. examples/bench.js diffs two JSON reports.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include "convert.h"
+#include "convert_engine.h"
+#include "jpeg_decoder.h"
+#include "jpeg_encoder.h"
+
+struct BenchCase {
+  std::string name;  // "<conversion>/<variant>"
+  bool supported;
+  // Bytes read and written for one frame
+  std::function<size_t(size_t w, size_t h)> srcBytes;
+  std::function<size_t(size_t w, size_t h)> dstBytes;
+  std::function<void(const uint8_t* src, uint8_t* dst, size_t w, size_t h)> run;
+};
+
+struct Measurement {
+  std::string name;
+  size_t width = 0;
+  size_t height = 0;
+  bool aligned = true;
+  bool cold = false;
+  size_t samples = 0;
+  double medianMs = 0;
+  double p99Ms = 0;
+  double minMs = 0;
+  double gbps = 0;
+  double cyclesPerPixel = 0;
+};
+
+struct Options {
+  std::vector<std::pair<size_t, size_t>> sizes;
+  std::string filter;
+  std::string jsonPath;
+  double budgetMs = 250;
+  size_t evictBytes = 64u << 20;
+  bool scaling = false;
+  bool verifyOnly = false;
+  std::string jpegPath;
+};
+
+static size_t EvenWidth(size_t w) {
+  return (w + 1) & ~static_cast<size_t>(1);
+}
+
+static std::vector<BenchCase> BuildCases(const CpuFeatures& cpu) {
+  std::vector<BenchCase> cases;
+  auto rgb32Src = [](size_t w, size_t h) { return w * h * 4; };
+  auto rgb24Src = [](size_t w, size_t h) { return w * h * 3; };
+  auto rgbaDst = [](size_t w, size_t h) { return w * h * 4; };
+  auto bgr24Dst = [](size_t w, size_t h) { return w * h * 3; };
+  auto nv12Src = [](size_t w, size_t h) { return w * h + EvenWidth(w) * ((h + 1) / 2); };
+  auto yuy2Src = [](size_t w, size_t h) { return EvenWidth(w) * 2 * h; };
+
+  auto packed = [&](const char* name, bool ok, PackedToRgbaFn fn, bool rgb24) {
+    cases.push_back({name, ok, rgb24 ? std::function<size_t(size_t, size_t)>(rgb24Src) : rgb32Src, rgbaDst,
+                     [fn](const uint8_t* s, uint8_t* d, size_t w, size_t h) { fn(s, d, w * h); }});
+  };
+  packed("rgb32_to_rgba/baseline", true, baseline_rgb32_to_rgba, false);
+  packed("rgb32_to_rgba/optimized", true, [](const uint8_t* s, uint8_t* d, size_t n) { optimized_rgb32_to_rgba(s, d, n, 0, 0); }, false);
+  packed("rgb32_to_rgba/ssse3", cpu.ssse3, ssse3_rgb32_to_rgba, false);
+  packed("rgb32_to_rgba/avx2", cpu.avx2, avx2_rgb32_to_rgba, false);
+  packed("rgb24_to_rgba/baseline", true, baseline_rgb24_to_rgba, true);
+  packed("rgb24_to_rgba/optimized", true, optimized_rgb24_to_rgba, true);
+  packed("rgb24_to_rgba/ssse3", cpu.ssse3, ssse3_rgb24_to_rgba, true);
+  packed("rgb24_to_rgba/avx2", cpu.avx2, avx2_rgb24_to_rgba, true);
+
+  auto nv12 = [&](const char* name, bool ok, Nv12ToRgb32Fn fn) {
+    cases.push_back({name, ok, nv12Src, rgbaDst, [fn](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       fn(s, w, s + w * h, EvenWidth(w), d, w * 4, w, h, Rgb32Order::RGBA, YuvMatrix::BT601, YuvRange::Limited);
+                     }});
+  };
+  nv12("nv12_to_rgba/baseline", true, baseline_nv12_to_rgb32);
+  nv12("nv12_to_rgba/sse2", cpu.sse2, sse2_nv12_to_rgb32);
+  nv12("nv12_to_rgba/avx2", cpu.avx2, avx2_nv12_to_rgb32);
+  nv12("nv12_to_rgba/avx512", cpu.avx512bw, avx512_nv12_to_rgb32);
+
+  auto yuv422 = [&](const char* name, bool ok, Yuv422ToRgbFn fn, Yuv422Layout layout, RgbFormat format) {
+    bool bgr = format == RgbFormat::BGR24;
+    cases.push_back({name, ok, yuy2Src, bgr ? std::function<size_t(size_t, size_t)>(bgr24Dst) : rgbaDst,
+                     [fn, layout, format, bgr](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       fn(s, EvenWidth(w) * 2, d, w * (bgr ? 3 : 4), w, h, layout, format, YuvMatrix::BT601, YuvRange::Limited);
+                     }});
+  };
+  yuv422("yuy2_to_bgr24/baseline", true, baseline_yuv422_to_rgb, Yuv422Layout::YUY2, RgbFormat::BGR24);
+  yuv422("yuy2_to_bgr24/ssse3", cpu.ssse3, ssse3_yuv422_to_rgb, Yuv422Layout::YUY2, RgbFormat::BGR24);
+  yuv422("yuy2_to_bgr24/avx2", cpu.avx2, avx2_yuv422_to_rgb, Yuv422Layout::YUY2, RgbFormat::BGR24);
+  yuv422("yuy2_to_bgra/baseline", true, baseline_yuv422_to_rgb, Yuv422Layout::YUY2, RgbFormat::BGRA);
+  yuv422("yuy2_to_bgra/ssse3", cpu.ssse3, ssse3_yuv422_to_rgb, Yuv422Layout::YUY2, RgbFormat::BGRA);
+  yuv422("yuy2_to_bgra/avx2", cpu.avx2, avx2_yuv422_to_rgb, Yuv422Layout::YUY2, RgbFormat::BGRA);
+  yuv422("uyvy_to_bgra/baseline", true, baseline_yuv422_to_rgb, Yuv422Layout::UYVY, RgbFormat::BGRA);
+  yuv422("uyvy_to_bgra/avx2", cpu.avx2, avx2_yuv422_to_rgb, Yuv422Layout::UYVY, RgbFormat::BGRA);
+
+  // Planar I420 and semi-planar NV12 share the 4:2:0 kernels; uvStep picks the chroma layout
+  auto yuv420 = [&](const char* name, bool ok, Yuv420ToRgbFn fn, bool planar, RgbFormat format) {
+    bool bgr = format == RgbFormat::BGR24;
+    cases.push_back({name, ok, nv12Src, bgr ? std::function<size_t(size_t, size_t)>(bgr24Dst) : rgbaDst,
+                     [fn, planar, format, bgr](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       const uint8_t* u = s + w * h;
+                       const size_t cw = (w + 1) / 2;
+                       fn(s, w, u, planar ? u + cw * ((h + 1) / 2) : u + 1, planar ? cw : cw * 2, planar ? 1 : 2, d, w * (bgr ? 3 : 4), w, h, format,
+                          YuvMatrix::BT601, YuvRange::Limited);
+                     }});
+  };
+  yuv420("i420_to_bgr24/baseline", true, baseline_yuv420_to_rgb, true, RgbFormat::BGR24);
+  yuv420("i420_to_bgr24/ssse3", cpu.ssse3, ssse3_yuv420_to_rgb, true, RgbFormat::BGR24);
+  yuv420("i420_to_bgr24/avx2", cpu.avx2, avx2_yuv420_to_rgb, true, RgbFormat::BGR24);
+  yuv420("i420_to_rgba/baseline", true, baseline_yuv420_to_rgb, true, RgbFormat::RGBA);
+  yuv420("i420_to_rgba/ssse3", cpu.ssse3, ssse3_yuv420_to_rgb, true, RgbFormat::RGBA);
+  yuv420("i420_to_rgba/avx2", cpu.avx2, avx2_yuv420_to_rgb, true, RgbFormat::RGBA);
+  yuv420("nv12_to_bgr24/baseline", true, baseline_yuv420_to_rgb, false, RgbFormat::BGR24);
+  yuv420("nv12_to_bgr24/ssse3", cpu.ssse3, ssse3_yuv420_to_rgb, false, RgbFormat::BGR24);
+  yuv420("nv12_to_bgr24/avx2", cpu.avx2, avx2_yuv420_to_rgb, false, RgbFormat::BGR24);
+
+  auto rgbSrc = [&](RgbFormat format) { return format == RgbFormat::BGR24 ? std::function<size_t(size_t, size_t)>(rgb24Src) : rgb32Src; };
+  auto toYuv420 = [&](const char* name, bool ok, RgbToYuv420Fn fn, RgbFormat format, bool planar) {
+    cases.push_back({name, ok, rgbSrc(format), nv12Src, [fn, format, planar](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       uint8_t* u = d + w * h;
+                       const size_t cw = (w + 1) / 2;
+                       fn(s, w * (format == RgbFormat::BGR24 ? 3 : 4), format, d, w, u, planar ? u + cw * ((h + 1) / 2) : u + 1, planar ? cw : cw * 2,
+                          planar ? 1 : 2, w, h, YuvMatrix::BT601, YuvRange::Limited);
+                     }});
+  };
+  toYuv420("bgra_to_nv12/baseline", true, baseline_rgb_to_yuv420, RgbFormat::BGRA, false);
+  toYuv420("bgra_to_nv12/ssse3", cpu.ssse3, ssse3_rgb_to_yuv420, RgbFormat::BGRA, false);
+  toYuv420("bgra_to_nv12/avx2", cpu.avx2, avx2_rgb_to_yuv420, RgbFormat::BGRA, false);
+  toYuv420("bgr24_to_i420/baseline", true, baseline_rgb_to_yuv420, RgbFormat::BGR24, true);
+  toYuv420("bgr24_to_i420/ssse3", cpu.ssse3, ssse3_rgb_to_yuv420, RgbFormat::BGR24, true);
+  toYuv420("bgr24_to_i420/avx2", cpu.avx2, avx2_rgb_to_yuv420, RgbFormat::BGR24, true);
+  toYuv420("rgba_to_i420/baseline", true, baseline_rgb_to_yuv420, RgbFormat::RGBA, true);
+  toYuv420("rgba_to_i420/avx2", cpu.avx2, avx2_rgb_to_yuv420, RgbFormat::RGBA, true);
+
+  auto toYuv422 = [&](const char* name, bool ok, RgbToYuv422Fn fn, RgbFormat format, Yuv422Layout layout) {
+    cases.push_back({name, ok, rgbSrc(format), yuy2Src, [fn, format, layout](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       fn(s, w * (format == RgbFormat::BGR24 ? 3 : 4), format, d, EvenWidth(w) * 2, w, h, layout, YuvMatrix::BT601, YuvRange::Limited);
+                     }});
+  };
+  toYuv422("bgra_to_yuy2/baseline", true, baseline_rgb_to_yuv422, RgbFormat::BGRA, Yuv422Layout::YUY2);
+  toYuv422("bgra_to_yuy2/ssse3", cpu.ssse3, ssse3_rgb_to_yuv422, RgbFormat::BGRA, Yuv422Layout::YUY2);
+  toYuv422("bgra_to_yuy2/avx2", cpu.avx2, avx2_rgb_to_yuv422, RgbFormat::BGRA, Yuv422Layout::YUY2);
+  toYuv422("bgr24_to_uyvy/baseline", true, baseline_rgb_to_yuv422, RgbFormat::BGR24, Yuv422Layout::UYVY);
+  toYuv422("bgr24_to_uyvy/ssse3", cpu.ssse3, ssse3_rgb_to_yuv422, RgbFormat::BGR24, Yuv422Layout::UYVY);
+  toYuv422("bgr24_to_uyvy/avx2", cpu.avx2, avx2_rgb_to_yuv422, RgbFormat::BGR24, Yuv422Layout::UYVY);
+
+  auto repack = [&](const char* name, bool ok, RgbRepackFn fn, RgbFormat from, RgbFormat to) {
+    cases.push_back({name, ok, rgbSrc(from), to == RgbFormat::BGR24 ? std::function<size_t(size_t, size_t)>(bgr24Dst) : rgbaDst,
+                     [fn, from, to](const uint8_t* s, uint8_t* d, size_t w, size_t h) { fn(s, from, d, to, w * h); }});
+  };
+  repack("bgra_to_bgr24/baseline", true, baseline_rgb_repack, RgbFormat::BGRA, RgbFormat::BGR24);
+  repack("bgra_to_bgr24/ssse3", cpu.ssse3, ssse3_rgb_repack, RgbFormat::BGRA, RgbFormat::BGR24);
+  repack("bgra_to_bgr24/avx2", cpu.avx2, avx2_rgb_repack, RgbFormat::BGRA, RgbFormat::BGR24);
+  repack("rgba_to_bgr24/baseline", true, baseline_rgb_repack, RgbFormat::RGBA, RgbFormat::BGR24);
+  repack("rgba_to_bgr24/ssse3", cpu.ssse3, ssse3_rgb_repack, RgbFormat::RGBA, RgbFormat::BGR24);
+  repack("rgba_to_bgr24/avx2", cpu.avx2, avx2_rgb_repack, RgbFormat::RGBA, RgbFormat::BGR24);
+  repack("bgr24_to_bgra/baseline", true, baseline_rgb_repack, RgbFormat::BGR24, RgbFormat::BGRA);
+  repack("bgr24_to_bgra/ssse3", cpu.ssse3, ssse3_rgb_repack, RgbFormat::BGR24, RgbFormat::BGRA);
+  repack("bgr24_to_bgra/avx2", cpu.avx2, avx2_rgb_repack, RgbFormat::BGR24, RgbFormat::BGRA);
+  repack("rgba_to_bgra/baseline", true, baseline_rgb_repack, RgbFormat::RGBA, RgbFormat::BGRA);
+  repack("rgba_to_bgra/ssse3", cpu.ssse3, ssse3_rgb_repack, RgbFormat::RGBA, RgbFormat::BGRA);
+  repack("rgba_to_bgra/avx2", cpu.avx2, avx2_rgb_repack, RgbFormat::RGBA, RgbFormat::BGRA);
+
+  auto toYuv422From420 = [&](const char* name, bool ok, Yuv420ToYuv422Fn fn, bool planar, Yuv422Layout layout) {
+    cases.push_back({name, ok, nv12Src, yuy2Src, [fn, planar, layout](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       const uint8_t* u = s + w * h;
+                       const size_t cw = (w + 1) / 2;
+                       fn(s, w, u, planar ? u + cw * ((h + 1) / 2) : u + 1, planar ? cw : cw * 2, planar ? 1 : 2, d, EvenWidth(w) * 2, w, h, layout);
+                     }});
+  };
+  toYuv422From420("nv12_to_yuy2/baseline", true, baseline_yuv420_to_yuv422, false, Yuv422Layout::YUY2);
+  toYuv422From420("nv12_to_yuy2/sse2", cpu.sse2, sse2_yuv420_to_yuv422, false, Yuv422Layout::YUY2);
+  toYuv422From420("nv12_to_yuy2/avx2", cpu.avx2, avx2_yuv420_to_yuv422, false, Yuv422Layout::YUY2);
+  toYuv422From420("i420_to_uyvy/baseline", true, baseline_yuv420_to_yuv422, true, Yuv422Layout::UYVY);
+  toYuv422From420("i420_to_uyvy/sse2", cpu.sse2, sse2_yuv420_to_yuv422, true, Yuv422Layout::UYVY);
+  toYuv422From420("i420_to_uyvy/avx2", cpu.avx2, avx2_yuv420_to_yuv422, true, Yuv422Layout::UYVY);
+
+  auto toYuv420From422 = [&](const char* name, bool ok, Yuv422ToYuv420Fn fn, Yuv422Layout layout, bool planar) {
+    cases.push_back({name, ok, yuy2Src, nv12Src, [fn, layout, planar](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       uint8_t* u = d + w * h;
+                       const size_t cw = (w + 1) / 2;
+                       fn(s, EvenWidth(w) * 2, d, w, u, planar ? u + cw * ((h + 1) / 2) : u + 1, planar ? cw : cw * 2, planar ? 1 : 2, w, h, layout);
+                     }});
+  };
+  toYuv420From422("yuy2_to_nv12/baseline", true, baseline_yuv422_to_yuv420, Yuv422Layout::YUY2, false);
+  toYuv420From422("yuy2_to_nv12/sse2", cpu.sse2, sse2_yuv422_to_yuv420, Yuv422Layout::YUY2, false);
+  toYuv420From422("yuy2_to_nv12/avx2", cpu.avx2, avx2_yuv422_to_yuv420, Yuv422Layout::YUY2, false);
+  toYuv420From422("uyvy_to_i420/baseline", true, baseline_yuv422_to_yuv420, Yuv422Layout::UYVY, true);
+  toYuv420From422("uyvy_to_i420/sse2", cpu.sse2, sse2_yuv422_to_yuv420, Yuv422Layout::UYVY, true);
+  toYuv420From422("uyvy_to_i420/avx2", cpu.avx2, avx2_yuv422_to_yuv420, Yuv422Layout::UYVY, true);
+
+  // Chroma-only repacks over w * h samples
+  auto pairBytes = [](size_t w, size_t h) { return w * h * 2; };
+  auto interleave = [&](const char* name, bool ok, UvInterleaveFn fn) {
+    cases.push_back({name, ok, pairBytes, pairBytes, [fn](const uint8_t* s, uint8_t* d, size_t w, size_t h) { fn(s, s + w * h, d, w * h); }});
+  };
+  interleave("uv_interleave/baseline", true, baseline_uv_interleave);
+  interleave("uv_interleave/sse2", cpu.sse2, sse2_uv_interleave);
+  interleave("uv_interleave/avx2", cpu.avx2, avx2_uv_interleave);
+  auto deinterleave = [&](const char* name, bool ok, UvDeinterleaveFn fn) {
+    cases.push_back({name, ok, pairBytes, pairBytes, [fn](const uint8_t* s, uint8_t* d, size_t w, size_t h) { fn(s, d, d + w * h, w * h); }});
+  };
+  deinterleave("uv_deinterleave/baseline", true, baseline_uv_deinterleave);
+  deinterleave("uv_deinterleave/sse2", cpu.sse2, sse2_uv_deinterleave);
+  deinterleave("uv_deinterleave/avx2", cpu.avx2, avx2_uv_deinterleave);
+  auto swap422 = [&](const char* name, bool ok, Yuv422SwapFn fn) {
+    cases.push_back({name, ok, yuy2Src, yuy2Src, [fn](const uint8_t* s, uint8_t* d, size_t w, size_t h) { fn(s, d, EvenWidth(w) / 2 * h); }});
+  };
+  swap422("yuy2_to_uyvy/baseline", true, baseline_yuv422_swap);
+  swap422("yuy2_to_uyvy/sse2", cpu.sse2, sse2_yuv422_swap);
+  swap422("yuy2_to_uyvy/avx2", cpu.avx2, avx2_yuv422_swap);
+
+  // JPEG DCT + quantization over the frame as consecutive 64-sample blocks
+  auto fdct = [&](const char* name, bool ok, JpegFdctFn fn) {
+    cases.push_back({name, ok, [](size_t w, size_t h) { return w * h / 64 * 64; }, [](size_t w, size_t h) { return w * h / 64 * 128; },
+                     [fn](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       static const struct Divisors {
+                         alignas(32) float v[64];
+                         Divisors() {
+                           for (int i = 0; i < 64; ++i) v[i] = 1.0f / (8.0f * (1 + (i % 8) + (i / 8)));
+                         }
+                       } divisors;
+                       alignas(32) int16_t coefs[64];
+                       for (size_t b = 0; b < w * h / 64; ++b) {
+                         fn(s + b * 64, 128.0f, divisors.v, coefs);
+                         memcpy(d + b * 128, coefs, sizeof(coefs));
+                       }
+                     }});
+  };
+  fdct("jpeg_fdct/baseline", true, baseline_jpeg_fdct_quant);
+  fdct("jpeg_fdct/sse2", cpu.sse2, sse2_jpeg_fdct_quant);
+  fdct("jpeg_fdct/avx2", cpu.avx2, avx2_jpeg_fdct_quant);
+
+  // Dequantization + inverse DCT of consecutive 64-coefficient blocks
+  auto idct = [&](const char* name, bool ok, JpegIdctFn fn) {
+    cases.push_back({name, ok, [](size_t w, size_t h) { return w * h / 64 * 128; }, [](size_t w, size_t h) { return w * h / 64 * 64; },
+                     [fn](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                       static const struct Multipliers {
+                         alignas(32) float v[64];
+                         Multipliers() {
+                           for (int i = 0; i < 64; ++i) v[i] = 0.125f / (1 + (i % 8) + (i / 8));
+                         }
+                       } multipliers;
+                       alignas(32) int16_t coefs[64];
+                       for (size_t b = 0; b < w * h / 64; ++b) {
+                         memcpy(coefs, s + b * 128, sizeof(coefs));
+                         fn(coefs, multipliers.v, 128.0f, d + b * 64, 8);
+                       }
+                     }});
+  };
+  idct("jpeg_idct/baseline", true, baseline_jpeg_idct);
+  idct("jpeg_idct/sse2", cpu.sse2, sse2_jpeg_idct);
+  idct("jpeg_idct/avx2", cpu.avx2, avx2_jpeg_idct);
+
+  // Whole-frame NV12 -> JPEG through the portable encoder (output size varies)
+  cases.push_back({"nv12_to_jpeg/encoder", true, nv12Src, [](size_t, size_t) { return size_t(0); },
+                   [](const uint8_t* s, uint8_t*, size_t w, size_t h) {
+                     static YuvJpegEncoder encoder;
+                     static std::vector<uint8_t> out;
+                     encoder.EncodeNv12(s, w, s + w * h, EvenWidth(w), w, h, YuvRange::Limited, out);
+                   }});
+
+  // The banded engine at full width, sharing one pool across all sizes
+  static ConvertEngine engine;
+  cases.push_back({"nv12_to_rgba/engine", true, nv12Src, rgbaDst, [](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                     engine.Nv12ToRgb32(s, d, w, h, Rgb32Order::RGBA);
+                   }});
+  cases.push_back({"yuy2_to_bgr24/engine", true, yuy2Src, bgr24Dst, [](const uint8_t* s, uint8_t* d, size_t w, size_t h) {
+                     engine.Yuv422ToRgb(s, d, w, h, Yuv422Layout::YUY2, RgbFormat::BGR24);
+                   }});
+  return cases;
+}
+
+// "<conversion>/<variant>" -> "<conversion>"
+static std::string Conversion(const std::string& name) {
+  return name.substr(0, name.find('/'));
+}
+
+// Randomized differential check of every supported case against the
+// baseline of the same conversion. Returns the number of failing cases.
+static size_t VerifyCases(const std::vector<BenchCase>& cases, FILE* out) {
+  const uint8_t kGuard = 0xA5;
+  std::mt19937 rng(0x5eed);
+  size_t failures = 0;
+  for (const BenchCase& c : cases) {
+    if (!c.supported || c.name.find("/baseline") != std::string::npos) continue;
+    const BenchCase* ref = nullptr;
+    for (const BenchCase& b : cases) {
+      if (b.name == Conversion(c.name) + "/baseline") ref = &b;
+    }
+    if (!ref) continue;
+
+    bool ok = true;
+    for (int trial = 0; trial < 200 && ok; ++trial) {
+      // Mostly small frames to hit every tail length, some wider rows
+      size_t w = 1 + rng() % (trial % 4 == 0 ? 1000 : 70);
+      size_t h = 1 + rng() % 6;
+      size_t srcOffset = rng() % 64, dstOffset = rng() % 64;
+      size_t srcLen = c.srcBytes(w, h), dstLen = c.dstBytes(w, h);
+      // Source ends exactly at the end of its allocation so over-reads show
+      // up under ASan/valgrind; destination gets guard bytes.
+      std::vector<uint8_t> src(srcOffset + srcLen);
+      for (auto& b : src) b = static_cast<uint8_t>(rng());
+      std::vector<uint8_t> want(dstOffset + dstLen + 64, kGuard), got(want);
+      ref->run(src.data() + srcOffset, want.data() + dstOffset, w, h);
+      c.run(src.data() + srcOffset, got.data() + dstOffset, w, h);
+      if (got != want) {
+        size_t at = 0;
+        while (got[at] == want[at]) ++at;
+        std::fprintf(out, "MISMATCH %s at %zux%zu (src+%zu, dst+%zu): byte %zd of %zu\n", c.name.c_str(), w, h, srcOffset, dstOffset,
+                     static_cast<ptrdiff_t>(at) - static_cast<ptrdiff_t>(dstOffset), dstLen);
+        ok = false;
+      }
+    }
+    if (!ok) ++failures;
+  }
+  std::fprintf(out, "Differential check: %s\n", failures ? "FAILED" : "all variants match their baseline");
+  return failures;
+}
+
+// Nearest-rank percentile of sorted samples
+static double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > sorted.size()) rank = sorted.size();
+  return sorted[rank - 1];
+}
+
+static void EvictCaches(std::vector<uint8_t>& evict) {
+  // Write then read so both dirty and clean lines are displaced
+  for (size_t i = 0; i < evict.size(); i += 64) evict[i] = static_cast<uint8_t>(evict[i] + 1);
+  volatile uint8_t sink = 0;
+  for (size_t i = 0; i < evict.size(); i += 64) sink = static_cast<uint8_t>(sink + evict[i]);
+  (void)sink;
+}
+
+static Measurement Measure(const BenchCase& c, size_t w, size_t h, const uint8_t* src, uint8_t* dst, bool aligned, bool cold,
+                           const Options& opts, std::vector<uint8_t>& evict) {
+  using Clock = std::chrono::steady_clock;
+  c.run(src, dst, w, h);  // warm up and page in
+
+  // Warm samples batch enough frames to be well above timer resolution.
+  size_t reps = 1;
+  if (!cold) {
+    auto t0 = Clock::now();
+    c.run(src, dst, w, h);
+    double one = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    if (one < 0.2) reps = static_cast<size_t>(0.2 / std::max(one, 1e-6)) + 1;
+  }
+
+  const size_t minSamples = cold ? 5 : 9;
+  const size_t maxSamples = cold ? 51 : 201;
+  std::vector<double> ms;
+  std::vector<double> cycles;
+  double spent = 0;
+  while (ms.size() < maxSamples && (ms.size() < minSamples || spent < opts.budgetMs)) {
+    if (cold) EvictCaches(evict);
+    auto t0 = Clock::now();
+    uint64_t c0 = __rdtsc();
+    for (size_t r = 0; r < reps; ++r) c.run(src, dst, w, h);
+    uint64_t c1 = __rdtsc();
+    double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    ms.push_back(elapsed / reps);
+    cycles.push_back(static_cast<double>(c1 - c0) / reps);
+    spent += elapsed;
+  }
+  std::sort(ms.begin(), ms.end());
+  std::sort(cycles.begin(), cycles.end());
+
+  Measurement m;
+  m.name = c.name;
+  m.width = w;
+  m.height = h;
+  m.aligned = aligned;
+  m.cold = cold;
+  m.samples = ms.size();
+  m.medianMs = Percentile(ms, 50);
+  m.p99Ms = Percentile(ms, 99);
+  m.minMs = ms.front();
+  double bytes = static_cast<double>(c.srcBytes(w, h) + c.dstBytes(w, h));
+  m.gbps = m.medianMs > 0 ? bytes / (m.medianMs * 1e6) : 0;
+  m.cyclesPerPixel = Percentile(cycles, 50) / static_cast<double>(w * h);
+  return m;
+}
+
+static bool ParseSizes(const std::string& spec, std::vector<std::pair<size_t, size_t>>& out) {
+  out.clear();
+  size_t pos = 0;
+  while (pos < spec.size()) {
+    size_t end = spec.find(',', pos);
+    if (end == std::string::npos) end = spec.size();
+    std::string item = spec.substr(pos, end - pos);
+    size_t x = item.find('x');
+    if (x == std::string::npos) return false;
+    size_t w = std::strtoul(item.substr(0, x).c_str(), nullptr, 10);
+    size_t h = std::strtoul(item.substr(x + 1).c_str(), nullptr, 10);
+    if (w == 0 || h == 0) return false;
+    out.emplace_back(w, h);
+    pos = end + 1;
+  }
+  return !out.empty();
+}
+
+static void WriteJson(FILE* f, const CpuFeatures& cpu, const std::vector<Measurement>& results) {
+  std::fprintf(f, "{\n  \"version\": 1,\n");
+  std::fprintf(f, "  \"cpu\": {\"sse2\": %s, \"ssse3\": %s, \"sse4_1\": %s, \"avx\": %s, \"avx2\": %s, \"bmi2\": %s, \"avx512bw\": %s},\n",
+               cpu.sse2 ? "true" : "false", cpu.ssse3 ? "true" : "false", cpu.sse41 ? "true" : "false", cpu.avx ? "true" : "false",
+               cpu.avx2 ? "true" : "false", cpu.bmi2 ? "true" : "false", cpu.avx512bw ? "true" : "false");
+  std::fprintf(f, "  \"isa\": \"%s\",\n  \"threads\": %u,\n  \"results\": [\n", convert_isa_name(convert_kernels().isa),
+               std::thread::hardware_concurrency());
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Measurement& m = results[i];
+    std::fprintf(f,
+                 "    {\"case\": \"%s\", \"width\": %zu, \"height\": %zu, \"aligned\": %s, \"cache\": \"%s\", \"samples\": %zu, "
+                 "\"median_ms\": %.6f, \"p99_ms\": %.6f, \"min_ms\": %.6f, \"gbps\": %.4f, \"cycles_per_pixel\": %.4f}%s\n",
+                 m.name.c_str(), m.width, m.height, m.aligned ? "true" : "false", m.cold ? "cold" : "warm", m.samples, m.medianMs,
+                 m.p99Ms, m.minMs, m.gbps, m.cyclesPerPixel, i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+}
+
+static void RunScaling(const Options& opts) {
+  size_t maxThreads = std::thread::hardware_concurrency();
+  if (maxThreads == 0) maxThreads = 1;
+  for (const auto& size : opts.sizes) {
+    size_t w = size.first, h = size.second;
+    std::vector<uint8_t> src(w * h * 4, 0x80), dst(w * h * 4);
+    std::printf("\nConvertEngine scaling %zux%zu (median ms/frame)\n", w, h);
+    ConvertEngine engine(1);
+    double nv12One = 0, yuy2One = 0;
+    for (size_t threads = 1; threads <= maxThreads; ++threads) {
+      engine.SetThreadCount(threads);
+      std::vector<double> nv12, yuy2;
+      for (int i = 0; i < 15; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        engine.Nv12ToRgb32(src.data(), dst.data(), w, h, Rgb32Order::RGBA);
+        auto t1 = std::chrono::steady_clock::now();
+        engine.Yuv422ToRgb(src.data(), dst.data(), w, h, Yuv422Layout::YUY2, RgbFormat::BGR24);
+        auto t2 = std::chrono::steady_clock::now();
+        nv12.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        yuy2.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+      }
+      std::sort(nv12.begin(), nv12.end());
+      std::sort(yuy2.begin(), yuy2.end());
+      double n = Percentile(nv12, 50), y = Percentile(yuy2, 50);
+      if (threads == 1) {
+        nv12One = n;
+        yuy2One = y;
+      }
+      std::printf("  threads=%-3zu nv12 %9.4f (x%.2f)   yuy2 %9.4f (x%.2f)\n", threads, n, nv12One / n, y, yuy2One / y);
+    }
+  }
+}
+
+static uint32_t ReadU32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Frames for --jpeg: every record of a recording, or one JPEG file.
+static bool LoadJpegFrames(const std::string& path, std::vector<std::vector<uint8_t>>& frames) {
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return false;
+  std::vector<uint8_t> file;
+  uint8_t chunk[1 << 16];
+  size_t n;
+  while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) file.insert(file.end(), chunk, chunk + n);
+  std::fclose(f);
+
+  frames.clear();
+  // CAMREC01 records have a 16-byte header, CAMREC02 a 24-byte one
+  const bool v1 = file.size() >= 96 && memcmp(file.data(), "CAMREC01", 8) == 0;
+  if (file.size() < 96 || (!v1 && memcmp(file.data(), "CAMREC02", 8) != 0)) {
+    if (!file.empty()) frames.push_back(std::move(file));
+    return !frames.empty();
+  }
+  // Records run from the header to the index (or to the first truncated
+  // record when the recording has none)
+  size_t end = file.size();
+  if (end >= 24 + 96 && memcmp(file.data() + end - 8, "CAMRECIX", 8) == 0) {
+    uint64_t indexOffset = ReadU32(file.data() + end - 24) | (static_cast<uint64_t>(ReadU32(file.data() + end - 20)) << 32);
+    if (indexOffset <= end) end = static_cast<size_t>(indexOffset);
+  }
+  const size_t recordHeader = v1 ? 16 : 24;
+  size_t pos = ReadU32(file.data() + 8);
+  while (pos + recordHeader <= end) {
+    size_t size = ReadU32(file.data() + pos);
+    if (pos + recordHeader + size > end) break;
+    frames.emplace_back(file.data() + pos + recordHeader, file.data() + pos + recordHeader + size);
+    pos += recordHeader + size;
+  }
+  return !frames.empty();
+}
+
+// Decode every frame into each output format, on the calling thread and on
+// the engine, and report median ms per frame.
+static int RunJpegDecode(const Options& opts, FILE* out) {
+  std::vector<std::vector<uint8_t>> frames;
+  if (!LoadJpegFrames(opts.jpegPath, frames)) {
+    std::fprintf(stderr, "cannot read JPEG frames from %s\n", opts.jpegPath.c_str());
+    return 1;
+  }
+  JpegImageInfo info;
+  if (!JpegDecoder::ReadInfo(frames[0].data(), frames[0].size(), info)) {
+    std::fprintf(stderr, "%s: not a baseline JPEG the decoder supports\n", opts.jpegPath.c_str());
+    return 1;
+  }
+  size_t bytes = 0;
+  for (const auto& frame : frames) bytes += frame.size();
+  std::fprintf(out, "\n%s: %zu frames, %zux%zu, %d component(s), sampling %dx%d, restart interval %zu, %.1f KB/frame\n",
+               opts.jpegPath.c_str(), frames.size(), info.width, info.height, info.components, info.hSampling, info.vSampling,
+               info.restartInterval, bytes / 1024.0 / frames.size());
+
+  static const struct {
+    const char* name;
+    JpegOutputFormat format;
+  } kFormats[] = {{"nv12", JpegOutputFormat::NV12}, {"i420", JpegOutputFormat::I420}, {"yuy2", JpegOutputFormat::YUY2},
+                  {"uyvy", JpegOutputFormat::UYVY}, {"rgba", JpegOutputFormat::RGBA}, {"bgra", JpegOutputFormat::BGRA},
+                  {"bgr24", JpegOutputFormat::BGR24}};
+  static const char* kModes[] = {"serial", "restart", "pipelined"};
+  ConvertEngine engine;
+  JpegDecoder decoder;
+  std::vector<uint8_t> dst(JpegDecoder::OutputSize(JpegOutputFormat::RGBA, info.width, info.height));
+  std::fprintf(out, "  %-12s %-8s %-10s %10s %10s %10s %8s\n", "format", "threads", "mode", "median_ms", "p99_ms", "min_ms", "fps");
+  for (const auto& fmt : kFormats) {
+    if (!opts.filter.empty() && std::string(fmt.name).find(opts.filter) == std::string::npos) continue;
+    for (int threaded = 0; threaded <= 1; ++threaded) {
+      ConvertEngine* e = threaded ? &engine : nullptr;
+      std::vector<double> ms;
+      double spent = 0;
+      size_t failed = 0;
+      for (size_t i = 0; ms.size() < 9 || (spent < opts.budgetMs && ms.size() < 1000); ++i) {
+        const auto& frame = frames[i % frames.size()];
+        auto t0 = std::chrono::steady_clock::now();
+        if (!decoder.Decode(frame.data(), frame.size(), fmt.format, dst.data(), info.width, info.height, e)) ++failed;
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        ms.push_back(elapsed);
+        spent += elapsed;
+      }
+      std::sort(ms.begin(), ms.end());
+      double median = Percentile(ms, 50);
+      std::fprintf(out, "  %-12s %-8zu %-10s %10.4f %10.4f %10.4f %8.1f%s\n", fmt.name, threaded ? engine.ThreadCount() : size_t(1),
+                   kModes[static_cast<int>(decoder.LastMode())], median, Percentile(ms, 99), ms.front(), median > 0 ? 1000.0 / median : 0.0,
+                   failed ? "  (frames failed to decode)" : "");
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  ParseSizes("320x240,640x480,1280x720,1920x1080,3840x2160,7680x4320", opts.sizes);
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--sizes" && hasValue) {
+      if (!ParseSizes(argv[++i], opts.sizes)) {
+        std::fprintf(stderr, "invalid --sizes (expected WxH[,WxH...])\n");
+        return 1;
+      }
+    } else if (arg == "--quick") {
+      ParseSizes("640x480,1920x1080", opts.sizes);
+    } else if (arg == "--filter" && hasValue) {
+      opts.filter = argv[++i];
+    } else if (arg == "--json" && hasValue) {
+      opts.jsonPath = argv[++i];
+    } else if (arg == "--budget" && hasValue) {
+      opts.budgetMs = std::atof(argv[++i]);
+    } else if (arg == "--evict-mb" && hasValue) {
+      opts.evictBytes = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10)) << 20;
+    } else if (arg == "--scaling") {
+      opts.scaling = true;
+    } else if (arg == "--verify") {
+      opts.verifyOnly = true;
+    } else if (arg == "--jpeg" && hasValue) {
+      opts.jpegPath = argv[++i];
+    } else {
+      std::fprintf(stderr, "usage: %s [--sizes WxH,...] [--quick] [--filter TEXT] [--json PATH] [--budget MS] [--evict-mb N] [--scaling] [--verify] [--jpeg PATH]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // Human-readable output goes to stderr when the JSON report owns stdout.
+  FILE* out = opts.jsonPath == "-" ? stderr : stdout;
+  const CpuFeatures& cpu = cpu_features();
+  std::fprintf(out, "CPU: sse2=%d ssse3=%d sse4_1=%d avx=%d avx2=%d bmi2=%d avx512bw=%d\n", cpu.sse2, cpu.ssse3, cpu.sse41, cpu.avx,
+               cpu.avx2, cpu.bmi2, cpu.avx512bw);
+  std::fprintf(out, "Kernels: %s (detected %s; set CAMERA_CONVERT_ISA to override)\n", convert_isa_name(convert_kernels().isa),
+               convert_isa_name(detected_convert_isa()));
+
+  std::vector<BenchCase> cases = BuildCases(cpu);
+  if (VerifyCases(cases, out) != 0) return 2;
+  if (opts.verifyOnly) return 0;
+  if (!opts.jpegPath.empty()) return RunJpegDecode(opts, out);
+
+  std::vector<uint8_t> evict(opts.evictBytes ? opts.evictBytes : 64);
+  std::vector<Measurement> results;
+
+  for (const auto& size : opts.sizes) {
+    const size_t w = size.first, h = size.second;
+    // Largest source (RGB32) and destination (RGBA) plus room for alignment
+    // and the unaligned offset.
+    std::vector<uint8_t> srcStore(w * h * 4 + 128), dstStore(w * h * 4 + 128);
+    for (size_t i = 0; i < srcStore.size(); ++i) srcStore[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+    uint8_t* srcAligned = srcStore.data() + (64 - reinterpret_cast<uintptr_t>(srcStore.data()) % 64) % 64;
+    uint8_t* dstAligned = dstStore.data() + (64 - reinterpret_cast<uintptr_t>(dstStore.data()) % 64) % 64;
+
+    std::fprintf(out, "\n%zux%zu\n  %-26s %-9s %-5s %10s %10s %10s %8s %8s\n", w, h, "case", "align", "cache", "median_ms",
+                 "p99_ms", "min_ms", "GB/s", "cyc/px");
+    for (const BenchCase& c : cases) {
+      if (!c.supported) continue;
+      if (!opts.filter.empty() && c.name.find(opts.filter) == std::string::npos) continue;
+      for (int aligned = 1; aligned >= 0; --aligned) {
+        for (int cold = 0; cold <= 1; ++cold) {
+          const uint8_t* s = aligned ? srcAligned : srcAligned + 1;
+          uint8_t* d = aligned ? dstAligned : dstAligned + 1;
+          Measurement m = Measure(c, w, h, s, d, aligned != 0, cold != 0, opts, evict);
+          std::fprintf(out, "  %-26s %-9s %-5s %10.4f %10.4f %10.4f %8.2f %8.3f\n", m.name.c_str(), aligned ? "aligned" : "unaligned",
+                       cold ? "cold" : "warm", m.medianMs, m.p99Ms, m.minMs, m.gbps, m.cyclesPerPixel);
+          results.push_back(m);
+        }
+      }
+    }
+  }
+
+  if (opts.scaling) RunScaling(opts);
+
+  if (!opts.jsonPath.empty()) {
+    FILE* f = opts.jsonPath == "-" ? stdout : std::fopen(opts.jsonPath.c_str(), "w");
+    if (!f) {
+      std::fprintf(stderr, "cannot write %s\n", opts.jsonPath.c_str());
+      return 1;
+    }
+    WriteJson(f, cpu, results);
+    if (f != stdout) std::fclose(f);
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include "convert_engine.h"
+
+#include <algorithm>
+
+static size_t ResolveThreadCount(size_t threads) {
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  return std::min<size_t>(std::max<size_t>(threads, 1), 64);
+}
+
+ConvertEngine::ConvertEngine(size_t threads, size_t bandHeight) : m_threads(ResolveThreadCount(threads)), m_bandHeight(bandHeight) {
+  StartWorkers(m_threads - 1);
+}
+
+ConvertEngine::~ConvertEngine() {
+  std::lock_guard<std::mutex> run(m_runLock);
+  StopWorkers();
+}
+
+void ConvertEngine::StartWorkers(size_t count) {
+  m_stop = false;
+  m_workers.reserve(count);
+  for (size_t i = 0; i < count; ++i) m_workers.emplace_back(&ConvertEngine::WorkerLoop, this);
+}
+
+void ConvertEngine::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (std::thread& t : m_workers) t.join();
+  m_workers.clear();
+}
+
+void ConvertEngine::SetThreadCount(size_t threads) {
+  std::lock_guard<std::mutex> run(m_runLock);
+  threads = ResolveThreadCount(threads);
+  if (threads == m_threads) return;
+  StopWorkers();
+  m_threads = threads;
+  StartWorkers(m_threads - 1);
+}
+
+size_t ConvertEngine::ThreadCount() const {
+  return m_threads;
+}
+
+void ConvertEngine::SetBandHeight(size_t rows) {
+  std::lock_guard<std::mutex> run(m_runLock);
+  m_bandHeight = rows;
+}
+
+size_t ConvertEngine::BandHeight() const {
+  return m_bandHeight;
+}
+
+size_t ConvertEngine::PickBandHeight(size_t height, size_t width, size_t rowAlign) const {
+  size_t rows = m_bandHeight;
+  if (rows == 0) {
+    // A few bands per thread so a slow core does not hold up the frame, but
+    // never so small that the hand-off costs more than the conversion.
+    size_t target = m_threads * 4;
+    rows = (height + target - 1) / target;
+    size_t minRows = width ? (kMinBandPixels + width - 1) / width : height;
+    rows = std::max(rows, minRows);
+  }
+  rows = std::max<size_t>(rows, 1);
+  return (rows + rowAlign - 1) / rowAlign * rowAlign;
+}
+
+void ConvertEngine::WorkerLoop() {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_lock);
+      m_wake.wait(lock, [&] { return m_stop || (m_fn && m_generation != seen); });
+      if (m_stop) return;
+      seen = m_generation;
+      ++m_active;
+    }
+    RunBands();
+  }
+}
+
+void ConvertEngine::RunBands() {
+  // Job fields are stable while this participant is counted in m_active.
+  size_t done = 0;
+  for (;;) {
+    size_t band = m_nextBand.fetch_add(1, std::memory_order_relaxed);
+    if (band >= m_bandCount) break;
+    size_t begin = band * m_band;
+    (*m_fn)(begin, std::min(begin + m_band, m_height));
+    ++done;
+  }
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_bandsLeft -= done;
+  --m_active;
+  if (m_bandsLeft == 0 && m_active == 0) m_done.notify_all();
+}
+
+void ConvertEngine::ParallelRows(size_t height, size_t width, size_t rowAlign, const std::function<void(size_t, size_t)>& fn) {
+  if (height == 0) return;
+  if (rowAlign == 0) rowAlign = 1;
+  std::lock_guard<std::mutex> run(m_runLock);
+
+  size_t band = PickBandHeight(height, width, rowAlign);
+  size_t bandCount = (height + band - 1) / band;
+  if (m_workers.empty() || bandCount <= 1) {
+    fn(0, height);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_fn = &fn;
+    m_height = height;
+    m_band = band;
+    m_bandCount = bandCount;
+    m_bandsLeft = bandCount;
+    m_nextBand.store(0, std::memory_order_relaxed);
+    ++m_generation;
+    ++m_active;  // the calling thread
+  }
+  m_wake.notify_all();
+  RunBands();
+
+  // Wait for every band and for every worker to leave the job, so none can
+  // touch `fn` (or claim bands of the next job) after we return.
+  std::unique_lock<std::mutex> lock(m_lock);
+  m_done.wait(lock, [this] { return m_bandsLeft == 0 && m_active == 0; });
+  m_fn = nullptr;
+}
+
+void ConvertEngine::Nv12ToRgb32(const uint8_t* src, uint8_t* dst, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix, YuvRange range) {
+  const uint8_t* uv = src + width * height;
+  const size_t uvStride = (width + 1) & ~static_cast<size_t>(1);
+  // Bands start on even rows so each band owns whole chroma rows.
+  ParallelRows(height, width, 2, [&](size_t begin, size_t end) {
+    simd_nv12_to_rgb32(src + begin * width, width, uv + (begin / 2) * uvStride, uvStride, dst + begin * width * 4, width * 4, width, end - begin, order, matrix, range);
+  });
+}
+
+void ConvertEngine::Yuv422ToRgb(const uint8_t* src, uint8_t* dst, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix, YuvRange range) {
+  const size_t srcStride = ((width + 1) & ~static_cast<size_t>(1)) * 2;
+  const size_t dstStride = width * (format == RgbFormat::BGR24 ? 3 : 4);
+  ParallelRows(height, width, 1, [&](size_t begin, size_t end) {
+    simd_yuv422_to_rgb(src + begin * srcStride, srcStride, dst + begin * dstStride, dstStride, width, end - begin, layout, format, matrix, range);
+  });
+}
+
+void ConvertEngine::Rgb32ToRgba(const uint8_t* src, uint8_t* dst, size_t width, size_t height) {
+  ParallelRows(height, width, 1, [&](size_t begin, size_t end) {
+    simd_rgb32_to_rgba(src + begin * width * 4, dst + begin * width * 4, (end - begin) * width);
+  });
+}
+
+void ConvertEngine::Rgb24ToRgba(const uint8_t* src, uint8_t* dst, size_t width, size_t height) {
+  ParallelRows(height, width, 1, [&](size_t begin, size_t end) {
+    simd_rgb24_to_rgba(src + begin * width * 3, dst + begin * width * 4, (end - begin) * width);
+  });
+}
+
+void ConvertEngine::Convert(FrameLayout from, const uint8_t* src, FrameLayout to, uint8_t* dst, size_t width, size_t height, YuvMatrix matrix, YuvRange range,
+                            size_t srcStride) {
+  const ConvertPlan& plan = PlanConversion(from, to);
+  // Even band starts keep 4:2:0 chroma rows whole, in or out.
+  ParallelRows(height, width, 2, [&](size_t begin, size_t end) {
+    RunConvertPlan(plan, from, src, to, dst, width, height, begin, end, matrix, range, srcStride);
+  });
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "convert.h"
+#include "convert_plan.h"
+
+// Splits a frame into horizontal row bands and converts them on a persistent
+// worker pool with the startup-selected SIMD kernels. The calling thread works
+// on bands too, so an engine with N threads owns N-1 workers. Workers are
+// created once and parked between frames; nothing is spawned per frame.
+//
+// Conversions are synchronous: each call returns once every band is written.
+// Calls on one engine are serialized, so an engine may be shared.
+class ConvertEngine {
+ public:
+  // Frames smaller than this per band are not worth a hand-off to a worker.
+  static constexpr size_t kMinBandPixels = 64 * 1024;
+
+  // `threads` = 0 uses one thread per hardware thread.
+  explicit ConvertEngine(size_t threads = 0, size_t bandHeight = 0);
+  ~ConvertEngine();
+
+  ConvertEngine(const ConvertEngine&) = delete;
+  ConvertEngine& operator=(const ConvertEngine&) = delete;
+
+  // Resize the pool (0 = one per hardware thread). Waits for a running frame.
+  void SetThreadCount(size_t threads);
+  size_t ThreadCount() const;
+  // Rows per band (0 = automatic: a few bands per thread, at least
+  // kMinBandPixels each). Rounded up to the format's row alignment.
+  void SetBandHeight(size_t rows);
+  size_t BandHeight() const;
+
+  // Run fn(rowBegin, rowEnd) over [0, height) in bands whose first row is a
+  // multiple of `rowAlign`. Blocks until all bands are done.
+  void ParallelRows(size_t height, size_t width, size_t rowAlign, const std::function<void(size_t, size_t)>& fn);
+
+  // Banded versions of the dispatched kernels (tightly packed buffers)
+  void Nv12ToRgb32(const uint8_t* src, uint8_t* dst, size_t width, size_t height, Rgb32Order order, YuvMatrix matrix = YuvMatrix::BT601, YuvRange range = YuvRange::Limited);
+  void Yuv422ToRgb(const uint8_t* src, uint8_t* dst, size_t width, size_t height, Yuv422Layout layout, RgbFormat format, YuvMatrix matrix = YuvMatrix::BT601, YuvRange range = YuvRange::Limited);
+  void Rgb32ToRgba(const uint8_t* src, uint8_t* dst, size_t width, size_t height);
+  void Rgb24ToRgba(const uint8_t* src, uint8_t* dst, size_t width, size_t height);
+  // Any layout to any other along the planner's cheapest path (PlanConversion).
+  // `srcStride` as for RunConvertPlan (0 = tightly packed source).
+  void Convert(FrameLayout from, const uint8_t* src, FrameLayout to, uint8_t* dst, size_t width, size_t height, YuvMatrix matrix = YuvMatrix::BT601,
+               YuvRange range = YuvRange::Limited, size_t srcStride = 0);
+
+ private:
+  void StartWorkers(size_t count);
+  void StopWorkers();
+  void WorkerLoop();
+  // Claim and convert bands of the current job until none are left.
+  void RunBands();
+  size_t PickBandHeight(size_t height, size_t width, size_t rowAlign) const;
+
+  std::mutex m_runLock;  // serializes callers and pool resizing
+  std::mutex m_lock;     // guards the job hand-off below
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  std::vector<std::thread> m_workers;
+  std::atomic<size_t> m_threads{1};
+  std::atomic<size_t> m_bandHeight{0};
+  bool m_stop = false;
+
+  // Current job; published under m_lock, bands claimed lock-free.
+  uint64_t m_generation = 0;
+  const std::function<void(size_t, size_t)>* m_fn = nullptr;
+  size_t m_height = 0;
+  size_t m_band = 0;
+  size_t m_bandCount = 0;
+  std::atomic<size_t> m_nextBand{0};
+  size_t m_bandsLeft = 0;  // guarded by m_lock
+  size_t m_active = 0;     // threads inside the current job, guarded by m_lock
+};
@@ -0,0 +1,467 @@
+#include "convert_plan.h"
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Layouts
+
+static bool is_rgb(FrameLayout l) {
+  return l == FrameLayout::BGRA || l == FrameLayout::RGBA || l == FrameLayout::BGR24;
+}
+
+static bool is_yuv420(FrameLayout l) {
+  return l == FrameLayout::NV12 || l == FrameLayout::I420;
+}
+
+static RgbFormat rgb_format(FrameLayout l) {
+  return l == FrameLayout::RGBA ? RgbFormat::RGBA : l == FrameLayout::BGRA ? RgbFormat::BGRA : RgbFormat::BGR24;
+}
+
+static Yuv422Layout yuv422_layout(FrameLayout l) {
+  return l == FrameLayout::UYVY ? Yuv422Layout::UYVY : Yuv422Layout::YUY2;
+}
+
+size_t FrameLayoutSize(FrameLayout layout, size_t width, size_t height) {
+  const size_t chromaW = (width + 1) / 2, chromaH = (height + 1) / 2;
+  switch (layout) {
+    case FrameLayout::BGRA:
+    case FrameLayout::RGBA:
+      return width * height * 4;
+    case FrameLayout::BGR24:
+      return width * height * 3;
+    case FrameLayout::NV12:
+    case FrameLayout::I420:
+      return width * height + chromaW * chromaH * 2;
+    case FrameLayout::YUY2:
+    case FrameLayout::UYVY:
+      return chromaW * 4 * height;
+  }
+  return 0;
+}
+
+const char* FrameLayoutName(FrameLayout layout) {
+  static const char* const kNames[] = {"bgra", "rgba", "bgr24", "nv12", "i420", "yuy2", "uyvy"};
+  return kNames[static_cast<size_t>(layout)];
+}
+
+// Plane pointers of a tightly packed frame, advanced to an even row. NV12
+// chroma is addressed as U at u[i * 2] and V at u[i * 2 + 1], I420 as two
+// planes, matching the uvStep convention of the 4:2:0 kernels.
+struct FramePlanes {
+  uint8_t* data = nullptr;  // RGB pixels, packed 4:2:2 words or luma
+  size_t stride = 0;
+  uint8_t* u = nullptr;
+  uint8_t* v = nullptr;
+  size_t strideUV = 0;
+  size_t uvStep = 0;
+};
+
+// Planes of `layout` at `row`. `stride` 0 = tightly packed; otherwise rows
+// of the first plane are `stride` bytes apart, NV12 chroma rows too and I420
+// chroma rows half as far (single-planar layout of padded capture buffers).
+static FramePlanes frame_planes(FrameLayout layout, const uint8_t* base, size_t width, size_t height, size_t row, size_t stride = 0) {
+  uint8_t* p = const_cast<uint8_t*>(base);
+  const size_t chromaW = (width + 1) / 2, chromaH = (height + 1) / 2;
+  FramePlanes f;
+  switch (layout) {
+    case FrameLayout::BGRA:
+    case FrameLayout::RGBA:
+    case FrameLayout::BGR24:
+      f.stride = stride ? stride : width * (layout == FrameLayout::BGR24 ? 3 : 4);
+      f.data = p + row * f.stride;
+      break;
+    case FrameLayout::YUY2:
+    case FrameLayout::UYVY:
+      f.stride = stride ? stride : chromaW * 4;
+      f.data = p + row * f.stride;
+      break;
+    case FrameLayout::NV12:
+      f.stride = stride ? stride : width;
+      f.data = p + row * f.stride;
+      f.strideUV = stride ? stride : chromaW * 2;
+      f.uvStep = 2;
+      f.u = p + f.stride * height + (row / 2) * f.strideUV;
+      f.v = f.u + 1;
+      break;
+    case FrameLayout::I420:
+      f.stride = stride ? stride : width;
+      f.data = p + row * f.stride;
+      f.strideUV = stride ? stride / 2 : chromaW;
+      f.uvStep = 1;
+      f.u = p + f.stride * height + (row / 2) * f.strideUV;
+      f.v = f.u + f.strideUV * chromaH;
+      break;
+  }
+  return f;
+}
+
+// ---------------------------------------------------------------------------
+// Cost model
+//
+// A step costs the bytes it reads and writes per pixel plus its arithmetic,
+// scaled by how well the active variant is vectorized. Chains pay for every
+// intermediate, so they only win where a direct kernel is scalar at the
+// active tier (e.g. I420 -> BGR24 at SSE2 interleaves to NV12, runs the SSE2
+// NV12 kernel and repacks). Chains are also restricted to ones that produce
+// exactly the direct kernel's output, so the ISA tier never changes pixels:
+// at most one step may change sample values (colour conversion or 4:2:2 ->
+// 4:2:0 averaging), and no intermediate may hold less chroma than the lower
+// of the two end layouts.
+
+static double layout_bytes_per_pixel(FrameLayout l) {
+  switch (l) {
+    case FrameLayout::BGRA:
+    case FrameLayout::RGBA:
+      return 4;
+    case FrameLayout::BGR24:
+      return 3;
+    case FrameLayout::NV12:
+    case FrameLayout::I420:
+      return 1.5;
+    case FrameLayout::YUY2:
+    case FrameLayout::UYVY:
+      return 2;
+  }
+  return 4;
+}
+
+// Arithmetic per pixel relative to a vectorized byte shuffle
+static double kernel_work(ConvertStepKernel k) {
+  switch (k) {
+    case ConvertStepKernel::RgbToYuv420:
+    case ConvertStepKernel::RgbToYuv422:
+    case ConvertStepKernel::Nv12ToRgb32:
+    case ConvertStepKernel::Yuv420ToRgb:
+    case ConvertStepKernel::Yuv422ToRgb:
+      return 3;
+    case ConvertStepKernel::RgbRepack:
+      return 0.5;
+    case ConvertStepKernel::Copy:
+      return 0;
+    default:
+      return 0.25;
+  }
+}
+
+static double variant_factor(const char* name) {
+  if (std::strcmp(name, "avx512") == 0) return 0.6;
+  if (std::strcmp(name, "avx2") == 0) return 1;
+  if (std::strcmp(name, "ssse3") == 0 || std::strcmp(name, "sse2") == 0) return 2;
+  return 8;  // baseline / scalar
+}
+
+// Chroma samples per 2x2 pixels: 4:4:4 RGB, 4:2:2 or 4:2:0
+static int chroma_resolution(FrameLayout l) {
+  return is_rgb(l) ? 4 : is_yuv420(l) ? 1 : 2;
+}
+
+// Colour conversion and chroma averaging round; the other kernels only move
+// or duplicate samples.
+static bool changes_samples(ConvertStepKernel k) {
+  switch (k) {
+    case ConvertStepKernel::RgbToYuv420:
+    case ConvertStepKernel::RgbToYuv422:
+    case ConvertStepKernel::Nv12ToRgb32:
+    case ConvertStepKernel::Yuv420ToRgb:
+    case ConvertStepKernel::Yuv422ToRgb:
+    case ConvertStepKernel::Yuv422ToYuv420:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Whether a chain through `steps` reproduces the direct conversion exactly
+static bool chain_is_exact(const ConvertStep* steps, size_t count) {
+  const FrameLayout from = steps[0].from, to = steps[count - 1].to;
+  const int floor = chroma_resolution(from) < chroma_resolution(to) ? chroma_resolution(from) : chroma_resolution(to);
+  size_t lossy = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (changes_samples(steps[i].kernel)) ++lossy;
+    if (i + 1 < count && chroma_resolution(steps[i].to) < floor) return false;
+  }
+  return lossy <= 1;
+}
+
+static const char* kernel_family(ConvertStepKernel k) {
+  static const char* const kFamilies[] = {"memcpy",         "rgbRepack",      "rgbToYuv420",  "rgbToYuv422",    "nv12ToRgb32", "yuv420ToRgb",
+                                          "yuv422ToRgb",    "yuv420ToYuv422", "yuv422ToYuv420", "uvInterleave", "uvDeinterleave", "yuv422Swap"};
+  return kFamilies[static_cast<size_t>(k)];
+}
+
+static const char* kernel_variant(const ConvertKernels& t, ConvertStepKernel k) {
+  switch (k) {
+    case ConvertStepKernel::Copy:
+      return "memcpy";
+    case ConvertStepKernel::RgbRepack:
+      return t.rgbRepackName;
+    case ConvertStepKernel::RgbToYuv420:
+      return t.rgbToYuv420Name;
+    case ConvertStepKernel::RgbToYuv422:
+      return t.rgbToYuv422Name;
+    case ConvertStepKernel::Nv12ToRgb32:
+      return t.nv12ToRgb32Name;
+    case ConvertStepKernel::Yuv420ToRgb:
+      return t.yuv420ToRgbName;
+    case ConvertStepKernel::Yuv422ToRgb:
+      return t.yuv422ToRgbName;
+    case ConvertStepKernel::Yuv420ToYuv422:
+      return t.yuv420ToYuv422Name;
+    case ConvertStepKernel::Yuv422ToYuv420:
+      return t.yuv422ToYuv420Name;
+    case ConvertStepKernel::UvInterleave:
+      return t.uvInterleaveName;
+    case ConvertStepKernel::UvDeinterleave:
+      return t.uvDeinterleaveName;
+    case ConvertStepKernel::Yuv422Swap:
+      return t.yuv422SwapName;
+  }
+  return "baseline";
+}
+
+// Single-pass kernels for from -> to, preferred first on equal cost. Every
+// pair of distinct layouts has at least one.
+static size_t direct_kernels(FrameLayout from, FrameLayout to, ConvertStepKernel out[2]) {
+  if (from == to) return 0;
+  if (is_rgb(from)) {
+    out[0] = is_rgb(to) ? ConvertStepKernel::RgbRepack : is_yuv420(to) ? ConvertStepKernel::RgbToYuv420 : ConvertStepKernel::RgbToYuv422;
+    return 1;
+  }
+  if (is_yuv420(from)) {
+    if (is_rgb(to)) {
+      // The NV12 kernel has an AVX-512 variant
+      if (from == FrameLayout::NV12 && to != FrameLayout::BGR24) {
+        out[0] = ConvertStepKernel::Nv12ToRgb32;
+        out[1] = ConvertStepKernel::Yuv420ToRgb;
+        return 2;
+      }
+      out[0] = ConvertStepKernel::Yuv420ToRgb;
+    } else if (is_yuv420(to)) {
+      out[0] = from == FrameLayout::NV12 ? ConvertStepKernel::UvDeinterleave : ConvertStepKernel::UvInterleave;
+    } else {
+      out[0] = ConvertStepKernel::Yuv420ToYuv422;
+    }
+    return 1;
+  }
+  out[0] = is_rgb(to) ? ConvertStepKernel::Yuv422ToRgb : is_yuv420(to) ? ConvertStepKernel::Yuv422ToYuv420 : ConvertStepKernel::Yuv422Swap;
+  return 1;
+}
+
+static double step_cost(const ConvertKernels& t, FrameLayout from, FrameLayout to, ConvertStepKernel k) {
+  return layout_bytes_per_pixel(from) + layout_bytes_per_pixel(to) + kernel_work(k) * variant_factor(kernel_variant(t, k));
+}
+
+static const size_t kIsaTierCount = static_cast<size_t>(ConvertIsa::AVX512) + 1;
+
+struct PlanCache {
+  std::once_flag built[kIsaTierCount];
+  ConvertPlan plans[kIsaTierCount][kFrameLayoutCount][kFrameLayoutCount];
+};
+
+static PlanCache& plan_cache() {
+  static PlanCache cache;
+  return cache;
+}
+
+// Shortest path of up to 3 steps over the cheapest direct edge of every pair
+static void build_plans(const ConvertKernels& t, ConvertPlan (*plans)[kFrameLayoutCount]) {
+  const size_t n = kFrameLayoutCount;
+  ConvertStep edge[kFrameLayoutCount][kFrameLayoutCount];
+  double cost[kFrameLayoutCount][kFrameLayoutCount];
+  for (size_t a = 0; a < n; ++a) {
+    for (size_t b = 0; b < n; ++b) {
+      const FrameLayout from = static_cast<FrameLayout>(a), to = static_cast<FrameLayout>(b);
+      ConvertStepKernel candidates[2];
+      const size_t count = direct_kernels(from, to, candidates);
+      cost[a][b] = 0;
+      for (size_t i = 0; i < count; ++i) {
+        const double c = step_cost(t, from, to, candidates[i]);
+        if (i == 0 || c < cost[a][b]) {
+          cost[a][b] = c;
+          edge[a][b] = {from, to, candidates[i]};
+        }
+      }
+    }
+  }
+  for (size_t a = 0; a < n; ++a) {
+    for (size_t b = 0; b < n; ++b) {
+      ConvertPlan& p = plans[a][b];
+      p = ConvertPlan();
+      if (a == b) {
+        p.stepCount = 1;
+        p.steps[0] = {static_cast<FrameLayout>(a), static_cast<FrameLayout>(b), ConvertStepKernel::Copy};
+        p.cost = 2 * layout_bytes_per_pixel(static_cast<FrameLayout>(a));
+        continue;
+      }
+      p.stepCount = 1;
+      p.steps[0] = edge[a][b];
+      p.cost = cost[a][b];
+      for (size_t m = 0; m < n; ++m) {
+        if (m == a || m == b) continue;
+        const ConvertStep two[2] = {edge[a][m], edge[m][b]};
+        if (cost[a][m] + cost[m][b] < p.cost && chain_is_exact(two, 2)) {
+          p.stepCount = 2;
+          p.steps[0] = two[0];
+          p.steps[1] = two[1];
+          p.cost = cost[a][m] + cost[m][b];
+        }
+        for (size_t m2 = 0; m2 < n; ++m2) {
+          if (m2 == a || m2 == b || m2 == m) continue;
+          const ConvertStep three[3] = {edge[a][m], edge[m][m2], edge[m2][b]};
+          const double c = cost[a][m] + cost[m][m2] + cost[m2][b];
+          if (c < p.cost && chain_is_exact(three, 3)) {
+            p.stepCount = 3;
+            for (size_t i = 0; i < 3; ++i) p.steps[i] = three[i];
+            p.cost = c;
+          }
+        }
+      }
+    }
+  }
+}
+
+const ConvertPlan& PlanConversion(FrameLayout from, FrameLayout to) {
+  const ConvertKernels& t = convert_kernels();
+  const size_t tier = static_cast<size_t>(t.isa);
+  PlanCache& cache = plan_cache();
+  std::call_once(cache.built[tier], [&] { build_plans(t, cache.plans[tier]); });
+  return cache.plans[tier][static_cast<size_t>(from)][static_cast<size_t>(to)];
+}
+
+std::string DescribeConvertPlan(FrameLayout from, const ConvertPlan& plan) {
+  const ConvertKernels& t = convert_kernels();
+  std::string s = FrameLayoutName(from);
+  for (size_t i = 0; i < plan.stepCount; ++i) {
+    const ConvertStep& step = plan.steps[i];
+    s += " -> ";
+    s += FrameLayoutName(step.to);
+    s += " (";
+    s += kernel_family(step.kernel);
+    if (step.kernel != ConvertStepKernel::Copy) {
+      s += '/';
+      s += kernel_variant(t, step.kernel);
+    }
+    s += ')';
+  }
+  return s;
+}
+
+// ---------------------------------------------------------------------------
+// Execution
+
+// `rows` rows from `s` (layout `from`) to `d` (layout `to`), both positioned
+// at the same even row of frames `width` wide.
+static void run_step(const ConvertStep& step, const FramePlanes& s, const FramePlanes& d, size_t width, size_t rows, YuvMatrix matrix, YuvRange range) {
+  const size_t chromaW = (width + 1) / 2, chromaRows = (rows + 1) / 2;
+  // Kernels without stride arguments run once over contiguous rows, or row
+  // by row when the source is padded (the destination never is)
+  const FramePlanes packed = frame_planes(step.from, s.data, width, rows, 0);
+  const bool tight = s.stride == packed.stride;
+  const bool tightUV = s.strideUV == packed.strideUV;
+  auto copyRows = [](const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t rowBytes, size_t n) {
+    if (srcStride == dstStride && rowBytes == dstStride) {
+      std::memcpy(dst, src, rowBytes * n);
+      return;
+    }
+    for (size_t r = 0; r < n; ++r) std::memcpy(dst + r * dstStride, src + r * srcStride, rowBytes);
+  };
+  switch (step.kernel) {
+    case ConvertStepKernel::Copy:
+      copyRows(s.data, s.stride, d.data, d.stride, d.stride, rows);
+      if (is_yuv420(step.from)) {
+        copyRows(s.u, s.strideUV, d.u, d.strideUV, d.strideUV, chromaRows);
+        if (s.uvStep == 1) copyRows(s.v, s.strideUV, d.v, d.strideUV, d.strideUV, chromaRows);
+      }
+      break;
+    case ConvertStepKernel::RgbRepack:
+      if (tight) {
+        simd_rgb_repack(s.data, rgb_format(step.from), d.data, rgb_format(step.to), width * rows);
+      } else {
+        for (size_t r = 0; r < rows; ++r) simd_rgb_repack(s.data + r * s.stride, rgb_format(step.from), d.data + r * d.stride, rgb_format(step.to), width);
+      }
+      break;
+    case ConvertStepKernel::RgbToYuv420:
+      simd_rgb_to_yuv420(s.data, s.stride, rgb_format(step.from), d.data, d.stride, d.u, d.v, d.strideUV, d.uvStep, width, rows, matrix, range);
+      break;
+    case ConvertStepKernel::RgbToYuv422:
+      simd_rgb_to_yuv422(s.data, s.stride, rgb_format(step.from), d.data, d.stride, width, rows, yuv422_layout(step.to), matrix, range);
+      break;
+    case ConvertStepKernel::Nv12ToRgb32:
+      simd_nv12_to_rgb32(s.data, s.stride, s.u, s.strideUV, d.data, d.stride, width, rows, step.to == FrameLayout::RGBA ? Rgb32Order::RGBA : Rgb32Order::BGRA,
+                         matrix, range);
+      break;
+    case ConvertStepKernel::Yuv420ToRgb:
+      simd_yuv420_to_rgb(s.data, s.stride, s.u, s.v, s.strideUV, s.uvStep, d.data, d.stride, width, rows, rgb_format(step.to), matrix, range);
+      break;
+    case ConvertStepKernel::Yuv422ToRgb:
+      simd_yuv422_to_rgb(s.data, s.stride, d.data, d.stride, width, rows, yuv422_layout(step.from), rgb_format(step.to), matrix, range);
+      break;
+    case ConvertStepKernel::Yuv420ToYuv422:
+      simd_yuv420_to_yuv422(s.data, s.stride, s.u, s.v, s.strideUV, s.uvStep, d.data, d.stride, width, rows, yuv422_layout(step.to));
+      break;
+    case ConvertStepKernel::Yuv422ToYuv420:
+      simd_yuv422_to_yuv420(s.data, s.stride, d.data, d.stride, d.u, d.v, d.strideUV, d.uvStep, width, rows, yuv422_layout(step.from));
+      break;
+    case ConvertStepKernel::UvInterleave:
+      copyRows(s.data, s.stride, d.data, d.stride, width, rows);
+      if (tightUV) {
+        simd_uv_interleave(s.u, s.v, d.u, chromaW * chromaRows);
+      } else {
+        for (size_t r = 0; r < chromaRows; ++r) simd_uv_interleave(s.u + r * s.strideUV, s.v + r * s.strideUV, d.u + r * d.strideUV, chromaW);
+      }
+      break;
+    case ConvertStepKernel::UvDeinterleave:
+      copyRows(s.data, s.stride, d.data, d.stride, width, rows);
+      if (tightUV) {
+        simd_uv_deinterleave(s.u, d.u, d.v, chromaW * chromaRows);
+      } else {
+        for (size_t r = 0; r < chromaRows; ++r) simd_uv_deinterleave(s.u + r * s.strideUV, d.u + r * d.strideUV, d.v + r * d.strideUV, chromaW);
+      }
+      break;
+    case ConvertStepKernel::Yuv422Swap:
+      if (tight) {
+        simd_yuv422_swap(s.data, d.data, chromaW * rows);
+      } else {
+        for (size_t r = 0; r < rows; ++r) simd_yuv422_swap(s.data + r * s.stride, d.data + r * d.stride, chromaW);
+      }
+      break;
+  }
+}
+
+// Rows per strip of a multi-step plan: even, and small enough that the
+// intermediates of a 4K row strip stay in L2.
+static const size_t kStripRows = 16;
+
+void RunConvertPlan(const ConvertPlan& plan, FrameLayout from, const uint8_t* src, FrameLayout to, uint8_t* dst, size_t width, size_t height,
+                    size_t rowBegin, size_t rowEnd, YuvMatrix matrix, YuvRange range, size_t srcStride) {
+  if (rowBegin >= rowEnd || plan.stepCount == 0) return;
+  if (plan.stepCount == 1) {
+    run_step(plan.steps[0], frame_planes(from, src, width, height, rowBegin, srcStride), frame_planes(to, dst, width, height, rowBegin), width,
+             rowEnd - rowBegin, matrix, range);
+    return;
+  }
+
+  // Intermediates are strip-sized frames of their own; strips start on even
+  // rows, so their chroma rows line up with the frame's.
+  thread_local std::vector<uint8_t> scratch[2];
+  for (size_t row = rowBegin; row < rowEnd; row += kStripRows) {
+    const size_t rows = rowEnd - row < kStripRows ? rowEnd - row : kStripRows;
+    FramePlanes in = frame_planes(from, src, width, height, row, srcStride);
+    for (size_t i = 0; i < plan.stepCount; ++i) {
+      const ConvertStep& step = plan.steps[i];
+      FramePlanes out;
+      if (i + 1 == plan.stepCount) {
+        out = frame_planes(to, dst, width, height, row);
+      } else {
+        std::vector<uint8_t>& buf = scratch[i & 1];
+        const size_t bytes = FrameLayoutSize(step.to, width, rows);
+        if (buf.size() < bytes) buf.resize(bytes);
+        out = frame_planes(step.to, buf.data(), width, rows, 0);
+      }
+      run_step(step, in, out, width, rows, matrix, range);
+      in = out;
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#include "convert.h"
+
+// Tightly packed frame layouts the conversion planner connects, sized as the
+// capture backends deliver them: NV12/I420 chroma planes are (width + 1) / 2
+// samples wide and (height + 1) / 2 rows, YUY2/UYVY rows cover an even width.
+enum class FrameLayout { BGRA, RGBA, BGR24, NV12, I420, YUY2, UYVY };
+const size_t kFrameLayoutCount = 7;
+
+// Bytes of one width x height frame
+size_t FrameLayoutSize(FrameLayout layout, size_t width, size_t height);
+// Lower-case name ("bgra", "nv12", ...)
+const char* FrameLayoutName(FrameLayout layout);
+
+// Dispatched kernel families a plan step can run
+enum class ConvertStepKernel {
+  Copy,
+  RgbRepack,
+  RgbToYuv420,
+  RgbToYuv422,
+  Nv12ToRgb32,
+  Yuv420ToRgb,
+  Yuv422ToRgb,
+  Yuv420ToYuv422,
+  Yuv422ToYuv420,
+  UvInterleave,
+  UvDeinterleave,
+  Yuv422Swap
+};
+
+struct ConvertStep {
+  FrameLayout from;
+  FrameLayout to;
+  ConvertStepKernel kernel;
+};
+
+// Path from one layout to another: a single direct kernel for every pair, or
+// up to three steps when the direct kernel has no SIMD variant at the active
+// ISA tier and a chain of vectorized ones is estimated to be cheaper. A chain
+// always produces exactly the direct kernel's output.
+struct ConvertPlan {
+  size_t stepCount = 0;  // 1..3; from == to is a single Copy step
+  ConvertStep steps[3];
+  double cost = 0;  // estimated cost per pixel, in bytes moved
+};
+
+// Cheapest plan under the active kernel table; computed once per ISA tier.
+const ConvertPlan& PlanConversion(FrameLayout from, FrameLayout to);
+
+// "yuy2 -> nv12 (yuv422ToYuv420/sse2) -> bgra (nv12ToRgb32/sse2)"
+std::string DescribeConvertPlan(FrameLayout from, const ConvertPlan& plan);
+
+// Run `plan` over rows [rowBegin, rowEnd) of a width x height frame;
+// `rowBegin` must be even so 4:2:0 chroma rows are not split. Multi-step
+// plans go through per-thread scratch a few rows at a time, so intermediates
+// stay in cache. Bands may run concurrently on disjoint rows.
+//
+// `srcStride` 0 reads a tightly packed source. Otherwise the source rows are
+// `srcStride` bytes apart in the single-planar layout of padded capture
+// buffers: NV12 chroma rows at the same stride after the luma plane, I420 U
+// and V planes at half of it. The destination is always tightly packed.
+void RunConvertPlan(const ConvertPlan& plan, FrameLayout from, const uint8_t* src, FrameLayout to, uint8_t* dst, size_t width, size_t height,
+                    size_t rowBegin, size_t rowEnd, YuvMatrix matrix, YuvRange range, size_t srcStride = 0);
@@ -0,0 +1,79 @@
+#include "cpu_features.h"
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static void query_cpuid(int leaf, int subleaf, int regs[4]) {
+  __cpuidex(regs, leaf, subleaf);
+}
+
+static uint64_t read_xcr0() {
+  return _xgetbv(0);
+}
+#else
+#include <cpuid.h>
+
+static void query_cpuid(int leaf, int subleaf, int regs[4]) {
+  unsigned int a = 0, b = 0, c = 0, d = 0;
+  __cpuid_count(leaf, subleaf, a, b, c, d);
+  regs[0] = static_cast<int>(a);
+  regs[1] = static_cast<int>(b);
+  regs[2] = static_cast<int>(c);
+  regs[3] = static_cast<int>(d);
+}
+
+static uint64_t read_xcr0() {
+  // Encoded xgetbv so no -mxsave is needed
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+#endif
+
+static CpuFeatures detect_cpu_features() {
+  CpuFeatures f;
+  int regs[4] = {0};
+  query_cpuid(0, 0, regs);
+  const int maxLeaf = regs[0];
+  if (maxLeaf < 1) return f;
+
+  query_cpuid(1, 0, regs);
+  const int ecx1 = regs[2], edx1 = regs[3];
+  f.sse2 = (edx1 & (1 << 26)) != 0;   // EDX bit 26 = SSE2
+  f.sse3 = (ecx1 & (1 << 0)) != 0;    // ECX bit 0 = SSE3
+  f.ssse3 = (ecx1 & (1 << 9)) != 0;   // ECX bit 9 = SSSE3
+  f.sse41 = (ecx1 & (1 << 19)) != 0;  // ECX bit 19 = SSE4.1
+
+  // YMM/ZMM state must be enabled by the OS (OSXSAVE, then XCR0) before any
+  // AVX instruction may execute, whatever CPUID advertises.
+  uint64_t xcr0 = (ecx1 & (1 << 27)) ? read_xcr0() : 0;  // ECX bit 27 = OSXSAVE
+  const bool osYmm = (xcr0 & 0x06) == 0x06;              // XMM | YMM
+  const bool osZmm = (xcr0 & 0xE6) == 0xE6;              // + opmask, ZMM_Hi256, Hi16_ZMM
+  f.avx = osYmm && (ecx1 & (1 << 28)) != 0;              // ECX bit 28 = AVX
+
+  if (maxLeaf >= 7) {
+    query_cpuid(7, 0, regs);
+    const int ebx7 = regs[1];
+    f.avx2 = f.avx && (ebx7 & (1 << 5)) != 0;  // EBX bit 5 = AVX2
+    f.bmi2 = (ebx7 & (1 << 8)) != 0;           // EBX bit 8 = BMI2
+    // EBX bit 16 = AVX512F, bit 30 = AVX512BW
+    f.avx512bw = f.avx2 && osZmm && (ebx7 & (1 << 16)) != 0 && (ebx7 & (1 << 30)) != 0;
+  }
+  return f;
+}
+
+const CpuFeatures& cpu_features() {
+  static const CpuFeatures features = detect_cpu_features();
+  return features;
+}
+
+bool cpu_has_avx2() { return cpu_features().avx2; }
+bool cpu_has_ssse3() { return cpu_features().ssse3; }
+bool cpu_has_sse2() { return cpu_features().sse2; }
+bool cpu_has_sse3() { return cpu_features().sse3; }
+bool cpu_has_sse41() { return cpu_features().sse41; }
+bool cpu_has_avx() { return cpu_features().avx; }
+bool cpu_has_bmi2() { return cpu_features().bmi2; }
+bool cpu_has_avx512bw() { return cpu_features().avx512bw; }
@@ -0,0 +1,40 @@
+#pragma once
+
+// x86 CPU features relevant to the conversion kernels. Detected once (CPUID
+// plus XGETBV for OS-enabled register state) and cached for the process.
+struct CpuFeatures {
+  bool sse2 = false;
+  bool sse3 = false;
+  bool ssse3 = false;
+  bool sse41 = false;
+  bool avx = false;       // AVX with OS support for YMM state
+  bool avx2 = false;      // AVX2 with OS support for YMM state
+  bool bmi2 = false;
+  bool avx512bw = false;  // AVX-512 F+BW with OS support for ZMM state
+};
+
+const CpuFeatures& cpu_features();
+
+// CPU feature queries (cached; no CPUID per call)
+bool cpu_has_avx2();
+bool cpu_has_ssse3();
+bool cpu_has_sse2();
+bool cpu_has_sse3();
+bool cpu_has_sse41();
+bool cpu_has_avx();
+bool cpu_has_bmi2();
+bool cpu_has_avx512bw();
+
+// Per-function instruction set targets. MSVC compiles any intrinsic anywhere;
+// GCC/Clang need the ISA enabled on each function that uses it (including the
+// inline helpers it calls) so one translation unit can hold every variant
+// without raising the baseline ISA of the whole library.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512BW __attribute__((target("avx2,avx512f,avx512bw")))
+#else
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#define TARGET_AVX512BW
+#endif
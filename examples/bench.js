@@ -1,5 +1,10 @@
-const bindings = require('bindings');
-const native = bindings('addon.node');
+// The addon is loaded on first use so `diff` also works where it is not built
+// (e.g. comparing convert_bench JSON reports on a headless Linux runner).
+let native = null;
+function loadNative() {
+  if (!native) native = require('bindings')('addon.node');
+  return native;
+}
 
 // Single bench runner that calls both native benchmarks and prints a merged result.
 function runAllBench(width, height, testConfigs = [{ iters: 50, repeat: 5 }]) {
@@ -11,6 +16,7 @@ function runAllBench(width, height, testConfigs = [{ iters: 50, repeat: 5 }]) {
     const iters = cfg.iters || 50;
     const repeat = cfg.repeat || 5;
     console.log(`Running benchmark ${width}x${height} (${iters} iters x ${repeat} repeats)`);
+    const native = loadNative();
 
     if (typeof native.runRgb32Bench !== 'function') {
       console.error('native.runRgb32Bench is not available');
@@ -37,6 +43,23 @@ function runAllBench(width, height, testConfigs = [{ iters: 50, repeat: 5 }]) {
   merged.rgb24_baseline_ms = rgbRes.rgb24_baseline_ms;
   merged.rgb24_optimized_ms = rgbRes.rgb24_optimized_ms;
   merged.rgb24_simd_ms = rgbRes.rgb24_simd_ms;
+  merged.rgb24_kernel = rgbRes.rgb24_kernel;
+  merged.rgb24_exact = rgbRes.rgb24_exact;
+  // NV12 -> RGBA timings (-1 when a variant is unsupported on this CPU)
+  merged.nv12_baseline_ms = rgbRes.nv12_baseline_ms;
+  merged.nv12_sse2_ms = rgbRes.nv12_sse2_ms;
+  merged.nv12_avx2_ms = rgbRes.nv12_avx2_ms;
+  merged.nv12_avx512_ms = rgbRes.nv12_avx512_ms;
+  merged.nv12_simd_ms = rgbRes.nv12_simd_ms;
+  merged.nv12_kernel = rgbRes.nv12_kernel;
+  merged.nv12_exact = rgbRes.nv12_exact;
+  // YUY2 -> BGR24 timings (-1 when a variant is unsupported on this CPU)
+  merged.yuy2_baseline_ms = rgbRes.yuy2_baseline_ms;
+  merged.yuy2_ssse3_ms = rgbRes.yuy2_ssse3_ms;
+  merged.yuy2_avx2_ms = rgbRes.yuy2_avx2_ms;
+  merged.yuy2_simd_ms = rgbRes.yuy2_simd_ms;
+  merged.yuy2_kernel = rgbRes.yuy2_kernel;
+  merged.yuy2_exact = rgbRes.yuy2_exact;
 
     results.push(merged);
     completed += 1;
@@ -47,13 +70,90 @@ function runAllBench(width, height, testConfigs = [{ iters: 50, repeat: 5 }]) {
   return results;
 }
 
+// Thread scaling of the banded conversion engine (1..maxThreads threads)
+function runScalingBench(width, height, iters, repeat, maxThreads, bandHeight) {
+  const native = loadNative();
+  if (typeof native.runConvertScalingBench !== 'function') {
+    console.error('native.runConvertScalingBench is not available');
+    return;
+  }
+  console.log(`Running conversion scaling ${width}x${height} (${iters} iters x ${repeat} repeats)`);
+  const rows = native.runConvertScalingBench(width, height, iters, repeat, maxThreads, bandHeight);
+  const one = rows[0] || {};
+  console.log('\nthreads | nv12_ms   | nv12_x | yuy2_ms   | yuy2_x');
+  console.log('--------|-----------|--------|-----------|-------');
+  for (const r of rows) {
+    const nv12x = one.nv12_ms > 0 ? (one.nv12_ms / r.nv12_ms).toFixed(2) : '';
+    const yuy2x = one.yuy2_ms > 0 ? (one.yuy2_ms / r.yuy2_ms).toFixed(2) : '';
+    console.log(`${String(r.threads).padEnd(7)} | ${r.nv12_ms.toFixed(4).padEnd(9)} | ${nv12x.padEnd(6)} | ${r.yuy2_ms.toFixed(4).padEnd(9)} | ${yuy2x}`);
+  }
+}
+
+// Compare two convert_bench --json reports on median_ms. Returns the number of
+// measurements that got slower than `threshold` percent.
+function diffReports(basePath, currentPath, threshold) {
+  const fs = require('fs');
+  const load = (p) => JSON.parse(fs.readFileSync(p, 'utf8'));
+  const base = load(basePath);
+  const current = load(currentPath);
+  const key = (r) => `${r.case} ${r.width}x${r.height} ${r.aligned ? 'aligned' : 'unaligned'} ${r.cache}`;
+  const baseByKey = new Map(base.results.map((r) => [key(r), r]));
+
+  if (base.isa !== current.isa) {
+    console.log(`note: kernel tier differs (baseline ${base.isa}, current ${current.isa})`);
+  }
+  const regressions = [];
+  const improvements = [];
+  let compared = 0;
+  for (const r of current.results) {
+    const b = baseByKey.get(key(r));
+    if (!b || !(b.median_ms > 0)) continue;
+    compared += 1;
+    const change = ((r.median_ms - b.median_ms) / b.median_ms) * 100.0;
+    const row = [key(r), b.median_ms.toFixed(4), r.median_ms.toFixed(4), (change >= 0 ? '+' : '') + change.toFixed(1) + '%'];
+    if (change > threshold) regressions.push(row);
+    else if (change < -threshold) improvements.push(row);
+  }
+
+  const print = (title, rows) => {
+    if (rows.length === 0) return;
+    const headers = ['measurement', 'base_ms', 'cur_ms', 'change'];
+    const widths = headers.map((h, i) => Math.max(h.length, ...rows.map((r) => r[i].length)));
+    console.log(`\n${title}`);
+    console.log(headers.map((h, i) => h.padEnd(widths[i])).join(' | '));
+    console.log(widths.map((w) => '-'.repeat(w)).join('-|-'));
+    for (const row of rows) console.log(row.map((c, i) => c.padEnd(widths[i])).join(' | '));
+  };
+  print(`Regressions (> ${threshold}% slower):`, regressions);
+  print(`Improvements (> ${threshold}% faster):`, improvements);
+  console.log(`\n${compared} measurements compared, ${regressions.length} regressions, ${improvements.length} improvements`);
+  return regressions.length;
+}
+
 // CLI: node bench.js [width height [iters repeat]] | all
+//      node bench.js scaling [width height [iters repeat [maxThreads [bandHeight]]]]
+//      node bench.js diff baseline.json current.json [thresholdPercent]
 const args = process.argv.slice(2);
 const presets = [ [640,480], [1280,720], [1920,1080] ];
 const defaultTestConfigs = [{ iters: 50, repeat: 5 }, { iters: 200, repeat: 3 }];
 
 // Run all and aggregate results
 async function main() {
+  if (args[0] === 'diff') {
+    if (args.length < 3) {
+      console.error('usage: node bench.js diff baseline.json current.json [thresholdPercent]');
+      process.exitCode = 2;
+      return;
+    }
+    const threshold = args.length > 3 ? parseFloat(args[3]) : 5;
+    if (diffReports(args[1], args[2], threshold) > 0) process.exitCode = 1;
+    return;
+  }
+  if (args[0] === 'scaling') {
+    const num = (i, d) => (args.length > i ? parseInt(args[i], 10) : d);
+    runScalingBench(num(1, 3840), num(2, 2160), num(3, 20), num(4, 3), num(5, require('os').cpus().length), num(6, 0));
+    return;
+  }
   const aggregate = [];
 
   const runSizes = (args.length === 0 || args[0] === 'all') ? presets : [[parseInt(args[0],10), parseInt(args[1],10)]];
@@ -77,7 +177,7 @@ async function main() {
     // CPU feature summary: take from first result's cpu object
     const cpu = aggregate[0].cpu || {};
     console.log('\nCPU features:');
-    const cpuFlags = [ 'avx2', 'ssse3', 'sse2', 'sse3', 'sse4_1', 'avx', 'bmi2' ];
+    const cpuFlags = [ 'avx2', 'ssse3', 'sse2', 'sse3', 'sse4_1', 'avx', 'bmi2', 'avx512bw' ];
     for (const f of cpuFlags) {
       console.log(`  ${f}: ${cpu[f] ? 'yes' : 'no'}`);
     }
@@ -103,7 +203,7 @@ async function main() {
     });
 
     // --- RGB24 table (baseline | optimized) ---
-  const headers24 = ['size', 'iters', 'repeat', 'base_ms', 'opt_ms', 'simd_ms', 'opt%', 'simd%'];
+  const headers24 = ['size', 'iters', 'repeat', 'base_ms', 'opt_ms', 'simd_ms', 'opt%', 'simd%', 'kernel', 'exact'];
     const rows24 = aggregate.map(r => {
       const base24 = Number.isFinite(r.rgb24_baseline_ms) ? r.rgb24_baseline_ms : NaN;
       const opt24 = Number.isFinite(r.rgb24_optimized_ms) ? r.rgb24_optimized_ms : NaN;
@@ -118,10 +218,42 @@ async function main() {
         Number.isFinite(opt24) ? opt24.toFixed(4) : '',
         Number.isFinite(simd24) ? simd24.toFixed(4) : '',
         Number.isFinite(opt24Boost) ? opt24Boost.toFixed(2) + '%' : '',
-        Number.isFinite(simd24Boost) ? simd24Boost.toFixed(2) + '%' : ''
+        Number.isFinite(simd24Boost) ? simd24Boost.toFixed(2) + '%' : '',
+        String(r.rgb24_kernel || ''),
+        r.rgb24_exact === undefined ? '' : (r.rgb24_exact ? 'yes' : 'NO')
       ];
     });
 
+    // --- NV12 -> RGBA table (baseline | sse2 | avx2 | avx512 | dispatched) ---
+    const headersNv12 = ['size', 'iters', 'repeat', 'base_ms', 'sse2_ms', 'avx2_ms', 'avx512_ms', 'simd_ms', 'kernel', 'exact'];
+    const fmtMs = (v) => (Number.isFinite(v) && v >= 0) ? v.toFixed(4) : 'n/a';
+    const rowsNv12 = aggregate.map(r => [
+      r.size,
+      String(r.iters),
+      String(r.repeat),
+      fmtMs(r.nv12_baseline_ms),
+      fmtMs(r.nv12_sse2_ms),
+      fmtMs(r.nv12_avx2_ms),
+      fmtMs(r.nv12_avx512_ms),
+      fmtMs(r.nv12_simd_ms),
+      String(r.nv12_kernel || ''),
+      r.nv12_exact === undefined ? '' : (r.nv12_exact ? 'yes' : 'NO')
+    ]);
+
+    // --- YUY2 -> BGR24 table (baseline | ssse3 | avx2 | dispatched) ---
+    const headersYuy2 = ['size', 'iters', 'repeat', 'base_ms', 'ssse3_ms', 'avx2_ms', 'simd_ms', 'kernel', 'exact'];
+    const rowsYuy2 = aggregate.map(r => [
+      r.size,
+      String(r.iters),
+      String(r.repeat),
+      fmtMs(r.yuy2_baseline_ms),
+      fmtMs(r.yuy2_ssse3_ms),
+      fmtMs(r.yuy2_avx2_ms),
+      fmtMs(r.yuy2_simd_ms),
+      String(r.yuy2_kernel || ''),
+      r.yuy2_exact === undefined ? '' : (r.yuy2_exact ? 'yes' : 'NO')
+    ]);
+
     function pad(s, n) { return String(s).padEnd(n); }
 
     // print helper
@@ -139,6 +271,8 @@ async function main() {
 
     printTable('Aggregated results (RGB32 performance):', headers32, rows32);
     printTable('Aggregated results (RGB24 performance):', headers24, rows24);
+    printTable('Aggregated results (NV12 -> RGBA performance):', headersNv12, rowsNv12);
+    printTable('Aggregated results (YUY2 -> BGR24 performance):', headersYuy2, rowsYuy2);
 }
 
 main();
@@ -1,17 +1,26 @@
 const Camera = require('../addon.js');
 
-function expectedSizes(width, height, subtype) {
-  // For compressed subtypes (MJPEG, etc.) the frame buffer length is variable
-  // and cannot be predicted from width/height. Return null to indicate
-  // variable/compressed frames.
-  if (subtype && /(MJP|MJPEG|MJPG|JPEG|H264|AVC1|HEVC|H265|X264)/i.test(subtype)) {
-    return null;
+// Expected byte length of a tightly packed frame, or null for compressed
+// formats (MJPEG, H264, ...) whose length varies per frame.
+function expectedSize(info) {
+  const w = info.width;
+  const h = info.height;
+  const cw = Math.ceil(w / 2);
+  const ch = Math.ceil(h / 2);
+  switch (info.subtype) {
+    case 'RGB32':
+      return w * h * 4;
+    case 'RGB24':
+      return w * h * 3;
+    case 'YUY2':
+    case 'UYVY':
+      return cw * 4 * h;
+    case 'NV12':
+    case 'IYUV':
+      return w * h + cw * ch * 2;
+    default:
+      return null;
   }
-
-  const rgba = width * height * 4; // RGB32 / RGBA
-  const rgb24 = width * height * 3; // RGB24
-  const nv12 = (width * height * 3) / 2; // NV12 (Y plane + interleaved UV)
-  return { rgba, rgb24, nv12 };
 }
 
 function formatToString(f) {
@@ -52,37 +61,25 @@ async function runTest() {
     console.warn('setFormat failed, continuing with default:', e && e.message ? e.message : e);
   }
 
-    const dims = await cam.getDimensions();
-    console.log('getDimensions reports:', dims);
-
-  // Use the actual dimensions returned by the device and the chosen subtype/guid
-  const subtypeForCheck = (chosen && (chosen.subtype || chosen.guid)) || null;
-  const exp = expectedSizes(dims.width, dims.height, subtypeForCheck);
-    console.log('Expected sizes (bytes):', exp);
-
     let frameCount = 0;
     let mismatches = 0;
 
-    const onFrame = (buffer) => {
+    // Each frame carries its own format, size and stride (no guessing from
+    // the buffer length or getDimensions()).
+    const onFrame = (buffer, info) => {
       frameCount++;
       const len = buffer.length;
-      const matches = [];
-      // If exp is null the chosen format is likely compressed (e.g., MJPEG)
+      const exp = expectedSize(info);
+      const desc = `${info.subtype || '<native>'} ${info.width}x${info.height} stride=${info.stride}`;
       if (exp === null) {
-        // Classify as compressed; report length but do not count as mismatch.
-        const sub = subtypeForCheck || '<compressed>';
-        console.log(`Frame ${frameCount}: buffer.length=${len} (COMPRESSED, subtype=${sub})`);
+        // Compressed: report length but do not count as mismatch.
+        console.log(`Frame ${info.sequence}: buffer.length=${len} (COMPRESSED, ${desc})`);
       } else {
-        if (len === exp.rgba) matches.push('RGBA');
-        if (len === exp.rgb24) matches.push('RGB24');
-        if (len === exp.nv12) matches.push('NV12');
-
-        console.log(`Frame ${frameCount}: buffer.length=${len} (${matches.length ? matches.join('|') : 'UNKNOWN'})`);
-
-        if (!matches.length) {
-          mismatches++;
-        }
+        const ok = len === exp;
+        console.log(`Frame ${info.sequence}: buffer.length=${len} expected=${exp} (${desc})${ok ? '' : ' MISMATCH'}`);
+        if (!ok) mismatches++;
       }
+      if (info.discontinuity) console.log('  (frames lost before this one)');
 
       // After 5 frames stop and report
       if (frameCount >= 5) {
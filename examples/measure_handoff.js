@@ -0,0 +1,86 @@
+const Camera = require('../addon.js');
+
+// Usage: node examples/measure_handoff.js [durationMs] [subtype] [WxH] [frameRate] [outputFormat] [handlerMs]
+// durationMs:   milliseconds to capture (default 5000)
+// subtype:      synthetic native format (default NV12)
+// WxH:          frame size (default 1920x1080)
+// frameRate:    synthetic rate; 0 renders back to back for throughput (default 60)
+// outputFormat: converter output, e.g. RGB32 or MJPEG; '-' keeps the native format (default -)
+// handlerMs:    busy time per 'frame' event, to model a slow JS consumer (default 0)
+//
+// Runs the synthetic backend and prints the processing stage counters from
+// getStats(): hand-off latency (capture thread push until the stage picks the
+// frame up), per-frame conversion and delivery time, and frames the stage
+// dropped. A slow handler should show up as delivery-queue drops, not as a
+// longer hand-off or stage drops.
+
+const durationMs = parseInt(process.argv[2], 10) || 5000;
+const subtype = process.argv[3] || 'NV12';
+const [width, height] = (process.argv[4] || '1920x1080').split('x').map((v) => parseInt(v, 10));
+const frameRate = typeof process.argv[5] !== 'undefined' ? parseInt(process.argv[5], 10) : 60;
+const outputFormat = process.argv[6] && process.argv[6] !== '-' ? process.argv[6] : null;
+const handlerMs = parseFloat(process.argv[7]) || 0;
+
+function hrNowMs() {
+  return Number(process.hrtime.bigint()) / 1e6;
+}
+
+function busyWait(ms) {
+  const end = hrNowMs() + ms;
+  while (hrNowMs() < end) {}
+}
+
+function us(value) {
+  return `${value.toFixed(1)} us`;
+}
+
+async function measure() {
+  const cam = new Camera({ backend: 'synthetic' });
+
+  try {
+    await cam.claimDevice('synthetic://camera0');
+    await cam.setFormat({ subtype, width, height, frameRate });
+    if (outputFormat) await cam.setOutputFormat(outputFormat);
+
+    let frames = 0;
+    const onFrame = () => {
+      ++frames;
+      if (handlerMs > 0) busyWait(handlerMs);
+    };
+    cam.on('frame', onFrame);
+
+    console.log(`Capturing ${subtype} ${width}x${height}@${frameRate} -> ${outputFormat || 'native'} for ${durationMs}ms` +
+      (handlerMs > 0 ? ` (handler busy ${handlerMs}ms per frame)` : ''));
+    const start = hrNowMs();
+    await cam.startCapture();
+    await new Promise((res) => setTimeout(res, durationMs));
+    // Sampled while capturing: stopCapture discards frames still queued
+    const stats = cam.getStats();
+    const elapsedMs = hrNowMs() - start;
+    await cam.stopCapture();
+    cam.removeListener('frame', onFrame);
+
+    const p = stats.processing;
+    if (!p || p.capacity === 0) {
+      console.error('This backend has no processing stage');
+    } else {
+      console.log('Processing stage:');
+      console.log(`  queued ${p.queued}, processed ${p.processed}, dropped ${p.dropped}, high-water ${p.highWater}/${p.capacity}`);
+      console.log(`  hand-off wait: mean ${us(p.meanWaitUs)}, max ${us(p.maxWaitUs)}`);
+      console.log(`  processing:    mean ${us(p.meanProcessUs)}, max ${us(p.maxProcessUs)}`);
+      console.log(`  throughput:    ${(p.processed * 1000 / elapsedMs).toFixed(1)} frames/s`);
+    }
+    if (stats.delivery) {
+      const d = stats.delivery;
+      console.log(`Delivery queue: delivered ${d.delivered}, dropped ${d.dropped} (${d.policy}), JS handled ${frames}`);
+    }
+
+    await cam.releaseDevice();
+  } catch (err) {
+    console.error('Error during measurement:', err);
+    try { await cam.releaseDevice(); } catch (e) {}
+    process.exitCode = 1;
+  }
+}
+
+measure();
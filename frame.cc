@@ -0,0 +1,189 @@
+#include "frame.h"
+
+#include <chrono>
+#include <utility>
+
+int64_t MonotonicMicros() {
+  // steady_clock is QueryPerformanceCounter on MSVC and CLOCK_MONOTONIC on
+  // Linux and macOS.
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameStamper::Reset() {
+  m_sequence = 0;
+  m_haveBase = false;
+  m_baseUs = 0;
+  m_discontinuity = false;
+}
+
+void FrameStamper::Stamp(FrameInfo& info, int64_t deviceTimeUs, int64_t arrivalUs, bool discontinuity) {
+  if (!m_haveBase) {
+    m_baseUs = deviceTimeUs;
+    m_haveBase = true;
+  }
+  info.sequence = m_sequence++;
+  info.deviceTimeUs = deviceTimeUs;
+  info.timestampUs = deviceTimeUs - m_baseUs;
+  info.arrivalUs = arrivalUs;
+  info.flags = (discontinuity || m_discontinuity) ? FrameInfo::kDiscontinuity : 0;
+  m_discontinuity = false;
+}
+
+void FrameDeleter::operator()(Frame* frame) const {
+  if (!frame) return;
+  if (frame->pool) {
+    // Move the reference out first: the pool may be destroyed as soon as its
+    // last leased frame comes home.
+    std::shared_ptr<FramePool> pool = std::move(frame->pool);
+    pool->Recycle(frame);
+    return;
+  }
+  if (frame->destination) {
+    std::shared_ptr<FrameDestination> destination = std::move(frame->destination);
+    uint8_t* storage = frame->external;
+    delete frame;
+    destination->Release(storage);
+    return;
+  }
+  delete frame;
+}
+
+std::shared_ptr<FramePool> FramePool::Create(size_t maxInFlight) {
+  return std::shared_ptr<FramePool>(new FramePool(maxInFlight));
+}
+
+FramePool::FramePool(size_t maxInFlight) {
+  m_stats.maxInFlight = maxInFlight;
+}
+
+FramePool::~FramePool() {
+  for (auto& bucket : m_buckets) {
+    for (Frame* f : bucket.second) delete f;
+  }
+}
+
+size_t FramePool::BucketCapacity(size_t size) {
+  if (size <= 4096) return 4096;
+  // Smallest of 2^k / 1.5*2^k that fits `size`
+  size_t pow2 = 4096;
+  while (pow2 < size) {
+    size_t mid = pow2 + (pow2 >> 1);
+    if (mid >= size) return mid;
+    pow2 <<= 1;
+  }
+  return pow2;
+}
+
+FramePtr FramePool::Acquire(size_t size, bool allowDestination) {
+  std::shared_ptr<FrameDestination> destination;
+  if (allowDestination) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    destination = m_destination;
+  }
+  if (destination) {
+    // Allocated before the claim so a failed allocation cannot strand it
+    std::unique_ptr<Frame> external(new Frame());
+    size_t externalCapacity = 0;
+    if (uint8_t* storage = destination->Claim(size, externalCapacity)) {
+      external->external = storage;
+      external->externalCapacity = externalCapacity;
+      external->size = size;
+      external->destination = std::move(destination);
+      return FramePtr(external.release());
+    }
+  }
+
+  const size_t capacity = BucketCapacity(size);
+  Frame* frame = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_stats.maxInFlight != 0 && m_stats.inFlight >= m_stats.maxInFlight) {
+      ++m_stats.exhausted;
+      return FramePtr();
+    }
+    auto it = m_buckets.find(capacity);
+    if (it != m_buckets.end() && !it->second.empty()) {
+      frame = it->second.back();
+      it->second.pop_back();
+      --m_stats.cached;
+      m_stats.cachedBytes -= frame->capacity();
+      ++m_stats.hits;
+    } else {
+      ++m_stats.misses;
+    }
+    ++m_stats.inFlight;
+    if (m_stats.inFlight > m_stats.highWater) m_stats.highWater = m_stats.inFlight;
+  }
+
+  if (!frame) {
+    // Allocate outside the lock; undo the lease if allocation fails.
+    try {
+      frame = new Frame();
+      frame->bytes.resize(capacity);
+    } catch (...) {
+      delete frame;
+      std::lock_guard<std::mutex> lock(m_lock);
+      --m_stats.inFlight;
+      throw;
+    }
+  }
+
+  frame->size = size;
+  frame->info = FrameInfo();  // recycled frames carry the previous lease's info
+  frame->pool = shared_from_this();
+  return FramePtr(frame);
+}
+
+void FramePool::Recycle(Frame* frame) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_stats.inFlight > 0) --m_stats.inFlight;
+
+  // Bound idle storage per bucket so a burst does not pin memory forever.
+  size_t idleLimit = m_stats.maxInFlight ? m_stats.maxInFlight : kDefaultMaxInFlight;
+  std::vector<Frame*>& bucket = m_buckets[frame->capacity()];
+  if (bucket.size() >= idleLimit) {
+    delete frame;
+    return;
+  }
+  frame->size = 0;
+  bucket.push_back(frame);
+  ++m_stats.cached;
+  m_stats.cachedBytes += frame->capacity();
+}
+
+void FramePool::SetDestination(std::shared_ptr<FrameDestination> destination) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_destination = std::move(destination);
+}
+
+void FramePool::SetMaxInFlight(size_t maxInFlight) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_stats.maxInFlight = maxInFlight;
+}
+
+FramePoolStats FramePool::GetStats() const {
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_stats;
+}
+
+void FramePool::ResetStats() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_stats.hits = 0;
+  m_stats.misses = 0;
+  m_stats.exhausted = 0;
+  m_stats.highWater = m_stats.inFlight;
+}
+
+void FramePool::Trim() {
+  std::vector<Frame*> idle;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (auto& bucket : m_buckets) {
+      idle.insert(idle.end(), bucket.second.begin(), bucket.second.end());
+    }
+    m_buckets.clear();
+    m_stats.cached = 0;
+    m_stats.cachedBytes = 0;
+  }
+  for (Frame* f : idle) delete f;
+}
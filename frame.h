@@ -0,0 +1,175 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class FramePool;
+
+// Pixel formats understood by the conversion path. Backends report native
+// formats they cannot classify as Unknown together with their native id.
+// The numeric values are part of the recording format and the frame info
+// array; append new formats at the end.
+enum class PixelFormat {
+  Unknown,
+  NV12,
+  YUY2,
+  UYVY,
+  RGB24,  // packed B,G,R
+  RGB32,  // packed B,G,R,X
+  MJPEG,
+  IYUV,
+  RGBA,  // packed R,G,B,A
+};
+
+// Metadata carried with every frame, filled in by the backend that produced
+// it (see FrameStamper). Times are microseconds.
+struct FrameInfo {
+  // The frame follows a gap: frames were lost before delivery (device or
+  // driver gap, pool exhausted, flagged discontinuity).
+  static constexpr uint32_t kDiscontinuity = 1u << 0;
+
+  uint64_t sequence = 0;     // frames delivered by the backend this session, from 0
+  int64_t deviceTimeUs = 0;  // presentation time on the device/driver clock
+  int64_t timestampUs = 0;   // deviceTimeUs rebased to the session's first frame
+  int64_t arrivalUs = 0;     // MonotonicMicros() when the backend received it
+  PixelFormat format = PixelFormat::Unknown;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t stride = 0;  // bytes per row of the first plane; 0 = compressed
+  uint32_t flags = 0;
+};
+
+// Monotonic clock shared by all backends (QueryPerformanceCounter on Windows,
+// CLOCK_MONOTONIC elsewhere), in microseconds.
+int64_t MonotonicMicros();
+
+// Numbers a capture session's frames and rebases their device timestamps.
+// Owned by a backend and used from its capture thread only.
+class FrameStamper {
+ public:
+  // Start a new session: sequence 0, next frame is the time base.
+  void Reset();
+  // A frame was lost before delivery; the next stamped frame is flagged.
+  void MarkDiscontinuity() { m_discontinuity = true; }
+  // Fill sequence, times and flags. `arrivalUs` is the MonotonicMicros() of
+  // the frame's arrival.
+  void Stamp(FrameInfo& info, int64_t deviceTimeUs, int64_t arrivalUs, bool discontinuity = false);
+
+ private:
+  uint64_t m_sequence = 0;
+  bool m_haveBase = false;
+  int64_t m_baseUs = 0;
+  bool m_discontinuity = false;
+};
+
+// Storage owned by the embedding that a frame can be written into instead of
+// pooled storage (cam.readInto). FramePool offers each lease to its
+// destination first; claimed storage stays claimed until that frame is
+// released. Claim and Release may be called from any thread.
+class FrameDestination {
+ public:
+  virtual ~FrameDestination() {}
+  // Storage for a frame of `size` bytes, or null to use pooled storage.
+  // `outCapacity` receives the usable size of the returned storage.
+  virtual uint8_t* Claim(size_t size, size_t& outCapacity) = 0;
+  // The frame written into `storage` was released
+  virtual void Release(uint8_t* storage) = 0;
+};
+
+// A single captured frame travelling from the capture thread to the embedding.
+// The frame owns its bytes until it is released. The JS layer wraps the bytes
+// in an external Buffer and releases the frame from the Buffer's finalizer, so
+// the payload is written once on the native side and never copied again.
+// Frames leased from a FrameDestination write into its storage instead.
+struct Frame {
+  std::vector<uint8_t> bytes;  // backing storage (capacity may exceed size)
+  size_t size = 0;             // number of valid bytes in data()
+  FrameInfo info;
+  // Pool the frame was leased from; null for standalone frames. Holding the
+  // pool keeps it alive until every leased frame has been returned.
+  std::shared_ptr<FramePool> pool;
+  // Destination whose storage the frame was written into; `bytes` is empty
+  // then and `external` is the storage
+  std::shared_ptr<FrameDestination> destination;
+  uint8_t* external = nullptr;
+  size_t externalCapacity = 0;
+
+  uint8_t* data() { return external ? external : bytes.data(); }
+  const uint8_t* data() const { return external ? external : bytes.data(); }
+  size_t capacity() const { return external ? externalCapacity : bytes.size(); }
+};
+
+// Deleter used by FramePtr. Pooled frames are returned to their pool, frames
+// in a destination's storage release it, other frames are freed. Kept as a
+// named type so ownership can be handed across the N-API boundary as a raw
+// pointer and reclaimed in a finalizer.
+struct FrameDeleter {
+  void operator()(Frame* frame) const;
+};
+
+using FramePtr = std::unique_ptr<Frame, FrameDeleter>;
+
+// Allocate a standalone (non-pooled) frame whose storage is sized for `size` bytes.
+inline FramePtr MakeFrame(size_t size) {
+  FramePtr frame(new Frame());
+  frame->bytes.resize(size);
+  frame->size = size;
+  return frame;
+}
+
+struct FramePoolStats {
+  uint64_t hits = 0;       // leases served from cached storage
+  uint64_t misses = 0;     // leases that had to allocate
+  uint64_t exhausted = 0;  // leases refused because maxInFlight frames were out
+  size_t inFlight = 0;     // frames currently leased
+  size_t highWater = 0;    // maximum simultaneous leases observed
+  size_t maxInFlight = 0;  // configured cap (0 = unbounded)
+  size_t cached = 0;       // idle frames held for reuse
+  size_t cachedBytes = 0;  // storage held by idle frames
+};
+
+// Size-bucketed recycling pool for frame storage. Capacities are rounded up
+// to 2^k or 1.5*2^k so frames of a fixed-size stream always land in one
+// bucket while variable-size payloads (MJPEG) still find a reusable buffer.
+// Thread-safe; leases may be returned from any thread.
+class FramePool : public std::enable_shared_from_this<FramePool> {
+ public:
+  static constexpr size_t kDefaultMaxInFlight = 16;
+
+  static std::shared_ptr<FramePool> Create(size_t maxInFlight = kDefaultMaxInFlight);
+  ~FramePool();
+
+  // Lease a frame with room for at least `size` bytes; `frame->size` is set to
+  // `size`. Returns null when maxInFlight frames are already leased. Storage
+  // claimed from the destination (SetDestination) is used when offered, unless
+  // `allowDestination` is false: writers that grow `bytes` (JPEG encoders)
+  // need pooled storage.
+  FramePtr Acquire(size_t size, bool allowDestination = true);
+
+  // Offer leases to `destination` before pooled storage (null = pool only).
+  // Leases written into a destination do not count against maxInFlight.
+  void SetDestination(std::shared_ptr<FrameDestination> destination);
+
+  // Cap the number of simultaneously leased frames (0 = unbounded).
+  void SetMaxInFlight(size_t maxInFlight);
+  FramePoolStats GetStats() const;
+  void ResetStats();
+  // Free all idle storage (outstanding leases are unaffected).
+  void Trim();
+
+  // Capacity class used for a request of `size` bytes.
+  static size_t BucketCapacity(size_t size);
+
+ private:
+  friend struct FrameDeleter;
+  explicit FramePool(size_t maxInFlight);
+  void Recycle(Frame* frame);
+
+  mutable std::mutex m_lock;
+  std::map<size_t, std::vector<Frame*>> m_buckets;  // capacity -> idle frames
+  std::shared_ptr<FrameDestination> m_destination;
+  FramePoolStats m_stats;
+};
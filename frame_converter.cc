@@ -0,0 +1,192 @@
+#include "frame_converter.h"
+
+#include <utility>
+
+FrameConverter::FrameConverter(std::shared_ptr<FramePool> pool) : m_pool(std::move(pool)) {
+}
+
+void FrameConverter::SetThreads(size_t threads, size_t bandHeight) {
+  m_threads = threads;
+  m_bandHeight = bandHeight;
+  if (m_engine) {
+    m_engine->SetThreadCount(threads);
+    m_engine->SetBandHeight(bandHeight);
+  }
+}
+
+ConvertEngine& FrameConverter::Engine() {
+  // Conversions are split into row bands across a persistent worker pool.
+  if (!m_engine) m_engine.reset(new ConvertEngine(m_threads, m_bandHeight));
+  return *m_engine;
+}
+
+void FrameConverter::Reset() {
+  m_engine.reset();
+  m_yuvJpeg.Reset();
+  m_jpegDecoder.Reset();
+  m_lastJpegSize = 0;
+}
+
+// Planner layout of a tightly packed frame; false for MJPEG and Unknown.
+static bool LayoutOf(PixelFormat format, FrameLayout& out) {
+  switch (format) {
+    case PixelFormat::RGB32:
+      out = FrameLayout::BGRA;
+      return true;
+    case PixelFormat::RGBA:
+      out = FrameLayout::RGBA;
+      return true;
+    case PixelFormat::RGB24:
+      out = FrameLayout::BGR24;
+      return true;
+    case PixelFormat::NV12:
+      out = FrameLayout::NV12;
+      return true;
+    case PixelFormat::IYUV:
+      out = FrameLayout::I420;
+      return true;
+    case PixelFormat::YUY2:
+      out = FrameLayout::YUY2;
+      return true;
+    case PixelFormat::UYVY:
+      out = FrameLayout::UYVY;
+      return true;
+    default:
+      return false;
+  }
+}
+
+HRESULT FrameConverter::EncodeJpeg(PixelFormat input, const uint8_t* data, size_t stride, uint32_t width, uint32_t height, FramePtr& outFrame) {
+  const bool rgb = input == PixelFormat::RGB32 || input == PixelFormat::RGB24;
+  // The platform encoder takes tightly packed pixels only
+  if (rgb && m_jpegEncoder && stride == 0) return m_jpegEncoder(data, width, height, input == PixelFormat::RGB32, m_jpegOptions, outFrame);
+  if (!rgb && input != PixelFormat::RGBA && input != PixelFormat::NV12 && input != PixelFormat::IYUV && input != PixelFormat::YUY2 && input != PixelFormat::UYVY) {
+    return E_NOTIMPL;
+  }
+
+  // Sized from the previous frame plus headroom; the encoder grows the
+  // storage in the rare case a frame comes out larger.
+  const size_t pixelCount = static_cast<size_t>(width) * height;
+  const size_t estimate = m_lastJpegSize ? m_lastJpegSize + m_lastJpegSize / 4 : pixelCount / 2;
+  outFrame = m_pool->Acquire(estimate, false);
+  if (!outFrame) return S_FALSE;  // pool exhausted; caller drops the frame
+
+  m_yuvJpeg.SetQuality(m_jpegOptions.quality);
+  const size_t evenWidth = (static_cast<size_t>(width) + 1) & ~static_cast<size_t>(1);
+  size_t size = 0;
+  switch (input) {
+    case PixelFormat::NV12:
+      // Native 4:2:0, BT.601 limited range
+      if (stride == 0) {
+        size = m_yuvJpeg.EncodeNv12(data, width, data + pixelCount, evenWidth, width, height, YuvRange::Limited, outFrame->bytes);
+      } else {
+        size = m_yuvJpeg.EncodeNv12(data, stride, data + stride * height, stride, width, height, YuvRange::Limited, outFrame->bytes);
+      }
+      break;
+    case PixelFormat::IYUV:
+      if (stride == 0) {
+        size = m_yuvJpeg.EncodeI420(data, width, height, YuvRange::Limited, outFrame->bytes);
+      } else {
+        JpegSource src;
+        src.y = data;
+        src.yStride = stride;
+        src.cb = data + stride * height;
+        src.cStride = stride / 2;
+        src.cr = src.cb + src.cStride * ((height + 1) / 2);
+        src.width = width;
+        src.height = height;
+        src.chroma = JpegChroma::Yuv420;
+        src.range = YuvRange::Limited;
+        size = m_yuvJpeg.Encode(src, outFrame->bytes);
+      }
+      break;
+    case PixelFormat::YUY2:
+    case PixelFormat::UYVY:
+      // Native 4:2:2
+      size = m_yuvJpeg.EncodeYuv422(data, stride ? stride : evenWidth * 2, width, height, input == PixelFormat::YUY2 ? Yuv422Layout::YUY2 : Yuv422Layout::UYVY,
+                                    YuvRange::Limited, outFrame->bytes);
+      break;
+    default: {
+      // RGB without a platform encoder: subsampling as configured (4:4:0 is
+      // not supported here and falls back to 4:2:0)
+      JpegChroma chroma = JpegChroma::Yuv420;
+      if (m_jpegOptions.subsampling == JpegSubsampling::Yuv422) chroma = JpegChroma::Yuv422;
+      if (m_jpegOptions.subsampling == JpegSubsampling::Yuv444) chroma = JpegChroma::Yuv444;
+      const RgbFormat format = input == PixelFormat::RGB32 ? RgbFormat::BGRA : (input == PixelFormat::RGBA ? RgbFormat::RGBA : RgbFormat::BGR24);
+      size = m_yuvJpeg.EncodeRgb(data, stride ? stride : static_cast<size_t>(width) * (format == RgbFormat::BGR24 ? 3 : 4), width, height, format, chroma,
+                                 outFrame->bytes);
+      break;
+    }
+  }
+  if (size == 0) {
+    outFrame.reset();
+    return E_INVALIDARG;
+  }
+  // Storage the encoder grew is rounded up to a bucket so the frame still
+  // recycles through the pool.
+  const size_t bucket = FramePool::BucketCapacity(outFrame->capacity());
+  if (bucket != outFrame->capacity()) outFrame->bytes.resize(bucket);
+  outFrame->size = size;
+  m_lastJpegSize = size;
+  return S_OK;
+}
+
+HRESULT FrameConverter::DecodeJpeg(const uint8_t* data, size_t size, uint32_t width, uint32_t height, FramePtr& outFrame) {
+  JpegOutputFormat format;
+  switch (m_outputFormat) {
+    case PixelFormat::RGB32:
+      format = JpegOutputFormat::BGRA;
+      break;
+    case PixelFormat::RGB24:
+      format = JpegOutputFormat::BGR24;
+      break;
+    case PixelFormat::RGBA:
+      format = JpegOutputFormat::RGBA;
+      break;
+    case PixelFormat::NV12:
+      format = JpegOutputFormat::NV12;
+      break;
+    case PixelFormat::IYUV:
+      format = JpegOutputFormat::I420;
+      break;
+    case PixelFormat::YUY2:
+      format = JpegOutputFormat::YUY2;
+      break;
+    case PixelFormat::UYVY:
+      format = JpegOutputFormat::UYVY;
+      break;
+    default:
+      return E_NOTIMPL;
+  }
+
+  // A null lease means the in-flight cap is reached: drop the frame.
+  outFrame = m_pool->Acquire(PixelFormatFrameSize(m_outputFormat, width, height));
+  if (!outFrame) return S_FALSE;
+  // Decoded in place, restart intervals or reconstruction spread over the
+  // engine's workers
+  if (!m_jpegDecoder.Decode(data, size, format, outFrame->data(), width, height, &Engine())) {
+    outFrame.reset();
+    return E_INVALIDARG;
+  }
+  return S_OK;
+}
+
+HRESULT FrameConverter::Convert(PixelFormat input, const uint8_t* data, size_t size, uint32_t width, uint32_t height, FramePtr& outFrame, size_t stride) {
+  if (!data || width == 0 || height == 0) return E_INVALIDARG;
+  if (stride != 0 && stride < PixelFormatStride(input, width)) return E_INVALIDARG;
+  const size_t needed = stride ? PixelFormatStridedFrameSize(input, stride, height) : PixelFormatFrameSize(input, width, height);
+  if (needed != 0 && size < needed) return E_UNEXPECTED;
+
+  if (m_outputFormat == PixelFormat::MJPEG) return EncodeJpeg(input, data, stride, width, height, outFrame);
+  if (input == PixelFormat::MJPEG) return DecodeJpeg(data, size, width, height, outFrame);
+
+  // Any packed/planar pair, along the planner's path, straight into pooled
+  // frame storage
+  FrameLayout from, to;
+  if (!LayoutOf(input, from) || !LayoutOf(m_outputFormat, to)) return E_NOTIMPL;
+  // A null lease means the in-flight cap is reached: drop the frame.
+  outFrame = m_pool->Acquire(PixelFormatFrameSize(m_outputFormat, width, height));
+  if (!outFrame) return S_FALSE;
+  Engine().Convert(from, data, to, outFrame->data(), width, height, YuvMatrix::BT601, YuvRange::Limited, stride);
+  return S_OK;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "capture_backend.h"
+#include "convert_engine.h"
+#include "frame.h"
+#include "jpeg_decoder.h"
+#include "jpeg_encoder.h"
+
+// Output-format conversion shared by the capture backends. Converts one
+// native frame into a frame leased from the backend's pool, using the banded
+// ConvertEngine for pixel conversions (any pair of RGB32, RGB24, RGBA, NV12,
+// IYUV, YUY2 and UYVY, along the path PlanConversion picks), JpegDecoder for
+// MJPEG input (decoded on the engine's workers straight into the output
+// frame) and, for MJPEG output, the portable YuvJpegEncoder (YUV input is
+// encoded as is, without going through RGB) or an optional platform encoder
+// for RGB input. Not thread-safe: each backend serializes its calls.
+class FrameConverter {
+ public:
+  // Platform encoder for RGB input: encode tightly packed BGRA (`bgra` =
+  // true) or BGR24 pixels to JPEG into a frame leased from the pool. Returns
+  // S_FALSE with no frame when the pool is exhausted.
+  using JpegEncoder = std::function<HRESULT(const uint8_t* pixels, uint32_t width, uint32_t height, bool bgra, const JpegOptions& options, FramePtr& outFrame)>;
+
+  explicit FrameConverter(std::shared_ptr<FramePool> pool);
+
+  void SetOutputFormat(PixelFormat format) { m_outputFormat = format; }
+  PixelFormat OutputFormat() const { return m_outputFormat; }
+  void SetJpegEncoder(JpegEncoder encoder) { m_jpegEncoder = std::move(encoder); }
+  void SetJpegOptions(const JpegOptions& options) { m_jpegOptions = options; }
+  // Applied to the engine now, or when it is first created.
+  void SetThreads(size_t threads, size_t bandHeight);
+
+  // True when frames of `input` must be converted before delivery.
+  bool NeedsConversion(PixelFormat input) const {
+    return m_outputFormat != PixelFormat::Unknown && input != m_outputFormat;
+  }
+
+  // Convert `size` bytes of `input` to the output format. `stride` 0 means
+  // the frame is tightly packed; otherwise its rows are `stride` bytes apart
+  // (see PixelFormatStridedFrameSize) and are read in place. Returns S_FALSE
+  // with no frame when the pool is exhausted, E_NOTIMPL for unsupported
+  // pairs, E_UNEXPECTED when the payload is shorter than the frame size and
+  // E_INVALIDARG for an MJPEG frame that cannot be decoded.
+  HRESULT Convert(PixelFormat input, const uint8_t* data, size_t size, uint32_t width, uint32_t height, FramePtr& outFrame, size_t stride = 0);
+
+  // Drop the worker pool and scratch storage (output format is kept).
+  void Reset();
+
+ private:
+  ConvertEngine& Engine();
+  // MJPEG output through m_yuvJpeg
+  HRESULT EncodeJpeg(PixelFormat input, const uint8_t* data, size_t stride, uint32_t width, uint32_t height, FramePtr& outFrame);
+  // MJPEG input through m_jpegDecoder
+  HRESULT DecodeJpeg(const uint8_t* data, size_t size, uint32_t width, uint32_t height, FramePtr& outFrame);
+
+  std::shared_ptr<FramePool> m_pool;
+  PixelFormat m_outputFormat = PixelFormat::Unknown;
+  JpegEncoder m_jpegEncoder;
+  JpegOptions m_jpegOptions;
+  // Banded multi-threaded converter; created on the first converted frame
+  std::unique_ptr<ConvertEngine> m_engine;
+  size_t m_threads = 0;
+  size_t m_bandHeight = 0;
+  YuvJpegEncoder m_yuvJpeg;
+  JpegDecoder m_jpegDecoder;
+  // Size of the previous JPEG; the next output lease is sized from it
+  size_t m_lastJpegSize = 0;
+};
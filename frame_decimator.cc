@@ -0,0 +1,83 @@
+#include "frame_decimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Frames per step of the period measurement window (64 to 128 frames long)
+constexpr int64_t kWindowFrames = 64;
+
+}  // namespace
+
+FrameDecimator::FrameDecimator(uint32_t step, double targetRate)
+    : m_step(step), m_targetRate(targetRate), m_intervalUs(targetRate > 0.0 ? 1e6 / targetRate : 0.0) {}
+
+std::shared_ptr<FrameDecimator> FrameDecimator::EveryNth(uint32_t step) {
+  return std::shared_ptr<FrameDecimator>(new FrameDecimator(step == 0 ? 1 : step, 0.0));
+}
+
+std::shared_ptr<FrameDecimator> FrameDecimator::TargetRate(double framesPerSecond) {
+  return std::shared_ptr<FrameDecimator>(new FrameDecimator(0, framesPerSecond));
+}
+
+void FrameDecimator::SetSourceRate(double framesPerSecond) {
+  m_nominalPeriodUs = framesPerSecond > 0.0 && std::isfinite(framesPerSecond) ? 1e6 / framesPerSecond : 0.0;
+}
+
+bool FrameDecimator::Admit(int64_t deviceTimeUs) {
+  bool admit;
+  if (m_step != 0) {
+    admit = m_count++ % m_step == 0;
+  } else {
+    const int64_t delta = deviceTimeUs - m_lastUs;
+    if (!m_haveBase || delta < 0) {
+      // First frame, or the device clock went backwards: rebase on this frame
+      m_haveBase = true;
+      m_index = 0;
+      m_periodUs = m_nominalPeriodUs;
+      m_position = 0.0;
+      m_lastSlot = 0;
+      m_anchorUs = m_midAnchorUs = deviceTimeUs;
+      m_anchorIndex = m_midAnchorIndex = 0;
+      admit = true;
+    } else {
+      // A gap of several periods holds the frames the device dropped. Until
+      // there is a period, every interval is one frame.
+      const int64_t steps = m_periodUs > 0.0 ? std::max<int64_t>(1, std::llround(static_cast<double>(delta) / m_periodUs)) : 1;
+      m_index += steps;
+      if (m_index - m_midAnchorIndex >= kWindowFrames) {
+        m_anchorUs = m_midAnchorUs;
+        m_anchorIndex = m_midAnchorIndex;
+        m_midAnchorUs = deviceTimeUs;
+        m_midAnchorIndex = m_index;
+      }
+      // The nominal period holds while the window's span is within half a
+      // period of it, which quarter-period jitter at both ends always is
+      const int64_t frames = m_index - m_anchorIndex;
+      const double span = static_cast<double>(deviceTimeUs - m_anchorUs);
+      if (m_nominalPeriodUs > 0.0 && std::fabs(span - frames * m_nominalPeriodUs) <= m_nominalPeriodUs / 2.0) {
+        m_periodUs = m_nominalPeriodUs;
+      } else if (span > 0.0) {
+        m_periodUs = span / static_cast<double>(frames);
+      }
+      m_position += steps * m_periodUs / m_intervalUs;
+      const double shift = std::min(m_periodUs, m_intervalUs) / (2.0 * m_intervalUs);
+      const int64_t slot = static_cast<int64_t>(std::floor(m_position + shift));
+      admit = slot > m_lastSlot;
+      if (admit) m_lastSlot = slot;
+    }
+    m_lastUs = deviceTimeUs;
+  }
+  (admit ? m_admitted : m_skipped).fetch_add(1, std::memory_order_relaxed);
+  return admit;
+}
+
+FrameDecimatorStats FrameDecimator::GetStats() const {
+  FrameDecimatorStats stats;
+  stats.admitted = m_admitted.load(std::memory_order_relaxed);
+  stats.skipped = m_skipped.load(std::memory_order_relaxed);
+  stats.step = m_step;
+  stats.targetRate = m_targetRate;
+  return stats;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+struct FrameDecimatorStats {
+  uint64_t admitted = 0;  // frames passed on to delivery
+  uint64_t skipped = 0;   // frames dropped before conversion or copying
+  uint32_t step = 0;      // keep one frame in `step` (0 = target rate mode)
+  double targetRate = 0.0;
+};
+
+// Frame-rate reduction run by the frame gate, so a dropped frame is never
+// locked, converted, copied or delivered (startCapture { decimate,
+// targetFrameRate }). Two modes:
+//   - every Nth: keeps frames 0, N, 2N, ... of the session;
+//   - target rate: keeps the first frame of each 1/targetRate interval of
+//     the session. Frames are placed at their nominal times (source frames
+//     since the session's first frame, counting the ones the device dropped,
+//     times the source frame period) shifted by half a period, rather than
+//     at their timestamps. The period is the format's (SetSourceRate) while
+//     the timestamps agree with it, else the one measured over the last 64
+//     to 128 frames. Timestamp jitter of up to a quarter period either way
+//     therefore never changes which frames are kept: 30 -> 5 fps keeps
+//     exactly every 6th frame.
+// Admit is called from the capture thread only, SetSourceRate before
+// capture starts; GetStats from any thread.
+class FrameDecimator {
+ public:
+  static std::shared_ptr<FrameDecimator> EveryNth(uint32_t step);
+  static std::shared_ptr<FrameDecimator> TargetRate(double framesPerSecond);
+
+  // The device format's frame rate; 0 (unknown) measures it
+  void SetSourceRate(double framesPerSecond);
+  bool Admit(int64_t deviceTimeUs);
+  FrameDecimatorStats GetStats() const;
+
+ private:
+  FrameDecimator(uint32_t step, double targetRate);
+
+  const uint32_t m_step;
+  const double m_targetRate;
+  const double m_intervalUs;
+  // Every Nth
+  uint64_t m_count = 0;
+  // Target rate
+  double m_nominalPeriodUs = 0.0;
+  bool m_haveBase = false;
+  int64_t m_lastUs = 0;
+  int64_t m_index = 0;        // source frames since the base, dropped ones included
+  double m_periodUs = 0.0;    // source frame period in use
+  double m_position = 0.0;    // nominal time of the current frame, in intervals
+  int64_t m_lastSlot = 0;
+  // Measurement window: from m_anchor, which moves up to m_midAnchor every
+  // kWindowFrames frames
+  int64_t m_anchorUs = 0;
+  int64_t m_anchorIndex = 0;
+  int64_t m_midAnchorUs = 0;
+  int64_t m_midAnchorIndex = 0;
+  std::atomic<uint64_t> m_admitted{0};
+  std::atomic<uint64_t> m_skipped{0};
+};
@@ -0,0 +1,384 @@
+#include "frame_pull.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "capture_backend.h"
+#include "frame_target.h"
+
+// Same fields as FrameInfo in addon.js, as a snapshot: pulled frames are
+// held across awaits, so they cannot share one rewritten info array.
+static void SetFrameInfo(Napi::Env env, Napi::Object result, const FrameInfo& info, size_t size) {
+  result.Set("sequence", Napi::Number::New(env, static_cast<double>(info.sequence)));
+  result.Set("deviceTimestamp", Napi::Number::New(env, static_cast<double>(info.deviceTimeUs)));
+  result.Set("timestamp", Napi::Number::New(env, static_cast<double>(info.timestampUs)));
+  result.Set("arrivalTime", Napi::Number::New(env, static_cast<double>(info.arrivalUs)));
+  result.Set("subtype", Napi::String::New(env, PixelFormatName(info.format)));
+  result.Set("width", Napi::Number::New(env, info.width));
+  result.Set("height", Napi::Number::New(env, info.height));
+  result.Set("stride", Napi::Number::New(env, info.stride));
+  result.Set("discontinuity", Napi::Boolean::New(env, (info.flags & FrameInfo::kDiscontinuity) != 0));
+  result.Set("size", Napi::Number::New(env, static_cast<double>(size)));
+}
+
+// The bytes of an ArrayBuffer or view as they are now. A detached buffer
+// (transferred, or a resizable one shrunk below the view) reports `detached`
+// or a shorter `length`. `shared` views are over a SharedArrayBuffer, which
+// can be neither detached nor shrunk, so the capture thread may write into
+// them while they are held. Raw N-API: the node-addon-api accessors go
+// through napi_get_arraybuffer_info, which refuses shared buffers.
+static bool GetBufferBytes(Napi::Env env, Napi::Value value, uint8_t*& data, size_t& length, bool& shared, bool& detached) {
+  void* bytes = nullptr;
+  napi_value arrayBuffer = nullptr;
+  size_t byteOffset = 0;
+  length = 0;
+  shared = false;
+  detached = false;
+  if (value.IsArrayBuffer()) {
+    arrayBuffer = value;
+    if (napi_get_arraybuffer_info(env, value, &bytes, &length) != napi_ok) return false;
+  } else if (value.IsTypedArray()) {
+    napi_typedarray_type type;
+    size_t elements = 0;
+    if (napi_get_typedarray_info(env, value, &type, &elements, &bytes, &arrayBuffer, &byteOffset) != napi_ok) return false;
+    length = elements * value.As<Napi::TypedArray>().ElementSize();
+  } else if (value.IsDataView()) {
+    if (napi_get_dataview_info(env, value, &length, &bytes, &arrayBuffer, &byteOffset) != napi_ok) return false;
+  } else {
+    return false;
+  }
+  bool isArrayBuffer = false;
+  if (napi_is_arraybuffer(env, arrayBuffer, &isArrayBuffer) != napi_ok) return false;
+  shared = !isArrayBuffer;
+  if (isArrayBuffer && napi_is_detached_arraybuffer(env, arrayBuffer, &detached) != napi_ok) return false;
+  if (detached) length = 0;
+  data = static_cast<uint8_t*>(bytes);
+  return true;
+}
+
+FramePullSource::FramePullSource(bool latestOnly, size_t capacity, bool zeroCopy)
+    : m_latestOnly(latestOnly), m_capacity(latestOnly ? 1 : (capacity == 0 ? 1 : capacity)), m_zeroCopy(zeroCopy) {
+  m_stats.capacity = m_capacity;
+  m_stats.latestOnly = latestOnly;
+}
+
+FramePullSource::~FramePullSource() {
+  if (m_tsfn) m_tsfn.Release();
+}
+
+std::shared_ptr<FramePullSource> FramePullSource::Create(Napi::Env env, bool latestOnly, size_t capacity, bool zeroCopy) {
+  std::shared_ptr<FramePullSource> source(new FramePullSource(latestOnly, capacity, zeroCopy));
+  std::weak_ptr<FramePullSource> weak = source;
+  // The finalizer also runs when the environment is torn down (worker exit)
+  source->m_tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function(), "FramePullSource", 0, 1, [weak](Napi::Env) {
+    if (std::shared_ptr<FramePullSource> self = weak.lock()) {
+      std::lock_guard<std::mutex> lock(self->m_lock);
+      self->m_closed = true;
+      self->m_tsfn = Napi::ThreadSafeFunction();
+    }
+  });
+  return source;
+}
+
+bool FramePullSource::Wanted() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_closed) return false;
+  // Frames being written into readInto buffers count as ready. Latest-only
+  // admits one frame per waiting request; a frame admitted while an earlier
+  // one is still converting replaces it (superseded).
+  const size_t coming = m_ready.size() + m_claimed;
+  const bool wanted = m_latestOnly ? m_requests.size() > coming : coming < m_capacity;
+  if (!wanted) ++m_stats.skipped;
+  return wanted;
+}
+
+uint8_t* FramePullSource::Claim(size_t size, size_t& outCapacity) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_closed) return nullptr;
+  // The next frame answers the first unclaimed request that no ready frame
+  // in pooled storage is headed for
+  size_t covered = 0;
+  for (const FramePtr& frame : m_ready) {
+    if (!frame->external) ++covered;
+  }
+  for (const std::unique_ptr<PendingRequest>& request : m_requests) {
+    if (request->claimed) continue;
+    if (covered > 0) {
+      --covered;
+      continue;
+    }
+    // Only shared buffers are written from here; frames for other buffers,
+    // and frames too large for the buffer, go to pooled storage and are
+    // copied or rejected on the JS thread
+    if (!request->into || request->expired || size > request->length) return nullptr;
+    request->claimed = true;
+    ++m_claimed;
+    outCapacity = request->length;
+    return request->into;
+  }
+  return nullptr;
+}
+
+void FramePullSource::Release(uint8_t* storage) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_claimed > 0) --m_claimed;
+  // Still queued: the frame was dropped before delivery (pool exhausted,
+  // conversion failure, superseded); the request waits for another frame
+  // unless it has expired meanwhile
+  for (const std::unique_ptr<PendingRequest>& request : m_requests) {
+    if (request->claimed && request->into == storage) {
+      request->claimed = false;
+      if (request->expired || !m_ready.empty()) ScheduleResolve();
+      return;
+    }
+  }
+}
+
+void FramePullSource::Push(FramePtr frame) {
+  if (!frame) return;
+  // Replaced frames go back to their pool after the lock is dropped
+  std::deque<FramePtr> evicted;
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_closed) return;
+  m_ready.push_back(std::move(frame));
+  // Only frames in pooled storage are replaced. A frame written into a
+  // readInto buffer answers the request that claimed it: replacing it would
+  // waste the write or answer the requests out of order.
+  size_t pooled = 0;
+  for (const FramePtr& ready : m_ready) {
+    if (!ready->external) ++pooled;
+  }
+  for (auto it = m_ready.begin(); pooled > m_capacity && it != m_ready.end();) {
+    if ((*it)->external) {
+      ++it;
+      continue;
+    }
+    evicted.push_back(std::move(*it));
+    it = m_ready.erase(it);
+    --pooled;
+    ++m_stats.superseded;
+  }
+  if (!m_requests.empty()) ScheduleResolve();
+}
+
+void FramePullSource::ScheduleResolve() {
+  if (m_resolvePending || !m_tsfn) return;
+  std::weak_ptr<FramePullSource> weak = shared_from_this();
+  auto resolve = [weak](Napi::Env env, Napi::Function) {
+    std::shared_ptr<FramePullSource> self = weak.lock();
+    // env is null when the TSFN is torn down with a call still queued
+    if (self && static_cast<napi_env>(env) != nullptr) self->Resolve(env);
+  };
+  m_resolvePending = m_tsfn.NonBlockingCall(resolve) == napi_ok;
+}
+
+void FramePullSource::Resolve(Napi::Env env) {
+  for (;;) {
+    std::unique_ptr<PendingRequest> request;
+    FramePtr frame;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      // Expired requests whose frame was dropped are answered with null
+      for (auto it = m_requests.begin(); it != m_requests.end(); ++it) {
+        if ((*it)->expired && !(*it)->claimed) {
+          request = std::move(*it);
+          m_requests.erase(it);
+          break;
+        }
+      }
+      // A frame written into a readInto buffer answers that request; other
+      // frames answer the first request not waiting on its own frame
+      for (auto f = m_ready.begin(); !request && f != m_ready.end();) {
+        auto it = m_requests.begin();
+        for (; it != m_requests.end(); ++it) {
+          if ((*f)->external ? (*it)->claimed && (*it)->into == (*f)->external : !(*it)->claimed) break;
+        }
+        if (it == m_requests.end()) {
+          ++f;
+          continue;
+        }
+        request = std::move(*it);
+        m_requests.erase(it);
+        frame = std::move(*f);
+        m_ready.erase(f);
+      }
+      if (!request) {
+        m_resolvePending = false;
+        return;
+      }
+    }
+    Answer(env, *request, std::move(frame));
+  }
+}
+
+void FramePullSource::Answer(Napi::Env env, PendingRequest& request, FramePtr frame) {
+  if (!frame) {
+    request.deferred.Resolve(env.Null());
+    return;
+  }
+  if (!request.readInto) {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      ++m_stats.delivered;
+    }
+    request.deferred.Resolve(FrameToObject(env, std::move(frame)));
+    return;
+  }
+
+  const bool direct = request.into && frame->data() == request.into;
+  if (!direct) {
+    // Pooled storage: the buffer is not shared, the frame was ready before
+    // the request, or it is JPEG output whose size is only known once
+    // encoded. The buffer is looked up again, as JS may have detached or
+    // shrunk it while the request waited.
+    uint8_t* data = nullptr;
+    size_t length = 0;
+    bool shared, detached;
+    if (!GetBufferBytes(env, request.buffer.Value(), data, length, shared, detached) || detached) {
+      request.deferred.Reject(Napi::TypeError::New(env, "readInto buffer was detached before the frame arrived").Value());
+      return;
+    }
+    if (frame->size > length) {
+      request.deferred.Reject(Napi::RangeError::New(env, "readInto buffer is too small for the frame (" + std::to_string(frame->size) + " bytes)").Value());
+      return;
+    }
+    memcpy(data, frame->data(), frame->size);
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    ++m_stats.delivered;
+    ++(direct ? m_stats.direct : m_stats.copied);
+  }
+  Napi::Object result = Napi::Object::New(env);
+  SetFrameInfo(env, result, frame->info, frame->size);
+  // The frame (and with it the claim on the buffer) is released before the
+  // caller sees the buffer again
+  frame.reset();
+  request.deferred.Resolve(result);
+}
+
+Napi::Value FramePullSource::Request(Napi::Env env) {
+  PendingRequest request(Napi::Promise::Deferred::New(env));
+  Napi::Promise promise = request.deferred.Promise();
+  FramePtr frame;
+  bool closed;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    ++m_stats.requested;
+    closed = m_closed;
+    // Earlier requests are answered first
+    if (!closed && m_requests.empty() && !m_ready.empty()) {
+      frame = std::move(m_ready.front());
+      m_ready.pop_front();
+    } else if (!closed) {
+      m_requests.push_back(std::unique_ptr<PendingRequest>(new PendingRequest(request.deferred)));
+    }
+  }
+  if (frame || closed) Answer(env, request, std::move(frame));
+  return promise;
+}
+
+Napi::Value FramePullSource::ReadInto(Napi::Env env, Napi::Value buffer, uint32_t id) {
+  std::unique_ptr<PendingRequest> request(new PendingRequest(Napi::Promise::Deferred::New(env)));
+  Napi::Promise promise = request->deferred.Promise();
+  uint8_t* data = nullptr;
+  size_t length = 0;
+  bool shared, detached;
+  if (!GetBufferBytes(env, buffer, data, length, shared, detached) || detached) {
+    request->deferred.Reject(Napi::TypeError::New(env, "readInto buffer is detached").Value());
+    return promise;
+  }
+  request->readInto = true;
+  // Held until the request is answered: the frame is written or copied
+  // into it then
+  request->buffer = Napi::Persistent(buffer);
+  if (shared) {
+    request->into = data;
+    request->length = length;
+  }
+  request->id = id;
+  FramePtr frame;
+  bool closed;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    ++m_stats.requested;
+    closed = m_closed;
+    // A frame already waiting (only ever in pooled storage here) is copied
+    if (!closed && m_requests.empty() && !m_ready.empty()) {
+      frame = std::move(m_ready.front());
+      m_ready.pop_front();
+    } else if (!closed) {
+      m_requests.push_back(std::move(request));
+    }
+  }
+  if (request) Answer(env, *request, std::move(frame));
+  return promise;
+}
+
+void FramePullSource::Expire(Napi::Env env, uint32_t id) {
+  std::unique_ptr<PendingRequest> request;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (auto it = m_requests.begin(); it != m_requests.end(); ++it) {
+      if (!(*it)->readInto || (*it)->id != id) continue;
+      if ((*it)->claimed) {
+        (*it)->expired = true;
+      } else {
+        request = std::move(*it);
+        m_requests.erase(it);
+      }
+      break;
+    }
+  }
+  if (request) Answer(env, *request, FramePtr());
+}
+
+void FramePullSource::Close(Napi::Env env) {
+  std::deque<FramePtr> dropped;
+  std::deque<std::unique_ptr<PendingRequest>> requests;
+  Napi::ThreadSafeFunction tsfn;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_closed = true;
+    dropped.swap(m_ready);
+    requests.swap(m_requests);
+    tsfn = m_tsfn;
+    m_tsfn = Napi::ThreadSafeFunction();
+  }
+  for (std::unique_ptr<PendingRequest>& request : requests) {
+    request->deferred.Resolve(env.Null());
+  }
+  if (tsfn) tsfn.Release();
+}
+
+void FramePullSource::Detach() {
+  std::deque<FramePtr> dropped;
+  std::deque<std::unique_ptr<PendingRequest>> requests;
+  Napi::ThreadSafeFunction tsfn;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_closed = true;
+    dropped.swap(m_ready);
+    requests.swap(m_requests);
+    tsfn = m_tsfn;
+    m_tsfn = Napi::ThreadSafeFunction();
+  }
+  if (tsfn) tsfn.Release();
+}
+
+FramePullStats FramePullSource::GetStats() const {
+  std::lock_guard<std::mutex> lock(m_lock);
+  FramePullStats stats = m_stats;
+  stats.ready = m_ready.size();
+  return stats;
+}
+
+Napi::Object FramePullSource::FrameToObject(Napi::Env env, FramePtr frame) {
+  const FrameInfo info = frame->info;
+  const size_t size = frame->size;
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("data", FrameToBuffer(env, frame.release(), m_zeroCopy));
+  SetFrameInfo(env, result, info, size);
+  return result;
+}
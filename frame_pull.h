@@ -0,0 +1,110 @@
+#pragma once
+#include <napi.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "frame.h"
+
+struct FramePullStats {
+  uint64_t requested = 0;   // frames asked for by JS (pulls and readInto)
+  uint64_t delivered = 0;   // requests answered with a frame
+  uint64_t skipped = 0;     // frames the gate refused before conversion
+  uint64_t superseded = 0;  // converted frames replaced before JS took them
+  uint64_t direct = 0;      // readInto frames written straight into the caller's (shared) buffer
+  uint64_t copied = 0;      // readInto frames copied from pooled storage
+  size_t ready = 0;         // frames waiting for a request
+  size_t capacity = 0;
+  bool latestOnly = false;
+};
+
+// Readiness slot behind cam.frames() and cam.readInto(): frames are produced
+// on demand rather than pushed. The backend asks Wanted() (its frame gate)
+// before converting or copying a frame, so nothing is produced for a
+// consumer that is busy or gone:
+//   - latest-only: a frame is admitted only while a request is waiting for
+//     one, and a newer frame replaces an older one in pooled storage (a frame
+//     written into a readInto buffer is never replaced);
+//   - otherwise: frames are admitted while fewer than `capacity` are ready,
+//     and handed out in order.
+// It is also the backend's frame destination: while the next request to be
+// answered is a readInto over a SharedArrayBuffer, the frame is converted or
+// copied straight into the caller's buffer. Other buffers can be detached or
+// shrunk by JS at any time, so their frames go to pooled storage and are
+// copied on the JS thread. Request, ReadInto, Expire and Close run on the JS
+// thread; Wanted, Push, Claim and Release on capture threads.
+class FramePullSource : public FrameDestination, public std::enable_shared_from_this<FramePullSource> {
+ public:
+  static std::shared_ptr<FramePullSource> Create(Napi::Env env, bool latestOnly, size_t capacity, bool zeroCopy);
+  ~FramePullSource();
+  FramePullSource(const FramePullSource&) = delete;
+  FramePullSource& operator=(const FramePullSource&) = delete;
+
+  // Frame gate: whether the next captured frame should be produced
+  bool Wanted();
+  // A produced frame; answers a waiting request or becomes ready
+  void Push(FramePtr frame);
+  // Promise of the next frame object, or of null once closed
+  Napi::Value Request(Napi::Env env);
+  // Promise of the metadata of the next frame once it is written into
+  // `buffer` (an ArrayBuffer or a view, held until then), or of null once
+  // closed or expired. A frame that does not fit rejects with a RangeError,
+  // a detached buffer with a TypeError.
+  Napi::Value ReadInto(Napi::Env env, Napi::Value buffer, uint32_t id);
+  // Answer readInto request `id` with null (its timeout). A request whose
+  // frame is already being written is answered with that frame instead.
+  void Expire(Napi::Env env, uint32_t id);
+  // Drop ready frames and answer waiting requests with null. Safe to call
+  // more than once. Frames being written into readInto buffers must be done
+  // (capture stopped) before it is called.
+  void Close(Napi::Env env);
+  // Close without calling into JS (Camera finalizer): waiting requests are
+  // dropped unanswered and the thread-safe function is released. Capture
+  // must be stopped first.
+  void Detach();
+
+  // FrameDestination: the buffer of the readInto request the next frame answers
+  uint8_t* Claim(size_t size, size_t& outCapacity) override;
+  void Release(uint8_t* storage) override;
+
+  FramePullStats GetStats() const;
+
+ private:
+  // A waiting pullFrameAsync or readInto
+  struct PendingRequest {
+    explicit PendingRequest(Napi::Promise::Deferred d) : deferred(d) {}
+    Napi::Promise::Deferred deferred;
+    // readInto only: the caller's buffer, and its bytes when it is shared
+    // (the capture thread may write those directly)
+    bool readInto = false;
+    Napi::Reference<Napi::Value> buffer;
+    uint8_t* into = nullptr;
+    size_t length = 0;
+    uint32_t id = 0;
+    bool claimed = false;  // a frame is being written into `into`
+    bool expired = false;  // timed out while claimed
+  };
+
+  FramePullSource(bool latestOnly, size_t capacity, bool zeroCopy);
+  // Queue a Resolve on the JS thread. Called with m_lock held.
+  void ScheduleResolve();
+  // Pair ready frames with waiting requests and answer expired ones (JS thread)
+  void Resolve(Napi::Env env);
+  // Settle `request` with `frame` (null = no frame)
+  void Answer(Napi::Env env, PendingRequest& request, FramePtr frame);
+  Napi::Object FrameToObject(Napi::Env env, FramePtr frame);
+
+  const bool m_latestOnly;
+  const size_t m_capacity;
+  const bool m_zeroCopy;
+  mutable std::mutex m_lock;  // guards the fields below; N-API handles in
+                              // m_requests are only touched on the JS thread
+  std::deque<std::unique_ptr<PendingRequest>> m_requests;
+  std::deque<FramePtr> m_ready;
+  size_t m_claimed = 0;  // frames being written into readInto buffers
+  bool m_resolvePending = false;
+  bool m_closed = false;
+  Napi::ThreadSafeFunction m_tsfn;
+  FramePullStats m_stats;
+};
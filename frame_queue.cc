@@ -0,0 +1,130 @@
+#include "frame_queue.h"
+
+#include <utility>
+
+bool ParseDropPolicy(const std::string& s, DropPolicy& out) {
+  if (s == "drop-oldest") {
+    out = DropPolicy::DropOldest;
+    return true;
+  }
+  if (s == "drop-newest") {
+    out = DropPolicy::DropNewest;
+    return true;
+  }
+  if (s == "latest-only" || s == "latest") {
+    out = DropPolicy::LatestOnly;
+    return true;
+  }
+  if (s == "block") {
+    out = DropPolicy::Block;
+    return true;
+  }
+  return false;
+}
+
+const char* DropPolicyName(DropPolicy policy) {
+  switch (policy) {
+    case DropPolicy::DropOldest:
+      return "drop-oldest";
+    case DropPolicy::DropNewest:
+      return "drop-newest";
+    case DropPolicy::LatestOnly:
+      return "latest-only";
+    case DropPolicy::Block:
+      return "block";
+  }
+  return "drop-oldest";
+}
+
+FrameQueue::FrameQueue(size_t capacity, DropPolicy policy)
+    : m_capacity(policy == DropPolicy::LatestOnly ? 1 : (capacity ? capacity : 1)),
+      m_policy(policy) {
+  m_stats.capacity = m_capacity;
+}
+
+FrameQueue::~FrameQueue() {
+  Close();
+}
+
+bool FrameQueue::Push(FramePtr frame, const std::atomic<bool>* cancel) {
+  if (!frame) return false;
+
+  // Frames evicted by the policy are released after the lock is dropped:
+  // returning a frame to its pool takes the pool's own lock.
+  FramePtr evicted;
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  if (m_closed) {
+    ++m_stats.dropped;
+    return false;
+  }
+
+  if (m_frames.size() >= m_capacity) {
+    switch (m_policy) {
+      case DropPolicy::DropNewest:
+        ++m_stats.dropped;
+        lock.unlock();
+        return false;
+      case DropPolicy::Block:
+        m_space.wait(lock, [&] { return m_closed || m_frames.size() < m_capacity || (cancel && cancel->load()); });
+        if (m_closed || m_frames.size() >= m_capacity) {
+          ++m_stats.dropped;
+          return false;
+        }
+        break;
+      case DropPolicy::DropOldest:
+      case DropPolicy::LatestOnly:
+        evicted = std::move(m_frames.front());
+        m_frames.pop_front();
+        ++m_stats.dropped;
+        break;
+    }
+  }
+
+  m_frames.push_back(std::move(frame));
+  ++m_stats.queued;
+
+  bool wake = !m_wakePending;
+  m_wakePending = true;
+  return wake;
+}
+
+FramePtr FrameQueue::Pop() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_frames.empty()) {
+    m_wakePending = false;
+    return FramePtr();
+  }
+  FramePtr frame = std::move(m_frames.front());
+  m_frames.pop_front();
+  ++m_stats.delivered;
+  m_space.notify_one();
+  return frame;
+}
+
+void FrameQueue::Close() {
+  std::deque<FramePtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_closed = true;
+    m_stats.dropped += m_frames.size();
+    pending.swap(m_frames);
+    m_wakePending = false;
+  }
+  m_space.notify_all();
+}
+
+void FrameQueue::WakeProducers() {
+  {
+    // Orders the caller's cancel store before the waiters' predicate check
+    std::lock_guard<std::mutex> lock(m_lock);
+  }
+  m_space.notify_all();
+}
+
+FrameQueueStats FrameQueue::GetStats() const {
+  std::lock_guard<std::mutex> lock(m_lock);
+  FrameQueueStats stats = m_stats;
+  stats.depth = m_frames.size();
+  return stats;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "frame.h"
+
+// What to do with a new frame when the delivery queue is full.
+enum class DropPolicy {
+  DropOldest,  // evict the oldest queued frame (default)
+  DropNewest,  // reject the incoming frame
+  LatestOnly,  // mailbox: keep only the most recent frame
+  Block,       // stall the producer until the consumer makes room
+};
+
+// Parse 'drop-oldest' | 'drop-newest' | 'latest-only' | 'block'.
+bool ParseDropPolicy(const std::string& s, DropPolicy& out);
+const char* DropPolicyName(DropPolicy policy);
+
+struct FrameQueueStats {
+  uint64_t queued = 0;     // frames accepted into the queue
+  uint64_t delivered = 0;  // frames handed to the consumer
+  uint64_t dropped = 0;    // frames discarded by the drop policy or on close
+  size_t depth = 0;        // frames currently queued
+  size_t capacity = 0;
+};
+
+// Bounded hand-off between the capture thread (producer) and the JS thread
+// (consumer). The queue also tracks whether a consumer wake-up is pending so
+// the producer only schedules one TSFN call per burst instead of one per frame.
+class FrameQueue {
+ public:
+  FrameQueue(size_t capacity, DropPolicy policy);
+  ~FrameQueue();
+
+  // Enqueue a frame according to the drop policy. Returns true when the caller
+  // must wake the consumer (no drain was pending). A producer blocked by the
+  // 'block' policy gives up (dropping the frame) once `cancel` is set and
+  // WakeProducers is called.
+  bool Push(FramePtr frame, const std::atomic<bool>* cancel = nullptr);
+  // Dequeue the next frame for delivery. Returns null once the queue is empty,
+  // which also clears the pending wake-up so the next Push schedules a new one.
+  FramePtr Pop();
+  // Drop everything queued and release blocked producers. Further pushes drop.
+  void Close();
+  // Re-check the cancel flags of blocked producers (queue stays open).
+  void WakeProducers();
+
+  DropPolicy Policy() const { return m_policy; }
+  FrameQueueStats GetStats() const;
+
+ private:
+  const size_t m_capacity;
+  const DropPolicy m_policy;
+  mutable std::mutex m_lock;
+  std::condition_variable m_space;
+  std::deque<FramePtr> m_frames;
+  bool m_wakePending = false;
+  bool m_closed = false;
+  FrameQueueStats m_stats;
+};
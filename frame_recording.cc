@@ -0,0 +1,282 @@
+#include "frame_recording.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'C', 'A', 'M', 'R', 'E', 'C', '0', '2'};
+// Version 1: records without the device time
+const char kMagicV1[8] = {'C', 'A', 'M', 'R', 'E', 'C', '0', '1'};
+const char kIndexMagic[8] = {'C', 'A', 'M', 'R', 'E', 'C', 'I', 'X'};
+constexpr size_t kHeaderSize = 96;
+constexpr size_t kRecordHeaderSize = 24;
+constexpr size_t kRecordHeaderSizeV1 = 16;
+constexpr size_t kFooterSize = 24;
+constexpr size_t kSubtypeSize = 64;
+// stdio buffer: absorbs small (MJPEG) frames without a syscall each
+constexpr size_t kWriteBuffer = 1 << 20;
+
+void PutU32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+void PutU64(uint8_t* p, uint64_t v) {
+  for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+uint32_t GetU32(const uint8_t* p) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+  return v;
+}
+uint64_t GetU64(const uint8_t* p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+  return v;
+}
+
+FILE* OpenForWrite(const std::string& path) {
+#ifdef _WIN32
+  int len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+  if (len <= 0) return nullptr;
+  std::wstring w(len, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &w[0], len);
+  return _wfopen(w.c_str(), L"wb");
+#else
+  return fopen(path.c_str(), "wb");
+#endif
+}
+
+}  // namespace
+
+FrameRecorder::~FrameRecorder() {
+  Close();
+}
+
+HRESULT FrameRecorder::Open(const std::string& path, const CaptureFormat& format) {
+  Close();
+  std::lock_guard<std::mutex> lock(m_lock);
+  FILE* file = OpenForWrite(path);
+  if (!file) return E_ACCESSDENIED;
+  setvbuf(file, nullptr, _IOFBF, kWriteBuffer);
+
+  uint8_t header[kHeaderSize] = {};
+  memcpy(header, kMagic, sizeof(kMagic));
+  PutU32(header + 8, static_cast<uint32_t>(kHeaderSize));
+  PutU32(header + 12, static_cast<uint32_t>(format.format));
+  PutU32(header + 16, format.width);
+  PutU32(header + 20, format.height);
+  uint64_t rateBits;
+  static_assert(sizeof(rateBits) == sizeof(format.frameRate), "f64 frame rate");
+  memcpy(&rateBits, &format.frameRate, sizeof(rateBits));
+  PutU64(header + 24, rateBits);
+  // Prefer the native id (round-trips through ParseNativeFormat on replay)
+  const std::string& subtype = format.guid.empty() ? format.subtype : format.guid;
+  memcpy(header + 32, subtype.data(), std::min(subtype.size(), kSubtypeSize - 1));
+  if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+    fclose(file);
+    return E_FAIL;
+  }
+
+  m_file = file;
+  m_failed = false;
+  m_offset = kHeaderSize;
+  m_index.clear();
+  m_format = format.format;
+  m_width = format.width;
+  m_height = format.height;
+  m_started = false;
+  m_lastUs = 0;
+  return S_OK;
+}
+
+void FrameRecorder::Write(const uint8_t* data, size_t size, const FrameInfo& info) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_file || m_failed) return;
+  if (info.format != m_format || info.width != m_width || info.height != m_height) return;
+  const uint32_t packedStride = PixelFormatStride(info.format, info.width);
+  if (packedStride != 0 && info.stride > packedStride) {
+    if (size < PixelFormatStridedFrameSize(info.format, info.stride, info.height)) return;
+    m_packed.resize(PixelFormatFrameSize(info.format, info.width, info.height));
+    PackPixelRows(info.format, data, info.stride, info.width, info.height, m_packed.data());
+    data = m_packed.data();
+    size = m_packed.size();
+  }
+  if (size > UINT32_MAX) return;
+  if (!m_started) {
+    m_baseUs = info.deviceTimeUs;
+    m_started = true;
+  }
+  // Replay paces by differences; a device clock that steps back must not wrap
+  const int64_t sinceBase = info.deviceTimeUs - m_baseUs;
+  const uint64_t timestampUs = std::max<uint64_t>(m_lastUs, sinceBase > 0 ? static_cast<uint64_t>(sinceBase) : 0);
+  m_lastUs = timestampUs;
+
+  uint8_t record[kRecordHeaderSize];
+  PutU32(record, static_cast<uint32_t>(size));
+  PutU32(record + 4, 0);
+  PutU64(record + 8, timestampUs);
+  PutU64(record + 16, static_cast<uint64_t>(info.deviceTimeUs));
+  if (fwrite(record, 1, sizeof(record), m_file) != sizeof(record) || fwrite(data, 1, size, m_file) != size) {
+    m_failed = true;
+    return;
+  }
+  m_index.push_back(m_offset);
+  m_offset += kRecordHeaderSize + size;
+}
+
+HRESULT FrameRecorder::Close() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_file) return S_OK;
+  bool ok = !m_failed;
+  if (ok) {
+    // Index, then the footer that locates it
+    std::vector<uint8_t> index(m_index.size() * 8 + kFooterSize);
+    for (size_t i = 0; i < m_index.size(); ++i) PutU64(&index[i * 8], m_index[i]);
+    uint8_t* footer = index.data() + m_index.size() * 8;
+    PutU64(footer, m_offset);
+    PutU64(footer + 8, m_index.size());
+    memcpy(footer + 16, kIndexMagic, sizeof(kIndexMagic));
+    ok = fwrite(index.data(), 1, index.size(), m_file) == index.size();
+  }
+  if (fclose(m_file) != 0) ok = false;
+  m_file = nullptr;
+  m_index.clear();
+  m_index.shrink_to_fit();
+  m_packed.clear();
+  m_packed.shrink_to_fit();
+  return ok ? S_OK : E_FAIL;
+}
+
+uint64_t FrameRecorder::FramesWritten() const {
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_index.size();
+}
+
+FrameRecording::~FrameRecording() {
+  Close();
+}
+
+HRESULT FrameRecording::Open(const std::string& path) {
+  Close();
+#ifdef _WIN32
+  int len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+  if (len <= 0) return E_INVALIDARG;
+  std::wstring w(len, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &w[0], len);
+  HANDLE file = CreateFileW(w.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) return HRESULT_FROM_WIN32(GetLastError());
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || static_cast<uint64_t>(size.QuadPart) < kHeaderSize) {
+    CloseHandle(file);
+    return E_INVALIDARG;
+  }
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  const void* base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!base) {
+    HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    return hr;
+  }
+  m_fileHandle = file;
+  m_mapping = mapping;
+  m_length = static_cast<size_t>(size.QuadPart);
+#else
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return errno == ENOENT ? CAPTURE_E_NOT_FOUND : E_ACCESSDENIED;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < kHeaderSize) {
+    close(fd);
+    return E_INVALIDARG;
+  }
+  void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);  // the mapping keeps the file
+  if (base == MAP_FAILED) return E_OUTOFMEMORY;
+  // Replay reads front to back
+  madvise(base, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+  m_length = static_cast<size_t>(st.st_size);
+#endif
+  m_base = static_cast<const uint8_t*>(base);
+
+  const uint8_t* h = m_base;
+  const bool v1 = memcmp(h, kMagicV1, sizeof(kMagicV1)) == 0;
+  if ((!v1 && memcmp(h, kMagic, sizeof(kMagic)) != 0) || GetU32(h + 8) < kHeaderSize || GetU32(h + 8) > m_length) {
+    Close();
+    return E_INVALIDARG;
+  }
+  const size_t recordHeaderSize = v1 ? kRecordHeaderSizeV1 : kRecordHeaderSize;
+  const size_t headerSize = GetU32(h + 8);
+  m_format = CaptureFormat();
+  m_format.format = static_cast<PixelFormat>(GetU32(h + 12));
+  m_format.width = GetU32(h + 16);
+  m_format.height = GetU32(h + 20);
+  uint64_t rateBits = GetU64(h + 24);
+  memcpy(&m_format.frameRate, &rateBits, sizeof(rateBits));
+  const char* subtype = reinterpret_cast<const char*>(h + 32);
+  m_format.guid.assign(subtype, strnlen(subtype, kSubtypeSize));
+  m_format.subtype = m_format.format != PixelFormat::Unknown ? PixelFormatName(m_format.format) : m_format.guid;
+
+  auto readRecord = [this, v1, recordHeaderSize](uint64_t offset, Entry& out) {
+    if (offset > m_length || m_length - offset < recordHeaderSize) return false;
+    const uint8_t* r = m_base + offset;
+    uint32_t size = GetU32(r);
+    if (m_length - offset - recordHeaderSize < size) return false;
+    out.data = r + recordHeaderSize;
+    out.size = size;
+    out.timestampUs = GetU64(r + 8);
+    out.deviceTimeUs = v1 ? 0 : static_cast<int64_t>(GetU64(r + 16));
+    return true;
+  };
+
+  // Indexed: trust the footer if it is consistent, otherwise fall back to a scan
+  m_frames.clear();
+  m_indexed = false;
+  if (m_length >= headerSize + kFooterSize && memcmp(m_base + m_length - 8, kIndexMagic, sizeof(kIndexMagic)) == 0) {
+    const uint8_t* footer = m_base + m_length - kFooterSize;
+    uint64_t indexOffset = GetU64(footer), count = GetU64(footer + 8);
+    if (indexOffset >= headerSize && indexOffset <= m_length - kFooterSize && count == (m_length - kFooterSize - indexOffset) / 8) {
+      m_frames.reserve(static_cast<size_t>(count));
+      Entry e;
+      m_indexed = true;
+      for (uint64_t i = 0; i < count; ++i) {
+        if (!readRecord(GetU64(m_base + indexOffset + i * 8), e)) {
+          m_indexed = false;
+          m_frames.clear();
+          break;
+        }
+        m_frames.push_back(e);
+      }
+    }
+  }
+  if (!m_indexed) {
+    Entry e;
+    for (uint64_t offset = headerSize; readRecord(offset, e); offset += recordHeaderSize + e.size) m_frames.push_back(e);
+  }
+  return S_OK;
+}
+
+void FrameRecording::Close() {
+#ifdef _WIN32
+  if (m_base) UnmapViewOfFile(m_base);
+  if (m_mapping) CloseHandle(static_cast<HANDLE>(m_mapping));
+  if (m_fileHandle) CloseHandle(static_cast<HANDLE>(m_fileHandle));
+  m_mapping = nullptr;
+  m_fileHandle = nullptr;
+#else
+  if (m_base) munmap(const_cast<uint8_t*>(m_base), m_length);
+#endif
+  m_base = nullptr;
+  m_length = 0;
+  m_frames.clear();
+  m_indexed = false;
+}
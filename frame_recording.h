@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "capture_backend.h"
+
+// Frame recordings: the captured frame stream of a session, as the device
+// delivered it (before the gate, conversion and delivery), written to disk so
+// it can be replayed later (ReplayCaptureBackend) with its original payload
+// sizes and device timing. All integers are little-endian.
+//
+//   header   96 bytes
+//     0  char[8]  "CAMREC02"
+//     8  u32      header size (96)
+//    12  u32      PixelFormat of every frame (the device format)
+//    16  u32      width
+//    20  u32      height
+//    24  f64      nominal frame rate
+//    32  char[64] subtype / native id, NUL-padded
+//   records  one per frame, back to back
+//     u32 payload size | u32 flags (0) | u64 timestamp (us since the first
+//     frame, device clock) | i64 device time (us) | payload
+//   index    written on Close
+//     u64 record offset, one per frame
+//     u64 index offset | u64 frame count | char[8] "CAMRECIX"
+//
+// Raw payloads are tightly packed. "CAMREC01" files (no device time, 16-byte
+// record headers) are still read.
+//
+// A recording cut short (crash, full disk) has no index; the reader then scans
+// the records and stops at the first truncated one.
+
+// Appends captured frames to a recording. Write is called from the backend's
+// frame tap (the capture thread); writes go through a large stdio buffer so a
+// frame costs one memcpy in the common case.
+class FrameRecorder {
+ public:
+  FrameRecorder() = default;
+  ~FrameRecorder();
+  FrameRecorder(const FrameRecorder&) = delete;
+  FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+  // Create (truncate) `path` and write the header for frames in `format`.
+  HRESULT Open(const std::string& path, const CaptureFormat& format);
+  // Append one frame as the backend's tap saw it: stamped with its device
+  // time, padded rows packed. Frames of another format or size than the
+  // header's are skipped. After a write error the recorder stops writing and
+  // Close reports the failure.
+  void Write(const uint8_t* data, size_t size, const FrameInfo& info);
+  // Write the index and close the file. Safe to call more than once.
+  HRESULT Close();
+
+  uint64_t FramesWritten() const;
+
+ private:
+  mutable std::mutex m_lock;
+  FILE* m_file = nullptr;
+  bool m_failed = false;
+  uint64_t m_offset = 0;
+  std::vector<uint64_t> m_index;
+  PixelFormat m_format = PixelFormat::Unknown;
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+  bool m_started = false;
+  int64_t m_baseUs = 0;  // device time of the first frame
+  uint64_t m_lastUs = 0;
+  // Padded frames are packed here before they are written
+  std::vector<uint8_t> m_packed;
+};
+
+// Read-only view of a recording, memory-mapped so replay copies each payload
+// straight from the page cache into a pooled frame.
+class FrameRecording {
+ public:
+  struct Entry {
+    const uint8_t* data;
+    uint32_t size;
+    uint64_t timestampUs;
+    int64_t deviceTimeUs;  // 0 in CAMREC01 files
+  };
+
+  FrameRecording() = default;
+  ~FrameRecording();
+  FrameRecording(const FrameRecording&) = delete;
+  FrameRecording& operator=(const FrameRecording&) = delete;
+
+  HRESULT Open(const std::string& path);
+  void Close();
+
+  bool IsOpen() const { return m_base != nullptr; }
+  // Stream format from the header (format, subtype/guid, size, frame rate)
+  const CaptureFormat& Format() const { return m_format; }
+  const std::vector<Entry>& Frames() const { return m_frames; }
+  // Whether the index was present (false = recovered by scanning)
+  bool Indexed() const { return m_indexed; }
+
+ private:
+  const uint8_t* m_base = nullptr;
+  size_t m_length = 0;
+#ifdef _WIN32
+  void* m_fileHandle = nullptr;
+  void* m_mapping = nullptr;
+#endif
+  CaptureFormat m_format;
+  std::vector<Entry> m_frames;
+  bool m_indexed = false;
+};
@@ -0,0 +1,105 @@
+#include "frame_ring.h"
+
+#include <cstring>
+
+// Header fields are accessed as std::atomic<int32_t> in place, like the
+// Int32Array JS uses for Atomics on the same words.
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "atomic int32 must be a plain int32");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "atomic int32 must be lock-free");
+
+FrameRing::~FrameRing() {
+  Detach();
+}
+
+std::atomic<int32_t>& FrameRing::Field(FrameRingField field) const {
+  return reinterpret_cast<std::atomic<int32_t>*>(m_base)[field];
+}
+
+HRESULT FrameRing::Attach(uint8_t* data, size_t length) {
+  if (!data || length < kFrameRingHeaderBytes || reinterpret_cast<uintptr_t>(data) % 8 != 0) return E_INVALIDARG;
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_base) return CAPTURE_E_BUSY;
+
+  const int32_t* header = reinterpret_cast<const int32_t*>(data);
+  const uint32_t slotCount = static_cast<uint32_t>(header[kRingSlotCount]);
+  const uint32_t slotBytes = static_cast<uint32_t>(header[kRingSlotBytes]);
+  const uint32_t slotStride = static_cast<uint32_t>(header[kRingSlotStride]);
+  if (static_cast<uint32_t>(header[kRingMagic]) != kFrameRingMagic || static_cast<uint32_t>(header[kRingVersion]) != kFrameRingVersion) {
+    return E_INVALIDARG;
+  }
+  if (slotCount < 2 || slotCount > kFrameRingMaxSlots || (slotCount & (slotCount - 1)) != 0) return E_INVALIDARG;
+  if (slotBytes == 0 || slotStride % 64 != 0 || slotStride < kFrameRingSlotHeaderBytes + slotBytes) return E_INVALIDARG;
+  if (length < kFrameRingHeaderBytes + static_cast<size_t>(slotCount) * slotStride) return E_INVALIDARG;
+
+  m_base = data;
+  // One writer at a time: a ring left capturing belongs to another camera.
+  int32_t state = Field(kRingState).load();
+  if (state == kRingCapturing || !Field(kRingState).compare_exchange_strong(state, kRingCapturing)) {
+    m_base = nullptr;
+    return CAPTURE_E_BUSY;
+  }
+  m_slotCount = slotCount;
+  m_slotBytes = slotBytes;
+  m_slotStride = slotStride;
+  m_wakePending.store(false);
+  m_stats = FrameRingStats();
+  m_stats.slots = slotCount;
+  m_stats.slotBytes = slotBytes;
+  // Publish numbers continue across sessions so readers keep their place.
+  Field(kRingGeneration).fetch_add(1);
+  return S_OK;
+}
+
+void FrameRing::Detach() {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_base) return;
+  Field(kRingState).store(kRingStopped);
+  Field(kRingSignal).fetch_add(1);
+  m_base = nullptr;
+}
+
+bool FrameRing::Attached() const {
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_base != nullptr;
+}
+
+bool FrameRing::Publish(const Frame& frame) {
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_base) return false;
+  if (frame.size > m_slotBytes) {
+    Field(kRingTooLarge).fetch_add(1, std::memory_order_relaxed);
+    ++m_stats.tooLarge;
+    return false;
+  }
+
+  // Claim before overwriting: a reader that sees the claim has moved past
+  // its frame's lap discards what it read.
+  const uint32_t n = static_cast<uint32_t>(Field(kRingPublished).load(std::memory_order_relaxed)) + 1;
+  Field(kRingClaimed).store(static_cast<int32_t>(n), std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  uint8_t* slot = m_base + kFrameRingHeaderBytes + static_cast<size_t>(n & (m_slotCount - 1)) * m_slotStride;
+  const FrameInfo& info = frame.info;
+  const int32_t ints[8] = {static_cast<int32_t>(n), static_cast<int32_t>(frame.size), static_cast<int32_t>(info.format), static_cast<int32_t>(info.width),
+                           static_cast<int32_t>(info.height), static_cast<int32_t>(info.stride), static_cast<int32_t>(info.flags), 0};
+  const double times[4] = {static_cast<double>(info.sequence), static_cast<double>(info.deviceTimeUs), static_cast<double>(info.timestampUs),
+                           static_cast<double>(info.arrivalUs)};
+  memcpy(slot, ints, sizeof(ints));
+  memcpy(slot + sizeof(ints), times, sizeof(times));
+  memcpy(slot + kFrameRingSlotHeaderBytes, frame.data(), frame.size);
+
+  Field(kRingPublished).store(static_cast<int32_t>(n), std::memory_order_release);
+  Field(kRingSignal).fetch_add(1);
+  ++m_stats.published;
+
+  // Pollers cost nothing; only a blocked consumer needs a notify, and one
+  // pending notify covers every frame published until it runs.
+  if (Field(kRingWaiters).load() <= 0 || m_wakePending.exchange(true)) return false;
+  ++m_stats.wakes;
+  return true;
+}
+
+FrameRingStats FrameRing::GetStats() const {
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_stats;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+#include "frame.h"
+#include "platform.h"
+
+// Frame ring: delivered frames written into caller-allocated shared memory (a
+// SharedArrayBuffer laid out by createFrameRing in frame_ring.js) so JS and
+// worker_threads consumers can read them without a per-frame N-API call.
+// All integers are little-endian; slots start 64-byte aligned.
+//
+//   header   64 bytes, int32 fields
+//     0  magic "FRNG" (0x474E5246)
+//     1  version (1)
+//     2  slot count (power of two, 2-1024)
+//     3  slot payload capacity in bytes
+//     4  slot stride in bytes (64 + capacity rounded up to 64)
+//     5  claimed: publish number of the frame being written
+//     6  published: publish number of the newest complete frame
+//     7  signal: bumped on every publish and on stop (the Atomics.wait word)
+//     8  state (0 idle, 1 capturing, 2 stopped)
+//     9  generation: capture sessions that attached to the ring
+//    10  waiters: consumers blocked in Atomics.wait / waitAsync
+//    11  frames dropped because they did not fit a slot
+//   slots    slot count x stride, frame n in slot n & (slot count - 1)
+//     0  i32 publish number | 4 i32 size | 8 i32 PixelFormat | 12 i32 width
+//    16  i32 height | 20 i32 stride | 24 i32 flags | 28 reserved
+//    32  f64 sequence | 40 f64 device time | 48 f64 timestamp | 56 f64 arrival
+//    64  payload
+//
+// Publish numbers start at 1 and wrap at 2^32. A frame is intact while
+// claimed - n < slot count; readers check that after reading (seqlock style)
+// to detect being lapped by the writer.
+enum FrameRingField {
+  kRingMagic,
+  kRingVersion,
+  kRingSlotCount,
+  kRingSlotBytes,
+  kRingSlotStride,
+  kRingClaimed,
+  kRingPublished,
+  kRingSignal,
+  kRingState,
+  kRingGeneration,
+  kRingWaiters,
+  kRingTooLarge,
+};
+
+enum FrameRingState { kRingIdle, kRingCapturing, kRingStopped };
+
+const uint32_t kFrameRingMagic = 0x474E5246;
+const uint32_t kFrameRingVersion = 1;
+const size_t kFrameRingHeaderBytes = 64;
+const size_t kFrameRingSlotHeaderBytes = 64;
+const uint32_t kFrameRingMaxSlots = 1024;
+
+struct FrameRingStats {
+  uint64_t published = 0;  // frames written this session
+  uint64_t tooLarge = 0;   // frames dropped because they exceeded a slot
+  uint64_t wakes = 0;      // consumer wake-ups requested (coalesced)
+  uint32_t slots = 0;
+  uint32_t slotBytes = 0;
+};
+
+// Writer side of a frame ring. Publish is called from the backend's frame
+// callback; Attach/Detach from the JS thread. Detach waits for a Publish in
+// progress, so the shared memory may be released once it returns.
+class FrameRing {
+ public:
+  FrameRing() = default;
+  ~FrameRing();
+  FrameRing(const FrameRing&) = delete;
+  FrameRing& operator=(const FrameRing&) = delete;
+
+  // Validate the header at `data` and mark the ring capturing. Returns
+  // E_INVALIDARG for a malformed ring and CAPTURE_E_BUSY when another
+  // capture is writing to it.
+  HRESULT Attach(uint8_t* data, size_t length);
+  // Mark the ring stopped and stop writing to it. Safe to call more than once.
+  void Detach();
+  bool Attached() const;
+
+  // Copy `frame` into the next slot and publish it. Returns true when a
+  // consumer is blocked waiting and no wake-up is pending yet: the caller
+  // must then notify the signal word (Atomics.notify) and call WakeDone.
+  bool Publish(const Frame& frame);
+  // Called on the JS thread right before Atomics.notify.
+  void WakeDone() { m_wakePending.store(false); }
+
+  FrameRingStats GetStats() const;
+
+ private:
+  std::atomic<int32_t>& Field(FrameRingField field) const;
+
+  mutable std::mutex m_lock;
+  uint8_t* m_base = nullptr;
+  uint32_t m_slotCount = 0;
+  uint32_t m_slotBytes = 0;
+  size_t m_slotStride = 0;
+  std::atomic<bool> m_wakePending{false};
+  FrameRingStats m_stats;
+};
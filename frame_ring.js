@@ -0,0 +1,209 @@
+// Frame ring: frames written by the native capture thread into a
+// SharedArrayBuffer and read here without any per-frame call into the addon.
+// This file does not load the addon, so worker_threads can require it on
+// their own. The layout is documented in frame_ring.h.
+
+const RING_MAGIC = 0x474e5246; // "FRNG"
+const RING_VERSION = 1;
+const RING_HEADER_BYTES = 64;
+const SLOT_HEADER_BYTES = 64;
+const MAX_SLOTS = 1024;
+
+// Int32 fields of the ring header (FrameRingField in frame_ring.h)
+const RING_MAGIC_FIELD = 0;
+const RING_VERSION_FIELD = 1;
+const RING_SLOT_COUNT = 2;
+const RING_SLOT_BYTES = 3;
+const RING_SLOT_STRIDE = 4;
+const RING_CLAIMED = 5;
+const RING_PUBLISHED = 6;
+const RING_SIGNAL = 7;
+const RING_STATE = 8;
+const RING_GENERATION = 9;
+const RING_WAITERS = 10;
+const RING_TOO_LARGE = 11;
+
+// Longest single Atomics.wait. The notify that wakes waiters is issued on
+// the capturing camera's event loop, so while that thread is busy a waiter
+// only sees new frames by re-checking the ring after each slice.
+const WAIT_SLICE_MS = 5;
+
+const STATE_STOPPED = 2;
+const FLAG_DISCONTINUITY = 1;
+
+// PixelFormat names by value (frame.h); mirrors the addon's pixelFormatNames
+const FORMAT_NAMES = ["", "NV12", "YUY2", "UYVY", "RGB24", "RGB32", "MJPEG", "IYUV", "RGBA"];
+
+// Allocate a SharedArrayBuffer laid out as a ring of `slots` frames of up to
+// `slotBytes` bytes each. `slots` is rounded up to a power of two.
+function createFrameRing(options = {}) {
+  const slotBytes = Math.floor(options.slotBytes);
+  if (!(slotBytes > 0) || slotBytes > 0x7fffffff - SLOT_HEADER_BYTES) {
+    throw new RangeError("slotBytes must be a positive frame size in bytes");
+  }
+  let slots = 2;
+  while (slots < (options.slots || 4)) slots *= 2;
+  if (slots > MAX_SLOTS) {
+    throw new RangeError(`slots must be at most ${MAX_SLOTS}`);
+  }
+  const stride = SLOT_HEADER_BYTES + Math.ceil(slotBytes / 64) * 64;
+  const buffer = new SharedArrayBuffer(RING_HEADER_BYTES + slots * stride);
+  const header = new Int32Array(buffer, 0, RING_HEADER_BYTES / 4);
+  header[RING_MAGIC_FIELD] = RING_MAGIC;
+  header[RING_VERSION_FIELD] = RING_VERSION;
+  header[RING_SLOT_COUNT] = slots;
+  header[RING_SLOT_BYTES] = slotBytes;
+  header[RING_SLOT_STRIDE] = stride;
+  return buffer;
+}
+
+// A frame still in its ring slot. `data` views the slot payload directly and
+// stays valid only until the writer laps the reader: check `intact` after
+// using it (or copy it first) to know the bytes were not overwritten.
+class FrameRingFrame {
+  constructor(reader, number) {
+    const offset = RING_HEADER_BYTES + (number & (reader.slotCount - 1)) * reader._stride;
+    const ints = new Int32Array(reader.buffer, offset, 8);
+    const times = new Float64Array(reader.buffer, offset + 32, 4);
+    this._reader = reader;
+    this._number = number;
+    this.sequence = times[0];
+    this.deviceTimestamp = times[1];
+    this.timestamp = times[2];
+    this.arrivalTime = times[3];
+    this.subtype = FORMAT_NAMES[ints[2]] || "";
+    this.width = ints[3];
+    this.height = ints[4];
+    this.stride = ints[5];
+    this.discontinuity = (ints[6] & FLAG_DISCONTINUITY) !== 0;
+    this.size = ints[1];
+    this.data = new Uint8Array(reader.buffer, offset + SLOT_HEADER_BYTES, Math.min(Math.max(this.size, 0), reader.slotBytes));
+  }
+  // The slot has not been reused since this frame was published
+  get intact() {
+    return this._reader._intact(this._number);
+  }
+}
+
+// Consumer side of a frame ring. Use one reader per consumer; readers do not
+// coordinate, each sees every frame it keeps up with.
+class FrameRingReader {
+  constructor(buffer) {
+    if (!(buffer instanceof SharedArrayBuffer) || buffer.byteLength < RING_HEADER_BYTES) {
+      throw new TypeError("Expected a SharedArrayBuffer from createFrameRing()");
+    }
+    this.buffer = buffer;
+    this._header = new Int32Array(buffer, 0, RING_HEADER_BYTES / 4);
+    if (this._header[RING_MAGIC_FIELD] !== RING_MAGIC || this._header[RING_VERSION_FIELD] !== RING_VERSION) {
+      throw new TypeError("SharedArrayBuffer is not a frame ring");
+    }
+    this.slotCount = this._header[RING_SLOT_COUNT];
+    this.slotBytes = this._header[RING_SLOT_BYTES];
+    this._stride = this._header[RING_SLOT_STRIDE];
+    // Start with the first frame published after the reader was created
+    this._next = (Atomics.load(this._header, RING_PUBLISHED) + 1) | 0;
+    // Frames overwritten before this reader got to them
+    this.overruns = 0;
+    // Frames passed over by latest()
+    this.skipped = 0;
+  }
+
+  // Frames published since the ring was created (wraps at 2^32)
+  get published() {
+    return Atomics.load(this._header, RING_PUBLISHED) >>> 0;
+  }
+  // Capture sessions that have written to the ring
+  get generation() {
+    return Atomics.load(this._header, RING_GENERATION);
+  }
+  // The last writer stopped capturing
+  get stopped() {
+    return Atomics.load(this._header, RING_STATE) === STATE_STOPPED;
+  }
+  // Frames the writer dropped because they did not fit a slot
+  get tooLarge() {
+    return Atomics.load(this._header, RING_TOO_LARGE);
+  }
+
+  // Next unread frame, or null when there is none. When the writer has lapped
+  // the reader, skips to the oldest frame still in the ring and counts the
+  // lost ones in `overruns`.
+  next() {
+    for (;;) {
+      const published = Atomics.load(this._header, RING_PUBLISHED);
+      if (((published - this._next) | 0) < 0) return null;
+      const oldest = (Atomics.load(this._header, RING_CLAIMED) - this.slotCount + 1) | 0;
+      if (((oldest - this._next) | 0) > 0) {
+        this.overruns += (oldest - this._next) | 0;
+        this._next = oldest;
+      }
+      const frame = new FrameRingFrame(this, this._next);
+      this._next = (this._next + 1) | 0;
+      // Header read while the slot was being rewritten: lost as well
+      if (frame.intact) return frame;
+      this.overruns++;
+    }
+  }
+
+  // Newest published frame if it has not been read yet, else null. Older
+  // unread frames are skipped (counted in `skipped`).
+  latest() {
+    const published = Atomics.load(this._header, RING_PUBLISHED);
+    const behind = (published - this._next) | 0;
+    if (behind < 0) return null;
+    this.skipped += behind;
+    this._next = published;
+    return this.next();
+  }
+
+  // Block until a frame is available (worker threads; the main thread should
+  // use waitAsync). Returns the next frame (latest frame with
+  // { latestOnly: true }), or null on timeout or when capture stopped. Waits
+  // in WAIT_SLICE_MS slices, so a frame published while the camera's thread
+  // is too busy to notify is picked up within a slice.
+  wait(timeoutMs = Infinity, options = {}) {
+    const deadline = Date.now() + timeoutMs;
+    for (;;) {
+      const seen = Atomics.load(this._header, RING_SIGNAL);
+      const frame = options.latestOnly ? this.latest() : this.next();
+      if (frame) return frame;
+      if (this.stopped) return null;
+      const remaining = deadline - Date.now();
+      if (remaining <= 0) return null;
+      Atomics.add(this._header, RING_WAITERS, 1);
+      Atomics.wait(this._header, RING_SIGNAL, seen, Math.min(remaining, WAIT_SLICE_MS));
+      Atomics.sub(this._header, RING_WAITERS, 1);
+    }
+  }
+
+  // Promise form of wait() that does not block the event loop.
+  async waitAsync(timeoutMs = Infinity, options = {}) {
+    const deadline = Date.now() + timeoutMs;
+    for (;;) {
+      const seen = Atomics.load(this._header, RING_SIGNAL);
+      const frame = options.latestOnly ? this.latest() : this.next();
+      if (frame) return frame;
+      if (this.stopped) return null;
+      const remaining = deadline - Date.now();
+      if (remaining <= 0) return null;
+      Atomics.add(this._header, RING_WAITERS, 1);
+      try {
+        if (typeof Atomics.waitAsync === "function") {
+          const result = Atomics.waitAsync(this._header, RING_SIGNAL, seen, Math.min(remaining, WAIT_SLICE_MS));
+          if (result.async) await result.value;
+        } else {
+          // Runtimes without waitAsync: poll at a millisecond
+          await new Promise((resolve) => setTimeout(resolve, Math.min(remaining, 1)));
+        }
+      } finally {
+        Atomics.sub(this._header, RING_WAITERS, 1);
+      }
+    }
+  }
+
+  _intact(number) {
+    return ((Atomics.load(this._header, RING_CLAIMED) - number) | 0) < this.slotCount;
+  }
+}
+
+module.exports = { createFrameRing, FrameRingReader, FrameRingFrame };
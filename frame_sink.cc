@@ -0,0 +1,70 @@
+#include "frame_sink.h"
+
+#include <string>
+
+Napi::Object FrameSink::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "FrameSink", {InstanceMethod("getId", &FrameSink::GetId), InstanceMethod("close", &FrameSink::Close), InstanceMethod("getStats", &FrameSink::GetStats), InstanceMethod("getFrameInfoArray", &FrameSink::GetFrameInfoArray)});
+  exports.Set("FrameSink", func);
+  return exports;
+}
+
+FrameSink::FrameSink(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<FrameSink>(info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsFunction()) {
+    Napi::TypeError::New(env, "FrameSink expects a frame callback").ThrowAsJavaScriptException();
+    return;
+  }
+
+  // Same delivery options as startCapture
+  size_t queueSize = 4;
+  DropPolicy dropPolicy = DropPolicy::DropOldest;
+  bool zeroCopy = true;
+  if (info.Length() > 1 && info[1].IsObject()) {
+    Napi::Object opts = info[1].As<Napi::Object>();
+    if (opts.Has("queueSize") && opts.Get("queueSize").IsNumber()) {
+      queueSize = opts.Get("queueSize").As<Napi::Number>().Uint32Value();
+    }
+    if (opts.Has("dropPolicy") && opts.Get("dropPolicy").IsString()) {
+      std::string policyStr = opts.Get("dropPolicy").As<Napi::String>().Utf8Value();
+      if (!ParseDropPolicy(policyStr, dropPolicy)) {
+        Napi::TypeError::New(env, "Unknown dropPolicy. Use 'drop-oldest', 'drop-newest', 'latest-only' or 'block'.").ThrowAsJavaScriptException();
+        return;
+      }
+    }
+    if (opts.Has("zeroCopy") && opts.Get("zeroCopy").IsBoolean()) {
+      zeroCopy = opts.Get("zeroCopy").As<Napi::Boolean>().Value();
+    }
+  }
+
+  Napi::Float64Array slots = Napi::Float64Array::New(env, kFrameInfoSlots);
+  m_frameInfo = Napi::Persistent(slots);
+  m_target = FrameTarget::Create(env, info[0].As<Napi::Function>(), queueSize, dropPolicy, zeroCopy, slots.Data());
+  m_id = m_target->Register();
+}
+
+FrameSink::~FrameSink() {
+  // The info slots go with this object; cameras still holding the target
+  // drop their frames from now on.
+  if (m_target) m_target->Close();
+}
+
+Napi::Value FrameSink::GetId(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), m_id);
+}
+
+Napi::Value FrameSink::Close(const Napi::CallbackInfo& info) {
+  if (m_target) m_target->Close();
+  return info.Env().Undefined();
+}
+
+Napi::Value FrameSink::GetStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!m_target) return Napi::Object::New(env);
+  return FrameTargetStatsToObject(env, *m_target);
+}
+
+Napi::Value FrameSink::GetFrameInfoArray(const Napi::CallbackInfo& info) {
+  (void)info;
+  return m_frameInfo.Value();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <napi.h>
+#include <memory>
+
+#include "frame_target.h"
+
+// Receiving end of frames captured by a camera in another JS environment.
+// Created on the thread that should run the frame callback (typically a
+// worker); a camera started with { target: id } delivers straight into it,
+// so frames never pass through the camera's own event loop.
+//
+//   new FrameSink(callback, { queueSize?, dropPolicy?, zeroCopy? })
+class FrameSink : public Napi::ObjectWrap<FrameSink> {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  FrameSink(const Napi::CallbackInfo& info);
+  ~FrameSink();
+
+  Napi::Value GetId(const Napi::CallbackInfo& info);
+  Napi::Value Close(const Napi::CallbackInfo& info);
+  Napi::Value GetStats(const Napi::CallbackInfo& info);
+  Napi::Value GetFrameInfoArray(const Napi::CallbackInfo& info);
+
+ private:
+  std::shared_ptr<FrameTarget> m_target;
+  uint32_t m_id = 0;
+  // FrameInfoSlot storage the target rewrites before each callback
+  Napi::Reference<Napi::Float64Array> m_frameInfo;
+};
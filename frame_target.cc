@@ -0,0 +1,187 @@
+#include "frame_target.h"
+
+#include <map>
+
+// Registered targets by id. Entries are weak so a registry entry never keeps
+// a closed environment's target alive.
+static std::mutex& registry_lock() {
+  static std::mutex lock;
+  return lock;
+}
+
+static std::map<uint32_t, std::weak_ptr<FrameTarget>>& registry() {
+  static std::map<uint32_t, std::weak_ptr<FrameTarget>> targets;
+  return targets;
+}
+
+Napi::Buffer<uint8_t> FrameToBuffer(Napi::Env env, Frame* data, bool zeroCopy, bool* copied) {
+  if (copied) *copied = !zeroCopy;
+  if (!zeroCopy) {
+    Napi::Buffer<uint8_t> nodeBuf = Napi::Buffer<uint8_t>::Copy(env, data->data(), data->size);
+    FrameDeleter()(data);
+    return nodeBuf;
+  }
+  // Report the pooled storage to V8 so GC pressure reflects frames held by
+  // JS; otherwise collection lags and the in-flight cap drops frames.
+  Napi::MemoryManagement::AdjustExternalMemory(env, static_cast<int64_t>(data->capacity()));
+  // NewOrCopy falls back to a copy (and runs the finalizer immediately) on
+  // runtimes that forbid external buffers.
+  const uint8_t* storage = data->data();
+  Napi::Buffer<uint8_t> nodeBuf = Napi::Buffer<uint8_t>::NewOrCopy(
+      env, data->data(), data->size, [](Napi::Env env, uint8_t*, Frame* f) {
+        Napi::MemoryManagement::AdjustExternalMemory(env, -static_cast<int64_t>(f->capacity()));
+        FrameDeleter()(f);
+      },
+      data);
+  if (copied) *copied = nodeBuf.Data() != storage;
+  return nodeBuf;
+}
+
+static void WriteFrameInfo(double* slots, const Frame& frame) {
+  const FrameInfo& info = frame.info;
+  slots[kInfoSequence] = static_cast<double>(info.sequence);
+  slots[kInfoDeviceTime] = static_cast<double>(info.deviceTimeUs);
+  slots[kInfoTimestamp] = static_cast<double>(info.timestampUs);
+  slots[kInfoArrival] = static_cast<double>(info.arrivalUs);
+  slots[kInfoFormat] = static_cast<double>(info.format);
+  slots[kInfoWidth] = info.width;
+  slots[kInfoHeight] = info.height;
+  slots[kInfoStride] = info.stride;
+  slots[kInfoFlags] = info.flags;
+  slots[kInfoSize] = static_cast<double>(frame.size);
+}
+
+FrameTarget::FrameTarget(size_t queueSize, DropPolicy policy, bool zeroCopy, double* infoSlots)
+    : m_queue(queueSize, policy), m_zeroCopy(zeroCopy), m_infoSlots(infoSlots) {}
+
+FrameTarget::~FrameTarget() {
+  Close();
+}
+
+std::shared_ptr<FrameTarget> FrameTarget::Create(Napi::Env env, Napi::Function callback, size_t queueSize, DropPolicy policy, bool zeroCopy, double* infoSlots) {
+  std::shared_ptr<FrameTarget> target(new FrameTarget(queueSize, policy, zeroCopy, infoSlots));
+  std::weak_ptr<FrameTarget> weak = target;
+  // The finalizer runs on release and when the environment is torn down with
+  // the function still held; either way no call may follow it.
+  target->m_tsfn = Napi::ThreadSafeFunction::New(env, callback, "FrameTarget", 0, 1, [weak](Napi::Env) {
+    if (std::shared_ptr<FrameTarget> self = weak.lock()) self->Finalized();
+  });
+  return target;
+}
+
+void FrameTarget::Push(FramePtr frame, const std::atomic<bool>* cancel) {
+  // Outside m_lock: the 'block' policy may wait here for the drain
+  if (!m_queue.Push(std::move(frame), cancel)) return;
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_closed) {
+    m_queue.Close();
+    return;
+  }
+  ScheduleDrain();
+}
+
+void FrameTarget::ScheduleDrain() {
+  std::weak_ptr<FrameTarget> weak = shared_from_this();
+  auto drain = [weak](Napi::Env env, Napi::Function jsCallback) {
+    std::shared_ptr<FrameTarget> self = weak.lock();
+    if (!self) return;
+    // env is null when the TSFN is torn down with a drain still queued
+    if (static_cast<napi_env>(env) == nullptr || !jsCallback) {
+      self->m_queue.Close();
+      return;
+    }
+    self->Drain(env, jsCallback);
+  };
+  if (m_tsfn.NonBlockingCall(drain) != napi_ok) m_queue.Close();
+}
+
+void FrameTarget::Drain(Napi::Env env, Napi::Function callback) {
+  // Deliver at most one queue's worth per turn so producers using the
+  // 'block' policy cannot monopolize the event loop.
+  size_t budget = m_queue.GetStats().capacity;
+  for (size_t i = 0; i < budget; ++i) {
+    if (Closed()) return;
+    FramePtr frame = m_queue.Pop();
+    if (!frame) return;  // queue empty; next Push schedules a new drain
+    WriteFrameInfo(m_infoSlots, *frame);
+    bool copied = false;
+    Napi::Buffer<uint8_t> buffer = FrameToBuffer(env, frame.release(), m_zeroCopy, &copied);
+    if (copied && m_zeroCopy) m_copyFallbacks.fetch_add(1, std::memory_order_relaxed);
+    callback.Call({buffer});
+  }
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (!m_closed) ScheduleDrain();
+}
+
+void FrameTarget::Close() {
+  // Queue first: releases producers blocked by the 'block' policy
+  m_queue.Close();
+  Napi::ThreadSafeFunction tsfn;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_closed) return;
+    m_closed = true;
+    tsfn = m_tsfn;
+    m_tsfn = Napi::ThreadSafeFunction();
+  }
+  Unregister();
+  if (tsfn) tsfn.Release();
+}
+
+void FrameTarget::Finalized() {
+  m_queue.Close();
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_closed = true;
+    m_tsfn = Napi::ThreadSafeFunction();
+  }
+  Unregister();
+}
+
+bool FrameTarget::Closed() const {
+  std::lock_guard<std::mutex> lock(m_lock);
+  return m_closed;
+}
+
+uint32_t FrameTarget::Register() {
+  std::lock_guard<std::mutex> registryLock(registry_lock());
+  std::lock_guard<std::mutex> lock(m_lock);
+  if (m_closed || m_id != 0) return m_id;
+  static uint32_t nextId = 0;
+  do {
+    m_id = ++nextId;
+  } while (m_id == 0 || registry().count(m_id));
+  registry()[m_id] = shared_from_this();
+  return m_id;
+}
+
+void FrameTarget::Unregister() {
+  std::lock_guard<std::mutex> registryLock(registry_lock());
+  uint32_t id;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    id = m_id;
+  }
+  if (id != 0) registry().erase(id);
+}
+
+std::shared_ptr<FrameTarget> FrameTarget::Find(uint32_t id) {
+  std::lock_guard<std::mutex> registryLock(registry_lock());
+  auto it = registry().find(id);
+  if (it == registry().end()) return nullptr;
+  std::shared_ptr<FrameTarget> target = it->second.lock();
+  return target && !target->Closed() ? target : nullptr;
+}
+
+Napi::Object FrameTargetStatsToObject(Napi::Env env, const FrameTarget& target) {
+  FrameQueueStats qs = target.GetStats();
+  Napi::Object delivery = Napi::Object::New(env);
+  delivery.Set("queued", Napi::Number::New(env, static_cast<double>(qs.queued)));
+  delivery.Set("delivered", Napi::Number::New(env, static_cast<double>(qs.delivered)));
+  delivery.Set("dropped", Napi::Number::New(env, static_cast<double>(qs.dropped)));
+  delivery.Set("depth", Napi::Number::New(env, static_cast<double>(qs.depth)));
+  delivery.Set("capacity", Napi::Number::New(env, static_cast<double>(qs.capacity)));
+  delivery.Set("policy", Napi::String::New(env, DropPolicyName(target.Policy())));
+  delivery.Set("copyFallbacks", Napi::Number::New(env, static_cast<double>(target.CopyFallbacks())));
+  return delivery;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "frame.h"
+#include "frame_queue.h"
+
+// Slots of the Float64Array behind the 'frame' event's info argument (see
+// FrameInfo in addon.js). Rewritten before every frame callback, so JS reads
+// metadata without a per-frame object.
+enum FrameInfoSlot {
+  kInfoSequence,
+  kInfoDeviceTime,
+  kInfoTimestamp,
+  kInfoArrival,
+  kInfoFormat,
+  kInfoWidth,
+  kInfoHeight,
+  kInfoStride,
+  kInfoFlags,
+  kInfoSize,
+  kFrameInfoSlots
+};
+
+// Wrap a frame in a JS Buffer, taking ownership of `data`. Zero-copy buffers
+// return the storage to its pool from their finalizer. `copied` is set when
+// the Buffer holds a copy (zeroCopy off, or a runtime without external
+// buffers).
+Napi::Buffer<uint8_t> FrameToBuffer(Napi::Env env, Frame* data, bool zeroCopy, bool* copied = nullptr);
+
+// Where a capture session's frames are delivered: a bounded FrameQueue drained
+// on the thread of one JS environment (the main thread or a worker) through a
+// thread-safe function that calls `callback(buffer)` after rewriting
+// `infoSlots`. At most one drain is pending per target, so a stalled event
+// loop accumulates frames in the bounded queue rather than TSFN calls.
+//
+// Create runs on the owning environment's thread; Push (capture threads) and
+// Close may run on any thread. A target closes itself when its thread-safe function
+// is finalized (environment teardown, e.g. worker exit), so capture threads
+// never call into a torn-down environment. Targets registered with Register
+// can be found from any environment by id, which is how a camera delivers
+// into another environment's FrameSink.
+class FrameTarget : public std::enable_shared_from_this<FrameTarget> {
+ public:
+  // `infoSlots` (kFrameInfoSlots doubles) must stay valid until Close.
+  static std::shared_ptr<FrameTarget> Create(Napi::Env env, Napi::Function callback, size_t queueSize, DropPolicy policy, bool zeroCopy, double* infoSlots);
+  ~FrameTarget();
+  FrameTarget(const FrameTarget&) = delete;
+  FrameTarget& operator=(const FrameTarget&) = delete;
+
+  // Queue `frame` for delivery. A producer blocked by the 'block' policy
+  // drops its frame once `cancel` is set and CancelProducers is called.
+  void Push(FramePtr frame, const std::atomic<bool>* cancel = nullptr);
+  void CancelProducers() { m_queue.WakeProducers(); }
+  // Drop queued frames, release the thread-safe function and unregister.
+  // Further pushes drop. Safe to call more than once.
+  void Close();
+  bool Closed() const;
+
+  FrameQueueStats GetStats() const { return m_queue.GetStats(); }
+  DropPolicy Policy() const { return m_queue.Policy(); }
+  // Zero-copy frames delivered as copies because the runtime forbids
+  // external buffers
+  uint64_t CopyFallbacks() const { return m_copyFallbacks.load(std::memory_order_relaxed); }
+
+  // Make the target findable by other environments; returns its id (> 0).
+  uint32_t Register();
+  // Open registered target with `id`, or null.
+  static std::shared_ptr<FrameTarget> Find(uint32_t id);
+
+ private:
+  FrameTarget(size_t queueSize, DropPolicy policy, bool zeroCopy, double* infoSlots);
+  // Post a drain to the owning environment; m_lock held
+  void ScheduleDrain();
+  void Drain(Napi::Env env, Napi::Function callback);
+  // The thread-safe function is gone (released or torn down)
+  void Finalized();
+  void Unregister();
+
+  FrameQueue m_queue;
+  const bool m_zeroCopy;
+  double* const m_infoSlots;
+  std::atomic<uint64_t> m_copyFallbacks{0};
+  mutable std::mutex m_lock;  // guards the fields below
+  Napi::ThreadSafeFunction m_tsfn;
+  bool m_closed = false;
+  uint32_t m_id = 0;
+};
+
+// { queued, delivered, dropped, depth, capacity, policy, copyFallbacks } for
+// getStats()
+Napi::Object FrameTargetStatsToObject(Napi::Env env, const FrameTarget& target);
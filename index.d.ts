@@ -83,6 +83,467 @@ export interface CameraInfo {
   [k: string]: any;
 }
 
+/**
+ * Options accepted by startCapture()
+ */
+export interface StartCaptureOptions {
+  /**
+   * Deliver frames as external Buffers that wrap the native frame storage
+   * (no copy on the way to JS). The storage is returned to the native side
+   * when the Buffer is garbage collected. Set to false to receive a fresh
+   * copy of every frame instead. Defaults to true.
+   */
+  zeroCopy?: boolean;
+  /**
+   * Maximum number of frames that may be outstanding at once (held by JS or
+   * queued for delivery). Frame storage is recycled through a native pool;
+   * frames arriving while the cap is reached are dropped. 0 = unbounded.
+   * Defaults to 16.
+   */
+  maxInFlightFrames?: number;
+  /**
+   * Capacity of the bounded queue between the capture thread and the JS
+   * event loop. Defaults to 4. Ignored (forced to 1) for 'latest-only'.
+   */
+  queueSize?: number;
+  /**
+   * What to do when the queue is full because JS is not keeping up:
+   * - 'drop-oldest' (default): discard the oldest queued frame
+   * - 'drop-newest': discard the incoming frame
+   * - 'latest-only': mailbox; only the most recent frame is kept
+   * - 'block': stall capture until JS drains the queue
+   */
+  dropPolicy?: DropPolicy;
+  /**
+   * Threads used to convert frames when an output format is set (the capture
+   * thread plus a persistent worker pool). 0 = one per hardware thread.
+   * Defaults to 0.
+   */
+  conversionThreads?: number;
+  /**
+   * Rows per conversion band. 0 = automatic (a few bands per thread).
+   * Defaults to 0.
+   */
+  conversionBandHeight?: number;
+  /**
+   * Kernel capture buffers to stream through (V4L2 backend; 2-32, ignored by
+   * other backends). More buffers absorb longer capture-thread stalls at the
+   * cost of latency and memory. 0 = default (4).
+   */
+  deviceBufferCount?: number;
+  /**
+   * Write every frame the device delivers (native format and device
+   * timestamps, before conversion, decimation, pull gating or any queue
+   * drop) to this file, for later playback with the 'replay' backend.
+   * The file is finalized by stopCapture or releaseDevice.
+   */
+  record?: string;
+  /**
+   * JPEG quality from 0 (smallest) to 1 (best) when the output format is
+   * 'MJPEG'. Defaults to 0.85.
+   */
+  jpegQuality?: number;
+  /**
+   * Chroma subsampling of JPEG output from RGB frames. 'default' leaves the
+   * choice to the encoder. YUV frames keep their native subsampling (4:2:0
+   * for NV12/IYUV, 4:2:2 for YUY2/UYVY). Defaults to 'default'.
+   */
+  jpegSubsampling?: JpegSubsampling;
+  /**
+   * Keep one frame in N (frames 0, N, 2N, ... of the session). The others
+   * are dropped in the backend before they are locked, converted or copied,
+   * and are not discontinuities. Cannot be combined with targetFrameRate.
+   */
+  decimate?: number;
+  /**
+   * Keep frames at this rate (frames per second) from a faster camera,
+   * chosen by frame count and source frame period so the pick is not thrown
+   * off by timestamp jitter: 30 -> 5 fps keeps exactly every 6th frame. Dropped like
+   * `decimate`'s. Cannot be combined with decimate.
+   */
+  targetFrameRate?: number;
+  /**
+   * Deliver frames into this SharedArrayBuffer (from createFrameRing())
+   * instead of emitting 'frame' events. Frames are copied into the ring on
+   * the capture thread with no call into JS per frame; consumers read them
+   * with a FrameRingReader on any thread. zeroCopy, queueSize and dropPolicy
+   * do not apply. A ring is written by one capture at a time.
+   */
+  ring?: SharedArrayBuffer;
+  /**
+   * Deliver frames to a FrameSink instead of this camera's 'frame' events.
+   * The sink's callback runs on the thread that created it (typically a
+   * worker), so frames never pass through this thread's event loop. Accepts
+   * the sink, its `id`, `{ frameSinkId }`, or a Worker / MessagePort whose
+   * other end created a FrameSink with `{ port }` (the id is requested over
+   * it; rejects after 5 s without an answer). The sink's queueSize,
+   * dropPolicy and zeroCopy apply instead of these. Cannot be combined with
+   * `ring`.
+   */
+  target?: FrameSink | number | { frameSinkId: number } | FrameSinkPort;
+}
+
+/**
+ * Options for Camera#frames(): startCapture options plus the pull mode
+ */
+export interface FramesOptions extends Omit<StartCaptureOptions, "ring" | "target" | "dropPolicy"> {
+  /**
+   * Produce a frame only when the loop asks for one, and hand out the newest
+   * (frames captured meanwhile are never converted). Otherwise frames are
+   * produced while fewer than `queueSize` are waiting and handed out in
+   * order; frames arriving while that many wait are skipped. Defaults to false.
+   */
+  latestOnly?: boolean;
+}
+
+/**
+ * A frame yielded by Camera#frames(). Unlike the 'frame' event's FrameInfo,
+ * the metadata is a snapshot and stays valid.
+ */
+export interface PulledFrame {
+  data: Buffer;
+  sequence: number;
+  deviceTimestamp: number;
+  timestamp: number;
+  arrivalTime: number;
+  subtype: string;
+  width: number;
+  height: number;
+  stride: number;
+  discontinuity: boolean;
+  size: number;
+}
+
+/**
+ * Options for Camera#readInto()
+ */
+export interface ReadIntoOptions {
+  /**
+   * Reject with an ETIMEDOUT error when no frame arrives in this many
+   * milliseconds. A frame already being written into the buffer when the
+   * timeout fires is still delivered. Defaults to no timeout.
+   */
+  timeoutMs?: number;
+}
+
+/**
+ * Metadata of a frame written by Camera#readInto(); `size` is the number of
+ * bytes written from the start of the buffer
+ */
+export type ReadIntoResult = Omit<PulledFrame, "data">;
+
+/**
+ * Pull counters of a frames() or readInto() session
+ */
+export interface FramePullStats {
+  /** Frames the loop asked for */
+  requested: number;
+  /** Requests answered with a frame */
+  delivered: number;
+  /** Captured frames skipped before conversion because nobody wanted them */
+  skipped: number;
+  /** Produced frames replaced by a newer one before the loop took them */
+  superseded: number;
+  /** readInto frames converted or copied straight into the caller's SharedArrayBuffer */
+  direct: number;
+  /**
+   * readInto frames copied from pooled storage (buffer not shared, frame
+   * already waiting, or JPEG output)
+   */
+  copied: number;
+  /** Frames waiting for the loop */
+  ready: number;
+  capacity: number;
+  latestOnly: boolean;
+}
+
+/**
+ * A Worker or MessagePort carrying the FrameSink handshake
+ */
+export interface FrameSinkPort {
+  postMessage(message: any): void;
+  on(event: "message", listener: (message: any) => void): any;
+  off(event: "message", listener: (message: any) => void): any;
+}
+
+/**
+ * Options for the FrameSink constructor
+ */
+export interface FrameSinkOptions {
+  /** Delivery queue capacity, as StartCaptureOptions.queueSize. Defaults to 4. */
+  queueSize?: number;
+  /** Delivery queue policy, as StartCaptureOptions.dropPolicy. Defaults to 'drop-oldest'. */
+  dropPolicy?: DropPolicy;
+  /** As StartCaptureOptions.zeroCopy. Defaults to true. */
+  zeroCopy?: boolean;
+  /**
+   * Answer startCapture({ target: worker or port }) requests arriving on
+   * this port (e.g. worker_threads.parentPort)
+   */
+  port?: FrameSinkPort;
+}
+
+/**
+ * Receiving end of `startCapture({ target })`: emits 'frame' on the thread
+ * that created it, typically a worker_threads worker. Delivery is native
+ * (no postMessage); the sink keeps its thread alive until close(), which
+ * also stops delivery (frames still arriving are dropped).
+ */
+export declare class FrameSink extends EventEmitter {
+  constructor(options?: FrameSinkOptions);
+  /** Process-wide id accepted by startCapture({ target }) on any thread */
+  readonly id: number;
+  /** Delivery queue counters of this sink */
+  getStats(): FrameDeliveryStats;
+  close(): void;
+
+  on<K extends keyof CameraEvents>(event: K, listener: CameraEvents[K]): this;
+  on(event: string | symbol, listener: (...args: any[]) => void): this;
+}
+
+/**
+ * Options for createFrameRing()
+ */
+export interface FrameRingOptions {
+  /** Frames the ring holds; rounded up to a power of two (2-1024). Defaults to 4. */
+  slots?: number;
+  /** Largest frame in bytes; larger frames are dropped (FrameRingStats.tooLarge) */
+  slotBytes: number;
+}
+
+/**
+ * A frame read from a ring. `data` views the ring slot directly and is only
+ * valid until the writer laps the reader; check `intact` after using it (or
+ * copy it first).
+ */
+export declare class FrameRingFrame {
+  readonly data: Uint8Array;
+  /** Frames delivered by the backend this capture session, from 0 */
+  readonly sequence: number;
+  readonly deviceTimestamp: number;
+  readonly timestamp: number;
+  readonly arrivalTime: number;
+  readonly subtype: string;
+  readonly width: number;
+  readonly height: number;
+  readonly stride: number;
+  readonly discontinuity: boolean;
+  readonly size: number;
+  /** The slot has not been reused since this frame was published */
+  readonly intact: boolean;
+}
+
+/**
+ * Consumer of a frame ring; usable on the main thread and in worker_threads
+ * (require('<package>/frame_ring') there to skip loading the addon). Each
+ * reader sees every frame it keeps up with.
+ */
+export declare class FrameRingReader {
+  constructor(buffer: SharedArrayBuffer);
+  readonly buffer: SharedArrayBuffer;
+  readonly slotCount: number;
+  readonly slotBytes: number;
+  /** Frames published since the ring was created (wraps at 2^32) */
+  readonly published: number;
+  /** Capture sessions that have written to the ring */
+  readonly generation: number;
+  /** The last capture writing to the ring has stopped */
+  readonly stopped: boolean;
+  /** Frames the writer dropped because they exceeded slotBytes */
+  readonly tooLarge: number;
+  /** Frames overwritten before this reader read them */
+  overruns: number;
+  /** Frames passed over by latest() */
+  skipped: number;
+  /** Next unread frame, or null */
+  next(): FrameRingFrame | null;
+  /** Newest frame if not read yet, skipping older unread ones, or null */
+  latest(): FrameRingFrame | null;
+  /**
+   * Block until a frame is available (Atomics.wait; worker threads). Returns
+   * null on timeout or once capture has stopped and the ring is drained.
+   * The wake-up is sent from the capturing thread's event loop; while that
+   * loop is busy, new frames are still seen within a few milliseconds.
+   */
+  wait(timeoutMs?: number, options?: { latestOnly?: boolean }): FrameRingFrame | null;
+  /** Non-blocking form of wait() (Atomics.waitAsync) */
+  waitAsync(timeoutMs?: number, options?: { latestOnly?: boolean }): Promise<FrameRingFrame | null>;
+}
+
+/**
+ * Frame ring writer counters for the current (or last) ring capture session
+ */
+export interface FrameRingStats {
+  /** Frames written to the ring */
+  published: number;
+  /** Frames dropped because they exceeded slotBytes */
+  tooLarge: number;
+  /** Times a blocked consumer had to be woken through the event loop */
+  wakes: number;
+  slots: number;
+  slotBytes: number;
+}
+
+/**
+ * Frame-rate reduction counters (startCapture decimate / targetFrameRate)
+ */
+export interface FrameDecimationStats {
+  /** Frames kept */
+  admitted: number;
+  /** Frames dropped before conversion */
+  skipped: number;
+  /** Configured decimate, when set */
+  decimate?: number;
+  /** Configured targetFrameRate, when set */
+  targetFrameRate?: number;
+}
+
+/**
+ * Chroma subsampling for JPEG output
+ */
+export type JpegSubsampling = "default" | "420" | "422" | "444" | "440";
+
+/**
+ * Delivery queue policy used when JS falls behind the camera
+ */
+export type DropPolicy = "drop-oldest" | "drop-newest" | "latest-only" | "block";
+
+/**
+ * Delivery queue counters for the current (or last) capture session
+ */
+export interface FrameDeliveryStats {
+  /** Frames accepted into the delivery queue */
+  queued: number;
+  /** Frames emitted to JS */
+  delivered: number;
+  /** Frames discarded by the drop policy or when capture stopped */
+  dropped: number;
+  /** Frames currently waiting in the queue */
+  depth: number;
+  /** Queue capacity */
+  capacity: number;
+  /** Active drop policy */
+  policy: DropPolicy;
+  /**
+   * Zero-copy frames delivered as copies because the runtime does not allow
+   * external buffers (e.g. Electron with the V8 sandbox)
+   */
+  copyFallbacks: number;
+}
+
+/**
+ * Native frame pool counters
+ */
+export interface FramePoolStats {
+  /** Leases served from recycled storage */
+  hits: number;
+  /** Leases that had to allocate new storage */
+  misses: number;
+  /** Frames dropped because maxInFlightFrames were outstanding */
+  exhausted: number;
+  /** Frames currently leased */
+  inFlight: number;
+  /** Highest number of simultaneously leased frames */
+  highWater: number;
+  /** Configured in-flight cap (0 = unbounded) */
+  maxInFlight: number;
+  /** Idle frames held for reuse */
+  cached: number;
+  /** Bytes held by idle frames */
+  cachedBytes: number;
+}
+
+/**
+ * Counters of the native stage that converts and delivers frames off the
+ * capture thread (Media Foundation and synthetic backends)
+ */
+export interface ProcessingStats {
+  /** Frames handed from the capture thread to the stage */
+  queued: number;
+  /** Frames the stage finished (converted and passed on) */
+  processed: number;
+  /** Frames dropped because the stage was full */
+  dropped: number;
+  /** Frames waiting for the stage */
+  depth: number;
+  /** Highest depth observed */
+  highWater: number;
+  capacity: number;
+  /** Mean / maximum microseconds from hand-off until the stage picked a frame up */
+  meanWaitUs: number;
+  maxWaitUs: number;
+  /** Mean / maximum microseconds spent converting, encoding and delivering a frame */
+  meanProcessUs: number;
+  maxProcessUs: number;
+}
+
+/**
+ * Result of getStats()
+ */
+export interface CameraStats {
+  /** Frame pool counters; absent when no device is claimed */
+  pool?: FramePoolStats;
+  /**
+   * Delivery queue counters (of the FrameSink when started with a target);
+   * present once capture has been started without a ring
+   */
+  delivery?: FrameDeliveryStats;
+  /** Pull counters; present once capture has been started by frames() or readInto() */
+  pull?: FramePullStats;
+  /** Decimation counters; present once capture has been started with decimate or targetFrameRate */
+  decimation?: FrameDecimationStats;
+  /** Frame ring counters; present once capture has been started with a ring */
+  ring?: FrameRingStats;
+  /** Processing stage counters; absent for backends without one */
+  processing?: ProcessingStats;
+}
+
+/**
+ * Metadata of the frame being delivered, passed with every 'frame' event.
+ *
+ * One instance per camera is reused for every frame (its getters read a typed
+ * array the native side rewrites before each event), so values are only valid
+ * inside the event handler. Call toJSON() to keep a snapshot.
+ */
+export interface FrameInfo {
+  /**
+   * Frames delivered by the backend this capture session, from 0. A gap
+   * means frames were dropped between the backend and JS (delivery queue).
+   */
+  readonly sequence: number;
+  /** Presentation time on the device/driver clock, in microseconds */
+  readonly deviceTimestamp: number;
+  /** deviceTimestamp rebased to the session's first frame, in microseconds */
+  readonly timestamp: number;
+  /**
+   * Monotonic clock (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC
+   * elsewhere) when the backend received the frame, in microseconds
+   */
+  readonly arrivalTime: number;
+  /** Format of the delivered bytes ('NV12', 'RGB32', 'MJPEG', ...); '' if backend-native */
+  readonly subtype: string;
+  readonly width: number;
+  readonly height: number;
+  /** Bytes per row of the first plane; 0 for compressed formats */
+  readonly stride: number;
+  /** Frames were lost before delivery (device gap or exhausted frame pool) */
+  readonly discontinuity: boolean;
+  /** Payload size in bytes */
+  readonly size: number;
+  toJSON(): {
+    sequence: number;
+    deviceTimestamp: number;
+    timestamp: number;
+    arrivalTime: number;
+    subtype: string;
+    width: number;
+    height: number;
+    stride: number;
+    discontinuity: boolean;
+    size: number;
+  };
+}
+
 /**
  * Camera events interface
  */
@@ -95,9 +556,24 @@ export interface CameraEvents {
    * - NV12/YUY2: raw YUV planar/interleaved bytes
    * - RGB32/RGB24: raw pixel bytes
    *
-   * The exact layout depends on the chosen CameraFormat (check the `subtype`/`guid`).
+   * The exact layout is described by `info` (subtype, width, height, stride).
+   */
+  frame: (frameData: Buffer, info: FrameInfo) => void;
+}
+
+/**
+ * Options for the Camera constructor
+ */
+export interface CameraOptions {
+  /**
+   * Capture backend. 'auto' (default) uses the CAMERA_BACKEND environment
+   * variable, then the platform default ('mediafoundation' on Windows,
+   * 'v4l2' on Linux, 'synthetic' elsewhere). 'synthetic' renders test
+   * patterns without a camera (see README: Synthetic backend); 'replay' plays
+   * back a file written with startCapture({ record }) (see README: Replay
+   * backend).
    */
-  frame: (frameData: Buffer) => void;
+  backend?: "auto" | "mediafoundation" | "v4l2" | "synthetic" | "replay";
 }
 
 /**
@@ -105,7 +581,11 @@ export interface CameraEvents {
  * Extends EventEmitter to provide frame events
  */
 export declare class Camera extends EventEmitter {
-  constructor();
+  /** @throws TypeError if the backend is unknown or unavailable on this platform */
+  constructor(options?: CameraOptions);
+
+  /** Name of the capture backend in use */
+  readonly backend: "mediafoundation" | "v4l2" | "synthetic" | "replay";
 
   /**
    * Enumerate all available camera devices
@@ -168,7 +648,8 @@ export declare class Camera extends EventEmitter {
    * When set, captured frames will be converted from the native camera format
    * to the specified output format before being delivered to the 'frame' event.
    *
-   * Supported output formats: 'RGB32', 'RGB24', 'NV12', 'YUY2', 'UYVY', 'IYUV', or a GUID string.
+   * Supported output formats: 'RGB32', 'RGB24', 'RGBA', 'NV12', 'YUY2', 'UYVY', 'IYUV', 'MJPEG', or a GUID string.
+   * MJPEG cameras are decoded natively to any of the uncompressed formats.
    *
    * @param format - Output format string (e.g., 'RGB32', 'NV12') or null/undefined to disable conversion
    * @returns Promise that resolves when the output format is set
@@ -194,9 +675,38 @@ export declare class Camera extends EventEmitter {
    * Frames are emitted via the 'frame' event with Buffer payloads.
    * The JS wrapper passes an internal frame emitter callback into native code,
    * so no callback parameter is required here.
+   * @param options - Optional delivery options
    * @returns Promise that resolves when capture starts successfully
    */
-  startCapture(): Promise<OperationResult>;
+  startCapture(options?: StartCaptureOptions): Promise<OperationResult>;
+
+  /**
+   * Start capture and iterate over frames as the loop asks for them; capture
+   * stops when the loop ends (break, return or throw) and the iteration ends
+   * when stopCapture() is called. Frames nobody asks for are skipped before
+   * conversion and copying.
+   *
+   * @example
+   * for await (const frame of camera.frames({ latestOnly: true })) {
+   *   await detect(frame.data, frame.width, frame.height);
+   * }
+   */
+  frames(options?: FramesOptions): AsyncGenerator<PulledFrame, void, undefined>;
+
+  /**
+   * Write the next frame into `buffer`. Over a SharedArrayBuffer the frame is
+   * converted or copied straight into it; other buffers receive a copy when
+   * the promise settles. Starts a latest-only pull session when capture is
+   * not running (stopCapture() ends it); also works inside a frames() session.
+   * @returns Promise of the frame's metadata, or null once capture stops
+   * @throws RangeError if the frame does not fit in `buffer`
+   * @throws TypeError if `buffer` was detached (e.g. transferred) before the frame arrived
+   *
+   * @example
+   * const pixels = new Uint8Array(new SharedArrayBuffer(1920 * 1080 * 4));
+   * const { size, width, height } = await camera.readInto(pixels, { timeoutMs: 1000 });
+   */
+  readInto(buffer: ArrayBuffer | SharedArrayBuffer | ArrayBufferView, options?: ReadIntoOptions): Promise<ReadIntoResult | null>;
 
   /**
    * Stop capturing frames from the camera
@@ -205,6 +715,11 @@ export declare class Camera extends EventEmitter {
    */
   stopCapture(): Promise<OperationResult>;
 
+  /**
+   * Get native frame delivery counters for this camera
+   */
+  getStats(): CameraStats;
+
   /**
    * Check if the camera is currently capturing
    * @returns true if capturing, false otherwise
@@ -237,9 +752,63 @@ export declare class Camera extends EventEmitter {
   ): this;
 }
 
+/**
+ * Instruction set tier for the pixel-format conversion kernels
+ */
+export type ConversionIsa = "auto" | "scalar" | "sse2" | "ssse3" | "avx2" | "avx512";
+
+/**
+ * Conversion kernel variant active for each source -> destination format pair
+ */
+export interface ConversionKernels {
+  /** Tier the active table was built for */
+  isa: Exclude<ConversionIsa, "auto">;
+  /** Best tier this CPU supports */
+  detected: Exclude<ConversionIsa, "auto">;
+  rgb32ToRgba: string;
+  rgb24ToRgba: string;
+  nv12ToRgb32: string;
+  yuv422ToRgb: string;
+  /** I420/NV12 -> BGRA/RGBA/BGR24 */
+  yuv420ToRgb: string;
+  /** BGRA/RGBA/BGR24 -> NV12/I420 */
+  rgbToYuv420: string;
+  /** BGRA/RGBA/BGR24 -> YUY2/UYVY */
+  rgbToYuv422: string;
+  /** Channel shuffles between BGRA, RGBA and BGR24 */
+  rgbRepack: string;
+  /** NV12/I420 -> YUY2/UYVY */
+  yuv420ToYuv422: string;
+  /** YUY2/UYVY -> NV12/I420 */
+  yuv422ToYuv420: string;
+  /** I420 -> NV12 chroma */
+  uvInterleave: string;
+  /** NV12 -> I420 chroma */
+  uvDeinterleave: string;
+  /** YUY2 <-> UYVY */
+  yuv422Swap: string;
+  /** JPEG forward DCT + quantization used for MJPEG output */
+  jpegFdct: string;
+  /** JPEG dequantization + inverse DCT used for MJPEG input */
+  jpegIdct: string;
+}
+
 // For CommonJS usage
 declare const Camera: {
   new (): Camera;
+  /**
+   * Pin all conversion kernels to the best variant at or below `isa`
+   * (process-wide). Returns false if the CPU does not support that tier.
+   * The CAMERA_CONVERT_ISA environment variable sets the initial tier.
+   */
+  setConversionIsa(isa: ConversionIsa): boolean;
+  /** Kernel variant currently used for each format pair */
+  getConversionKernels(): ConversionKernels;
+  /** Allocate a SharedArrayBuffer for startCapture({ ring }) */
+  createFrameRing(options: FrameRingOptions): SharedArrayBuffer;
+  FrameRingReader: typeof FrameRingReader;
+  /** Frame delivery into another thread's event loop (startCapture({ target })) */
+  FrameSink: typeof FrameSink;
 };
 
 export = Camera;
@@ -0,0 +1,812 @@
+#include "jpeg_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "convert_engine.h"
+#include "jpeg_tables.h"
+
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
+namespace {
+
+const int kFastBits = 9;
+
+// Decoding table for one Huffman table slot. Codes of up to kFastBits bits
+// resolve with one lookup; longer ones walk the canonical code ranges.
+struct HuffDecoder {
+  // (code length << 8) | symbol, 0 when the code is longer than kFastBits
+  uint16_t fast[1 << kFastBits];
+  // AC tables: run/size symbol and its extra bits resolved in one lookup when
+  // both fit in kFastBits (length 0 otherwise)
+  struct FastAc {
+    int16_t value;
+    uint8_t run;
+    uint8_t length;
+  } fastAc[1 << kFastBits];
+  int32_t maxCode[17];  // largest code of each length, -1 if none
+  int32_t valOffset[17];
+  uint8_t values[256];
+};
+
+inline int Extend(int v, int s) {
+  return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+}
+
+inline uint8_t ClampU8(int v) {
+  return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+bool BuildHuffDecoder(const uint8_t* bits, const uint8_t* values, size_t count, bool ac, HuffDecoder& h) {
+  std::memset(h.fast, 0, sizeof(h.fast));
+  std::memset(h.fastAc, 0, sizeof(h.fastAc));
+  std::memset(h.values, 0, sizeof(h.values));
+  std::memcpy(h.values, values, count);
+  int32_t code = 0;
+  size_t k = 0;
+  for (int length = 1; length <= 16; ++length) {
+    h.valOffset[length] = static_cast<int32_t>(k) - code;
+    for (int i = 0; i < bits[length - 1]; ++i, ++k, ++code) {
+      if (code >= (1 << length)) return false;  // over-subscribed
+      if (length <= kFastBits) {
+        const int shift = kFastBits - length;
+        for (int j = 0; j < (1 << shift); ++j) h.fast[(code << shift) | j] = static_cast<uint16_t>((length << 8) | values[k]);
+      }
+    }
+    h.maxCode[length] = bits[length - 1] ? code - 1 : -1;
+    code <<= 1;
+  }
+  if (!ac) return true;
+  for (int i = 0; i < (1 << kFastBits); ++i) {
+    const uint16_t e = h.fast[i];
+    if (!e) continue;
+    const int length = e >> 8, run = (e >> 4) & 15, size = e & 15;
+    if (size == 0 || length + size > kFastBits) continue;
+    const int extra = (i >> (kFastBits - length - size)) & ((1 << size) - 1);
+    h.fastAc[i].value = static_cast<int16_t>(Extend(extra, size));
+    h.fastAc[i].run = static_cast<uint8_t>(run);
+    h.fastAc[i].length = static_cast<uint8_t>(length + size);
+  }
+  return true;
+}
+
+struct StandardDecoders {
+  HuffDecoder dc[2];  // luma, chroma
+  HuffDecoder ac[2];
+};
+
+const StandardDecoders& StandardHuffDecoders() {
+  static const StandardDecoders tables = [] {
+    StandardDecoders t;
+    BuildHuffDecoder(kJpegDcLumaBits, kJpegDcValues, 12, false, t.dc[0]);
+    BuildHuffDecoder(kJpegDcChromaBits, kJpegDcValues, 12, false, t.dc[1]);
+    BuildHuffDecoder(kJpegAcLumaBits, kJpegAcLumaValues, 162, true, t.ac[0]);
+    BuildHuffDecoder(kJpegAcChromaBits, kJpegAcChromaValues, 162, true, t.ac[1]);
+    return t;
+  }();
+  return tables;
+}
+
+inline uint64_t LoadBigEndian64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+#if defined(_MSC_VER)
+  return _byteswap_uint64(v);
+#else
+  return __builtin_bswap64(v);
+#endif
+}
+
+// Entropy-coded segment reader: a left-aligned 64-bit accumulator, refilled
+// eight bytes at a time when they hold no 0xFF (no stuffing to undo). At a
+// marker, or past the end of the data, it feeds zero bits.
+class BitReader {
+ public:
+  BitReader(const uint8_t* p, const uint8_t* end) : m_p(p), m_end(end) {}
+
+  // Top up to at least 57 valid bits.
+  void Refill() {
+    if (m_bits > 56) return;
+    if (!m_marker && m_end - m_p >= 8) {
+      const uint64_t w = LoadBigEndian64(m_p);
+      if ((((~w) - 0x0101010101010101ull) & w & 0x8080808080808080ull) == 0) {
+        const int n = (64 - m_bits) >> 3;
+        m_acc |= (w >> (64 - 8 * n)) << (64 - m_bits - 8 * n);
+        m_p += n;
+        m_bits += 8 * n;
+        return;
+      }
+    }
+    while (m_bits <= 56) {
+      uint64_t b = 0;
+      if (!m_marker) {
+        if (m_p < m_end && *m_p != 0xFF) {
+          b = *m_p++;
+        } else if (m_end - m_p >= 2 && m_p[1] == 0x00) {
+          b = 0xFF;
+          m_p += 2;
+        } else {
+          m_marker = true;  // stays put; Restart looks for it
+        }
+      }
+      m_acc |= b << (56 - m_bits);
+      m_bits += 8;
+    }
+  }
+
+  // Next `n` (1..32) bits without consuming them.
+  uint32_t Peek(int n) const { return static_cast<uint32_t>(m_acc >> (64 - n)); }
+  void Skip(int n) {
+    m_acc <<= n;
+    m_bits -= n;
+  }
+  uint32_t Get(int n) {
+    const uint32_t v = Peek(n);
+    Skip(n);
+    return v;
+  }
+  int Bits() const { return m_bits; }
+
+  // Drop the partial byte and move past the next RSTn marker. Another marker
+  // (EOI, or garbage) is left in place and the reader keeps feeding zeros.
+  void Restart() {
+    m_acc = 0;
+    m_bits = 0;
+    m_marker = false;
+    while (m_end - m_p >= 2) {
+      if (m_p[0] == 0xFF) {
+        const uint8_t m = m_p[1];
+        if (m >= 0xD0 && m <= 0xD7) {
+          m_p += 2;
+          return;
+        }
+        if (m != 0x00 && m != 0xFF) return;
+      }
+      ++m_p;
+    }
+    m_p = m_end;
+  }
+
+ private:
+  const uint8_t* m_p;
+  const uint8_t* m_end;
+  uint64_t m_acc = 0;
+  int m_bits = 0;
+  bool m_marker = false;
+};
+
+inline int DecodeSymbol(BitReader& br, const HuffDecoder& h) {
+  const uint16_t e = h.fast[br.Peek(kFastBits)];
+  if (e) {
+    br.Skip(e >> 8);
+    return e & 0xFF;
+  }
+  const uint32_t c16 = br.Peek(16);
+  for (int length = kFastBits + 1; length <= 16; ++length) {
+    const int32_t code = static_cast<int32_t>(c16 >> (16 - length));
+    if (code <= h.maxCode[length]) {
+      br.Skip(length);
+      return h.values[(code + h.valOffset[length]) & 0xFF];
+    }
+  }
+  br.Skip(16);  // no such code: corrupt data
+  return 0;
+}
+
+// Decode one block into natural order. Returns whether any AC coefficient is
+// set, so flat blocks can skip the IDCT.
+inline bool DecodeBlock(BitReader& br, const HuffDecoder& dc, const HuffDecoder& ac, int& pred, int16_t* block) {
+  std::memset(block, 0, 64 * sizeof(int16_t));
+  br.Refill();
+  const int s = DecodeSymbol(br, dc) & 15;
+  if (s) pred += Extend(static_cast<int>(br.Get(s)), s);
+  block[0] = static_cast<int16_t>(pred);
+
+  bool any = false;
+  for (int k = 1; k < 64;) {
+    if (br.Bits() < 32) br.Refill();
+    const HuffDecoder::FastAc& f = ac.fastAc[br.Peek(kFastBits)];
+    if (f.length) {
+      br.Skip(f.length);
+      k += f.run;
+      if (k > 63) break;
+      block[kJpegZigzag[k++]] = f.value;
+      any = true;
+      continue;
+    }
+    const int rs = DecodeSymbol(br, ac);
+    const int run = rs >> 4, size = rs & 15;
+    if (size) {
+      k += run;
+      if (k > 63) break;
+      block[kJpegZigzag[k++]] = static_cast<int16_t>(Extend(static_cast<int>(br.Get(size)), size));
+      any = true;
+    } else if (run == 15) {
+      k += 16;  // ZRL
+    } else {
+      break;  // EOB
+    }
+  }
+  return any;
+}
+
+inline uint16_t ReadU16(const uint8_t* p) {
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+}  // namespace
+
+struct JpegFrameHeader {
+  JpegImageInfo info;
+  int ncomp = 0;
+  struct Component {
+    int id;
+    int h;
+    int v;
+    int quant;
+    int dc;
+    int ac;
+  } comp[3];
+  size_t mcuWidth = 0;
+  size_t mcuHeight = 0;
+  size_t mcusX = 0;
+  size_t mcusY = 0;
+  size_t blocksPerMcu = 0;
+  uint16_t quant[4][64];
+  bool quantDefined[4];
+  // Slots 0/1 default to the standard tables; DHT segments replace them
+  HuffDecoder dcOwn[4];
+  HuffDecoder acOwn[4];
+  const HuffDecoder* dc[4];
+  const HuffDecoder* ac[4];
+  // Entropy-coded data of the scan, to the end of the buffer
+  const uint8_t* scan = nullptr;
+  const uint8_t* end = nullptr;
+  // Per component: dequantization multipliers and level shift for the IDCT
+  float multipliers[3][64];
+  float offset[3];
+  JpegIdctFn idct = nullptr;
+};
+
+struct JpegDecodeScratch {
+  std::vector<uint8_t> storage;
+  // One MCU row of each component
+  uint8_t* plane[3];
+  size_t stride[3];
+  // Chroma rows at 4:2:2 / 4:2:0 resolution, a row of neutral chroma for
+  // grayscale frames and one MCU row packed as YUY2 for the RGB kernels
+  uint8_t* tmp[4];
+  uint8_t* grey;
+  uint8_t* packed;
+  int16_t block[64];
+};
+
+namespace {
+
+// Parse the headers up to the first scan. With `tables` false the Huffman
+// tables are validated but not built (ReadInfo).
+bool ParseHeaders(const uint8_t* data, size_t size, JpegFrameHeader& f, bool tables) {
+  if (!data || size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+  const uint8_t* p = data + 2;
+  const uint8_t* end = data + size;
+  f.info = JpegImageInfo();
+  f.ncomp = 0;
+  for (bool& d : f.quantDefined) d = false;
+  bool huffDefined[2][4] = {{true, true, false, false}, {true, true, false, false}};
+  if (tables) {
+    const StandardDecoders& standard = StandardHuffDecoders();
+    f.dc[0] = &standard.dc[0];
+    f.dc[1] = &standard.dc[1];
+    f.ac[0] = &standard.ac[0];
+    f.ac[1] = &standard.ac[1];
+    f.dc[2] = f.dc[3] = f.ac[2] = f.ac[3] = nullptr;
+  }
+
+  for (;;) {
+    // Markers may be preceded by any number of 0xFF fill bytes
+    while (p < end && *p != 0xFF) ++p;
+    while (p < end && *p == 0xFF) ++p;
+    if (p >= end) return false;
+    const uint8_t marker = *p++;
+    if (marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7) || marker == 0x01) continue;  // standalone
+    if (marker == 0xD9) return false;  // EOI before any scan
+    if (end - p < 2) return false;
+    const size_t length = ReadU16(p);
+    if (length < 2 || static_cast<size_t>(end - p) < length) return false;
+    const uint8_t* seg = p + 2;
+    const uint8_t* segEnd = p + length;
+
+    switch (marker) {
+      case 0xC0:  // baseline
+      case 0xC1:  // extended sequential, Huffman
+        if (segEnd - seg < 6 || seg[0] != 8) return false;
+        f.info.height = ReadU16(seg + 1);
+        f.info.width = ReadU16(seg + 3);
+        f.ncomp = seg[5];
+        if (f.info.width == 0 || f.info.height == 0) return false;  // DNL not supported
+        if ((f.ncomp != 1 && f.ncomp != 3) || segEnd - seg < 6 + 3 * f.ncomp) return false;
+        for (int c = 0; c < f.ncomp; ++c) {
+          const uint8_t* q = seg + 6 + 3 * c;
+          f.comp[c].id = q[0];
+          f.comp[c].h = q[1] >> 4;
+          f.comp[c].v = q[1] & 15;
+          f.comp[c].quant = q[2];
+          if (f.comp[c].quant > 3 || f.comp[c].h < 1 || f.comp[c].v < 1) return false;
+        }
+        break;
+      case 0xC4:  // DHT
+        while (seg < segEnd) {
+          if (segEnd - seg < 17) return false;
+          const int tc = seg[0] >> 4, th = seg[0] & 15;
+          if (tc > 1 || th > 3) return false;
+          size_t count = 0;
+          for (int i = 0; i < 16; ++i) count += seg[1 + i];
+          if (count > 256 || static_cast<size_t>(segEnd - seg) < 17 + count) return false;
+          if (tables) {
+            HuffDecoder& h = tc == 0 ? f.dcOwn[th] : f.acOwn[th];
+            if (!BuildHuffDecoder(seg + 1, seg + 17, count, tc == 1, h)) return false;
+            (tc == 0 ? f.dc : f.ac)[th] = &h;
+          }
+          huffDefined[tc][th] = true;
+          seg += 17 + count;
+        }
+        break;
+      case 0xDB:  // DQT
+        while (seg < segEnd) {
+          const int pq = seg[0] >> 4, tq = seg[0] & 15;
+          const size_t bytes = pq ? 128 : 64;
+          if (tq > 3 || pq > 1 || static_cast<size_t>(segEnd - seg) < 1 + bytes) return false;
+          for (int k = 0; k < 64; ++k) {
+            f.quant[tq][kJpegZigzag[k]] = pq ? ReadU16(seg + 1 + 2 * k) : seg[1 + k];
+          }
+          f.quantDefined[tq] = true;
+          seg += 1 + bytes;
+        }
+        break;
+      case 0xDD:  // DRI
+        if (segEnd - seg < 2) return false;
+        f.info.restartInterval = ReadU16(seg);
+        break;
+      case 0xDA: {  // SOS
+        if (f.ncomp == 0 || segEnd - seg < 1) return false;
+        const int ns = seg[0];
+        // One interleaved scan holding every component
+        if (ns != f.ncomp || segEnd - seg < 1 + 2 * ns + 3) return false;
+        JpegFrameHeader::Component ordered[3];
+        for (int i = 0; i < ns; ++i) {
+          const int id = seg[1 + 2 * i];
+          int c = 0;
+          while (c < f.ncomp && f.comp[c].id != id) ++c;
+          if (c == f.ncomp) return false;
+          ordered[i] = f.comp[c];
+          ordered[i].dc = seg[2 + 2 * i] >> 4;
+          ordered[i].ac = seg[2 + 2 * i] & 15;
+          if (ordered[i].dc > 3 || ordered[i].ac > 3) return false;
+          if (!huffDefined[0][ordered[i].dc] || !huffDefined[1][ordered[i].ac] || !f.quantDefined[ordered[i].quant]) return false;
+        }
+        for (int i = 0; i < ns; ++i) f.comp[i] = ordered[i];
+
+        // Sampling: chroma planes share one factor and luma is 1x or 2x that
+        // in each direction. A single component is one block per MCU.
+        if (f.ncomp == 1) {
+          f.comp[0].h = f.comp[0].v = 1;
+        } else {
+          const JpegFrameHeader::Component& y = f.comp[0];
+          const JpegFrameHeader::Component& c = f.comp[1];
+          if (f.comp[2].h != c.h || f.comp[2].v != c.v) return false;
+          if ((y.h != c.h && y.h != 2 * c.h) || (y.v != c.v && y.v != 2 * c.v) || y.h > 2 || y.v > 2) return false;
+          f.info.hSampling = y.h / c.h;
+          f.info.vSampling = y.v / c.v;
+        }
+        f.info.components = f.ncomp;
+        f.mcuWidth = 8 * static_cast<size_t>(f.comp[0].h);
+        f.mcuHeight = 8 * static_cast<size_t>(f.comp[0].v);
+        f.mcusX = (f.info.width + f.mcuWidth - 1) / f.mcuWidth;
+        f.mcusY = (f.info.height + f.mcuHeight - 1) / f.mcuHeight;
+        f.blocksPerMcu = 0;
+        for (int i = 0; i < f.ncomp; ++i) f.blocksPerMcu += static_cast<size_t>(f.comp[i].h) * f.comp[i].v;
+        f.scan = segEnd;
+        f.end = end;
+        return true;
+      }
+      default:
+        // Progressive, lossless and arithmetic-coded frames are not supported
+        if (marker >= 0xC2 && marker <= 0xCF) return false;
+        break;  // APPn, COM, ...
+    }
+    p = segEnd;
+  }
+}
+
+// IDCT inputs for YUV output fold the JFIF -> BT.601 limited-range
+// compression into the multipliers and level shift.
+void PrepareMultipliers(JpegFrameHeader& f, bool limitedRange) {
+  for (int c = 0; c < f.ncomp; ++c) {
+    const uint16_t* q = f.quant[f.comp[c].quant];
+    const bool chroma = c > 0;
+    const float scale = !limitedRange ? 1.0f : (chroma ? 224.0f / 255.0f : 219.0f / 255.0f);
+    f.offset[c] = limitedRange && !chroma ? 16.0f + 128.0f * 219.0f / 255.0f : 128.0f;
+    for (int i = 0; i < 64; ++i) {
+      f.multipliers[c][i] = static_cast<float>(q[i]) * kJpegAanScale[i / 8] * kJpegAanScale[i % 8] * 0.125f * scale;
+    }
+  }
+  f.idct = convert_kernels().jpegIdct;
+}
+
+inline void ReconstructBlock(const JpegFrameHeader& f, int c, const int16_t* block, bool ac, uint8_t* dst, size_t stride) {
+  if (ac) {
+    f.idct(block, f.multipliers[c], f.offset[c], dst, stride);
+    return;
+  }
+  // Only DC: the transform yields the same value everywhere
+  const uint8_t v = ClampU8(static_cast<int>(std::lrintf(static_cast<float>(block[0]) * f.multipliers[c][0] + f.offset[c])));
+  for (int row = 0; row < 8; ++row) std::memset(dst + row * stride, v, 8);
+}
+
+struct ScanState {
+  int pred[3] = {0, 0, 0};
+  size_t restartsLeft = 0;
+};
+
+// Entropy-decode MCU row by row. Each block is either reconstructed into the
+// scratch planes straight away (`store` null) or kept in `store`, with its
+// AC flag in `acFlags`, for a later ReconstructMcuRow.
+void DecodeMcuRow(const JpegFrameHeader& f, BitReader& br, ScanState& st, JpegDecodeScratch* s, int16_t* store, uint8_t* acFlags) {
+  const size_t interval = f.info.restartInterval;
+  for (size_t mx = 0; mx < f.mcusX; ++mx) {
+    if (interval) {
+      if (st.restartsLeft == 0) {
+        br.Restart();
+        st.pred[0] = st.pred[1] = st.pred[2] = 0;
+        st.restartsLeft = interval;
+      }
+      --st.restartsLeft;
+    }
+    for (int c = 0; c < f.ncomp; ++c) {
+      const JpegFrameHeader::Component& comp = f.comp[c];
+      const HuffDecoder& dc = *f.dc[comp.dc];
+      const HuffDecoder& ac = *f.ac[comp.ac];
+      for (int by = 0; by < comp.v; ++by) {
+        for (int bx = 0; bx < comp.h; ++bx) {
+          if (store) {
+            *acFlags++ = DecodeBlock(br, dc, ac, st.pred[c], store);
+            store += 64;
+          } else {
+            const bool any = DecodeBlock(br, dc, ac, st.pred[c], s->block);
+            uint8_t* dst = s->plane[c] + by * 8 * s->stride[c] + (mx * comp.h + bx) * 8;
+            ReconstructBlock(f, c, s->block, any, dst, s->stride[c]);
+          }
+        }
+      }
+    }
+  }
+}
+
+void ReconstructMcuRow(const JpegFrameHeader& f, JpegDecodeScratch& s, const int16_t* coefs, const uint8_t* acFlags) {
+  for (size_t mx = 0; mx < f.mcusX; ++mx) {
+    for (int c = 0; c < f.ncomp; ++c) {
+      const JpegFrameHeader::Component& comp = f.comp[c];
+      for (int by = 0; by < comp.v; ++by) {
+        for (int bx = 0; bx < comp.h; ++bx) {
+          uint8_t* dst = s.plane[c] + by * 8 * s.stride[c] + (mx * comp.h + bx) * 8;
+          ReconstructBlock(f, c, coefs, *acFlags++ != 0, dst, s.stride[c]);
+          coefs += 64;
+        }
+      }
+    }
+  }
+}
+
+// Chroma component `c` for luma row `r` of the current MCU row, at 4:2:2
+// resolution (chromaW samples).
+const uint8_t* ChromaRow422(const JpegFrameHeader& f, const JpegDecodeScratch& s, int c, size_t r, uint8_t* tmp, size_t chromaW) {
+  if (f.ncomp == 1) return s.grey;
+  const uint8_t* src = s.plane[c] + (r * f.comp[c].v / f.comp[0].v) * s.stride[c];
+  if (f.info.hSampling == 2) return src;
+  for (size_t i = 0; i < chromaW; ++i) tmp[i] = static_cast<uint8_t>((src[2 * i] + src[2 * i + 1] + 1) >> 1);
+  return tmp;
+}
+
+// Chroma component `c` for chroma row `j` (luma rows 2j, 2j+1) of the current
+// MCU row, at 4:2:0 resolution.
+const uint8_t* ChromaRow420(const JpegFrameHeader& f, const JpegDecodeScratch& s, int c, size_t j, size_t rows, uint8_t* tmp0, uint8_t* tmp1,
+                            size_t chromaW) {
+  const uint8_t* a = ChromaRow422(f, s, c, 2 * j, tmp0, chromaW);
+  if (f.ncomp == 1 || f.info.vSampling == 2 || 2 * j + 1 >= rows) return a;
+  const uint8_t* b = ChromaRow422(f, s, c, 2 * j + 1, tmp1, chromaW);
+  for (size_t i = 0; i < chromaW; ++i) tmp0[i] = static_cast<uint8_t>((a[i] + b[i] + 1) >> 1);
+  return tmp0;
+}
+
+void PackRow422(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, size_t chromaW, Yuv422Layout layout) {
+  if (layout == Yuv422Layout::YUY2) {
+    for (size_t i = 0; i < chromaW; ++i, dst += 4) {
+      dst[0] = y[2 * i];
+      dst[1] = u[i];
+      dst[2] = y[2 * i + 1];
+      dst[3] = v[i];
+    }
+  } else {
+    for (size_t i = 0; i < chromaW; ++i, dst += 4) {
+      dst[0] = u[i];
+      dst[1] = y[2 * i];
+      dst[2] = v[i];
+      dst[3] = y[2 * i + 1];
+    }
+  }
+}
+
+// Full-range BT.601 (JFIF) at full chroma resolution, in the fixed-point
+// form of the convert.cc kernels.
+void Yuv444RowToRgb(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, size_t width, RgbFormat format) {
+  const size_t bpp = format == RgbFormat::BGR24 ? 3 : 4;
+  const bool rgbOrder = format == RgbFormat::RGBA;
+  for (size_t x = 0; x < width; ++x, dst += bpp) {
+    const int ys = y[x] * 8192, cb = u[x] - 128, cr = v[x] - 128;
+    const uint8_t r = ClampU8((ys + cr * 11485 + 4096) >> 13);
+    const uint8_t g = ClampU8((ys + cb * -2819 + cr * -5850 + 4096) >> 13);
+    const uint8_t b = ClampU8((ys + cb * 14516 + 4096) >> 13);
+    dst[0] = rgbOrder ? r : b;
+    dst[1] = g;
+    dst[2] = rgbOrder ? b : r;
+    if (bpp == 4) dst[3] = 255;
+  }
+}
+
+// Write the pixel rows of MCU row `mcuRow`, reconstructed in `s`, to `dst`.
+void EmitMcuRow(const JpegFrameHeader& f, JpegDecodeScratch& s, size_t mcuRow, JpegOutputFormat format, uint8_t* dst) {
+  const size_t width = f.info.width, height = f.info.height;
+  const size_t y0 = mcuRow * f.mcuHeight;
+  if (y0 >= height) return;
+  const size_t rows = std::min(f.mcuHeight, height - y0);
+  const size_t chromaW = (width + 1) / 2, chromaH = (height + 1) / 2;
+  const uint8_t* yPlane = s.plane[0];
+  const size_t yStride = s.stride[0];
+
+  switch (format) {
+    case JpegOutputFormat::NV12:
+    case JpegOutputFormat::I420: {
+      for (size_t r = 0; r < rows; ++r) std::memcpy(dst + (y0 + r) * width, yPlane + r * yStride, width);
+      uint8_t* chroma = dst + width * height;
+      for (size_t j = 0; j < (rows + 1) / 2; ++j) {
+        const size_t cy = y0 / 2 + j;
+        const uint8_t* u = ChromaRow420(f, s, 1, j, rows, s.tmp[0], s.tmp[1], chromaW);
+        const uint8_t* v = ChromaRow420(f, s, 2, j, rows, s.tmp[2], s.tmp[3], chromaW);
+        if (format == JpegOutputFormat::NV12) {
+          uint8_t* d = chroma + cy * chromaW * 2;
+          for (size_t i = 0; i < chromaW; ++i) {
+            d[2 * i] = u[i];
+            d[2 * i + 1] = v[i];
+          }
+        } else {
+          std::memcpy(chroma + cy * chromaW, u, chromaW);
+          std::memcpy(chroma + chromaW * chromaH + cy * chromaW, v, chromaW);
+        }
+      }
+      break;
+    }
+    case JpegOutputFormat::YUY2:
+    case JpegOutputFormat::UYVY: {
+      const Yuv422Layout layout = format == JpegOutputFormat::YUY2 ? Yuv422Layout::YUY2 : Yuv422Layout::UYVY;
+      for (size_t r = 0; r < rows; ++r) {
+        const uint8_t* u = ChromaRow422(f, s, 1, r, s.tmp[0], chromaW);
+        const uint8_t* v = ChromaRow422(f, s, 2, r, s.tmp[1], chromaW);
+        PackRow422(yPlane + r * yStride, u, v, dst + (y0 + r) * chromaW * 4, chromaW, layout);
+      }
+      break;
+    }
+    default: {
+      const RgbFormat rgb = format == JpegOutputFormat::RGBA ? RgbFormat::RGBA : (format == JpegOutputFormat::BGRA ? RgbFormat::BGRA : RgbFormat::BGR24);
+      const size_t dstStride = width * (rgb == RgbFormat::BGR24 ? 3 : 4);
+      if (f.ncomp == 3 && f.info.hSampling == 1 && f.info.vSampling == 1) {
+        // 4:4:4 keeps its full chroma resolution
+        for (size_t r = 0; r < rows; ++r) {
+          Yuv444RowToRgb(yPlane + r * yStride, s.plane[1] + r * s.stride[1], s.plane[2] + r * s.stride[2], dst + (y0 + r) * dstStride, width, rgb);
+        }
+        break;
+      }
+      // Everything else goes through the SIMD 4:2:2 -> RGB kernel
+      for (size_t r = 0; r < rows; ++r) {
+        const uint8_t* u = ChromaRow422(f, s, 1, r, s.tmp[0], chromaW);
+        const uint8_t* v = ChromaRow422(f, s, 2, r, s.tmp[1], chromaW);
+        PackRow422(yPlane + r * yStride, u, v, s.packed + r * chromaW * 4, chromaW, Yuv422Layout::YUY2);
+      }
+      simd_yuv422_to_rgb(s.packed, chromaW * 4, dst + y0 * dstStride, dstStride, width, rows, Yuv422Layout::YUY2, rgb, YuvMatrix::BT601, YuvRange::Full);
+      break;
+    }
+  }
+}
+
+size_t Gcd(size_t a, size_t b) {
+  while (b) {
+    const size_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Start of every restart interval in the scan.
+void FindSegments(const JpegFrameHeader& f, std::vector<const uint8_t*>& segments) {
+  segments.clear();
+  segments.push_back(f.scan);
+  const uint8_t* p = f.scan;
+  while (p < f.end) {
+    p = static_cast<const uint8_t*>(std::memchr(p, 0xFF, static_cast<size_t>(f.end - p)));
+    if (!p || f.end - p < 2) return;
+    const uint8_t m = p[1];
+    if (m >= 0xD0 && m <= 0xD7) {
+      segments.push_back(p + 2);
+    } else if (m != 0x00 && m != 0xFF) {
+      return;  // EOI or the next segment
+    }
+    p += m == 0xFF ? 1 : 2;
+  }
+}
+
+}  // namespace
+
+JpegDecoder::JpegDecoder() {
+}
+
+JpegDecoder::~JpegDecoder() {
+}
+
+bool JpegDecoder::ReadInfo(const uint8_t* data, size_t size, JpegImageInfo& info) {
+  std::unique_ptr<JpegFrameHeader> f(new JpegFrameHeader());
+  if (!ParseHeaders(data, size, *f, false)) return false;
+  info = f->info;
+  return true;
+}
+
+size_t JpegDecoder::OutputSize(JpegOutputFormat format, size_t width, size_t height) {
+  const size_t chromaW = (width + 1) / 2, chromaH = (height + 1) / 2;
+  switch (format) {
+    case JpegOutputFormat::NV12:
+    case JpegOutputFormat::I420:
+      return width * height + chromaW * chromaH * 2;
+    case JpegOutputFormat::YUY2:
+    case JpegOutputFormat::UYVY:
+      return chromaW * 4 * height;
+    case JpegOutputFormat::RGBA:
+    case JpegOutputFormat::BGRA:
+      return width * height * 4;
+    case JpegOutputFormat::BGR24:
+      return width * height * 3;
+  }
+  return 0;
+}
+
+const JpegImageInfo& JpegDecoder::LastInfo() const {
+  static const JpegImageInfo kNone;
+  return m_frame ? m_frame->info : kNone;
+}
+
+void JpegDecoder::Reset() {
+  std::lock_guard<std::mutex> lock(m_scratchLock);
+  m_idle.clear();
+  m_scratch.clear();
+  m_segments = std::vector<const uint8_t*>();
+  m_coefs = std::vector<int16_t>();
+  m_acFlags = std::vector<uint8_t>();
+}
+
+JpegDecodeScratch* JpegDecoder::AcquireScratch() {
+  JpegDecodeScratch* s = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_scratchLock);
+    if (!m_idle.empty()) {
+      s = m_idle.back();
+      m_idle.pop_back();
+    } else {
+      m_scratch.emplace_back(new JpegDecodeScratch());
+      s = m_scratch.back().get();
+    }
+  }
+  // Lay out the planes for the current frame
+  const JpegFrameHeader& f = *m_frame;
+  const size_t chromaW = (f.info.width + 1) / 2;
+  size_t bytes = 0;
+  for (int c = 0; c < f.ncomp; ++c) {
+    s->stride[c] = f.mcusX * f.comp[c].h * 8;
+    bytes += s->stride[c] * f.comp[c].v * 8;
+  }
+  const size_t rowBytes = (chromaW + 63) & ~static_cast<size_t>(63);
+  bytes += rowBytes * 5 + chromaW * 4 * f.mcuHeight;
+  if (s->storage.size() < bytes) s->storage.resize(bytes);
+  uint8_t* p = s->storage.data();
+  for (int c = 0; c < f.ncomp; ++c) {
+    s->plane[c] = p;
+    p += s->stride[c] * f.comp[c].v * 8;
+  }
+  for (uint8_t*& t : s->tmp) {
+    t = p;
+    p += rowBytes;
+  }
+  s->grey = p;
+  std::memset(s->grey, 128, chromaW);
+  p += rowBytes;
+  s->packed = p;
+  return s;
+}
+
+void JpegDecoder::ReleaseScratch(JpegDecodeScratch* scratch) {
+  std::lock_guard<std::mutex> lock(m_scratchLock);
+  m_idle.push_back(scratch);
+}
+
+bool JpegDecoder::Decode(const uint8_t* data, size_t size, JpegOutputFormat format, uint8_t* dst, size_t width, size_t height, ConvertEngine* engine) {
+  if (!dst) return false;
+  if (!m_frame) m_frame.reset(new JpegFrameHeader());
+  JpegFrameHeader& f = *m_frame;
+  if (!ParseHeaders(data, size, f, true)) return false;
+  if (f.info.width != width || f.info.height != height) return false;
+  const bool yuv = format == JpegOutputFormat::NV12 || format == JpegOutputFormat::I420 || format == JpegOutputFormat::YUY2 ||
+                   format == JpegOutputFormat::UYVY;
+  PrepareMultipliers(f, yuv);
+
+  const size_t mcuRows = f.mcusY;
+  const size_t interval = f.info.restartInterval;
+  const size_t threads = engine ? engine->ThreadCount() : 1;
+  // ParallelRows works in MCU rows; weigh each by its pixels
+  const size_t rowPixels = f.mcusX * f.mcuWidth * f.mcuHeight;
+
+  auto decodeBand = [&](size_t rowBegin, size_t rowEnd, const uint8_t* start) {
+    JpegDecodeScratch* s = AcquireScratch();
+    BitReader br(start, f.end);
+    ScanState st;
+    st.restartsLeft = interval;
+    for (size_t row = rowBegin; row < rowEnd; ++row) {
+      DecodeMcuRow(f, br, st, s, nullptr, nullptr);
+      EmitMcuRow(f, *s, row, format, dst);
+    }
+    ReleaseScratch(s);
+  };
+
+  if (threads > 1 && mcuRows > 1 && width * height >= 2 * ConvertEngine::kMinBandPixels) {
+    if (interval) {
+      // Bands must start on a restart boundary: every `rowAlign` MCU rows
+      const size_t rowAlign = interval / Gcd(interval, f.mcusX);
+      const size_t expected = (f.mcusX * mcuRows + interval - 1) / interval;
+      FindSegments(f, m_segments);
+      if (rowAlign < mcuRows && m_segments.size() >= expected) {
+        engine->ParallelRows(mcuRows, rowPixels, rowAlign, [&](size_t rowBegin, size_t rowEnd) {
+          decodeBand(rowBegin, rowEnd, m_segments[rowBegin * f.mcusX / interval]);
+        });
+        m_lastMode = JpegDecodeMode::Restart;
+        return true;
+      }
+    }
+
+    // No usable restart markers: Huffman decoding is inherently serial, but
+    // the IDCT and color conversion of the decoded rows are not.
+    const size_t blocksPerRow = f.mcusX * f.blocksPerMcu;
+    m_coefs.resize(blocksPerRow * mcuRows * 64);
+    m_acFlags.resize(blocksPerRow * mcuRows);
+    {
+      BitReader br(f.scan, f.end);
+      ScanState st;
+      st.restartsLeft = interval;
+      for (size_t row = 0; row < mcuRows; ++row) {
+        DecodeMcuRow(f, br, st, nullptr, m_coefs.data() + row * blocksPerRow * 64, m_acFlags.data() + row * blocksPerRow);
+      }
+    }
+    engine->ParallelRows(mcuRows, rowPixels, 1, [&](size_t rowBegin, size_t rowEnd) {
+      JpegDecodeScratch* s = AcquireScratch();
+      for (size_t row = rowBegin; row < rowEnd; ++row) {
+        ReconstructMcuRow(f, *s, m_coefs.data() + row * blocksPerRow * 64, m_acFlags.data() + row * blocksPerRow);
+        EmitMcuRow(f, *s, row, format, dst);
+      }
+      ReleaseScratch(s);
+    });
+    m_lastMode = JpegDecodeMode::Pipelined;
+    return true;
+  }
+
+  decodeBand(0, mcuRows, f.scan);
+  m_lastMode = JpegDecodeMode::Serial;
+  return true;
+}
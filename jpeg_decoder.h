@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "convert.h"
+
+class ConvertEngine;
+// Defined in jpeg_decoder.cc
+struct JpegFrameHeader;
+struct JpegDecodeScratch;
+
+// Output layouts of JpegDecoder: tightly packed frames, as the capture
+// backends deliver them. NV12/I420 chroma planes are (width + 1) / 2 samples
+// wide and (height + 1) / 2 rows; YUY2/UYVY rows cover an even width.
+enum class JpegOutputFormat { NV12, I420, YUY2, UYVY, RGBA, BGRA, BGR24 };
+
+// What a JPEG header says about the image.
+struct JpegImageInfo {
+  size_t width = 0;
+  size_t height = 0;
+  int components = 0;  // 1 (grayscale) or 3 (YCbCr)
+  // Luma sampling relative to chroma: 2x1 = 4:2:2, 2x2 = 4:2:0
+  int hSampling = 1;
+  int vSampling = 1;
+  size_t restartInterval = 0;  // MCUs per restart interval; 0 = none
+};
+
+// How the last frame was spread across threads.
+enum class JpegDecodeMode {
+  Serial,    // one thread decoded and reconstructed the frame
+  Restart,   // restart intervals decoded in parallel, band by band
+  Pipelined  // serial entropy decoding, parallel IDCT and color conversion
+};
+
+// Baseline (sequential, Huffman, 8-bit) JPEG decoder for MJPEG camera frames:
+// grayscale or YCbCr at 4:4:4, 4:2:2, 4:2:0 or 4:4:0, with or without DHT
+// segments (MJPEG streams often rely on the standard tables) and restart
+// markers. Dequantization and the IDCT run on the dispatched SIMD kernel
+// (simd_jpeg_idct). Each MCU row is reconstructed into small per-thread
+// planes and written straight to the output, so the frame is written once.
+//
+// With a ConvertEngine, frames whose restart intervals line up with MCU rows
+// are decoded in independent bands on the engine's workers; other frames are
+// entropy-decoded on the calling thread and reconstructed in parallel. Not
+// thread-safe: calls on one decoder must be serialized.
+class JpegDecoder {
+ public:
+  JpegDecoder();
+  ~JpegDecoder();
+  JpegDecoder(const JpegDecoder&) = delete;
+  JpegDecoder& operator=(const JpegDecoder&) = delete;
+
+  // Parse the headers up to the first scan. False when `data` is not a
+  // baseline JPEG this decoder handles (progressive, arithmetic, 12-bit,
+  // CMYK, ...) or the headers are damaged.
+  static bool ReadInfo(const uint8_t* data, size_t size, JpegImageInfo& info);
+
+  // Bytes of one `format` frame of width x height.
+  static size_t OutputSize(JpegOutputFormat format, size_t width, size_t height);
+
+  // Decode one width x height frame into `dst` (OutputSize bytes). YUV
+  // output is BT.601 limited range (JFIF samples are compressed in the
+  // dequantizer, at no cost per pixel); RGB output uses the full-range JFIF
+  // conversion. Truncated or corrupt entropy data decodes as far as it goes
+  // and the rest comes out grey. `engine` may be null for a single-threaded
+  // decode. Returns false, leaving `dst` untouched, when ReadInfo would or
+  // the frame is not width x height.
+  bool Decode(const uint8_t* data, size_t size, JpegOutputFormat format, uint8_t* dst, size_t width, size_t height, ConvertEngine* engine = nullptr);
+
+  // Header of the last frame passed to Decode
+  const JpegImageInfo& LastInfo() const;
+  JpegDecodeMode LastMode() const { return m_lastMode; }
+
+  // Free the per-thread scratch and coefficient storage.
+  void Reset();
+
+ private:
+  // Per-thread MCU-row planes, leased for one band of a frame
+  JpegDecodeScratch* AcquireScratch();
+  void ReleaseScratch(JpegDecodeScratch* scratch);
+
+  std::unique_ptr<JpegFrameHeader> m_frame;
+  std::mutex m_scratchLock;
+  std::vector<std::unique_ptr<JpegDecodeScratch>> m_scratch;
+  std::vector<JpegDecodeScratch*> m_idle;
+  // Entropy-coded segment starts (one per restart interval)
+  std::vector<const uint8_t*> m_segments;
+  // Whole-frame coefficients and per-block "has AC" flags (pipelined mode)
+  std::vector<int16_t> m_coefs;
+  std::vector<uint8_t> m_acFlags;
+  JpegDecodeMode m_lastMode = JpegDecodeMode::Serial;
+};
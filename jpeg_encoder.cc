@@ -0,0 +1,455 @@
+#include "jpeg_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "jpeg_tables.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Canonical code and length per symbol
+struct HuffTable {
+  uint16_t code[256];
+  uint8_t size[256];
+};
+
+struct HuffTables {
+  HuffTable dc[2];  // luma, chroma
+  HuffTable ac[2];
+};
+
+void BuildHuffTable(const uint8_t* bits, const uint8_t* values, HuffTable& table) {
+  std::memset(&table, 0, sizeof(table));
+  uint16_t code = 0;
+  size_t k = 0;
+  for (int length = 1; length <= 16; ++length) {
+    for (int i = 0; i < bits[length - 1]; ++i, ++k) {
+      table.code[values[k]] = code++;
+      table.size[values[k]] = static_cast<uint8_t>(length);
+    }
+    code = static_cast<uint16_t>(code << 1);
+  }
+}
+
+const HuffTables& StandardHuffTables() {
+  static const HuffTables tables = [] {
+    HuffTables t;
+    BuildHuffTable(kJpegDcLumaBits, kJpegDcValues, t.dc[0]);
+    BuildHuffTable(kJpegDcChromaBits, kJpegDcValues, t.dc[1]);
+    BuildHuffTable(kJpegAcLumaBits, kJpegAcLumaValues, t.ac[0]);
+    BuildHuffTable(kJpegAcChromaBits, kJpegAcChromaValues, t.ac[1]);
+    return t;
+  }();
+  return tables;
+}
+
+inline int BitLength(uint32_t v) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  return _BitScanReverse(&index, v) ? static_cast<int>(index) + 1 : 0;
+#else
+  return v ? 32 - __builtin_clz(v) : 0;
+#endif
+}
+
+inline int TrailingZeros(uint64_t v) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, v);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(v);
+#endif
+}
+
+// Entropy-coded segment writer with byte stuffing. Writes through a raw
+// pointer; callers Reserve room for what they are about to write.
+class BitWriter {
+ public:
+  // Worst case for one block: 22 DC bits plus 63 * 26 AC bits, doubled by
+  // byte stuffing, plus the bits still held in the accumulator.
+  static constexpr size_t kMaxBlockBytes = 512;
+
+  explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {
+    m_base = m_out.data();
+    m_pos = m_base;
+  }
+
+  size_t Size() const { return static_cast<size_t>(m_pos - m_base); }
+
+  void Reserve(size_t bytes) {
+    const size_t used = Size();
+    if (m_out.size() - used >= bytes) return;
+    m_out.resize(std::max(used + bytes, m_out.size() + m_out.size() / 2));
+    m_base = m_out.data();
+    m_pos = m_base + used;
+  }
+
+  void Byte(uint8_t b) { *m_pos++ = b; }
+  void Word(uint16_t v) {
+    Byte(static_cast<uint8_t>(v >> 8));
+    Byte(static_cast<uint8_t>(v));
+  }
+  void Marker(uint8_t m) {
+    Byte(0xFF);
+    Byte(m);
+  }
+
+  // `bits` holds exactly `count` (<= 32) significant bits.
+  void PutBits(uint32_t bits, int count) {
+    m_acc = (m_acc << count) | bits;
+    m_count += count;
+    if (m_count >= 32) {
+      m_count -= 32;
+      Emit32(static_cast<uint32_t>(m_acc >> m_count));
+    }
+  }
+
+  // Pad the last byte with 1s and write out what is left.
+  void Flush() {
+    const int pad = (8 - (m_count & 7)) & 7;
+    if (pad) PutBits((1u << pad) - 1, pad);
+    while (m_count > 0) {
+      m_count -= 8;
+      StuffedByte(static_cast<uint8_t>(m_acc >> m_count));
+    }
+  }
+
+ private:
+  void StuffedByte(uint8_t b) {
+    Byte(b);
+    if (b == 0xFF) Byte(0);
+  }
+
+  void Emit32(uint32_t word) {
+    // Common case: no 0xFF byte, so no stuffing
+    if (((~word - 0x01010101u) & word & 0x80808080u) == 0) {
+      m_pos[0] = static_cast<uint8_t>(word >> 24);
+      m_pos[1] = static_cast<uint8_t>(word >> 16);
+      m_pos[2] = static_cast<uint8_t>(word >> 8);
+      m_pos[3] = static_cast<uint8_t>(word);
+      m_pos += 4;
+      return;
+    }
+    StuffedByte(static_cast<uint8_t>(word >> 24));
+    StuffedByte(static_cast<uint8_t>(word >> 16));
+    StuffedByte(static_cast<uint8_t>(word >> 8));
+    StuffedByte(static_cast<uint8_t>(word));
+  }
+
+  std::vector<uint8_t>& m_out;
+  uint8_t* m_base;
+  uint8_t* m_pos;
+  uint64_t m_acc = 0;
+  int m_count = 0;
+};
+
+// Copy the 8x8 block at (x0, y0) of a plane, replicating the last column and
+// row where the block hangs over the edge.
+inline void LoadBlock(const uint8_t* plane, size_t stride, size_t step, size_t planeW, size_t planeH, size_t x0, size_t y0, uint8_t* block) {
+  if (x0 + 8 <= planeW && y0 + 8 <= planeH) {
+    const uint8_t* row = plane + y0 * stride + x0 * step;
+    if (step == 1) {
+      for (int r = 0; r < 8; ++r, row += stride) std::memcpy(block + r * 8, row, 8);
+    } else {
+      for (int r = 0; r < 8; ++r, row += stride) {
+        for (int i = 0; i < 8; ++i) block[r * 8 + i] = row[i * step];
+      }
+    }
+    return;
+  }
+  for (size_t r = 0; r < 8; ++r) {
+    const uint8_t* row = plane + std::min(y0 + r, planeH - 1) * stride;
+    for (size_t i = 0; i < 8; ++i) block[r * 8 + i] = row[std::min(x0 + i, planeW - 1) * step];
+  }
+}
+
+void EncodeBlock(BitWriter& w, const int16_t* coefs, int& lastDc, const HuffTable& dc, const HuffTable& ac) {
+  // Baseline limits: DC differences to 11 bits, AC values to 10. Only
+  // super-white limited-range input at the top quality can exceed them.
+  int dcValue = std::max(-1023, std::min(1023, static_cast<int>(coefs[0])));
+  int diff = dcValue - lastDc;
+  lastDc = dcValue;
+  int magnitude = diff < 0 ? -diff : diff;
+  int nbits = BitLength(static_cast<uint32_t>(magnitude));
+  w.PutBits((static_cast<uint32_t>(dc.code[nbits]) << nbits) | (static_cast<uint32_t>(diff < 0 ? diff - 1 : diff) & ((1u << nbits) - 1)),
+            dc.size[nbits] + nbits);
+
+  // Zigzag order plus a mask of the non-zero positions, so runs of zeros are
+  // skipped a whole run at a time.
+  int16_t zz[64];
+  uint64_t nonzero = 0;
+  for (int k = 1; k < 64; ++k) {
+    zz[k] = coefs[kJpegZigzag[k]];
+    nonzero |= static_cast<uint64_t>(zz[k] != 0) << k;
+  }
+  int last = 0;
+  while (nonzero) {
+    const int k = TrailingZeros(nonzero);
+    nonzero &= nonzero - 1;
+    int run = k - last - 1;
+    while (run > 15) {
+      w.PutBits(ac.code[0xF0], ac.size[0xF0]);  // ZRL
+      run -= 16;
+    }
+    int v = zz[k];
+    magnitude = v < 0 ? -v : v;
+    if (magnitude > 1023) {
+      magnitude = 1023;
+      v = v < 0 ? -1023 : 1023;
+    }
+    nbits = BitLength(static_cast<uint32_t>(magnitude));
+    const int symbol = (run << 4) | nbits;
+    w.PutBits((static_cast<uint32_t>(ac.code[symbol]) << nbits) | (static_cast<uint32_t>(v < 0 ? v - 1 : v) & ((1u << nbits) - 1)),
+              ac.size[symbol] + nbits);
+    last = k;
+  }
+  if (last != 63) w.PutBits(ac.code[0x00], ac.size[0x00]);  // EOB
+}
+
+void WriteHuffTable(BitWriter& w, uint8_t classAndId, const uint8_t* bits, const uint8_t* values, size_t count) {
+  w.Byte(classAndId);
+  for (int i = 0; i < 16; ++i) w.Byte(bits[i]);
+  for (size_t i = 0; i < count; ++i) w.Byte(values[i]);
+}
+
+}  // namespace
+
+YuvJpegEncoder::YuvJpegEncoder() {
+}
+
+void YuvJpegEncoder::SetQuality(float quality) {
+  m_quality = std::min(1.0f, std::max(0.0f, quality));
+}
+
+void YuvJpegEncoder::Reset() {
+  m_planes.clear();
+  m_planes.shrink_to_fit();
+}
+
+void YuvJpegEncoder::PrepareTables(YuvRange range) {
+  const int quality = std::max(1, std::min(100, static_cast<int>(std::lround(m_quality * 100.0f))));
+  if (m_tablesValid && quality == m_tablesQuality && range == m_tablesRange) return;
+
+  // IJG scaling of the K.1 tables
+  const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+  // Limited-range samples are mapped onto JFIF full range as part of the
+  // transform: y' - 128 = (y - (16 + 128 * 219 / 255)) * 255 / 219 and
+  // c' - 128 = (c - 128) * 255 / 224. The offset is the kernel's level shift,
+  // the factor goes into the divisors.
+  const bool limited = range == YuvRange::Limited;
+  const float rangeScale[2] = {limited ? 255.0f / 219.0f : 1.0f, limited ? 255.0f / 224.0f : 1.0f};
+  m_offset[0] = limited ? 16.0f + 128.0f * 219.0f / 255.0f : 128.0f;
+  m_offset[1] = 128.0f;
+  for (int t = 0; t < 2; ++t) {
+    const uint8_t* base = t == 0 ? kJpegLumaQuant : kJpegChromaQuant;
+    for (int i = 0; i < 64; ++i) {
+      const int q = std::max(1, std::min(255, (base[i] * scale + 50) / 100));
+      m_quant[t][i] = static_cast<uint8_t>(q);
+      m_divisors[t][i] = rangeScale[t] / (static_cast<float>(q) * kJpegAanScale[i / 8] * kJpegAanScale[i % 8] * 8.0f);
+    }
+  }
+  m_tablesValid = true;
+  m_tablesQuality = quality;
+  m_tablesRange = range;
+}
+
+size_t YuvJpegEncoder::Encode(const JpegSource& src, std::vector<uint8_t>& out) {
+  if (!src.y || !src.cb || !src.cr || src.width == 0 || src.height == 0 || src.width > 65535 || src.height > 65535) return 0;
+  PrepareTables(src.range);
+
+  const size_t hs = src.chroma == JpegChroma::Yuv444 ? 1 : 2;
+  const size_t vs = src.chroma == JpegChroma::Yuv420 ? 2 : 1;
+  const size_t chromaW = (src.width + hs - 1) / hs;
+  const size_t chromaH = (src.height + vs - 1) / vs;
+  const size_t mcuW = 8 * hs, mcuH = 8 * vs;
+  const size_t mcusX = (src.width + mcuW - 1) / mcuW;
+  const size_t mcusY = (src.height + mcuH - 1) / mcuH;
+
+  BitWriter w(out);
+  w.Reserve(1024);
+
+  static const uint8_t kJfif[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+  w.Marker(0xD8);  // SOI
+  w.Marker(0xE0);  // APP0
+  w.Word(2 + sizeof(kJfif));
+  for (uint8_t b : kJfif) w.Byte(b);
+  w.Marker(0xDB);  // DQT: luma table 0, chroma table 1, zigzag order
+  w.Word(2 + 2 * 65);
+  for (int t = 0; t < 2; ++t) {
+    w.Byte(static_cast<uint8_t>(t));
+    for (int k = 0; k < 64; ++k) w.Byte(m_quant[t][kJpegZigzag[k]]);
+  }
+  w.Marker(0xC0);  // SOF0
+  w.Word(17);
+  w.Byte(8);
+  w.Word(static_cast<uint16_t>(src.height));
+  w.Word(static_cast<uint16_t>(src.width));
+  w.Byte(3);
+  w.Byte(1);
+  w.Byte(static_cast<uint8_t>((hs << 4) | vs));
+  w.Byte(0);
+  for (uint8_t id = 2; id <= 3; ++id) {
+    w.Byte(id);
+    w.Byte(0x11);
+    w.Byte(1);
+  }
+  w.Marker(0xC4);  // DHT
+  w.Word(2 + 2 * (17 + 12) + 2 * (17 + 162));
+  WriteHuffTable(w, 0x00, kJpegDcLumaBits, kJpegDcValues, 12);
+  WriteHuffTable(w, 0x10, kJpegAcLumaBits, kJpegAcLumaValues, 162);
+  WriteHuffTable(w, 0x01, kJpegDcChromaBits, kJpegDcValues, 12);
+  WriteHuffTable(w, 0x11, kJpegAcChromaBits, kJpegAcChromaValues, 162);
+  w.Marker(0xDA);  // SOS
+  w.Word(12);
+  w.Byte(3);
+  w.Byte(1);
+  w.Byte(0x00);
+  w.Byte(2);
+  w.Byte(0x11);
+  w.Byte(3);
+  w.Byte(0x11);
+  w.Byte(0);
+  w.Byte(63);
+  w.Byte(0);
+
+  // Fetched once: the table may be switched between frames, not within one
+  const JpegFdctFn fdct = convert_kernels().jpegFdct;
+  const HuffTables& huff = StandardHuffTables();
+  const size_t blocksPerMcu = hs * vs + 2;
+  alignas(32) uint8_t block[64];
+  alignas(32) int16_t coefs[64];
+  int lastDc[3] = {0, 0, 0};
+  for (size_t my = 0; my < mcusY; ++my) {
+    for (size_t mx = 0; mx < mcusX; ++mx) {
+      w.Reserve(blocksPerMcu * BitWriter::kMaxBlockBytes);
+      for (size_t by = 0; by < vs; ++by) {
+        for (size_t bx = 0; bx < hs; ++bx) {
+          LoadBlock(src.y, src.yStride, src.yStep, src.width, src.height, mx * mcuW + bx * 8, my * mcuH + by * 8, block);
+          fdct(block, m_offset[0], m_divisors[0], coefs);
+          EncodeBlock(w, coefs, lastDc[0], huff.dc[0], huff.ac[0]);
+        }
+      }
+      LoadBlock(src.cb, src.cStride, src.cStep, chromaW, chromaH, mx * 8, my * 8, block);
+      fdct(block, m_offset[1], m_divisors[1], coefs);
+      EncodeBlock(w, coefs, lastDc[1], huff.dc[1], huff.ac[1]);
+      LoadBlock(src.cr, src.cStride, src.cStep, chromaW, chromaH, mx * 8, my * 8, block);
+      fdct(block, m_offset[1], m_divisors[1], coefs);
+      EncodeBlock(w, coefs, lastDc[2], huff.dc[1], huff.ac[1]);
+    }
+  }
+
+  w.Reserve(16);
+  w.Flush();
+  w.Marker(0xD9);  // EOI
+  return w.Size();
+}
+
+size_t YuvJpegEncoder::EncodeNv12(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, size_t width, size_t height, YuvRange range, std::vector<uint8_t>& out) {
+  if (!srcUV) return 0;
+  JpegSource src;
+  src.y = srcY;
+  src.yStride = strideY;
+  src.cb = srcUV;
+  src.cr = srcUV + 1;
+  src.cStride = strideUV;
+  src.cStep = 2;
+  src.width = width;
+  src.height = height;
+  src.chroma = JpegChroma::Yuv420;
+  src.range = range;
+  return Encode(src, out);
+}
+
+size_t YuvJpegEncoder::EncodeI420(const uint8_t* data, size_t width, size_t height, YuvRange range, std::vector<uint8_t>& out) {
+  if (!data) return 0;
+  const size_t chromaW = (width + 1) / 2, chromaH = (height + 1) / 2;
+  JpegSource src;
+  src.y = data;
+  src.yStride = width;
+  src.cb = data + width * height;
+  src.cr = src.cb + chromaW * chromaH;
+  src.cStride = chromaW;
+  src.width = width;
+  src.height = height;
+  src.chroma = JpegChroma::Yuv420;
+  src.range = range;
+  return Encode(src, out);
+}
+
+size_t YuvJpegEncoder::EncodeYuv422(const uint8_t* data, size_t stride, size_t width, size_t height, Yuv422Layout layout, YuvRange range, std::vector<uint8_t>& out) {
+  if (!data) return 0;
+  // YUY2: Y0 U Y1 V, UYVY: U Y0 V Y1
+  const bool yuy2 = layout == Yuv422Layout::YUY2;
+  JpegSource src;
+  src.y = data + (yuy2 ? 0 : 1);
+  src.yStride = stride;
+  src.yStep = 2;
+  src.cb = data + (yuy2 ? 1 : 0);
+  src.cr = data + (yuy2 ? 3 : 2);
+  src.cStride = stride;
+  src.cStep = 4;
+  src.width = width;
+  src.height = height;
+  src.chroma = JpegChroma::Yuv422;
+  src.range = range;
+  return Encode(src, out);
+}
+
+size_t YuvJpegEncoder::EncodeRgb(const uint8_t* data, size_t stride, size_t width, size_t height, RgbFormat format, JpegChroma chroma, std::vector<uint8_t>& out) {
+  if (!data || width == 0 || height == 0) return 0;
+  const size_t bpp = format == RgbFormat::BGR24 ? 3 : 4;
+  const int ri = format == RgbFormat::RGBA ? 0 : 2, bi = 2 - ri;
+  const size_t hs = chroma == JpegChroma::Yuv444 ? 1 : 2;
+  const size_t vs = chroma == JpegChroma::Yuv420 ? 2 : 1;
+  const size_t chromaW = (width + hs - 1) / hs, chromaH = (height + vs - 1) / vs;
+  m_planes.resize(width * height + chromaW * chromaH * 2);
+  uint8_t* yPlane = m_planes.data();
+  uint8_t* cbPlane = yPlane + width * height;
+  uint8_t* crPlane = cbPlane + chromaW * chromaH;
+
+  // JFIF YCbCr (BT.601 full range), 16-bit fixed point as libjpeg's jccolor
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t* s = data + row * stride;
+    uint8_t* d = yPlane + row * width;
+    for (size_t x = 0; x < width; ++x, s += bpp) {
+      d[x] = static_cast<uint8_t>((19595 * s[ri] + 38470 * s[1] + 7471 * s[bi] + 32768) >> 16);
+    }
+  }
+  // Chroma from the mean colour of each hs x vs box
+  for (size_t cy = 0; cy < chromaH; ++cy) {
+    for (size_t cx = 0; cx < chromaW; ++cx) {
+      int r = 0, g = 0, b = 0, n = 0;
+      for (size_t dy = 0; dy < vs && cy * vs + dy < height; ++dy) {
+        const uint8_t* s = data + (cy * vs + dy) * stride + cx * hs * bpp;
+        for (size_t dx = 0; dx < hs && cx * hs + dx < width; ++dx, s += bpp, ++n) {
+          r += s[ri];
+          g += s[1];
+          b += s[bi];
+        }
+      }
+      r = (r + n / 2) / n;
+      g = (g + n / 2) / n;
+      b = (b + n / 2) / n;
+      cbPlane[cy * chromaW + cx] = static_cast<uint8_t>((-11059 * r - 21709 * g + 32768 * b + (128 << 16) + 32767) >> 16);
+      crPlane[cy * chromaW + cx] = static_cast<uint8_t>((32768 * r - 27439 * g - 5329 * b + (128 << 16) + 32767) >> 16);
+    }
+  }
+
+  JpegSource src;
+  src.y = yPlane;
+  src.yStride = width;
+  src.cb = cbPlane;
+  src.cr = crPlane;
+  src.cStride = chromaW;
+  src.width = width;
+  src.height = height;
+  src.chroma = chroma;
+  src.range = YuvRange::Full;
+  return Encode(src, out);
+}
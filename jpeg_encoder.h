@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "convert.h"
+
+// Chroma subsampling of an encoded JPEG
+enum class JpegChroma { Yuv420, Yuv422, Yuv444 };
+
+// 8-bit YCbCr source for YuvJpegEncoder. `step` is the distance in bytes
+// between horizontally adjacent samples of a plane, so semi-planar (NV12
+// chroma: step 2) and packed 4:2:2 frames (YUY2 luma: step 2, chroma: step 4)
+// are read in place. The chroma planes are subsampled as `chroma` says and
+// the JPEG keeps that layout.
+struct JpegSource {
+  const uint8_t* y = nullptr;
+  size_t yStride = 0;
+  size_t yStep = 1;
+  const uint8_t* cb = nullptr;
+  const uint8_t* cr = nullptr;
+  size_t cStride = 0;
+  size_t cStep = 1;
+  size_t width = 0;  // luma size
+  size_t height = 0;
+  JpegChroma chroma = JpegChroma::Yuv420;
+  // Limited-range input (BT.601 camera output) is expanded to the full range
+  // JFIF specifies inside the quantizer, at no extra cost per sample.
+  YuvRange range = YuvRange::Limited;
+};
+
+// Portable baseline JPEG (JFIF) encoder that takes YUV as it comes from the
+// camera: NV12/IYUV are coded as 4:2:0 and YUY2/UYVY as 4:2:2 without a
+// round trip through RGB. DCT and quantization run on the dispatched SIMD
+// kernel (simd_jpeg_fdct_quant); entropy coding uses the standard Huffman
+// tables. Not thread-safe.
+class YuvJpegEncoder {
+ public:
+  YuvJpegEncoder();
+
+  // 0 (smallest) .. 1 (best), mapped onto the IJG 1-100 quality scale.
+  void SetQuality(float quality);
+  float Quality() const { return m_quality; }
+
+  // Encode into `out`. Its size is taken as the room available and grown
+  // (by at least half) when the stream does not fit; bytes past the returned
+  // size are unspecified. Returns the encoded size, or 0 when there is
+  // nothing to encode or a side exceeds 65535.
+  size_t Encode(const JpegSource& src, std::vector<uint8_t>& out);
+
+  // Strides in bytes.
+  size_t EncodeNv12(const uint8_t* srcY, size_t strideY, const uint8_t* srcUV, size_t strideUV, size_t width, size_t height, YuvRange range, std::vector<uint8_t>& out);
+  // Contiguous IYUV (I420): Y, then U, then V, chroma rows (width + 1) / 2.
+  size_t EncodeI420(const uint8_t* src, size_t width, size_t height, YuvRange range, std::vector<uint8_t>& out);
+  size_t EncodeYuv422(const uint8_t* src, size_t stride, size_t width, size_t height, Yuv422Layout layout, YuvRange range, std::vector<uint8_t>& out);
+  // RGBA/BGRA/BGR24 input, converted to full-range BT.601 YCbCr planes (as
+  // JFIF specifies) at the requested subsampling first.
+  size_t EncodeRgb(const uint8_t* src, size_t stride, size_t width, size_t height, RgbFormat format, JpegChroma chroma, std::vector<uint8_t>& out);
+
+  // Free the RGB conversion planes.
+  void Reset();
+
+ private:
+  // Rebuild the quantization tables and divisors for the current quality
+  // and `range` (no-op when neither changed).
+  void PrepareTables(YuvRange range);
+
+  float m_quality = 0.85f;
+  bool m_tablesValid = false;
+  int m_tablesQuality = 0;
+  YuvRange m_tablesRange = YuvRange::Limited;
+  // Luma [0] and chroma [1]: DQT entries (natural order) and the divisors and
+  // level shift handed to the DCT kernel.
+  uint8_t m_quant[2][64];
+  alignas(32) float m_divisors[2][64];
+  float m_offset[2];
+  // YCbCr planes for EncodeRgb
+  std::vector<uint8_t> m_planes;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+// Tables shared by the JPEG encoder and decoder (ITU T.81).
+
+// Natural-order index of each zigzag position
+extern const uint8_t kJpegZigzag[64];
+
+// K.1 quantization tables, natural order
+extern const uint8_t kJpegLumaQuant[64];
+extern const uint8_t kJpegChromaQuant[64];
+
+// AAN scale per frequency: cos(k*pi/16) * sqrt(2) for k > 0
+extern const float kJpegAanScale[8];
+
+// K.3 Huffman tables: code counts per length 1..16, then symbols. MJPEG
+// streams that carry no DHT segment are coded with these.
+extern const uint8_t kJpegDcLumaBits[16];
+extern const uint8_t kJpegDcChromaBits[16];
+extern const uint8_t kJpegDcValues[12];
+extern const uint8_t kJpegAcLumaBits[16];
+extern const uint8_t kJpegAcLumaValues[162];
+extern const uint8_t kJpegAcChromaBits[16];
+extern const uint8_t kJpegAcChromaValues[162];
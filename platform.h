@@ -0,0 +1,32 @@
+#pragma once
+
+// Minimal HRESULT vocabulary for code shared between the Windows (Media
+// Foundation) build and other platforms. On Windows the SDK definitions are
+// used as-is; elsewhere the same names and values are provided so portable
+// code can keep the SUCCEEDED/FAILED style used throughout the addon.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdint>
+
+typedef int32_t HRESULT;
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define S_OK ((HRESULT)0x00000000)
+#define S_FALSE ((HRESULT)0x00000001)
+#define E_NOTIMPL ((HRESULT)0x80004001)
+#define E_POINTER ((HRESULT)0x80004003)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_UNEXPECTED ((HRESULT)0x8000FFFF)
+#define E_ACCESSDENIED ((HRESULT)0x80070005)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000E)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#endif
+
+// HRESULT_FROM_WIN32 values used by the portable backends
+#define CAPTURE_E_NOT_FOUND ((HRESULT)0x80070490)  // ERROR_NOT_FOUND
+#define CAPTURE_E_BUSY ((HRESULT)0x800700AA)       // ERROR_BUSY
+#define CAPTURE_E_NOT_READY ((HRESULT)0x80070015)  // ERROR_NOT_READY
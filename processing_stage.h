@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "spsc_queue.h"
+
+struct ProcessingStageStats {
+  uint64_t queued = 0;     // items handed to the stage
+  uint64_t processed = 0;  // items the worker finished
+  uint64_t dropped = 0;    // items refused because the stage was full
+  size_t depth = 0;        // items waiting for the worker
+  size_t highWater = 0;    // maximum depth observed
+  size_t capacity = 0;     // 0 = the backend has no processing stage
+  double meanWaitUs = 0;   // hand-off latency: push until the worker starts
+  double maxWaitUs = 0;
+  double meanProcessUs = 0;  // handler time (conversion, encoding, callback)
+  double maxProcessUs = 0;
+};
+
+// Worker thread fed through an SpscQueue, used to take conversion, encoding
+// and the frame callback off a capture thread: the capture side pushes and
+// immediately goes back to the device, the worker runs the handler. Push
+// never blocks; when the worker falls `capacity` items behind, new items are
+// refused and the caller drops them.
+//
+// Push must come from one thread at a time and must not race with Stop.
+template <class T>
+class ProcessingStage {
+ public:
+  using Handler = std::function<void(T&)>;
+
+  ProcessingStage(size_t capacity, Handler handler) : m_queue(capacity), m_handler(std::move(handler)) {
+  }
+  ~ProcessingStage() { Stop(); }
+  ProcessingStage(const ProcessingStage&) = delete;
+  ProcessingStage& operator=(const ProcessingStage&) = delete;
+
+  // Start the worker (no-op while running).
+  void Start() {
+    if (m_running) return;
+    if (m_thread.joinable()) m_thread.join();  // stopped from its own handler
+    m_running = true;
+    m_thread = std::thread(&ProcessingStage::Run, this);
+  }
+
+  // Stop the worker and discard queued items. The handler is not running and
+  // will not run again once this returns (called from the handler itself,
+  // the worker exits after it returns and discards the items then).
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_running = false;
+    }
+    m_wake.notify_all();
+    if (m_thread.get_id() == std::this_thread::get_id()) return;
+    if (m_thread.joinable()) m_thread.join();
+    Slot slot;
+    while (m_queue.TryPop(slot)) slot = Slot();
+  }
+
+  // Hand `item` to the worker. Returns false (and leaves `item` with the
+  // caller) when the stage is stopped or full.
+  bool Push(T&& item) {
+    if (!m_running.load(std::memory_order_relaxed)) return false;
+    Slot slot{std::move(item), Clock::now()};
+    if (!m_queue.TryPush(std::move(slot))) {
+      item = std::move(slot.item);
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    m_queued.fetch_add(1, std::memory_order_relaxed);
+    const size_t depth = m_queue.Size();
+    if (depth > m_highWater.load(std::memory_order_relaxed)) m_highWater.store(depth, std::memory_order_relaxed);
+    // Pairs with the fence in Run: either the worker sees the item before it
+    // sleeps, or we see it sleeping and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_idle.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_idle.store(false, std::memory_order_relaxed);
+      m_wake.notify_one();
+    }
+    return true;
+  }
+
+  // Whether a Push would be refused for lack of room (producer side).
+  bool Full() const { return m_queue.Size() >= m_queue.Capacity(); }
+
+  ProcessingStageStats GetStats() const {
+    ProcessingStageStats s;
+    s.queued = m_queued.load(std::memory_order_relaxed);
+    s.processed = m_processed.load(std::memory_order_relaxed);
+    s.dropped = m_dropped.load(std::memory_order_relaxed);
+    s.depth = m_queue.Size();
+    s.highWater = m_highWater.load(std::memory_order_relaxed);
+    s.capacity = m_queue.Capacity();
+    if (s.processed > 0) {
+      s.meanWaitUs = static_cast<double>(m_waitUs.load(std::memory_order_relaxed)) / s.processed;
+      s.meanProcessUs = static_cast<double>(m_processUs.load(std::memory_order_relaxed)) / s.processed;
+    }
+    s.maxWaitUs = static_cast<double>(m_maxWaitUs.load(std::memory_order_relaxed));
+    s.maxProcessUs = static_cast<double>(m_maxProcessUs.load(std::memory_order_relaxed));
+    return s;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Slot {
+    T item;
+    Clock::time_point pushed;
+  };
+
+  static uint64_t Micros(Clock::duration d) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+  }
+
+  void Run() {
+    Slot slot;
+    while (m_running.load(std::memory_order_relaxed)) {
+      if (m_queue.TryPop(slot)) {
+        const Clock::time_point start = Clock::now();
+        const uint64_t waitUs = Micros(start - slot.pushed);
+        try { m_handler(slot.item); } catch (...) {}
+        slot = Slot();
+        const uint64_t processUs = Micros(Clock::now() - start);
+        m_waitUs.fetch_add(waitUs, std::memory_order_relaxed);
+        m_processUs.fetch_add(processUs, std::memory_order_relaxed);
+        if (waitUs > m_maxWaitUs.load(std::memory_order_relaxed)) m_maxWaitUs.store(waitUs, std::memory_order_relaxed);
+        if (processUs > m_maxProcessUs.load(std::memory_order_relaxed)) m_maxProcessUs.store(processUs, std::memory_order_relaxed);
+        m_processed.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(m_lock);
+      m_idle.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_queue.Empty()) {
+        m_wake.wait(lock, [this] { return !m_idle.load(std::memory_order_relaxed) || !m_running.load(std::memory_order_relaxed); });
+      }
+      m_idle.store(false, std::memory_order_relaxed);
+    }
+    // Release what is still queued (MF samples hold the source's buffers)
+    // on both stop paths, including a Stop from the handler.
+    while (m_queue.TryPop(slot)) slot = Slot();
+  }
+
+  SpscQueue<Slot> m_queue;
+  Handler m_handler;
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+  // Worker is (about to be) waiting on m_wake
+  std::atomic<bool> m_idle{false};
+  std::mutex m_lock;
+  std::condition_variable m_wake;
+  // Producer-side counters
+  std::atomic<uint64_t> m_queued{0};
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<size_t> m_highWater{0};
+  // Worker-side counters
+  std::atomic<uint64_t> m_processed{0};
+  std::atomic<uint64_t> m_waitUs{0};
+  std::atomic<uint64_t> m_processUs{0};
+  std::atomic<uint64_t> m_maxWaitUs{0};
+  std::atomic<uint64_t> m_maxProcessUs{0};
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Capacity is rounded up to a power of two. Neither side
+// blocks or allocates: a full queue rejects the push, an empty one the pop.
+template <class T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity) {
+    size_t n = 1;
+    while (n < capacity) n <<= 1;
+    m_slots.resize(n);
+    m_mask = n - 1;
+  }
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer only. Leaves `item` untouched when the queue is full.
+  bool TryPush(T&& item) {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_headCache == m_slots.size()) {
+      m_headCache = m_head.load(std::memory_order_acquire);
+      if (tail - m_headCache == m_slots.size()) return false;
+    }
+    m_slots[tail & m_mask] = std::move(item);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.
+  bool TryPop(T& out) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tailCache) {
+      m_tailCache = m_tail.load(std::memory_order_acquire);
+      if (head == m_tailCache) return false;
+    }
+    T& slot = m_slots[head & m_mask];
+    out = std::move(slot);
+    slot = T();  // drop what the slot held now rather than when it is reused
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with either side; exact otherwise.
+  size_t Size() const {
+    const size_t head = m_head.load(std::memory_order_acquire);
+    return m_tail.load(std::memory_order_acquire) - head;
+  }
+  bool Empty() const { return Size() == 0; }
+  size_t Capacity() const { return m_slots.size(); }
+
+ private:
+  std::vector<T> m_slots;
+  size_t m_mask = 0;
+  // Each index on its own cache line, next to the copy of the other index
+  // that its owner reads, so the two threads only share a line on wrap-around.
+  alignas(64) std::atomic<size_t> m_head{0};  // next slot to pop (consumer)
+  size_t m_tailCache = 0;
+  alignas(64) std::atomic<size_t> m_tail{0};  // next slot to fill (producer)
+  size_t m_headCache = 0;
+};
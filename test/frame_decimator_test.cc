@@ -0,0 +1,138 @@
+// FrameDecimator unit tests (no Node): every-Nth selection, target-rate
+// selection under timestamp jitter, non-integer and slower sources, and the
+// rebase when the device clock steps back.
+//
+//   frame_decimator_test    exit code 0 = pass, 1 = a check failed
+//
+// Built by binding.gyp next to the addon; test/native.test.js runs it.
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "frame_decimator.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond)                                                              \
+  do {                                                                           \
+    if (!(cond)) {                                                               \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++g_failures;                                                              \
+    }                                                                            \
+  } while (0)
+
+// Deterministic jitter source (xorshift32), uniform in [-1, 1)
+static double NextJitter(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return static_cast<double>(state) / 2147483648.0 - 1.0;
+}
+
+// Indices of the frames `decimator` keeps out of `times`
+static std::vector<size_t> Kept(FrameDecimator& decimator, const std::vector<int64_t>& times) {
+  std::vector<size_t> kept;
+  for (size_t i = 0; i < times.size(); ++i) {
+    if (decimator.Admit(times[i])) kept.push_back(i);
+  }
+  return kept;
+}
+
+// `count` frames at `rate` fps from `startUs`, each moved by up to
+// `jitter` periods either way
+static std::vector<int64_t> Timestamps(double rate, size_t count, double jitter, uint32_t seed, int64_t startUs = 1000000) {
+  const double periodUs = 1e6 / rate;
+  std::vector<int64_t> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    times[i] = startUs + static_cast<int64_t>(i * periodUs + (jitter > 0.0 ? NextJitter(seed) * jitter * periodUs : 0.0));
+  }
+  return times;
+}
+
+static void TestEveryNth() {
+  std::shared_ptr<FrameDecimator> decimator = FrameDecimator::EveryNth(3);
+  // Timestamps play no part
+  std::vector<size_t> kept = Kept(*decimator, Timestamps(30.0, 30, 0.0, 1));
+  CHECK(kept.size() == 10);
+  for (size_t i = 0; i < kept.size(); ++i) CHECK(kept[i] == i * 3);
+  FrameDecimatorStats stats = decimator->GetStats();
+  CHECK(stats.admitted == 10);
+  CHECK(stats.skipped == 20);
+  CHECK(stats.step == 3);
+
+  // 0 keeps every frame
+  std::shared_ptr<FrameDecimator> all = FrameDecimator::EveryNth(0);
+  CHECK(Kept(*all, Timestamps(30.0, 30, 0.0, 1)).size() == 30);
+}
+
+// 30 -> 5 fps keeps exactly every 6th frame, with up to a quarter period of
+// jitter either way
+static void TestJitteredSixth() {
+  for (uint32_t seed = 1; seed <= 200; ++seed) {
+    std::shared_ptr<FrameDecimator> decimator = FrameDecimator::TargetRate(5.0);
+    decimator->SetSourceRate(30.0);
+    // Just under a quarter period: a frame exactly on a boundary may go either way
+    std::vector<size_t> kept = Kept(*decimator, Timestamps(30.0, 600, 0.249, seed));
+    bool every6th = kept.size() == 100;
+    for (size_t i = 0; every6th && i < kept.size(); ++i) every6th = kept[i] == i * 6;
+    if (!every6th) std::fprintf(stderr, "jitter seed %u: %zu frames kept\n", seed, kept.size());
+    CHECK(every6th);
+  }
+}
+
+// 29.97 fps to 5 fps: one frame in 6, one in 5 every ~170 output frames,
+// whether the period is measured or the format's (with jitter)
+static void TestNtscSource() {
+  const double rate = 30000.0 / 1001.0;
+  const size_t count = 6000;  // 200 s
+  const double expected = count * 5.0 / rate;
+  for (int nominal = 0; nominal < 2; ++nominal) {
+    std::shared_ptr<FrameDecimator> decimator = FrameDecimator::TargetRate(5.0);
+    if (nominal) decimator->SetSourceRate(rate);
+    std::vector<size_t> kept = Kept(*decimator, Timestamps(rate, count, nominal ? 0.2 : 0.0, 3));
+    CHECK(kept.size() + 1 >= static_cast<size_t>(expected) && kept.size() <= static_cast<size_t>(expected) + 1);
+    size_t fives = 0;
+    for (size_t i = 1; i < kept.size(); ++i) {
+      const size_t gap = kept[i] - kept[i - 1];
+      CHECK(gap == 5 || gap == 6);
+      if (gap == 5) ++fives;
+    }
+    CHECK(fives >= 4 && fives <= 7);
+  }
+}
+
+// A source slower than the target keeps every frame
+static void TestSlowSource() {
+  std::shared_ptr<FrameDecimator> decimator = FrameDecimator::TargetRate(30.0);
+  CHECK(Kept(*decimator, Timestamps(15.0, 300, 0.2, 7)).size() == 300);
+  std::shared_ptr<FrameDecimator> same = FrameDecimator::TargetRate(30.0);
+  CHECK(Kept(*same, Timestamps(30.0, 300, 0.2, 7)).size() == 300);
+}
+
+// A device clock that steps back restarts the intervals at that frame
+static void TestBackwardClock() {
+  std::shared_ptr<FrameDecimator> decimator = FrameDecimator::TargetRate(10.0);
+  decimator->SetSourceRate(30.0);
+  std::vector<int64_t> times = Timestamps(30.0, 30, 0.0, 1, 5000000);
+  const std::vector<int64_t> after = Timestamps(30.0, 30, 0.0, 1, 20000);
+  times.insert(times.end(), after.begin(), after.end());
+  std::vector<size_t> kept = Kept(*decimator, times);
+  // Every 3rd frame before the step, then every 3rd from the step on
+  CHECK(kept.size() == 20);
+  for (size_t i = 0; i < kept.size(); ++i) CHECK(kept[i] == i * 3);
+}
+
+int main() {
+  TestEveryNth();
+  TestJitteredSixth();
+  TestNtscSource();
+  TestSlowSource();
+  TestBackwardClock();
+  if (g_failures != 0) {
+    std::fprintf(stderr, "frame_decimator_test: %d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("frame_decimator_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,168 @@
+// FramePool unit tests (no Node): bucket sizing, reuse of returned storage,
+// the in-flight cap and the pool's lifetime relative to its leases.
+//
+//   frame_pool_test      exit code 0 = pass, 1 = a check failed
+//
+// Built by binding.gyp next to the addon; test/native.test.js runs it.
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "frame.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond)                                                              \
+  do {                                                                           \
+    if (!(cond)) {                                                               \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++g_failures;                                                              \
+    }                                                                            \
+  } while (0)
+
+static void TestBucketCapacity() {
+  // Everything up to one page shares the smallest bucket
+  CHECK(FramePool::BucketCapacity(0) == 4096);
+  CHECK(FramePool::BucketCapacity(1) == 4096);
+  CHECK(FramePool::BucketCapacity(4096) == 4096);
+  // Then 2^k and 1.5 * 2^k
+  CHECK(FramePool::BucketCapacity(4097) == 6144);
+  CHECK(FramePool::BucketCapacity(6144) == 6144);
+  CHECK(FramePool::BucketCapacity(6145) == 8192);
+  CHECK(FramePool::BucketCapacity(8193) == 12288);
+  // 640x480 NV12 and 1920x1080 RGB32
+  CHECK(FramePool::BucketCapacity(460800) == 524288);
+  CHECK(FramePool::BucketCapacity(8294400) == 8388608);
+
+  for (size_t size = 1; size < (64u << 20); size = size * 5 / 3 + 1) {
+    const size_t capacity = FramePool::BucketCapacity(size);
+    CHECK(capacity >= size);
+    // Never more than 1.5x the request beyond the first bucket
+    CHECK(size <= 4096 || capacity * 2 <= size * 3);
+    CHECK(FramePool::BucketCapacity(capacity) == capacity);
+  }
+
+  std::shared_ptr<FramePool> pool = FramePool::Create();
+  FramePtr frame = pool->Acquire(5000);
+  CHECK(frame);
+  CHECK(frame->size == 5000);
+  CHECK(frame->capacity() == 6144);
+  CHECK(frame->pool == pool);
+}
+
+static void TestReuse() {
+  std::shared_ptr<FramePool> pool = FramePool::Create();
+  FramePtr frame = pool->Acquire(100000);
+  CHECK(frame);
+  const uint8_t* storage = frame->data();
+  frame->info.sequence = 42;
+  memset(frame->data(), 0xAB, frame->size);
+  frame.reset();  // FrameDeleter recycles it
+
+  FramePoolStats stats = pool->GetStats();
+  CHECK(stats.misses == 1);
+  CHECK(stats.hits == 0);
+  CHECK(stats.inFlight == 0);
+  CHECK(stats.cached == 1);
+  CHECK(stats.cachedBytes == FramePool::BucketCapacity(100000));
+
+  // Any size in the same bucket gets the same storage back, with fresh info
+  frame = pool->Acquire(98305);
+  CHECK(frame);
+  CHECK(frame->data() == storage);
+  CHECK(frame->size == 98305);
+  CHECK(frame->info.sequence == 0);
+  stats = pool->GetStats();
+  CHECK(stats.hits == 1);
+  CHECK(stats.misses == 1);
+  CHECK(stats.cached == 0);
+  CHECK(stats.cachedBytes == 0);
+
+  // A different bucket allocates
+  FramePtr other = pool->Acquire(200000);
+  CHECK(other);
+  CHECK(other->data() != storage);
+  CHECK(pool->GetStats().misses == 2);
+
+  frame.reset();
+  other.reset();
+  CHECK(pool->GetStats().cached == 2);
+  pool->Trim();
+  stats = pool->GetStats();
+  CHECK(stats.cached == 0);
+  CHECK(stats.cachedBytes == 0);
+}
+
+static void TestMaxInFlight() {
+  std::shared_ptr<FramePool> pool = FramePool::Create(3);
+  std::vector<FramePtr> leased;
+  for (int i = 0; i < 3; ++i) {
+    leased.push_back(pool->Acquire(1024));
+    CHECK(leased.back());
+  }
+  // The cap refuses further leases instead of allocating
+  FramePtr refused = pool->Acquire(1024);
+  CHECK(!refused);
+  CHECK(!pool->Acquire(1 << 20));
+  FramePoolStats stats = pool->GetStats();
+  CHECK(stats.exhausted == 2);
+  CHECK(stats.inFlight == 3);
+  CHECK(stats.highWater == 3);
+  CHECK(stats.maxInFlight == 3);
+
+  // Returning one frame makes room again
+  leased.pop_back();
+  FramePtr again = pool->Acquire(1024);
+  CHECK(again);
+  CHECK(pool->GetStats().hits == 1);
+
+  // Raising the cap (or removing it) admits more
+  pool->SetMaxInFlight(0);
+  FramePtr unbounded = pool->Acquire(1024);
+  CHECK(unbounded);
+  stats = pool->GetStats();
+  CHECK(stats.inFlight == 4);
+  CHECK(stats.highWater == 4);
+  CHECK(stats.exhausted == 2);
+
+  pool->ResetStats();
+  stats = pool->GetStats();
+  CHECK(stats.exhausted == 0);
+  CHECK(stats.hits == 0);
+  CHECK(stats.highWater == 4);
+}
+
+static void TestFrameOutlivesPool() {
+  std::shared_ptr<FramePool> pool = FramePool::Create();
+  std::weak_ptr<FramePool> weak = pool;
+  FramePtr frame = pool->Acquire(4096);
+  FramePtr idle = pool->Acquire(4096);
+  CHECK(frame);
+  CHECK(idle);
+  idle.reset();
+
+  // The embedding drops the pool while a frame is still leased (a Buffer
+  // not yet collected): the frame keeps it alive and stays usable
+  pool.reset();
+  CHECK(!weak.expired());
+  memset(frame->data(), 0x5A, frame->size);
+  CHECK(weak.lock()->GetStats().inFlight == 1);
+
+  // The last lease coming home frees the pool and its cached storage
+  frame.reset();
+  CHECK(weak.expired());
+}
+
+int main() {
+  TestBucketCapacity();
+  TestReuse();
+  TestMaxInFlight();
+  TestFrameOutlivesPool();
+  if (g_failures != 0) {
+    std::fprintf(stderr, "frame_pool_test: %d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("frame_pool_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,23 @@
+// Runs the standalone C++ test executables binding.gyp builds next to the
+// addon (build/Release). Each exits 0 on success and prints failed checks to
+// stderr.
+const test = require("node:test");
+const assert = require("node:assert");
+const { spawnSync } = require("node:child_process");
+const fs = require("node:fs");
+const path = require("node:path");
+
+const BUILD_DIR = path.join(__dirname, "..", "build", "Release");
+const EXE = process.platform === "win32" ? ".exe" : "";
+
+// v4l2_backend_test is only built on Linux
+const NATIVE_TESTS = ["frame_pool_test", "frame_decimator_test", "v4l2_backend_test"];
+
+for (const name of NATIVE_TESTS) {
+  const file = path.join(BUILD_DIR, name + EXE);
+  test(name, { skip: !fs.existsSync(file) && `${name} is not built` }, () => {
+    const result = spawnSync(file, [], { encoding: "utf8" });
+    assert.ifError(result.error);
+    assert.strictEqual(result.status, 0, result.stderr || result.stdout);
+  });
+}
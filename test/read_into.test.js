@@ -0,0 +1,100 @@
+// readInto() on the synthetic backend: shared buffers are written directly,
+// other buffers get a copy once the frame is ready, a buffer detached while
+// its read is pending rejects instead of being written, and concurrent reads
+// are answered in order with the frames written into their buffers. A read
+// still waiting when the device is released resolves with null.
+//
+//   npm test    (runs node --expose-gc --test test/)
+const test = require("node:test");
+const assert = require("node:assert");
+const Camera = require("../addon.js");
+
+const WIDTH = 320;
+const HEIGHT = 240;
+const NV12_SIZE = (WIDTH * HEIGHT * 3) / 2;
+
+async function openCamera(t) {
+  const cam = new Camera({ backend: "synthetic" });
+  t.after(async () => {
+    if (cam.isCapturing()) await cam.stopCapture();
+    await cam.releaseDevice();
+  });
+  await cam.claimDevice("synthetic://camera0");
+  await cam.setFormat({ subtype: "NV12", width: WIDTH, height: HEIGHT, frameRate: 60 });
+  return cam;
+}
+
+test("frames are written straight into a SharedArrayBuffer", async (t) => {
+  const cam = await openCamera(t);
+  const shared = new SharedArrayBuffer(NV12_SIZE);
+  for (const buffer of [new Uint8Array(shared), shared]) {
+    const frame = await cam.readInto(buffer, { timeoutMs: 2000 });
+    assert.ok(frame);
+    assert.strictEqual(frame.size, NV12_SIZE);
+    assert.strictEqual(frame.subtype, "NV12");
+  }
+  const { pull } = cam.getStats();
+  assert.strictEqual(pull.direct, 2);
+  assert.strictEqual(pull.copied, 0);
+});
+
+test("other buffers receive a copy", async (t) => {
+  const cam = await openCamera(t);
+  const pixels = Buffer.alloc(NV12_SIZE);
+  const frame = await cam.readInto(pixels, { timeoutMs: 2000 });
+  assert.ok(frame);
+  assert.strictEqual(frame.size, NV12_SIZE);
+  // Row 16 crosses the colour bars, some of them bright
+  assert.ok(pixels.subarray(16 * WIDTH, 17 * WIDTH).some((v) => v > 128));
+  const { pull } = cam.getStats();
+  assert.strictEqual(pull.direct, 0);
+  assert.strictEqual(pull.copied, 1);
+});
+
+test("a buffer detached while waiting rejects", async (t) => {
+  const cam = await openCamera(t);
+  await cam.startCapture({ pull: { latestOnly: true } });
+  const buffer = new ArrayBuffer(NV12_SIZE);
+  const pending = cam.readInto(buffer, { timeoutMs: 2000 });
+  // Detach it, as a postMessage transfer would
+  structuredClone(buffer, { transfer: [buffer] });
+  assert.strictEqual(buffer.byteLength, 0);
+  await assert.rejects(pending, TypeError);
+
+  await assert.rejects(cam.readInto(buffer), TypeError);
+  await assert.rejects(cam.readInto(new Uint8Array(16), { timeoutMs: 2000 }), RangeError);
+  // The session still delivers afterwards
+  assert.ok(await cam.readInto(new Uint8Array(NV12_SIZE), { timeoutMs: 2000 }));
+});
+
+test("concurrent shared-buffer reads keep the frames written into them", async (t) => {
+  const cam = await openCamera(t);
+  await cam.startCapture({ pull: { latestOnly: true } });
+  for (let round = 0; round < 10; round++) {
+    const buffers = [new SharedArrayBuffer(NV12_SIZE), new SharedArrayBuffer(NV12_SIZE)];
+    // Both requests are waiting before the first frame is produced, so each
+    // frame is claimed for (and written into) one of the buffers
+    const [first, second] = await Promise.all(buffers.map((buffer) => cam.readInto(buffer, { timeoutMs: 2000 })));
+    assert.ok(first && second);
+    assert.ok(first.sequence < second.sequence, `round ${round}: ${first.sequence} answered after ${second.sequence}`);
+  }
+  const { pull } = cam.getStats();
+  assert.strictEqual(pull.direct, 20);
+  assert.strictEqual(pull.copied, 0);
+  // No frame written into a buffer was replaced by a newer one
+  assert.strictEqual(pull.superseded, 0);
+});
+
+test("a read waiting when the device is released resolves with null", async (t) => {
+  const cam = await openCamera(t);
+  // Unpaced frames would answer the read before the release; a slow source
+  // keeps it waiting
+  await cam.setFormat({ subtype: "NV12", width: WIDTH, height: HEIGHT, frameRate: 1 });
+  await cam.startCapture({ pull: { latestOnly: true } });
+  // The first frame is due at once: take it so the next read has to wait
+  assert.ok(await cam.readInto(new Uint8Array(NV12_SIZE), { timeoutMs: 2000 }));
+  const pending = cam.readInto(new SharedArrayBuffer(NV12_SIZE));
+  await cam.releaseDevice();
+  assert.strictEqual(await pending, null);
+  assert.strictEqual(cam.isCapturing(), false);
+});
@@ -0,0 +1,494 @@
+// V4l2CaptureBackend against a fake device (no kernel driver): the mmap'd
+// buffer ring, the epoll-driven reader, requeueing of every dequeued buffer
+// (including frames the gate refuses), padded rows, copied or converted, and
+// StopCapture from a frame callback.
+//
+//   v4l2_backend_test    exit code 0 = pass, 1 = a check failed
+//
+// Built by binding.gyp on Linux; test/native.test.js runs it.
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend_v4l2.h"
+#include "frame_converter.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond)                                                              \
+  do {                                                                           \
+    if (!(cond)) {                                                               \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++g_failures;                                                              \
+    }                                                                            \
+  } while (0)
+
+namespace {
+
+const uint32_t kWidth = 64;
+const uint32_t kHeight = 48;
+// Extra bytes the fake driver adds to every row (bytesperline)
+const uint32_t kRowPadding = 32;
+const uint8_t kPaddingByte = 0xEE;
+const size_t kOffsetStep = 4096;
+
+// Single-planar capture device with an mmap buffer ring. Its fd is an
+// eventfd in semaphore mode: one count per filled buffer, so epoll reports
+// EPOLLIN exactly while VIDIOC_DQBUF has a buffer to return.
+struct FakeDevice {
+  struct Buffer {
+    std::vector<uint8_t> memory;
+    bool queued = false;
+    uint32_t bytesUsed = 0;
+    uint32_t sequence = 0;
+  };
+
+  std::mutex lock;
+  std::string dir;
+  int fd = -1;
+  uint32_t fourcc = V4L2_PIX_FMT_YUYV;
+  uint32_t bytesPerLine = 0;
+  uint32_t sizeImage = 0;
+  bool streaming = false;
+  std::vector<Buffer> buffers;
+  std::deque<uint32_t> queued;  // indices owned by the driver, fill order
+  std::deque<uint32_t> filled;  // indices ready for DQBUF
+  uint32_t sequence = 0;
+  // Counters checked by the tests
+  size_t qbufs = 0;
+  size_t dqbufs = 0;
+  size_t badQbufs = 0;  // QBUF of a buffer the driver already owns
+  size_t streamOffs = 0;
+  size_t mapped = 0;
+};
+
+FakeDevice g_device;
+
+void SetFormatLocked(uint32_t fourcc) {
+  g_device.fourcc = fourcc;
+  if (fourcc == V4L2_PIX_FMT_NV12) {
+    g_device.bytesPerLine = kWidth + kRowPadding;
+    g_device.sizeImage = g_device.bytesPerLine * kHeight * 3 / 2;
+  } else {
+    g_device.bytesPerLine = kWidth * 2 + kRowPadding;
+    g_device.sizeImage = g_device.bytesPerLine * kHeight;
+  }
+}
+
+int FakeOpen(const char* path, int flags) {
+  (void)flags;
+  if (g_device.dir + "/video0" != path) {
+    errno = ENOENT;
+    return -1;
+  }
+  return eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+int FakeClose(int fd) {
+  return ::close(fd);
+}
+
+int FakeIoctl(int fd, unsigned long request, void* arg) {
+  std::lock_guard<std::mutex> lock(g_device.lock);
+  g_device.fd = fd;
+  switch (request) {
+    case VIDIOC_QUERYCAP: {
+      v4l2_capability* cap = static_cast<v4l2_capability*>(arg);
+      strcpy(reinterpret_cast<char*>(cap->card), "Fake Camera");
+      cap->capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+      return 0;
+    }
+    case VIDIOC_ENUM_FMT: {
+      v4l2_fmtdesc* desc = static_cast<v4l2_fmtdesc*>(arg);
+      if (desc->index > 1) break;
+      desc->pixelformat = desc->index == 0 ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_NV12;
+      return 0;
+    }
+    case VIDIOC_ENUM_FRAMESIZES: {
+      v4l2_frmsizeenum* size = static_cast<v4l2_frmsizeenum*>(arg);
+      if (size->index > 0) break;
+      size->type = V4L2_FRMSIZE_TYPE_DISCRETE;
+      size->discrete.width = kWidth;
+      size->discrete.height = kHeight;
+      return 0;
+    }
+    case VIDIOC_S_FMT:
+    case VIDIOC_G_FMT: {
+      v4l2_format* fmt = static_cast<v4l2_format*>(arg);
+      if (request == VIDIOC_S_FMT) {
+        if (g_device.streaming) {
+          errno = EBUSY;
+          return -1;
+        }
+        SetFormatLocked(fmt->fmt.pix.pixelformat == V4L2_PIX_FMT_NV12 ? V4L2_PIX_FMT_NV12 : V4L2_PIX_FMT_YUYV);
+      }
+      fmt->fmt.pix.pixelformat = g_device.fourcc;
+      fmt->fmt.pix.width = kWidth;
+      fmt->fmt.pix.height = kHeight;
+      fmt->fmt.pix.bytesperline = g_device.bytesPerLine;
+      fmt->fmt.pix.sizeimage = g_device.sizeImage;
+      return 0;
+    }
+    case VIDIOC_G_PARM:
+      return 0;  // no V4L2_CAP_TIMEPERFRAME
+    case VIDIOC_REQBUFS: {
+      v4l2_requestbuffers* req = static_cast<v4l2_requestbuffers*>(arg);
+      g_device.buffers.clear();
+      g_device.queued.clear();
+      g_device.filled.clear();
+      g_device.buffers.resize(req->count);
+      for (FakeDevice::Buffer& b : g_device.buffers) b.memory.assign(g_device.sizeImage, 0);
+      return 0;
+    }
+    case VIDIOC_QUERYBUF: {
+      v4l2_buffer* buf = static_cast<v4l2_buffer*>(arg);
+      if (buf->index >= g_device.buffers.size()) break;
+      buf->length = g_device.sizeImage;
+      buf->m.offset = buf->index * kOffsetStep;
+      return 0;
+    }
+    case VIDIOC_QBUF: {
+      v4l2_buffer* buf = static_cast<v4l2_buffer*>(arg);
+      if (buf->index >= g_device.buffers.size()) break;
+      FakeDevice::Buffer& b = g_device.buffers[buf->index];
+      if (b.queued) {
+        ++g_device.badQbufs;
+        break;
+      }
+      b.queued = true;
+      g_device.queued.push_back(buf->index);
+      ++g_device.qbufs;
+      return 0;
+    }
+    case VIDIOC_DQBUF: {
+      if (g_device.filled.empty()) {
+        errno = EAGAIN;
+        return -1;
+      }
+      uint64_t count = 0;
+      ssize_t n = ::read(fd, &count, sizeof(count));  // one buffer fewer ready
+      (void)n;
+      v4l2_buffer* buf = static_cast<v4l2_buffer*>(arg);
+      buf->index = g_device.filled.front();
+      g_device.filled.pop_front();
+      FakeDevice::Buffer& b = g_device.buffers[buf->index];
+      b.queued = false;
+      buf->bytesused = b.bytesUsed;
+      buf->sequence = b.sequence;
+      buf->timestamp.tv_sec = b.sequence / 30;
+      buf->timestamp.tv_usec = (b.sequence % 30) * 33333;
+      buf->flags = 0;
+      ++g_device.dqbufs;
+      return 0;
+    }
+    case VIDIOC_STREAMON:
+      g_device.streaming = true;
+      return 0;
+    case VIDIOC_STREAMOFF:
+      g_device.streaming = false;
+      ++g_device.streamOffs;
+      return 0;
+    default:
+      errno = ENOTTY;
+      return -1;
+  }
+  errno = EINVAL;
+  return -1;
+}
+
+void* FakeMmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
+  (void)addr;
+  (void)prot;
+  (void)flags;
+  (void)fd;
+  std::lock_guard<std::mutex> lock(g_device.lock);
+  const size_t index = static_cast<size_t>(offset) / kOffsetStep;
+  if (index >= g_device.buffers.size() || length > g_device.buffers[index].memory.size()) return MAP_FAILED;
+  ++g_device.mapped;
+  return g_device.buffers[index].memory.data();
+}
+
+int FakeMunmap(void* addr, size_t length) {
+  (void)addr;
+  (void)length;
+  std::lock_guard<std::mutex> lock(g_device.lock);
+  --g_device.mapped;
+  return 0;
+}
+
+// Fill the next queued buffer: active bytes from `pixel(offset)` (offset into
+// the packed frame), row padding with kPaddingByte. False when the driver
+// owns no buffer.
+bool Produce(const std::function<uint8_t(size_t)>& pixel) {
+  std::lock_guard<std::mutex> lock(g_device.lock);
+  if (g_device.queued.empty()) return false;
+  const uint32_t index = g_device.queued.front();
+  g_device.queued.pop_front();
+  FakeDevice::Buffer& b = g_device.buffers[index];
+  const bool nv12 = g_device.fourcc == V4L2_PIX_FMT_NV12;
+  const size_t rowBytes = nv12 ? kWidth : kWidth * 2;
+  const size_t rows = nv12 ? kHeight * 3 / 2 : kHeight;
+  memset(b.memory.data(), kPaddingByte, b.memory.size());
+  for (size_t y = 0; y < rows; ++y) {
+    for (size_t x = 0; x < rowBytes; ++x) b.memory[y * g_device.bytesPerLine + x] = pixel(y * rowBytes + x);
+  }
+  b.bytesUsed = g_device.sizeImage;
+  b.sequence = g_device.sequence++;
+  g_device.filled.push_back(index);
+  uint64_t one = 1;
+  ssize_t n = ::write(g_device.fd, &one, sizeof(one));
+  (void)n;
+  return true;
+}
+
+// Every buffer is back with the driver
+bool AllQueued() {
+  std::lock_guard<std::mutex> lock(g_device.lock);
+  return !g_device.buffers.empty() && g_device.queued.size() == g_device.buffers.size();
+}
+
+bool WaitFor(const std::function<bool()>& done) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Frames delivered by the backend's callback
+struct Collector {
+  std::mutex lock;
+  std::vector<FramePtr> frames;
+
+  std::function<void(FramePtr)> Callback() {
+    return [this](FramePtr frame) {
+      std::lock_guard<std::mutex> guard(lock);
+      frames.push_back(std::move(frame));
+    };
+  }
+  size_t Count() {
+    std::lock_guard<std::mutex> guard(lock);
+    return frames.size();
+  }
+};
+
+uint8_t Pattern(size_t offset, uint32_t frame) {
+  return static_cast<uint8_t>((offset * 7 + frame * 13) & 0x7F);
+}
+
+const V4l2Io& FakeIo() {
+  static V4l2Io io = {FakeOpen, FakeClose, FakeIoctl, FakeMmap, FakeMunmap, nullptr};
+  io.deviceDir = g_device.dir.c_str();
+  return io;
+}
+
+void ClaimAndSetFormat(V4l2CaptureBackend& backend, const char* fourcc) {
+  std::vector<CaptureDeviceInfo> devices;
+  CHECK(SUCCEEDED(backend.EnumerateDevices(devices)));
+  CHECK(devices.size() == 1 && devices[0].friendlyName == "Fake Camera");
+  CHECK(SUCCEEDED(backend.ClaimDevice(g_device.dir + "/video0")));
+  CaptureFormat format;
+  format.guid = fourcc;
+  format.width = kWidth;
+  format.height = kHeight;
+  CHECK(SUCCEEDED(backend.SetFormat(format)));
+}
+
+// Padded rows without conversion are repacked into the frame
+void TestPaddedCopy() {
+  V4l2CaptureBackend backend(FakeIo());
+  Collector collector;
+  ClaimAndSetFormat(backend, "YUYV");
+  backend.SetFrameCallback(collector.Callback());
+  CHECK(SUCCEEDED(backend.StartCapture()));
+  CHECK(AllQueued());
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    CHECK(Produce([i](size_t offset) { return Pattern(offset, i); }));
+    CHECK(WaitFor([&] { return collector.Count() == i + 1; }));
+  }
+  CHECK(WaitFor(AllQueued));
+
+  const size_t packedSize = kWidth * 2 * kHeight;
+  for (uint32_t i = 0; i < collector.frames.size(); ++i) {
+    const Frame& frame = *collector.frames[i];
+    CHECK(frame.size == packedSize);
+    CHECK(frame.info.format == PixelFormat::YUY2);
+    CHECK(frame.info.stride == kWidth * 2);
+    CHECK(frame.info.sequence == i);
+    CHECK((frame.info.flags & FrameInfo::kDiscontinuity) == 0);
+    bool same = true;
+    for (size_t o = 0; o < packedSize; ++o) same = same && frame.data()[o] == Pattern(o, i);
+    CHECK(same);
+  }
+
+  CHECK(SUCCEEDED(backend.StopCapture()));
+  std::lock_guard<std::mutex> lock(g_device.lock);
+  CHECK(!g_device.streaming);
+  CHECK(g_device.mapped == 0);
+  CHECK(g_device.badQbufs == 0);
+}
+
+// A buffer whose frame the gate refuses is queued straight back, and the
+// skipped frames are not reported as a discontinuity
+void TestGateRequeues() {
+  V4l2CaptureBackend backend(FakeIo());
+  Collector collector;
+  ClaimAndSetFormat(backend, "YUYV");
+  backend.SetFrameCallback(collector.Callback());
+  size_t asked = 0;
+  backend.SetFrameGate([&asked](int64_t) { return asked++ % 2 == 0; });
+  CHECK(SUCCEEDED(backend.StartCapture()));
+
+  size_t bufferCount, qbufsAtStart, dqbufsAtStart;
+  {
+    std::lock_guard<std::mutex> lock(g_device.lock);
+    bufferCount = g_device.buffers.size();
+    qbufsAtStart = g_device.qbufs;
+    dqbufsAtStart = g_device.dqbufs;
+  }
+  // More frames than buffers: the ring stalls unless every buffer returns
+  const uint32_t frames = static_cast<uint32_t>(bufferCount) * 3;
+  for (uint32_t i = 0; i < frames; ++i) {
+    CHECK(Produce([i](size_t offset) { return Pattern(offset, i); }));
+    CHECK(WaitFor(AllQueued));
+  }
+  CHECK(WaitFor([&] { return collector.Count() == frames / 2 + frames % 2; }));
+  CHECK(SUCCEEDED(backend.StopCapture()));
+
+  CHECK(asked == frames);
+  {
+    std::lock_guard<std::mutex> lock(g_device.lock);
+    CHECK(g_device.dqbufs - dqbufsAtStart == frames);
+    CHECK(g_device.qbufs - qbufsAtStart == frames);
+    CHECK(g_device.badQbufs == 0);
+  }
+  for (size_t i = 0; i < collector.frames.size(); ++i) {
+    const Frame& frame = *collector.frames[i];
+    CHECK(frame.info.sequence == i);
+    CHECK((frame.info.flags & FrameInfo::kDiscontinuity) == 0);
+    // Admitted frames are the even ones
+    CHECK(frame.data()[1] == Pattern(1, static_cast<uint32_t>(i * 2)));
+  }
+}
+
+// StopCapture from a frame callback lets the reader exit on its own; the
+// ring stays mapped until the next StartCapture joins the reader
+void TestStopFromCallback() {
+  V4l2CaptureBackend backend(FakeIo());
+  Collector collector;
+  ClaimAndSetFormat(backend, "YUYV");
+  auto collect = collector.Callback();
+  HRESULT stopResult = E_FAIL;
+  backend.SetFrameCallback([&](FramePtr frame) {
+    collect(std::move(frame));
+    if (collector.Count() == 1) stopResult = backend.StopCapture();
+  });
+  CHECK(SUCCEEDED(backend.StartCapture()));
+
+  CHECK(Produce([](size_t offset) { return Pattern(offset, 0); }));
+  CHECK(WaitFor([&] { return collector.Count() == 1; }));
+  CHECK(WaitFor(AllQueued));
+  CHECK(SUCCEEDED(stopResult));
+  // The stopped reader dequeues nothing more
+  CHECK(Produce([](size_t offset) { return Pattern(offset, 1); }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK(collector.Count() == 1);
+  {
+    std::lock_guard<std::mutex> lock(g_device.lock);
+    CHECK(g_device.mapped > 0);
+  }
+
+  CHECK(SUCCEEDED(backend.StartCapture()));
+  CHECK(AllQueued());
+  CHECK(Produce([](size_t offset) { return Pattern(offset, 2); }));
+  CHECK(WaitFor([&] { return collector.Count() == 2; }));
+  CHECK(SUCCEEDED(backend.StopCapture()));
+  std::lock_guard<std::mutex> lock(g_device.lock);
+  CHECK(!g_device.streaming);
+  CHECK(g_device.mapped == 0);
+  CHECK(g_device.badQbufs == 0);
+}
+
+// Padded rows that need conversion are converted in place, matching a
+// conversion of the packed frame
+void TestPaddedConversion(const char* fourcc, PixelFormat native, PixelFormat output) {
+  V4l2CaptureBackend backend(FakeIo());
+  Collector collector;
+  ClaimAndSetFormat(backend, fourcc);
+  CHECK(SUCCEEDED(backend.SetOutputFormat(output)));
+  backend.SetFrameCallback(collector.Callback());
+  CHECK(SUCCEEDED(backend.StartCapture()));
+
+  // Limited-range YUV, so clamping does not hide a misread chroma row
+  auto pixel = [](size_t offset) { return static_cast<uint8_t>(16 + (offset * 37 + offset / 97) % 220); };
+  CHECK(Produce(pixel));
+  CHECK(WaitFor([&] { return collector.Count() == 1; }));
+  CHECK(WaitFor(AllQueued));
+  CHECK(SUCCEEDED(backend.StopCapture()));
+  if (collector.frames.size() != 1) return;
+
+  const size_t packedSize = PixelFormatFrameSize(native, kWidth, kHeight);
+  std::vector<uint8_t> packed(packedSize);
+  for (size_t o = 0; o < packedSize; ++o) packed[o] = pixel(o);
+  std::shared_ptr<FramePool> pool = FramePool::Create();
+  FrameConverter converter(pool);
+  converter.SetOutputFormat(output);
+  FramePtr expected;
+  CHECK(converter.Convert(native, packed.data(), packed.size(), kWidth, kHeight, expected) == S_OK);
+  if (!expected) return;
+
+  const Frame& frame = *collector.frames[0];
+  CHECK(frame.info.format == output);
+  CHECK(frame.size == expected->size);
+  CHECK(frame.size == expected->size && memcmp(frame.data(), expected->data(), frame.size) == 0);
+}
+
+}  // namespace
+
+int main() {
+  char dir[] = "/tmp/v4l2_backend_test.XXXXXX";
+  if (!mkdtemp(dir)) {
+    std::perror("mkdtemp");
+    return 1;
+  }
+  g_device.dir = dir;
+  // EnumerateDevices lists video* entries of the device directory
+  const std::string node = g_device.dir + "/video0";
+  int fd = ::open(node.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0600);
+  if (fd >= 0) ::close(fd);
+
+  TestPaddedCopy();
+  TestGateRequeues();
+  TestStopFromCallback();
+  TestPaddedConversion("YUYV", PixelFormat::YUY2, PixelFormat::RGB32);
+  TestPaddedConversion("NV12", PixelFormat::NV12, PixelFormat::RGB24);
+  TestPaddedConversion("NV12", PixelFormat::NV12, PixelFormat::IYUV);
+  TestPaddedConversion("NV12", PixelFormat::NV12, PixelFormat::MJPEG);
+  TestPaddedConversion("YUYV", PixelFormat::YUY2, PixelFormat::NV12);
+
+  ::unlink(node.c_str());
+  ::rmdir(dir);
+  if (g_failures != 0) {
+    std::fprintf(stderr, "v4l2_backend_test: %d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("v4l2_backend_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,252 @@
+#include "wic_jpeg_encoder.h"
+
+#include <wincodec.h>
+#include <algorithm>
+#include <cstring>
+
+// Output stream for the WIC encoder that writes into the storage of a pooled
+// frame. The frame is leased before encoding with an estimated size; should
+// the encoder write more, the frame's storage grows to the next pool bucket.
+class WicJpegEncoder::FrameStream : public IStream {
+ public:
+  FrameStream() : m_refCount(1) {
+  }
+
+  void Attach(Frame* frame) {
+    m_frame = frame;
+    m_position = 0;
+    m_length = 0;
+  }
+  void Detach() { m_frame = nullptr; }
+  size_t Length() const { return m_length; }
+
+  // IUnknown
+  STDMETHODIMP QueryInterface(REFIID riid, void** ppv) {
+    if (!ppv) return E_POINTER;
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(ISequentialStream) || riid == __uuidof(IStream)) {
+      *ppv = static_cast<IStream*>(this);
+      AddRef();
+      return S_OK;
+    }
+    *ppv = NULL;
+    return E_NOINTERFACE;
+  }
+  STDMETHODIMP_(ULONG) AddRef() { return InterlockedIncrement(&m_refCount); }
+  STDMETHODIMP_(ULONG) Release() {
+    ULONG count = InterlockedDecrement(&m_refCount);
+    if (count == 0) delete this;
+    return count;
+  }
+
+  // ISequentialStream
+  STDMETHODIMP Read(void* pv, ULONG cb, ULONG* pcbRead) {
+    if (!m_frame) return E_UNEXPECTED;
+    size_t n = m_position < m_length ? std::min<size_t>(cb, m_length - m_position) : 0;
+    if (n) memcpy(pv, m_frame->data() + m_position, n);
+    m_position += n;
+    if (pcbRead) *pcbRead = static_cast<ULONG>(n);
+    return n == cb ? S_OK : S_FALSE;
+  }
+  STDMETHODIMP Write(const void* pv, ULONG cb, ULONG* pcbWritten) {
+    if (!m_frame) return E_UNEXPECTED;
+    if (!Reserve(m_position + cb)) return STG_E_MEDIUMFULL;
+    memcpy(m_frame->data() + m_position, pv, cb);
+    m_position += cb;
+    m_length = std::max(m_length, m_position);
+    if (pcbWritten) *pcbWritten = cb;
+    return S_OK;
+  }
+
+  // IStream
+  STDMETHODIMP Seek(LARGE_INTEGER move, DWORD origin, ULARGE_INTEGER* newPosition) {
+    LONGLONG base = 0;
+    switch (origin) {
+      case STREAM_SEEK_SET:
+        break;
+      case STREAM_SEEK_CUR:
+        base = static_cast<LONGLONG>(m_position);
+        break;
+      case STREAM_SEEK_END:
+        base = static_cast<LONGLONG>(m_length);
+        break;
+      default:
+        return STG_E_INVALIDFUNCTION;
+    }
+    LONGLONG target = base + move.QuadPart;
+    if (target < 0) return STG_E_INVALIDFUNCTION;
+    m_position = static_cast<size_t>(target);
+    if (newPosition) newPosition->QuadPart = m_position;
+    return S_OK;
+  }
+  STDMETHODIMP SetSize(ULARGE_INTEGER size) {
+    if (!m_frame) return E_UNEXPECTED;
+    if (!Reserve(static_cast<size_t>(size.QuadPart))) return STG_E_MEDIUMFULL;
+    m_length = static_cast<size_t>(size.QuadPart);
+    return S_OK;
+  }
+  STDMETHODIMP Stat(STATSTG* stat, DWORD) {
+    if (!stat) return STG_E_INVALIDPOINTER;
+    ZeroMemory(stat, sizeof(*stat));
+    stat->type = STGTY_STREAM;
+    stat->cbSize.QuadPart = m_length;
+    return S_OK;
+  }
+  STDMETHODIMP Commit(DWORD) { return S_OK; }
+  STDMETHODIMP Revert() { return STG_E_INVALIDFUNCTION; }
+  STDMETHODIMP CopyTo(IStream*, ULARGE_INTEGER, ULARGE_INTEGER*, ULARGE_INTEGER*) { return E_NOTIMPL; }
+  STDMETHODIMP LockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) { return STG_E_INVALIDFUNCTION; }
+  STDMETHODIMP UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) { return STG_E_INVALIDFUNCTION; }
+  STDMETHODIMP Clone(IStream**) { return E_NOTIMPL; }
+
+ private:
+  ~FrameStream() {}
+
+  bool Reserve(size_t size) {
+    if (size <= m_frame->capacity()) return true;
+    try {
+      // Grow to a bucket size so the frame still recycles through the pool
+      m_frame->bytes.resize(FramePool::BucketCapacity(std::max(size, m_frame->capacity() + m_frame->capacity() / 2)));
+    } catch (...) {
+      return false;
+    }
+    return true;
+  }
+
+  ULONG m_refCount;
+  Frame* m_frame = nullptr;
+  size_t m_position = 0;
+  size_t m_length = 0;
+};
+
+WicJpegEncoder::WicJpegEncoder(std::shared_ptr<FramePool> pool) : m_pool(std::move(pool)) {
+  ZeroMemory(m_optionNames, sizeof(m_optionNames));
+  for (VARIANT& v : m_optionValues) VariantInit(&v);
+}
+
+WicJpegEncoder::~WicJpegEncoder() {
+  Reset();
+}
+
+void WicJpegEncoder::Reset() {
+  if (m_encoderFactory) {
+    m_encoderFactory->Release();
+    m_encoderFactory = nullptr;
+  }
+  if (m_stream) {
+    m_stream->Release();
+    m_stream = nullptr;
+  }
+  m_scratch.clear();
+  m_scratch.shrink_to_fit();
+  m_lastSize = 0;
+}
+
+void WicJpegEncoder::SetOptions(const JpegOptions& options) {
+  m_options = options;
+  m_haveOptions = true;
+  m_optionCount = 0;
+
+  m_optionNames[m_optionCount].pstrName = const_cast<LPOLESTR>(L"ImageQuality");
+  m_optionValues[m_optionCount].vt = VT_R4;
+  m_optionValues[m_optionCount].fltVal = std::min(1.0f, std::max(0.0f, options.quality));
+  ++m_optionCount;
+
+  BYTE subsampling = WICJpegYCrCbSubsamplingDefault;
+  switch (options.subsampling) {
+    case JpegSubsampling::Yuv420:
+      subsampling = WICJpegYCrCbSubsampling420;
+      break;
+    case JpegSubsampling::Yuv422:
+      subsampling = WICJpegYCrCbSubsampling422;
+      break;
+    case JpegSubsampling::Yuv444:
+      subsampling = WICJpegYCrCbSubsampling444;
+      break;
+    case JpegSubsampling::Yuv440:
+      subsampling = WICJpegYCrCbSubsampling440;
+      break;
+    default:
+      break;
+  }
+  if (subsampling != WICJpegYCrCbSubsamplingDefault) {
+    m_optionNames[m_optionCount].pstrName = const_cast<LPOLESTR>(L"JpegYCrCbSubsampling");
+    m_optionValues[m_optionCount].vt = VT_UI1;
+    m_optionValues[m_optionCount].bVal = subsampling;
+    ++m_optionCount;
+  }
+}
+
+HRESULT WicJpegEncoder::Encode(const uint8_t* pixels, uint32_t width, uint32_t height, bool bgra, const JpegOptions& options, FramePtr& outFrame) {
+  if (!pixels || width == 0 || height == 0) return E_INVALIDARG;
+
+  HRESULT hr = S_OK;
+  if (!m_encoderFactory) {
+    // Resolved once; per frame only CreateInstance runs
+    hr = CoGetClassObject(CLSID_WICJpegEncoder, CLSCTX_INPROC_SERVER, NULL, IID_PPV_ARGS(&m_encoderFactory));
+    if (FAILED(hr)) return hr;
+  }
+  if (!m_stream) m_stream = new FrameStream();
+  if (!m_haveOptions || options.quality != m_options.quality || options.subsampling != m_options.subsampling) SetOptions(options);
+
+  // Sized from the previous frame plus headroom; the stream grows the frame
+  // in the rare case the encoder writes more.
+  const size_t estimate = m_lastSize ? m_lastSize + m_lastSize / 4 : static_cast<size_t>(width) * height / 2;
+  outFrame = m_pool->Acquire(estimate, false);
+  if (!outFrame) return S_FALSE;  // pool exhausted; caller drops the frame
+  m_stream->Attach(outFrame.get());
+
+  IWICBitmapEncoder* pEncoder = NULL;
+  IWICBitmapFrameEncode* pFrame = NULL;
+  IPropertyBag2* pPropertyBag = NULL;
+
+  hr = m_encoderFactory->CreateInstance(NULL, IID_PPV_ARGS(&pEncoder));
+  if (SUCCEEDED(hr)) hr = pEncoder->Initialize(m_stream, WICBitmapEncoderNoCache);
+  if (SUCCEEDED(hr)) hr = pEncoder->CreateNewFrame(&pFrame, &pPropertyBag);
+  if (SUCCEEDED(hr) && pPropertyBag) {
+    // One at a time: an option the installed codec lacks (subsampling before
+    // Windows 8) must not take the others down with it.
+    for (ULONG i = 0; i < m_optionCount; ++i) pPropertyBag->Write(1, &m_optionNames[i], &m_optionValues[i]);
+  }
+  if (SUCCEEDED(hr)) hr = pFrame->Initialize(pPropertyBag);
+  if (SUCCEEDED(hr)) hr = pFrame->SetSize(width, height);
+
+  WICPixelFormatGUID pixelFormat = bgra ? GUID_WICPixelFormat32bppBGRA : GUID_WICPixelFormat24bppBGR;
+  if (SUCCEEDED(hr)) hr = pFrame->SetPixelFormat(&pixelFormat);
+  if (SUCCEEDED(hr)) {
+    const BYTE* data = pixels;
+    UINT stride = width * (bgra ? 4 : 3);
+    if (bgra && !IsEqualGUID(pixelFormat, GUID_WICPixelFormat32bppBGRA)) {
+      // The encoder negotiated its native 24bpp BGR layout; drop alpha so
+      // WritePixels receives the format it agreed to.
+      if (!IsEqualGUID(pixelFormat, GUID_WICPixelFormat24bppBGR)) {
+        hr = WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+      } else {
+        const size_t pixelCount = static_cast<size_t>(width) * height;
+        m_scratch.resize(pixelCount * 3);
+        for (size_t i = 0; i < pixelCount; ++i) {
+          m_scratch[i * 3 + 0] = pixels[i * 4 + 0];
+          m_scratch[i * 3 + 1] = pixels[i * 4 + 1];
+          m_scratch[i * 3 + 2] = pixels[i * 4 + 2];
+        }
+        data = m_scratch.data();
+        stride = width * 3;
+      }
+    }
+    if (SUCCEEDED(hr)) hr = pFrame->WritePixels(height, stride, stride * height, const_cast<BYTE*>(data));
+  }
+  if (SUCCEEDED(hr)) hr = pFrame->Commit();
+  if (SUCCEEDED(hr)) hr = pEncoder->Commit();
+
+  if (pFrame) pFrame->Release();
+  if (pPropertyBag) pPropertyBag->Release();
+  if (pEncoder) pEncoder->Release();
+
+  if (SUCCEEDED(hr)) {
+    outFrame->size = m_stream->Length();
+    m_lastSize = outFrame->size;
+  } else {
+    outFrame.reset();
+  }
+  m_stream->Detach();
+  return hr;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <windows.h>
+#include <oaidl.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "capture_backend.h"
+#include "frame.h"
+
+// JPEG encoding through WIC, kept alive for a whole capture session. A WIC
+// encoder commits exactly once, so each frame still needs a fresh encoder and
+// frame object; everything else persists: the encoder's class factory, an
+// output stream that writes straight into a pooled frame (no IWICStream, no
+// HGLOBAL, no read-back copy) and the property-bag options, rebuilt only when
+// they change. Not thread-safe; the owning backend serializes calls.
+class WicJpegEncoder {
+ public:
+  explicit WicJpegEncoder(std::shared_ptr<FramePool> pool);
+  ~WicJpegEncoder();
+  WicJpegEncoder(const WicJpegEncoder&) = delete;
+  WicJpegEncoder& operator=(const WicJpegEncoder&) = delete;
+
+  // Encode tightly packed BGRA (`bgra` = true) or BGR24 pixels into a frame
+  // leased from the pool. Returns S_FALSE with no frame when the pool is
+  // exhausted.
+  HRESULT Encode(const uint8_t* pixels, uint32_t width, uint32_t height, bool bgra, const JpegOptions& options, FramePtr& outFrame);
+  // Release the COM objects and scratch storage; recreated on the next Encode.
+  void Reset();
+
+ private:
+  class FrameStream;
+
+  void SetOptions(const JpegOptions& options);
+
+  std::shared_ptr<FramePool> m_pool;
+  IClassFactory* m_encoderFactory = nullptr;
+  FrameStream* m_stream = nullptr;
+  // Property bag entries written to every frame (ImageQuality, subsampling)
+  PROPBAG2 m_optionNames[2];
+  VARIANT m_optionValues[2];
+  ULONG m_optionCount = 0;
+  JpegOptions m_options;
+  bool m_haveOptions = false;
+  // 24bpp copy when the encoder negotiates BGR24 for BGRA input
+  std::vector<uint8_t> m_scratch;
+  // Size of the previous frame; the next lease is sized from it
+  size_t m_lastSize = 0;
+};